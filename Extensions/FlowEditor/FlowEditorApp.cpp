@@ -2,6 +2,7 @@
 #include <GL3/Window.hpp>
 #include <GL3/PerspectiveCamera.hpp>
 #include <GL3/Shader.hpp>
+#include <Common/GLTFMaterial.hpp>
 #include <Common/Macros.hpp>
 #include <glad/glad.h>
 
@@ -18,6 +19,13 @@ FlowEditorApp::~FlowEditorApp()
 bool FlowEditorApp::OnInitialize(std::shared_ptr<GL3::Window> window, const cxxopts::ParseResult& configure)
 {
 	UNUSED_VARIABLE(configure);
+	//! Submit PBR shader which is main shading pipeline in this application,
+	//! it is compiled while the other resources are created
+	auto defaultShader = std::make_shared<GL3::Shader>();
+	if (!defaultShader->InitializeAsync({ {GL_VERTEX_SHADER,	  RESOURCES_DIR "shaders/vertex.glsl"},
+										  {GL_FRAGMENT_SHADER, RESOURCES_DIR "shaders/output.glsl"} }))
+		return false;
+
 	//! Add perspective camera with default settings
 	auto defaultCam = std::make_shared<GL3::PerspectiveCamera>();
 
@@ -30,14 +38,14 @@ bool FlowEditorApp::OnInitialize(std::shared_ptr<GL3::Window> window, const cxxo
 
 	AddCamera(std::move(defaultCam));
 
-	//! Add PBR shader which is main shading pipeline in this application
-	auto defaultShader = std::make_shared<GL3::Shader>();
-	if (!defaultShader->Initialize({ {GL_VERTEX_SHADER,	  RESOURCES_DIR "shaders/vertex.glsl"},
-									 {GL_FRAGMENT_SHADER, RESOURCES_DIR "shaders/output.glsl"} }))
+	//! Add PBR shader after its compilation is finished
+	if (!defaultShader->Wait())
 		return false;
 
 	defaultShader->BindUniformBlock("UBOCamera", 0);
 	defaultShader->BindUniformBlock("UBOScene", 1);
+	//! Scene draws each material feature combination with its own variant
+	defaultShader->SetVariantDefines(Common::GetMaterialFeatureDefines());
 	GL3::DebugUtils::SetObjectName(GL_PROGRAM, defaultShader->GetResourceID(), "Default Program");
 	_shaders.emplace("default", std::move(defaultShader));
 
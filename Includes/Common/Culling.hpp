@@ -0,0 +1,89 @@
+#ifndef CULLING_HPP
+#define CULLING_HPP
+
+#include <cstddef>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+namespace Common
+{
+/**
+ * @brief View frustum as six planes pointing inward. Point p is inside the
+ * plane when dot(plane.xyz, p) + plane.w >= 0.
+ */
+struct Frustum
+{
+    //! left, right, bottom, top, near, far
+    glm::vec4 planes[6];
+};
+
+/**
+ * @brief Axis aligned bounding boxes stored in structure of arrays layout, so
+ * that the culling test loads eight boxes per component at once.
+ */
+struct AABBArray
+{
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    /**
+     * @brief Resize the arrays, new boxes are empty at the origin.
+     * @param count number of the boxes
+     */
+    void Resize(size_t count);
+
+    /**
+     * @brief Set the corners of the box.
+     * @param index index of the box
+     * @param lower lower corner of the box
+     * @param upper upper corner of the box
+     */
+    void Set(size_t index, const glm::vec3& lower, const glm::vec3& upper);
+
+    [[nodiscard]] size_t Size() const
+    {
+        return minX.size();
+    }
+};
+
+/**
+ * @brief Extract the normalized frustum planes of the view projection
+ * matrix (Gribb-Hartmann method) with the OpenGL clip space convention.
+ * @param viewProjection projection matrix multiplied with view matrix
+ * @return Frustum planes of the view volume in world space
+ */
+[[nodiscard]] Frustum ExtractFrustum(const glm::mat4& viewProjection);
+
+/**
+ * @brief Compute the axis aligned bounding box of the transformed box.
+ * @details The box is transformed as center and half extent, the extent is
+ * multiplied with the absolute upper 3x3 part of the matrix.
+ * @param matrix affine transform matrix
+ * @param lower lower corner of the box
+ * @param upper upper corner of the box
+ * @param worldLower returns lower corner of the transformed box
+ * @param worldUpper returns upper corner of the transformed box
+ */
+void TransformAABB(const glm::mat4& matrix, const glm::vec3& lower,
+                   const glm::vec3& upper, glm::vec3& worldLower,
+                   glm::vec3& worldUpper);
+
+/**
+ * @brief Test the boxes against the frustum planes.
+ * @details Each plane is tested with the box corner farthest along its
+ * normal, so the test is conservative for the boxes crossing the frustum
+ * edges. Eight boxes are tested at once with AVX2 and four with SSE2 when
+ * available.
+ * @param frustum frustum planes pointing inward
+ * @param boxes boxes to be tested
+ * @param visible returns 1 for the box intersecting the frustum, 0 otherwise,
+ * at least boxes.Size() elements
+ * @return size_t number of the visible boxes
+ */
+size_t CullAABBs(const Frustum& frustum, const AABBArray& boxes,
+                 unsigned char* visible);
+};  // namespace Common
+
+#endif  //! end of Culling.hpp
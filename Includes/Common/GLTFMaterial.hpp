@@ -6,6 +6,7 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <string>
+#include <vector>
 
 namespace Common
 {
@@ -23,6 +24,10 @@ namespace Common
 #define KHR_MESH_QUANTIZATION_EXTENSION_NAME "KHR_mesh_quantization"
 #define KHR_TEXTURE_TRANSFORM_EXTENSION_NAME "KHR_texture_transform"
 
+//! Multi-vendor extension list
+//! (https://github.com/KhronosGroup/glTF/tree/master/extensions/2.0/Vendor)
+#define EXT_MESH_GPU_INSTANCING_EXTENSION_NAME "EXT_mesh_gpu_instancing"
+
 namespace GLTFExtension
 {
 struct KHR_materials_clearcoat
@@ -118,6 +123,36 @@ struct GLTFMaterial
     GLTFExtension::KHR_materials_unlit unlit;
 };
 
+//! Features of the material fixed per draw, each bit is compiled into the
+//! shader variant of the material as the #define of the same index in
+//! GetMaterialFeatureDefines. Bits fit the 8-bit shader field of the render
+//! queue keys
+namespace MaterialFeature
+{
+constexpr unsigned int SpecularGlossiness = 1u << 0;
+constexpr unsigned int BaseColorTexture = 1u << 1;
+constexpr unsigned int MetallicRoughnessTexture = 1u << 2;
+constexpr unsigned int NormalTexture = 1u << 3;
+constexpr unsigned int OcclusionTexture = 1u << 4;
+constexpr unsigned int EmissiveTexture = 1u << 5;
+constexpr unsigned int AlphaCutoff = 1u << 6;
+constexpr unsigned int DiffuseTexture = 1u << 7;
+};  // namespace MaterialFeature
+
+/**
+ * @brief Returns the feature bits of the material.
+ * @param material material of the draw
+ * @return unsigned int combination of the MaterialFeature bits
+ */
+[[nodiscard]] unsigned int GetMaterialFeatures(const GLTFMaterial& material);
+
+/**
+ * @brief Returns the names of the #defines enabled by the feature bits,
+ * indexed by the bit.
+ * @return const std::vector<std::string>& define names of the features
+ */
+[[nodiscard]] const std::vector<std::string>& GetMaterialFeatureDefines();
+
 };  // namespace Common
 
 #endif  //! end of GLTFMaterial.hpp
\ No newline at end of file
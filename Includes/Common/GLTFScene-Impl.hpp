@@ -1,100 +1,129 @@
 #ifndef GLTF_SCENE_IMPL_HPP
 #define GLTF_SCENE_IMPL_HPP
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
 
 namespace Common
 {
 template <typename Type>
-bool GLTFScene::GetAttributes(const tinygltf::Model& model,
-                              const tinygltf::Primitive& primitive,
-                              std::vector<Type>& attributes,
-                              const std::string& name)
+bool GLTFScene::GetAttributes(
+    const tinygltf::Model& model,
+    const std::map<std::string, int>& primitiveAttributes, Type* attributes,
+    size_t maxCount, const std::string& name)
 {
-    auto iter = primitive.attributes.find(name);
-    if (iter == primitive.attributes.end())
+    auto iter = primitiveAttributes.find(name);
+    if (iter == primitiveAttributes.end())
         return false;
 
     //! Retrieving the data of the attributes
     const auto& accessor = model.accessors[iter->second];
     const auto& bufferView = model.bufferViews[accessor.bufferView];
     const auto& buffer = model.buffers[bufferView.buffer];
-    const Type* bufData = reinterpret_cast<const Type*>(
-        &(buffer.data[accessor.byteOffset + bufferView.byteOffset]));
-    const auto& numElements = accessor.count;
-
-    //! Supporting KHR_mesh_quantization
-    assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
+    const unsigned char* bufferByte =
+        &(buffer.data[accessor.byteOffset + bufferView.byteOffset]);
+    const size_t numElements = std::min(accessor.count, maxCount);
+
+    const int numComponents = tinygltf::GetNumComponentsInType(
+        static_cast<uint32_t>(accessor.type));
+    const int componentSize = tinygltf::GetComponentSizeInBytes(
+        static_cast<uint32_t>(accessor.componentType));
+    const int byteStride = accessor.ByteStride(bufferView);
+    if (numComponents <= 0 || componentSize <= 0 || byteStride <= 0)
+    {
+        std::cerr << "Invalid accessor of the attribute " << name << std::endl;
+        return false;
+    }
 
-    if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+    constexpr int kNumTypeComponents = static_cast<int>(Type::length());
+    if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT &&
+        numComponents == kNumTypeComponents)
     {
-        if (bufferView.byteStride == 0)
+        if (byteStride == static_cast<int>(sizeof(Type)))
         {
-            attributes.insert(attributes.end(), bufData, bufData + numElements);
+            const Type* bufData = reinterpret_cast<const Type*>(bufferByte);
+            std::copy(bufData, bufData + numElements, attributes);
         }
         else
         {
-            auto bufferByte = reinterpret_cast<const unsigned char*>(bufData);
             for (size_t i = 0; i < numElements; ++i)
             {
-                attributes.push_back(
-                    *reinterpret_cast<const Type*>(bufferByte));
-                bufferByte += bufferView.byteStride;
+                std::memcpy(&attributes[i], bufferByte, sizeof(Type));
+                bufferByte += byteStride;
             }
         }
+        return true;
     }
-    else  //! The component is smaller than flaot and need to be covnerted
-          //! (quantized)
+
+    //! Component is quantized (KHR_mesh_quantization) or the number of
+    //! components differs (ex. RGB vertex color), convert each component.
+    const int numCopyComponents = std::min(numComponents, kNumTypeComponents);
+    for (size_t i = 0; i < numElements; ++i)
     {
-        //! vec3 or vec4
-        int numComponents = accessor.type;
-        //! unsigned byte or unsigned short.
-        int strideComponent =
-            accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ? 1
-                                                                            : 2;
-
-        size_t byteStride = bufferView.byteStride > 0
-                                ? bufferView.byteStride
-                                : numComponents * strideComponent;
-        auto bufferByte = reinterpret_cast<const unsigned char*>(bufData);
-        for (size_t i = 0; i < numElements; ++i)
+        //! Missing alpha or w component defaults to one.
+        Type vecValue(0.0f);
+        if (kNumTypeComponents == 4)
         {
-            Type vecValue;
+            vecValue[kNumTypeComponents - 1] = 1.0f;
+        }
 
-            auto bufferByteData = bufferByte;
-            for (int c = 0; c < numComponents; ++c)
+        const unsigned char* bufferByteData = bufferByte;
+        for (int c = 0; c < numCopyComponents; ++c)
+        {
+            float value{ 0.0f };
+            switch (accessor.componentType)
             {
-                float value = *reinterpret_cast<const float*>(bufferByteData);
-                switch (accessor.componentType)
+                case TINYGLTF_COMPONENT_TYPE_FLOAT:
+                    std::memcpy(&value, bufferByteData, sizeof(float));
+                    break;
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                {
+                    unsigned short component;
+                    std::memcpy(&component, bufferByteData, sizeof(component));
+                    value = accessor.normalized
+                                ? component / 65535.0f
+                                : static_cast<float>(component);
+                    break;
+                }
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                {
+                    const unsigned char component = *bufferByteData;
+                    value = accessor.normalized
+                                ? component / 255.0f
+                                : static_cast<float>(component);
+                    break;
+                }
+                case TINYGLTF_COMPONENT_TYPE_SHORT:
+                {
+                    short component;
+                    std::memcpy(&component, bufferByteData, sizeof(component));
+                    value = accessor.normalized
+                                ? std::max(component / 32767.0f, -1.0f)
+                                : static_cast<float>(component);
+                    break;
+                }
+                case TINYGLTF_COMPONENT_TYPE_BYTE:
                 {
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-                        vecValue[c] =
-                            value / std::numeric_limits<unsigned short>::max();
-                        break;
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-                        vecValue[c] =
-                            value / std::numeric_limits<unsigned char>::max();
-                        break;
-                    case TINYGLTF_COMPONENT_TYPE_SHORT:
-                        vecValue[c] = std::max(
-                            value / std::numeric_limits<short>::max(), -1.0f);
-                        break;
-                    case TINYGLTF_COMPONENT_TYPE_BYTE:
-                        vecValue[c] = std::max(
-                            value / std::numeric_limits<char>::max(), -1.0f);
-                        break;
-                    default:
-                        std::cerr << "Unknown attributes component type : "
-                                  << accessor.componentType
-                                  << " is not supported" << std::endl;
-                        return false;
+                    const auto component =
+                        static_cast<signed char>(*bufferByteData);
+                    value = accessor.normalized
+                                ? std::max(component / 127.0f, -1.0f)
+                                : static_cast<float>(component);
+                    break;
                 }
-                bufferByteData += strideComponent;
+                default:
+                    std::cerr << "Unknown attributes component type : "
+                              << accessor.componentType << " is not supported"
+                              << std::endl;
+                    return false;
             }
-            bufferByte += byteStride;
-            attributes.push_back(vecValue);
+            vecValue[c] = value;
+            bufferByteData += componentSize;
         }
+        bufferByte += byteStride;
+        attributes[i] = vecValue;
     }
 
     return true;
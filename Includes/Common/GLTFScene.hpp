@@ -3,14 +3,18 @@
 
 #include <tinygltf/tiny_gltf.h>
 #include <Common/GLTFMaterial.hpp>
+#include <Common/Skinning.hpp>
+#include <Common/TextureCompressor.hpp>
 #include <Common/Vertex.hpp>
 #include <functional>
+#include <future>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <limits>
+#include <map>
 #include <string>
 #include <unordered_map>
 
@@ -50,6 +54,39 @@ class GLTFScene
     bool Initialize(const std::string& filename, VertexFormat format,
                     const ImageCallback& imageCallback = nullptr);
 
+    /**
+     * @brief Enable the binary scene cache stored in the given directory.
+     * @details Once a scene is loaded, the processed vertex attributes,
+     * indices, nodes, materials, animations and decoded images are written to
+     * the cache file keyed by hash of the source file and vertex format.
+     * Later Initialize calls map the cache file and skip tinygltf entirely.
+     * Cache is invalidated when the source file or any external buffer and
+     * image file referenced by it is modified.
+     * @param directory existing directory where cache files are stored,
+     * empty string disables the cache.
+     */
+    void SetCacheDirectory(const std::string& directory);
+
+    /**
+     * @brief Enable the vertex cache, overdraw and vertex fetch optimization
+     * of the loaded primitives.
+     * @details Indices of each primitive are reordered for post-transform
+     * vertex cache and overdraw, then vertices in the primitive range are
+     * reordered in order of first use. Disabled by default.
+     * @param enable true for optimizing primitives after loading
+     */
+    void SetMeshOptimization(bool enable);
+
+    /**
+     * @brief Generate the level of detail chain of each loaded primitive.
+     * @details Each level is simplified from the previous one to a quarter of
+     * its triangles with quadric error metric and appended to the shared
+     * index buffer as another index range of the primitive, together with
+     * its object space error. Disabled by default.
+     * @param numLevels number of coarser levels per primitive, 0 disables
+     */
+    void SetLODGeneration(unsigned int numLevels);
+
     /**
      * @brief Update scene animation
      * @param animIndex index of animation want to play in the array
@@ -59,18 +96,71 @@ class GLTFScene
      */
     bool UpdateAnimation(size_t animIndex, double timeElapsed);
 
+    /**
+     * @brief Returns the nodes whose world matrix is changed by the last
+     * UpdateAnimation call.
+     * @return const std::vector<unsigned int>& indices of the changed nodes in
+     * _sceneNodes, in ascending order
+     */
+    [[nodiscard]] const std::vector<unsigned int>& GetChangedNodes() const;
+
+    /**
+     * @brief Returns the nodes whose morph target weights are changed by the
+     * last UpdateAnimation call.
+     * @return const std::vector<unsigned int>& indices of the morphed nodes in
+     * _sceneNodes, in ascending order
+     */
+    [[nodiscard]] const std::vector<unsigned int>& GetChangedMorphNodes()
+        const;
+
+    /**
+     * @brief Returns the skinned nodes whose joint matrices are changed by the
+     * last UpdateAnimation call, either by their joints or by themselves.
+     * @return const std::vector<unsigned int>& indices of the skinned nodes
+     * in _sceneNodes, in ascending order
+     */
+    [[nodiscard]] const std::vector<unsigned int>& GetChangedSkinNodes()
+        const;
+
  protected:
-    struct GLTFNode
+    //! Scene nodes in structure of arrays. Parents always precede their
+    //! children, so world matrices are updated in a single linear pass.
+    struct GLTFNodes
     {
-        glm::mat4 world{ 1.0f };
-        glm::mat4 local{ 1.0f };
-        glm::vec3 translation{ 0.0f };
-        glm::vec3 scale{ 1.0f };
-        glm::quat rotation{ 0.0f, 0.0f, 0.0f, 0.0f };
-        std::vector<size_t> primMeshes;
-        std::vector<size_t> childNodes;
-        int parentNode{ -1 };
-        int nodeIndex{ 0 };
+        std::vector<glm::vec3> translations;
+        std::vector<glm::quat> rotations;
+        std::vector<glm::vec3> scales;
+        std::vector<glm::mat4> matrices;  //! matrix property, applied last
+        std::vector<glm::mat4> worlds;
+        std::vector<int> parents;      //! -1 for the root nodes
+        std::vector<int> nodeIndices;  //! index of the node in gltf model
+        //! Primitives of the node i are primMeshes[primMeshOffsets[i]] until
+        //! primMeshes[primMeshOffsets[i + 1]]
+        std::vector<unsigned int> primMeshOffsets{ 0 };
+        std::vector<unsigned int> primMeshes;
+        //! Morph target weights of the node i are weights[weightOffsets[i]]
+        //! until weights[weightOffsets[i + 1]]
+        std::vector<unsigned int> weightOffsets{ 0 };
+        std::vector<float> weights;
+        std::vector<int> skins;  //! index in _sceneSkins, -1 for none
+        //! Instance transforms of the node i from EXT_mesh_gpu_instancing are
+        //! instances[instanceOffsets[i]] until instances[instanceOffsets[i +
+        //! 1]], relative to the node. Node without them is drawn once.
+        std::vector<unsigned int> instanceOffsets{ 0 };
+        std::vector<glm::mat4> instances;
+        std::vector<unsigned char> dirty;
+
+        [[nodiscard]] size_t Size() const
+        {
+            return parents.size();
+        }
+    };
+
+    struct GLTFLod
+    {
+        unsigned int firstIndex{ 0 };
+        unsigned int indexCount{ 0 };
+        float error{ 0.0f };  //! simplification error in object space
     };
 
     struct GLTFPrimMesh
@@ -84,6 +174,36 @@ class GLTFScene
         glm::vec3 min{ 0.0f, 0.0f, 0.0f };
         glm::vec3 max{ 0.0f, 0.0f, 0.0f };
         std::string name;
+        std::vector<GLTFLod> lods;  //! coarser levels, finest first
+        //! Range of the morph targets in _sceneMorphTargets
+        unsigned int morphTargetBegin{ 0 };
+        unsigned int morphTargetCount{ 0 };
+        //! True if the vertices have joint influences in _skinVertices
+        bool skinned{ false };
+    };
+
+    //! Non-zero displacement of one vertex by the morph target, laid out for
+    //! std430 shader storage buffer
+    struct GLTFMorphDelta
+    {
+        glm::vec3 position{ 0.0f };
+        unsigned int vertex{ 0 };  //! vertex index local to the primitive
+        glm::vec3 normal{ 0.0f };
+        float padding{ 0.0f };
+    };
+
+    struct GLTFMorphTarget
+    {
+        //! Range of the deltas in _morphDeltas
+        unsigned int deltaBegin{ 0 };
+        unsigned int deltaCount{ 0 };
+    };
+
+    struct GLTFSkin
+    {
+        //! Range of the joints in _skinJoints and _inverseBindMatrices
+        unsigned int jointBegin{ 0 };
+        unsigned int jointCount{ 0 };
     };
 
     struct GLTFCamera
@@ -111,8 +231,14 @@ class GLTFScene
             Cubicspline = 2
         };
         Interpolation interpolation{ Interpolation::Linear };
-        std::vector<float> inputs;
-        std::vector<glm::vec4> outputs;
+        //! Range of the key times in _animKeyTimes
+        unsigned int keyBegin{ 0 };
+        unsigned int keyCount{ 0 };
+        //! First key value in _animKeyValues. Cubic spline samplers store
+        //! in-tangents, values and out-tangents for each key.
+        unsigned int valueBegin{ 0 };
+        //! Number of values per key, number of morph targets for weights
+        unsigned int valueWidth{ 1 };
     };
 
     struct GLTFChannel
@@ -125,7 +251,7 @@ class GLTFScene
             Weights = 3
         };
         Path path{ Path::Translation };
-        int samplerIndex{ 0 };
+        int samplerIndex{ 0 };  //! index in _sceneSamplers
         int nodeIndex{ 0 };
     };
 
@@ -136,6 +262,7 @@ class GLTFScene
         size_t samplerCount{ 0 };
         size_t channelIndex{ 0 };
         size_t channelCount{ 0 };
+        float duration{ 0.0f };  //! last key time among the samplers
     };
 
     struct SceneDimension
@@ -152,7 +279,7 @@ class GLTFScene
     };
 
     std::vector<GLTFMaterial> _sceneMaterials;
-    std::vector<GLTFNode> _sceneNodes;
+    GLTFNodes _sceneNodes;
     std::vector<GLTFPrimMesh> _scenePrimMeshes;
     std::vector<GLTFCamera> _sceneCameras;
     std::vector<GLTFLight> _sceneLights;
@@ -160,12 +287,27 @@ class GLTFScene
     std::vector<GLTFSampler> _sceneSamplers;
     std::vector<GLTFChannel> _sceneChannels;
 
+    //! Keyframe pools shared by all samplers of the scene
+    std::vector<float> _animKeyTimes;
+    std::vector<glm::vec4> _animKeyValues;
+
+    //! Morph targets of all primitives and their sparse vertex deltas
+    std::vector<GLTFMorphTarget> _sceneMorphTargets;
+    std::vector<GLTFMorphDelta> _morphDeltas;
+
+    //! Skins with their joint nodes in _sceneNodes and inverse bind matrices
+    std::vector<GLTFSkin> _sceneSkins;
+    std::vector<unsigned int> _skinJoints;
+    std::vector<glm::mat4> _inverseBindMatrices;
+
     std::vector<glm::vec3> _positions;
     std::vector<glm::vec3> _normals;
     std::vector<glm::vec4> _tangents;
     std::vector<glm::vec4> _colors;
     std::vector<glm::vec2> _texCoords;
     std::vector<unsigned int> _indices;
+    //! Joint influences parallel to the vertices, empty without skins
+    std::vector<SkinVertex> _skinVertices;
 
     SceneDimension _sceneDim;
 
@@ -174,38 +316,126 @@ class GLTFScene
      */
     void ReleaseSourceData();
 
+    /**
+     * @brief Compute the joint matrix palette of the skinned node.
+     * @details Joint matrices are relative to the node, so the skinned
+     * vertices are transformed by the world matrix of the node as usual.
+     * @param nodeIndex index of the skinned node in _sceneNodes
+     * @param jointMatrices returns jointCount matrices of the node skin
+     */
+    void ComputeJointMatrices(size_t nodeIndex,
+                              glm::mat4* jointMatrices) const;
+
+    /**
+     * @brief Returns the usage of the texture in the scene materials. When the
+     * texture is shared by several slots, normal map takes precedence over
+     * base color, emissive, metallic-roughness and occlusion in order.
+     * @param textureIndex index of the texture referenced by the materials
+     * @return TextureRole usage of the texture, Unknown if not referenced
+     */
+    [[nodiscard]] TextureRole GetTextureRole(int textureIndex) const;
+
+    /**
+     * @brief Returns the directory set by SetCacheDirectory.
+     * @return const std::string& cache directory, empty if disabled
+     */
+    [[nodiscard]] const std::string& GetCacheDirectory() const;
+
  private:
+    //! Encoded image files collected while loading, indexed by image index
+    using EncodedImages = std::vector<std::vector<unsigned char>>;
+
     /**
      * @brief Load GLTF model from the given filename and pass it by reference.
+     * @details Images are not decoded, their encoded bytes are returned
+     * instead so that they can be decoded concurrently with DecodeImages.
      * @param model returns loaded tinygltf model to this pointer
      * @param filename gltf scene file path
+     * @param encodedImages returns encoded bytes of each image
      * @return true if tinygltf model loading is success
      * @return false if tinygltf model loading is failed
      */
-    static bool LoadModel(tinygltf::Model* model, const std::string& filename);
+    static bool LoadModel(tinygltf::Model* model, const std::string& filename,
+                          EncodedImages* encodedImages);
+
+    /**
+     * @brief Submit decoding of the encoded images to the worker threads.
+     * @details Each task decodes into its own image of the model and releases
+     * the encoded bytes. The model and encoded images must outlive the tasks.
+     * @param model model whose images are decoded
+     * @param encodedImages encoded bytes of each image from LoadModel
+     * @return std::vector<std::future<bool>> result of each image decoding,
+     * invalid future for the image without encoded bytes
+     */
+    static std::vector<std::future<bool>> DecodeImages(
+        tinygltf::Model& model, EncodedImages& encodedImages);
 
     /**
      * @brief Parse attribute with desire type from the model.
      * @tparam Type attribute type to be retrieved from this function.
      * @param model initialized tinygltf model from gltf scene
      * @param primitive
-     * @param attributes
+     * @param attributes destination range of the primitive in the attribute
+     * array, at least maxCount elements
+     * @param maxCount number of vertices of the primitive
      * @param name
      * @return true
      * @return false
      */
     template <typename Type>
-    static bool GetAttributes(const tinygltf::Model& model,
-                              const tinygltf::Primitive& primitive,
-                              std::vector<Type>& attributes,
-                              const std::string& name);
+    static bool GetAttributes(
+        const tinygltf::Model& model,
+        const std::map<std::string, int>& primitiveAttributes,
+        Type* attributes, size_t maxCount, const std::string& name);
+
+    /**
+     * @brief Read the displacement attribute of the morph target. Sparse
+     * accessors are applied over the zero or dense base values.
+     * @param model initialized tinygltf model from gltf scene
+     * @param target attributes of the morph target
+     * @param displacements destination array, at least maxCount elements
+     * @param maxCount number of vertices of the primitive
+     * @param name attribute name, POSITION or NORMAL
+     * @return true if the target has the attribute
+     * @return false if the target does not have the attribute
+     */
+    static bool GetMorphAttributes(const tinygltf::Model& model,
+                                  const std::map<std::string, int>& target,
+                                  glm::vec3* displacements, size_t maxCount,
+                                  const std::string& name);
+
+    /**
+     * @brief Append the morph targets of the primitive to _sceneMorphTargets
+     * with their non-zero vertex deltas, and extend the bounding box of the
+     * primitive by the displacements of the targets.
+     * @param model initialized tinygltf model from gltf scene
+     * @param primitive primitive which has the morph targets
+     * @param primMesh processed primitive, receives the morph target range
+     */
+    void ProcessMorphTargets(const tinygltf::Model& model,
+                             const tinygltf::Primitive& primitive,
+                             GLTFPrimMesh& primMesh);
 
     /**
      * @brief Returns the SRT matrix combination of this node.
-     * @param node parsed gltf scene node
+     * @param nodeIndex index of the node in _sceneNodes
      * @return glm::mat4 calculated local transform matrix
      */
-    static glm::mat4 GetLocalMatrix(const GLTFNode& node);
+    [[nodiscard]] glm::mat4 GetLocalMatrix(size_t nodeIndex) const;
+
+    /**
+     * @brief Mark the local transform of the node as modified. World matrices
+     * of the node and its descendants are recomputed by UpdateWorldMatrices.
+     * @param nodeIndex index of the node in _sceneNodes
+     */
+    void MarkNodeDirty(size_t nodeIndex);
+
+    /**
+     * @brief Recompute world matrices of the dirty subtrees in one pass over
+     * the nodes, starting from the first dirty node. Updated nodes are
+     * collected into the changed node list and their dirty flags are cleared.
+     */
+    void UpdateWorldMatrices();
 
     /**
      * @brief Import materials from the model
@@ -215,14 +445,29 @@ class GLTFScene
 
     /**
      * @brief Process mesh in the model
+     * @details Writes only into the range of the attribute and index arrays
+     * given by resultMesh, different primitives can be processed concurrently.
      * @param model
      * @param mesh
      * @param format
-     * @param name
+     * @param resultMesh primitive with offsets and counts from the pre-pass
      */
     void ProcessMesh(const tinygltf::Model& model,
                      const tinygltf::Primitive& mesh, VertexFormat format,
-                     const std::string& name);
+                     GLTFPrimMesh& resultMesh);
+
+    /**
+     * @brief Optimize index and vertex order of all loaded primitives.
+     * @details Primitives are optimized concurrently, each one only touches
+     * its own range of the attribute and index arrays.
+     */
+    void OptimizePrimMeshes();
+
+    /**
+     * @brief Generate the level of detail chain of all loaded primitives and
+     * append their index ranges to the index array.
+     */
+    void GeneratePrimMeshLods();
 
     /**
      * @brief Process node in the model recursively.
@@ -232,8 +477,30 @@ class GLTFScene
      */
     void ProcessNode(const tinygltf::Model& model, int nodeIdx,
                      int parentIndex);
-    //! Update world coordinates of the given node and child nodes
-    void UpdateNode(size_t nodeIndex);
+
+    /**
+     * @brief Append the instance transforms of the EXT_mesh_gpu_instancing
+     * extension to _sceneNodes.instances.
+     * @param model initialized tinygltf model from gltf scene
+     * @param extension extension object of the node
+     */
+    void ProcessInstances(const tinygltf::Model& model,
+                          const tinygltf::Value& extension);
+
+    /**
+     * @brief Import the skins of the model with their joints resolved to the
+     * processed nodes. Nodes whose skin refers to a joint outside of the
+     * scene are rendered without skinning.
+     * @param model initialized tinygltf model from gltf scene
+     */
+    void ProcessSkins(const tinygltf::Model& model);
+
+    /**
+     * @brief Clamp the joint influences of the skinned primitives to the skin
+     * of each node instancing them, out of range joints get zero weight.
+     * Weights are renormalized to sum up to one.
+     */
+    void SanitizeSkinVertices();
     //! Process animation in the model
     void ProcessAnimation(const tinygltf::Model& model,
                           const tinygltf::Animation& anim,
@@ -242,17 +509,35 @@ class GLTFScene
     /**
      * @brief Process animation channel and append it to _sceneChannels
      * @param channel
+     * @param samplerOffset index of the first sampler of the animation
      */
-    void ProcessChannel(const tinygltf::AnimationChannel& channel);
+    void ProcessChannel(const tinygltf::AnimationChannel& channel,
+                        std::size_t samplerOffset);
 
     /**
-     * @brief Process animation sampler and append it to _sceneSamplers
+     * @brief Process animation sampler, append its keyframes to the pools
+     * and the sampler to _sceneSamplers
      * @param model
      * @param sampler
      */
     void ProcessSampler(const tinygltf::Model& model,
                         const tinygltf::AnimationSampler& sampler);
 
+    /**
+     * @brief Evaluate the sampler at the given time.
+     * @details The cursor caches the keyframe segment of the previous
+     * evaluation, so playing forward advances it in amortized O(1) steps.
+     * Seeking falls back to binary search over the key times.
+     * @param sampler sampler to be evaluated
+     * @param isRotation true for quaternion values interpolated with slerp
+     * @param time animation time in seconds
+     * @param cursor keyframe segment of the previous evaluation, updated
+     * @param result returns valueWidth interpolated values of the sampler
+     */
+    void EvaluateSampler(const GLTFSampler& sampler, bool isRotation,
+                         float time, unsigned int& cursor,
+                         glm::vec4* result) const;
+
     /**
      * @brief Calculate the scene dimension from loaded nodes.
      */
@@ -263,6 +548,28 @@ class GLTFScene
      */
     void ComputeCamera();
 
+    /**
+     * @brief Load the scene from the cache file of the given source file.
+     * @param filename gltf scene file path
+     * @param format desired vertex format for parsing scene
+     * @param imageCallback callback function called with each cached image
+     * @return true if valid cache is found and loaded
+     * @return false if cache is missing, outdated or corrupted
+     */
+    bool LoadCache(const std::string& filename, VertexFormat format,
+                   const ImageCallback& imageCallback);
+
+    /**
+     * @brief Write the processed scene to the cache file.
+     * @param filename gltf scene file path
+     * @param format vertex format used for parsing scene
+     * @param model loaded tinygltf model, provides images and dependencies
+     * @return true if cache file is written
+     * @return false if cache file cannot be written
+     */
+    bool SaveCache(const std::string& filename, VertexFormat format,
+                   const tinygltf::Model& model) const;
+
     /**
      * @brief Returns a vector of data for a tinygltf::Value
      * @tparam Type
@@ -293,11 +600,18 @@ class GLTFScene
     static void GetTextureID(const tinygltf::Value& value,
                              const std::string& name, int& id);
 
+    std::string _cacheDirectory;
+    std::vector<unsigned int> _channelCursors;
+    std::vector<unsigned int> _changedNodes;
+    std::vector<unsigned int> _changedMorphNodes;
+    std::vector<unsigned int> _changedSkinNodes;
+    std::vector<glm::vec4> _sampledWeights;
+    size_t _firstDirtyNode{ std::numeric_limits<size_t>::max() };
+    bool _optimizeMeshes{ false };
+    unsigned int _numLodLevels{ 0 };
+
     //! Temporary storages for processing nodes.
     std::unordered_map<size_t, std::vector<size_t>> _meshToPrimMap;
-    std::vector<unsigned int> _u32Buffer;
-    std::vector<unsigned short> _u16Buffer;
-    std::vector<unsigned char> _u8Buffer;
 };
 
 }  // namespace Common
@@ -0,0 +1,29 @@
+#ifndef HASH_UTILS_HPP
+#define HASH_UTILS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Common
+{
+/**
+ * @brief Collection of non-cryptographic hash functions for cache keys.
+ */
+class HashUtils
+{
+ public:
+    /**
+     * @brief Hash the byte range, eight bytes are processed at once with
+     * multiplicative hashing and the result is finalized with avalanche mix.
+     * @param data pointer to the first byte
+     * @param size number of bytes
+     * @param seed initial hash value, different seeds give independent hashes
+     * @return std::uint64_t 64-bit hash of the range
+     */
+    [[nodiscard]] static std::uint64_t HashBytes(const void* data, size_t size,
+                                                 std::uint64_t seed = 0);
+};
+
+}  // namespace Common
+
+#endif  //! end of HashUtils.hpp
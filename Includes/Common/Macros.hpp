@@ -12,6 +12,15 @@
 #define LINUX
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#endif
+
+#if defined(__AVX2__)
+#define SIMD_AVX2
+#endif
+
 #if defined(WINDOWS) && defined(_MSC_VER)
 #include <BaseTsd.h>
 using ssize_t = SSIZE_T;
@@ -0,0 +1,61 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+
+namespace Common
+{
+/**
+ * @brief Read-only memory mapped file.
+ * @details The whole file is mapped into the address space of the process
+ * and pages are loaded by the operating system on demand. Mapping is released
+ * on destruction.
+ */
+class MappedFile
+{
+ public:
+    //! Default constructor
+    MappedFile() = default;
+
+    //! Default destructor
+    ~MappedFile();
+
+    //! Mapped file is not copyable
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Map the file at the given path in read-only mode.
+     * Previously mapped file is closed.
+     * @param path file path to be mapped
+     * @return true if mapping success
+     * @return false if the file cannot be opened or mapped
+     */
+    bool Open(const std::string& path);
+
+    //! Unmap the file and close the handles.
+    void Close();
+
+    /**
+     * @brief Returns the pointer to the first byte of the mapped file
+     * @return const char* mapped file contents, nullptr if not mapped or empty
+     */
+    [[nodiscard]] const char* GetData() const;
+
+    /**
+     * @brief Returns the size of the mapped file in bytes
+     * @return size_t size of the mapped file
+     */
+    [[nodiscard]] size_t GetSize() const;
+
+ private:
+    const char* _data{ nullptr };
+    size_t _size{ 0 };
+    void* _fileHandle{ nullptr };
+    void* _mappingHandle{ nullptr };
+    int _fileDescriptor{ -1 };
+};
+
+};  // namespace Common
+
+#endif  //! end of MappedFile.hpp
@@ -45,12 +45,21 @@ Type SLerp(Type prev, Type next, const float keyframe)
 }
 
 template <typename Type>
-Type CubicSpline(Type prev, Type next, const float keyframe)
+Type CubicSpline(Type prev, Type prevOutTangent, Type nextInTangent, Type next,
+                 const float keyframe, const float deltaTime)
 {
-    UNUSED_VARIABLE(prev);
-    UNUSED_VARIABLE(next);
-    UNUSED_VARIABLE(keyframe);
-    static_assert("Not implemented yet");
+    const float t = keyframe;
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+
+    //! Hermite basis functions
+    const float prevWeight = 2.0f * t3 - 3.0f * t2 + 1.0f;
+    const float prevTangentWeight = (t3 - 2.0f * t2 + t) * deltaTime;
+    const float nextWeight = -2.0f * t3 + 3.0f * t2;
+    const float nextTangentWeight = (t3 - t2) * deltaTime;
+
+    return prevWeight * prev + prevTangentWeight * prevOutTangent +
+           nextWeight * next + nextTangentWeight * nextInTangent;
 }
 
 template <typename Type>
@@ -1,7 +1,9 @@
 #ifndef MATHUTILS_HPP
 #define MATHUTILS_HPP
 
+#include <cstddef>
 #include <functional>
+#include <glm/mat4x4.hpp>
 
 namespace Common
 {
@@ -33,15 +35,21 @@ template <typename Type>
 [[nodiscard]] Type SLerp(Type prev, Type next, float keyframe);
 
 /**
- * @brief Quaternion slerp interpolation between two quaternions
+ * @brief Cubic Hermite spline interpolation between two keyframes as defined
+ * by the glTF CUBICSPLINE interpolation
  * @tparam Type
  * @param prev value in previous step
+ * @param prevOutTangent out-tangent of the previous step
+ * @param nextInTangent in-tangent of the next step
  * @param next value in next step
  * @param keyframe interpolation keyframe factor
+ * @param deltaTime time between the two steps, scales the tangents
  * @return Type cubic spline interpolated value
  */
 template <typename Type>
-[[nodiscard]] Type CubicSpline(Type prev, Type next, float keyframe);
+[[nodiscard]] Type CubicSpline(Type prev, Type prevOutTangent,
+                               Type nextInTangent, Type next, float keyframe,
+                               float deltaTime);
 
 /**
  * @brief Returns prev if keyframe is less or equal than keyframe, next
@@ -55,6 +63,18 @@ template <typename Type>
 template <typename Type>
 [[nodiscard]] Type Step(Type prev, Type next, float keyframe);
 };  // namespace Interpolation
+
+/**
+ * @brief Compute the normal matrices of the affine transform matrices.
+ * @details Normal matrix is the inverse transpose of the upper 3x3 part,
+ * evaluated as its cofactor matrix divided by the determinant instead of the
+ * full 4x4 inverse. Four matrices are processed at once with SSE2.
+ * @param matrices affine transform matrices
+ * @param count number of the matrices
+ * @param normalMatrices returns the normal matrices, translation is zero
+ */
+void ComputeNormalMatrices(const glm::mat4* matrices, size_t count,
+                           glm::mat4* normalMatrices);
 };  // namespace Common
 
 #include <Common/MathUtils-Impl.hpp>
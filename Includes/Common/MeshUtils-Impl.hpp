@@ -0,0 +1,22 @@
+#ifndef MESH_UTILS_IMPL_HPP
+#define MESH_UTILS_IMPL_HPP
+
+#include <algorithm>
+
+namespace Common
+{
+template <typename Type>
+void MeshUtils::RemapVertexStream(Type* stream,
+                                  const std::vector<unsigned int>& remap)
+{
+    std::vector<Type> reordered(remap.size());
+    for (size_t i = 0; i < remap.size(); ++i)
+    {
+        reordered[remap[i]] = stream[i];
+    }
+    std::copy(reordered.begin(), reordered.end(), stream);
+}
+
+}  // namespace Common
+
+#endif  //! end of MeshUtils-Impl.hpp
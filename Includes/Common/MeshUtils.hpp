@@ -0,0 +1,194 @@
+#ifndef MESH_UTILS_HPP
+#define MESH_UTILS_HPP
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+namespace Common
+{
+/**
+ * @brief Vertex attributes of a single face corner used for welding.
+ */
+struct PackedVertex
+{
+    glm::vec3 position{ 0.0f };
+    glm::vec2 texCoord{ 0.0f };
+    glm::vec3 normal{ 0.0f };
+};
+
+/**
+ * @brief Collection of mesh processing helper functions.
+ */
+class MeshUtils
+{
+ public:
+    /**
+     * @brief Calculate the geometric normal of the triangle.
+     * @param v1 first vertex position of the triangle
+     * @param v2 second vertex position of the triangle
+     * @param v3 third vertex position of the triangle
+     * @return glm::vec3 normalized face normal, zero vector for degenerate
+     * triangle
+     */
+    static glm::vec3 CalculateFaceNormal(const glm::vec3& v1,
+                                         const glm::vec3& v2,
+                                         const glm::vec3& v3);
+
+    /**
+     * @brief Generate area weighted vertex normals of the triangle list.
+     * @details Unnormalized face normals are computed in structure of arrays
+     * batches (AVX2, SSE2 or scalar), then each vertex gathers the normals of
+     * its adjacent triangles through the vertex-triangle adjacency. Both
+     * passes run in parallel without scattered writes, so the result does not
+     * depend on the number of threads.
+     * @param indices triangle list indices
+     * @param indexCount number of indices, multiple of three
+     * @param positions vertex positions referenced by the indices
+     * @param vertexCount number of vertices
+     * @param normals returns normalized vertex normals, zero for vertices not
+     * referenced by any triangle
+     */
+    static void GenerateNormals(const unsigned int* indices, size_t indexCount,
+                                const glm::vec3* positions, size_t vertexCount,
+                                glm::vec3* normals);
+
+    /**
+     * @brief Generate vertex tangents of the triangle list following the
+     * MikkTSpace conventions.
+     * @details Each triangle contributes its normalized, orientation signed
+     * texture space tangent projected onto the tangent plane of the vertex
+     * and weighted by the corner angle. The handedness in w is the angle
+     * weighted orientation of the texture mapping. Unlike MikkTSpace, vertices
+     * are never split, so vertices shared by mirrored triangles get the
+     * dominant orientation. Vertices without valid texture mapping get an
+     * arbitrary tangent perpendicular to the normal.
+     * @param indices triangle list indices
+     * @param indexCount number of indices, multiple of three
+     * @param positions vertex positions referenced by the indices
+     * @param normals normalized vertex normals
+     * @param texCoords vertex texture coordinates, nullptr if not available
+     * @param vertexCount number of vertices
+     * @param tangents returns vertex tangents with handedness in w
+     */
+    static void GenerateTangents(const unsigned int* indices,
+                                 size_t indexCount, const glm::vec3* positions,
+                                 const glm::vec3* normals,
+                                 const glm::vec2* texCoords,
+                                 size_t vertexCount, glm::vec4* tangents);
+
+    /**
+     * @brief Weld vertices which have same quantized attributes.
+     * @details Each attribute is snapped into the grid of its own tolerance
+     * (position 1e-3, texture coordinates 1e-1, normal 3e-1) and vertices are
+     * deduplicated with open-addressing hash tables. Vertices are scattered
+     * into partitions by key hash, so each worker thread welds only the
+     * vertices of its partition.
+     * Unique vertices are numbered in order of first occurrence, result is
+     * deterministic regardless of the number of threads.
+     * @param vertices packed vertices to be welded, usually one per face corner
+     * @param remap returns index of welded vertex for each input vertex
+     * @param uniques returns index of the first input vertex for each welded
+     * vertex
+     * @return size_t the number of welded(unique) vertices
+     */
+    static size_t WeldVertices(const std::vector<PackedVertex>& vertices,
+                               std::vector<unsigned int>& remap,
+                               std::vector<unsigned int>& uniques);
+
+    /**
+     * @brief Calculate average cache miss ratio(ACMR) of the triangle list
+     * with simulated FIFO post-transform vertex cache.
+     * @param indices triangle list indices
+     * @param indexCount number of indices, multiple of three
+     * @param vertexCount number of vertices referenced by the indices
+     * @param cacheSize number of entries of the simulated cache
+     * @return float the number of transformed vertices per triangle
+     */
+    [[nodiscard]] static float CalculateACMR(const unsigned int* indices,
+                                             size_t indexCount,
+                                             size_t vertexCount,
+                                             size_t cacheSize = 16);
+
+    /**
+     * @brief Reorder triangles for post-transform vertex cache locality.
+     * @details Implementation of Tom Forsyth's "Linear-Speed Vertex Cache
+     * Optimisation". Triangles are greedily emitted by the score of their
+     * vertices computed from the position in the simulated LRU cache and the
+     * number of remaining triangles.
+     * @param indices triangle list indices, reordered in-place
+     * @param indexCount number of indices, multiple of three
+     * @param vertexCount number of vertices referenced by the indices
+     */
+    static void OptimizeVertexCache(unsigned int* indices, size_t indexCount,
+                                    size_t vertexCount);
+
+    /**
+     * @brief Reorder clusters of triangles to reduce overdraw.
+     * @details Cache optimized triangle list is split into clusters where
+     * splitting does not hurt ACMR more than threshold, then clusters are
+     * sorted so the outward facing clusters are drawn first (Tipsify style).
+     * Should be called after OptimizeVertexCache.
+     * @param indices triangle list indices, reordered in-place
+     * @param indexCount number of indices, multiple of three
+     * @param positions vertex positions referenced by the indices
+     * @param vertexCount number of vertices
+     * @param threshold allowed ACMR degradation factor, ex. 1.05
+     */
+    static void OptimizeOverdraw(unsigned int* indices, size_t indexCount,
+                                 const glm::vec3* positions,
+                                 size_t vertexCount, float threshold = 1.05f);
+
+    /**
+     * @brief Generate vertex remap table in order of first use by the indices
+     * and rewrite indices with it. Vertices never referenced are moved to the
+     * end of the vertex range.
+     * @param indices triangle list indices, remapped in-place
+     * @param indexCount number of indices
+     * @param vertexCount number of vertices
+     * @param remap returns new position of each old vertex
+     */
+    static void OptimizeVertexFetch(unsigned int* indices, size_t indexCount,
+                                    size_t vertexCount,
+                                    std::vector<unsigned int>& remap);
+
+    /**
+     * @brief Simplify the triangle list with quadric error metric edge
+     * collapses.
+     * @details Edges are collapsed onto one of their existing vertices, so the
+     * result indexes the same vertex buffer and can be stored as another
+     * index range of the same primitive. Vertices on the open border,
+     * non-manifold edges and attribute seams (vertices sharing the same
+     * position) are locked.
+     * @param indices triangle list indices
+     * @param indexCount number of indices, multiple of three
+     * @param positions vertex positions referenced by the indices
+     * @param vertexCount number of vertices
+     * @param targetIndexCount desired number of indices of the result
+     * @param targetError maximum allowed distance error in position units
+     * @param result returns simplified triangle list indices
+     * @return float distance error of the result in position units
+     */
+    static float SimplifyMesh(const unsigned int* indices, size_t indexCount,
+                              const glm::vec3* positions, size_t vertexCount,
+                              size_t targetIndexCount, float targetError,
+                              std::vector<unsigned int>& result);
+
+    /**
+     * @brief Reorder vertex attribute stream with the remap table generated
+     * by OptimizeVertexFetch.
+     * @tparam Type vertex attribute type
+     * @param stream vertex attribute array, reordered in-place
+     * @param remap new position of each old vertex
+     */
+    template <typename Type>
+    static void RemapVertexStream(Type* stream,
+                                  const std::vector<unsigned int>& remap);
+};
+
+}  // namespace Common
+
+#include <Common/MeshUtils-Impl.hpp>
+
+#endif  //! end of MeshUtils.hpp
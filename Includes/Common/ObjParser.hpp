@@ -0,0 +1,38 @@
+#ifndef OBJ_PARSER_HPP
+#define OBJ_PARSER_HPP
+
+#include <Common/MeshUtils.hpp>
+#include <vector>
+
+namespace Common
+{
+/**
+ * @brief Multi-threaded parser for the wavefront obj geometry records.
+ * @details Only v, vt, vn and f records are parsed, other records (groups,
+ * materials, smoothing groups, ...) are skipped. Input is split into
+ * line-aligned chunks which are parsed by the global thread pool in two passes.
+ * The first pass counts the records of each chunk and the prefix sum of the
+ * counts gives the output offset of each chunk, so the second pass writes
+ * directly into the shared arrays and resolves relative(negative) indices
+ * without any synchronization. Numbers are parsed without locale.
+ */
+class ObjParser
+{
+ public:
+    /**
+     * @brief Parse the obj text and returns triangulated face corners.
+     * Polygons are fan-triangulated, texture coordinates are flipped
+     * vertically and faces without normal get the geometric face normal.
+     * @param data pointer to the obj text, not necessarily null-terminated
+     * @param size size of the obj text in bytes
+     * @param corners returns three packed vertices per triangle
+     * @return true if parsing success
+     * @return false if the text has malformed or unsupported records
+     */
+    static bool Parse(const char* data, size_t size,
+                      std::vector<PackedVertex>& corners);
+};
+
+};  // namespace Common
+
+#endif  //! end of ObjParser.hpp
@@ -0,0 +1,108 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Common
+{
+/**
+ * @brief Queue of draws ordered by 64-bit sort keys.
+ * @details Keys are composed by MakeSortKey so that sorting them groups the
+ * draws by pass and alpha mode first. Opaque and masked draws are then
+ * grouped by shader, material and mesh and ordered front-to-back, blended
+ * draws are ordered back-to-front before their states.
+ */
+class RenderQueue
+{
+ public:
+    //! Sort key and the index of the draw it was built for
+    struct Item
+    {
+        std::uint64_t key;
+        std::uint32_t payload;
+    };
+
+    /**
+     * @brief Build the sort key of a draw.
+     * @details Layout from the most significant bit is pass(4), alphaMode(2)
+     * and then shader(8), material(16), mesh(10), depth(24) for the opaque
+     * and masked draws, or inverted depth(24), shader(8), material(16),
+     * mesh(10) for the blended draws. Fields wider than their bits are
+     * truncated, which only merges the draws of different meshes or
+     * materials that share the truncated bits.
+     * @param pass index of the render pass, the lower passes come first
+     * @param alphaMode 0 : OPAQUE, 1 : MASK, 2 : BLEND
+     * @param shader index of the shader variant
+     * @param material material index, -1 for the default material
+     * @param mesh index of the mesh
+     * @param depth non-negative view distance of the draw
+     * @return std::uint64_t key of the draw
+     */
+    [[nodiscard]] static std::uint64_t MakeSortKey(unsigned int pass,
+                                                   int alphaMode,
+                                                   unsigned int shader,
+                                                   int material,
+                                                   unsigned int mesh,
+                                                   float depth);
+
+    /**
+     * @brief Returns the alpha mode field of the key.
+     * @param key key built by MakeSortKey
+     * @return int 0 : OPAQUE, 1 : MASK, 2 : BLEND
+     */
+    [[nodiscard]] static int GetAlphaMode(std::uint64_t key);
+
+    /**
+     * @brief Returns the shader field of the key.
+     * @param key key built by MakeSortKey
+     * @return unsigned int truncated index of the shader variant
+     */
+    [[nodiscard]] static unsigned int GetShader(std::uint64_t key);
+
+    /**
+     * @brief Returns the shader and material fields of the key, consecutive
+     * draws with different states need the state change.
+     * @param key key built by MakeSortKey
+     * @return std::uint32_t shader bits above the material bits
+     */
+    [[nodiscard]] static std::uint32_t GetState(std::uint64_t key);
+
+    /**
+     * @brief Remove all queued draws, the storages are kept for reuse.
+     */
+    void Clear();
+
+    /**
+     * @brief Add a draw to the queue.
+     * @param key sort key of the draw
+     * @param payload index of the draw returned with the sorted items
+     */
+    void Push(std::uint64_t key, std::uint32_t payload);
+
+    /**
+     * @brief Sort the queued draws by their keys with LSD radix sort.
+     * @details Eight passes of 8-bit digits sort the keys in linear time and
+     * keep the push order of the equal keys. Histograms of all digits are
+     * counted in one sweep, and digits equal in every key are skipped.
+     */
+    void Sort();
+
+    /**
+     * @brief Returns the queued draws, ordered by key after Sort.
+     * @return const std::vector<Item>& queued draws
+     */
+    [[nodiscard]] const std::vector<Item>& GetItems() const
+    {
+        return _items;
+    }
+
+ private:
+    std::vector<Item> _items;
+    std::vector<Item> _scratch;
+};
+
+}  // namespace Common
+
+#endif  //! end of RenderQueue.hpp
@@ -0,0 +1,144 @@
+#ifndef SHADER_SOURCE_CACHE_HPP
+#define SHADER_SOURCE_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Common
+{
+/**
+ * @brief Memoized GLSL preprocessor expanding #include directives.
+ * @details Each file is read and split at its #include lines only once.
+ * Expanded sources are kept per root file and define set, so the shaders
+ * sharing the same headers never touch the disk again. Files containing
+ * #pragma once are expanded once per source, and the defines are injected
+ * after the #version line. Refresh re-reads the files and drops only the
+ * sources depending on the changed ones. Cache is not thread-safe and is
+ * used from the thread owning the GL context.
+ */
+class ShaderSourceCache
+{
+ public:
+    //! Pairs of macro name and its value injected as #define
+    using Defines = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+     * @brief Returns the source of the file with the includes expanded.
+     * @details Included paths are relative to the directory of the including
+     * file, written as `#include name`, `#include "name"` or
+     * `#include <name>`.
+     * @param path path of the root shader file
+     * @param defines macros injected after the #version line
+     * @return const std::string& expanded source, valid until the next
+     * Refresh or Clear
+     */
+    [[nodiscard]] const std::string& GetSource(const std::string& path,
+                                               const Defines& defines = {});
+
+    /**
+     * @brief Check whether the expanded source is cached, the source dropped
+     * by Refresh must be reprocessed.
+     * @param path path of the root shader file
+     * @param defines macros of the source
+     * @return true if the source is cached
+     */
+    [[nodiscard]] bool Contains(const std::string& path,
+                                const Defines& defines = {}) const;
+
+    /**
+     * @brief Returns the files included by the expanded source, including
+     * the root file itself.
+     * @param path path of the root shader file
+     * @param defines macros of the source
+     * @return std::vector<std::string> dependencies of the source, empty if
+     * the source is not cached
+     */
+    [[nodiscard]] std::vector<std::string> GetDependencies(
+        const std::string& path, const Defines& defines = {}) const;
+
+    /**
+     * @brief Re-read the cached files and drop the expanded sources depending
+     * on the changed files.
+     * @return std::vector<std::string> root paths of the dropped sources,
+     * programs built from them need to be reprocessed
+     */
+    std::vector<std::string> Refresh();
+
+    /**
+     * @brief Remove all cached files and sources.
+     */
+    void Clear();
+
+    /**
+     * @brief Returns the process-wide cache shared by all shaders.
+     * @return ShaderSourceCache& lazily created global cache
+     */
+    [[nodiscard]] static ShaderSourceCache& GetGlobalCache();
+
+ private:
+    //! Text of the file up to the include directive, and the normalized path
+    //! of the included file or empty for the last segment
+    struct Segment
+    {
+        std::string text;
+        std::string include;
+    };
+
+    struct SourceFile
+    {
+        std::vector<Segment> segments;
+        std::uint64_t hash{ 0 };
+        bool pragmaOnce{ false };
+    };
+
+    struct ExpandedSource
+    {
+        std::string root;
+        std::string contents;
+        std::vector<std::string> dependencies;
+    };
+
+    /**
+     * @brief Returns the parsed file, loaded from the disk on the first use.
+     * @param path normalized path of the file
+     * @return const SourceFile* parsed file, nullptr if it cannot be read
+     */
+    const SourceFile* LoadFile(const std::string& path);
+
+    /**
+     * @brief Append the file with its includes expanded.
+     * @param path normalized path of the file
+     * @param included files already expanded into the source
+     * @param stack files being expanded, for detecting the recursion
+     * @param source output source
+     * @param dependencies output files of the source
+     * @return true if the file and all its includes are expanded
+     */
+    bool Expand(const std::string& path,
+                std::unordered_set<std::string>& included,
+                std::vector<std::string>& stack, std::string& source,
+                std::vector<std::string>& dependencies);
+
+    /**
+     * @brief Returns the key of the expanded source.
+     * @param path normalized path of the root file
+     * @param defines macros of the source
+     * @return std::string root path followed by the defines
+     */
+    [[nodiscard]] static std::string MakeSourceKey(const std::string& path,
+                                                   const Defines& defines);
+
+    std::unordered_map<std::string, SourceFile> _files;
+    std::unordered_map<std::string, ExpandedSource> _sources;
+    //! Keys of the expanded sources each file is included in
+    std::unordered_map<std::string, std::unordered_set<std::string>>
+        _dependents;
+};
+
+}  // namespace Common
+
+#endif  //! end of ShaderSourceCache.hpp
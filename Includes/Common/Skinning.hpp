@@ -0,0 +1,41 @@
+#ifndef SKINNING_HPP
+#define SKINNING_HPP
+
+#include <cstddef>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+namespace Common
+{
+/**
+ * @brief Joint influences of a single vertex, laid out for std430 shader
+ * storage buffer. Joints index the joint matrix palette of the skin.
+ */
+struct SkinVertex
+{
+    glm::uvec4 joints{ 0 };
+    glm::vec4 weights{ 0.0f };
+};
+
+/**
+ * @brief Apply linear blend skinning to the vertices on CPU.
+ * @details Reference implementation of the skinning done by vertex.glsl and
+ * skin_vertices.comp, used for validation and benchmarks. The four joint
+ * matrices of each vertex are blended with AVX2 or SSE2 when available and
+ * normals are transformed by the upper 3x3 part of the blended matrix.
+ * @param positions rest positions of the vertices
+ * @param normals rest normals of the vertices, nullptr to skip normals
+ * @param skinVertices joint influences of the vertices
+ * @param jointMatrices joint matrix palette indexed by the joints
+ * @param count number of the vertices
+ * @param skinnedPositions returns skinned positions
+ * @param skinnedNormals returns skinned normals, unused without normals
+ */
+void SkinVertices(const glm::vec3* positions, const glm::vec3* normals,
+                  const SkinVertex* skinVertices,
+                  const glm::mat4* jointMatrices, size_t count,
+                  glm::vec3* skinnedPositions, glm::vec3* skinnedNormals);
+};  // namespace Common
+
+#endif  //! end of Skinning.hpp
@@ -0,0 +1,139 @@
+#ifndef TEXTURE_COMPRESSOR_HPP
+#define TEXTURE_COMPRESSOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Common
+{
+/**
+ * @brief Usage of the texture in the materials, decides the block format.
+ */
+enum class TextureRole : std::uint32_t
+{
+    Unknown = 0,
+    BaseColor,
+    Normal,
+    MetallicRoughness,
+    Occlusion,
+    Emissive
+};
+
+/**
+ * @brief Block compressed formats produced by TextureCompressor.
+ */
+enum class BlockFormat : std::uint32_t
+{
+    BC1 = 0,  //! RGB 5:6:5 endpoints with 2-bit indices, 8 bytes per block
+    BC3,      //! BC1 color with separate 8-bit alpha block, 16 bytes
+    BC5,      //! two independent 8-bit channel blocks, 16 bytes
+    BC7       //! mode 6 RGBA 7.1 endpoints with 4-bit indices, 16 bytes
+};
+
+/**
+ * @brief Block compressed texture with the full mipmap chain.
+ */
+struct CompressedTexture
+{
+    struct Level
+    {
+        std::uint32_t width{ 0 };
+        std::uint32_t height{ 0 };
+        std::uint64_t offset{ 0 };
+        std::uint64_t size{ 0 };
+    };
+
+    BlockFormat format{ BlockFormat::BC7 };
+    std::uint32_t width{ 0 };
+    std::uint32_t height{ 0 };
+    std::vector<Level> levels;
+    std::vector<unsigned char> data;
+};
+
+/**
+ * @brief CPU block compression encoder for texture images.
+ * @details Encodes RGBA8 images into BC1, BC3, BC5 and BC7 (mode 6) blocks.
+ * Mipmaps are generated on CPU with box filter before the compression, so the
+ * result can be uploaded without glGenerateTextureMipmap. Block rows are
+ * encoded in parallel on the global thread pool and the palette index search
+ * is vectorized with SSE2 when available.
+ */
+class TextureCompressor
+{
+ public:
+    /**
+     * @brief Returns the block format fitting the usage of the texture.
+     * @details Base color uses BC7, or BC3 when the alpha channel is used
+     * because mode 6 shares the endpoints between color and alpha. Normal maps
+     * use two channel BC5 and the shader reconstructs Z. Metallic-roughness
+     * uses BC7, occlusion and emissive use BC1.
+     * @param role usage of the texture in the materials
+     * @param pixels RGBA8 pixels of the base level
+     * @param width width of the base level
+     * @param height height of the base level
+     * @return BlockFormat format chosen for the texture
+     */
+    [[nodiscard]] static BlockFormat ChooseFormat(TextureRole role,
+                                                  const unsigned char* pixels,
+                                                  size_t width, size_t height);
+
+    /**
+     * @brief Generate the mipmap chain of the image and compress all levels.
+     * @param pixels RGBA8 pixels of the base level
+     * @param width width of the base level
+     * @param height height of the base level
+     * @param format block format of the result
+     * @param role usage of the texture, normal maps are renormalized in mips
+     * @param result returns compressed levels, finest level first
+     */
+    static void Compress(const unsigned char* pixels, size_t width,
+                         size_t height, BlockFormat format, TextureRole role,
+                         CompressedTexture& result);
+
+    /**
+     * @brief Returns the size of one 4x4 block of the format in bytes.
+     * @param format block compressed format
+     * @return size_t 8 for BC1, otherwise 16
+     */
+    [[nodiscard]] static size_t GetBlockSize(BlockFormat format);
+
+    /**
+     * @brief Returns the cache file path of the compressed texture.
+     * @param directory existing directory where cache files are stored
+     * @param pixels RGBA8 pixels of the base level, hashed into the key
+     * @param width width of the base level
+     * @param height height of the base level
+     * @param role usage of the texture
+     * @return std::string path of the KTX2 cache file
+     */
+    [[nodiscard]] static std::string GetCachePath(const std::string& directory,
+                                                  const unsigned char* pixels,
+                                                  size_t width, size_t height,
+                                                  TextureRole role);
+
+    /**
+     * @brief Write the compressed texture into the KTX2 container file.
+     * @param path destination file path
+     * @param texture compressed texture to be written
+     * @return true if the file is written
+     * @return false if the file cannot be written
+     */
+    static bool SaveKTX2(const std::string& path,
+                         const CompressedTexture& texture);
+
+    /**
+     * @brief Read the compressed texture from the KTX2 container file written
+     * by SaveKTX2.
+     * @param path source file path
+     * @param texture returns the compressed texture
+     * @return true if valid file is loaded
+     * @return false if file is missing, corrupted or has unsupported format
+     */
+    static bool LoadKTX2(const std::string& path, CompressedTexture& texture);
+};
+
+}  // namespace Common
+
+#endif  //! end of TextureCompressor.hpp
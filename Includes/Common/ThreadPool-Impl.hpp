@@ -0,0 +1,116 @@
+#ifndef THREAD_POOL_IMPL_HPP
+#define THREAD_POOL_IMPL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+namespace Common
+{
+template <typename Func>
+std::future<std::invoke_result_t<std::decay_t<Func>>> ThreadPool::Submit(
+    Func&& func)
+{
+    using ReturnType = std::invoke_result_t<std::decay_t<Func>>;
+
+    //! std::function requires copyable callable, wrap packaged_task with
+    //! shared pointer.
+    auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+        std::forward<Func>(func));
+    std::future<ReturnType> future = task->get_future();
+
+    //! Without worker threads, execute the task immediately.
+    if (_workers.empty())
+    {
+        (*task)();
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.emplace_back([task]() { (*task)(); });
+    }
+    _condition.notify_one();
+
+    return future;
+}
+
+template <typename Type>
+Type ThreadPool::Wait(std::future<Type>& future)
+{
+    while (future.wait_for(std::chrono::seconds(0)) !=
+           std::future_status::ready)
+    {
+        //! Help the workers instead of sleeping, nested tasks might be
+        //! waiting in the queue behind this one. With the queue empty, the
+        //! task is already running on a worker, so block until it finishes.
+        if (!RunPendingTask())
+        {
+            future.wait();
+            break;
+        }
+    }
+
+    return future.get();
+}
+
+template <typename Func>
+void ThreadPool::ParallelForRange(size_t begin, size_t end, const Func& func,
+                                  size_t grainSize)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    const size_t count = end - begin;
+    grainSize = std::max<size_t>(grainSize, 1);
+
+    //! Over-decompose a little for better load balancing.
+    const size_t maxChunks = std::max<size_t>(GetNumThreads(), 1) * 4;
+    const size_t numChunks =
+        std::min(maxChunks, (count + grainSize - 1) / grainSize);
+    if (numChunks <= 1)
+    {
+        func(begin, end);
+        return;
+    }
+
+    const size_t chunkSize = (count + numChunks - 1) / numChunks;
+    std::vector<std::future<void>> futures;
+    futures.reserve(numChunks);
+    for (size_t chunkBegin = begin + chunkSize; chunkBegin < end;
+         chunkBegin += chunkSize)
+    {
+        const size_t chunkEnd = std::min(chunkBegin + chunkSize, end);
+        futures.emplace_back(
+            Submit([&func, chunkBegin, chunkEnd]() { func(chunkBegin, chunkEnd); }));
+    }
+
+    //! The calling thread processes the first chunk by itself.
+    func(begin, std::min(begin + chunkSize, end));
+
+    for (auto& future : futures)
+    {
+        Wait(future);
+    }
+}
+
+template <typename Func>
+void ThreadPool::ParallelFor(size_t begin, size_t end, const Func& func,
+                             size_t grainSize)
+{
+    ParallelForRange(
+        begin, end,
+        [&func](size_t chunkBegin, size_t chunkEnd) {
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                func(i);
+            }
+        },
+        grainSize);
+}
+
+}  // namespace Common
+
+#endif  //! end of ThreadPool-Impl.hpp
@@ -0,0 +1,121 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Common
+{
+/**
+ * @brief Fixed-size worker thread pool for CPU side asset processing.
+ * @details Tasks are pushed into single shared queue and executed by worker
+ * threads in FIFO order. Threads waiting on the result of the pool (Wait,
+ * ParallelFor) execute pending tasks while waiting, therefore nested parallel
+ * calls from inside of tasks never dead-lock the pool.
+ */
+class ThreadPool
+{
+ public:
+    /**
+     * @brief Construct a new Thread Pool object
+     * @param numThreads number of worker threads to be spawned.
+     * zero means std::thread::hardware_concurrency()
+     */
+    explicit ThreadPool(size_t numThreads = 0);
+
+    /**
+     * @brief Destroy the Thread Pool object. Remained tasks are executed
+     * before worker threads are joined.
+     */
+    ~ThreadPool();
+
+    //! Thread pool is not copyable nor movable.
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Push the given task into the queue
+     * @tparam Func callable type without arguments
+     * @param func task to be executed in the worker thread
+     * @return std::future to the return value of the given task
+     */
+    template <typename Func>
+    [[nodiscard]] std::future<std::invoke_result_t<std::decay_t<Func>>> Submit(
+        Func&& func);
+
+    /**
+     * @brief Block until the given future is ready. Pending tasks of the pool
+     * are executed by this thread while waiting.
+     * @tparam Type return type of the future
+     * @param future future returned from Submit
+     * @return Type result of the task
+     */
+    template <typename Type>
+    Type Wait(std::future<Type>& future);
+
+    /**
+     * @brief Split [begin, end) into contiguous chunks and call func(chunkBegin,
+     * chunkEnd) for each chunk in parallel. Returns after all chunks finished.
+     * @tparam Func callable type with (size_t, size_t) signature
+     * @param begin first index of the range
+     * @param end one past the last index of the range
+     * @param func function called with each sub-range
+     * @param grainSize minimum number of elements in one chunk
+     */
+    template <typename Func>
+    void ParallelForRange(size_t begin, size_t end, const Func& func,
+                          size_t grainSize = 1024);
+
+    /**
+     * @brief Call func(i) for each index in [begin, end) in parallel.
+     * @tparam Func callable type with (size_t) signature
+     * @param begin first index of the range
+     * @param end one past the last index of the range
+     * @param func function called with each index
+     * @param grainSize minimum number of indices processed in one task
+     */
+    template <typename Func>
+    void ParallelFor(size_t begin, size_t end, const Func& func,
+                     size_t grainSize = 1);
+
+    /**
+     * @brief Returns the number of worker threads
+     * @return size_t number of spawned worker threads
+     */
+    [[nodiscard]] size_t GetNumThreads() const;
+
+    /**
+     * @brief Returns the process-wide thread pool shared by asset loaders.
+     * @return ThreadPool& lazily created global thread pool
+     */
+    [[nodiscard]] static ThreadPool& GetGlobalPool();
+
+ private:
+    /**
+     * @brief Pop one pending task from the queue and execute it.
+     * @return true if a task was executed
+     * @return false if the queue was empty
+     */
+    bool RunPendingTask();
+
+    //! Main loop of the worker threads
+    void WorkerLoop();
+
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stop{ false };
+};
+
+}  // namespace Common
+
+#include <Common/ThreadPool-Impl.hpp>
+
+#endif  //! end of ThreadPool.hpp
@@ -1,6 +1,7 @@
 #ifndef CAMERA_HPP
 #define CAMERA_HPP
 
+#include <Common/Culling.hpp>
 #include <GL3/DebugUtils.hpp>
 #include <GL3/GLTypes.hpp>
 #include <glm/mat4x4.hpp>
@@ -57,6 +58,13 @@ class Camera
      */
     [[nodiscard]] glm::mat4 GetProjectionMatrix();
 
+    /**
+     * @brief Returns the view frustum planes in world space, extracted from
+     * the matrices by the last UpdateMatrix call.
+     * @return Common::Frustum frustum of the camera
+     */
+    [[nodiscard]] const Common::Frustum& GetFrustum() const;
+
     /**
      * @brief Bind the uniform buffer to the current context.
      * @param bindingPoint UBO binding point for camera in current bound shader
@@ -102,6 +110,7 @@ class Camera
     virtual void OnUpdateMatrix(){};
     glm::mat4 _projection, _view;
     glm::vec3 _position, _direction, _up;
+    Common::Frustum _frustum;
 
  private:
     std::unordered_map<std::string, GLint> _uniformCache;
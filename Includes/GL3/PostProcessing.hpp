@@ -30,12 +30,20 @@ class PostProcessing
     ~PostProcessing();
 
     /**
-     * @brief Initialize the fbo and shader resources
+     * @brief Initialize the fbo and submit the shader for compiling, the
+     * shader is finished by WaitShader.
      * @return true if framebuffer and shader init success
      * @return false if framebuffer and shader init failed
      */
     bool Initialize();
 
+    /**
+     * @brief Wait for the shader submitted by Initialize and set its
+     * uniforms, must be called before Render.
+     * @return true if the shader is compiled and linked
+     */
+    bool WaitShader();
+
     /**
      * @brief Rendering the post-processed screen image
      */
@@ -61,6 +69,15 @@ class PostProcessing
         return _fbo;
     }
 
+    /**
+     * @brief Returns the depth attachment of the framebuffer
+     * @return GLuint opengl resource ID of depth texture
+     */
+    [[nodiscard]] inline GLuint GetDepthTexture() const
+    {
+        return _depth;
+    }
+
  protected:
  private:
     GLuint _fbo;
@@ -1,11 +1,15 @@
 #ifndef SCENE_HPP
 #define SCENE_HPP
 
+#include <Common/Culling.hpp>
 #include <Common/GLTFScene.hpp>
+#include <Common/RenderQueue.hpp>
 #include <Common/Vertex.hpp>
 #include <GL3/DebugUtils.hpp>
 #include <GL3/GLTypes.hpp>
+#include <cstdint>
 #include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
 #include <memory>
 #include <string>
 #include <vector>
@@ -23,6 +27,29 @@ class Scene : public Common::GLTFScene
     //! Scene node matrix type definition with pair of glm::mat4.
     using NodeMatrix = std::pair<glm::mat4, glm::mat4>;
 
+    //! Skinning path of the skinned primitives
+    enum class SkinningMode
+    {
+        VertexShader = 0,  //! blend the joint matrices in every draw
+        Compute            //! pre-skin once per update with compute shader
+    };
+
+    //! Where the instances are culled and the draw commands are built
+    enum class CullingMode
+    {
+        CPU = 0,  //! update the commands on CPU when the view is changed
+        GPU       //! cull and compact the commands with compute shaders
+    };
+
+    //! Statistics of the last update of the draw commands
+    struct RenderStats
+    {
+        size_t numDraws{ 0 };          //! commands with any instance
+        size_t visibleInstances{ 0 };  //! primitive instances to be drawn
+        size_t culledInstances{ 0 };   //! primitive instances outside view
+        size_t stateChanges{ 0 };      //! material or shader changes
+    };
+
     /**
      * @brief Construct a new Scene object
      */
@@ -42,6 +69,124 @@ class Scene : public Common::GLTFScene
      */
     bool Initialize(const std::string& filename, Common::VertexFormat format);
     
+    /**
+     * @brief Upload vertex attributes in quantized form, must be called before
+     * Initialize. Positions are stored in 16-bit snorm relative to the bounding
+     * box of each primitive, normals and tangents in 10-10-10-2 snorm, colors
+     * in 8-bit unorm and texture coordinates in half float. Dequantization of
+     * positions is passed with the per-draw data of the primitive.
+     * @param enabled true for quantized vertex attributes
+     */
+    void SetVertexQuantization(bool enabled);
+
+    /**
+     * @brief Upload the scene textures block compressed, must be called before
+     * Initialize. Textures are encoded on CPU with the full mipmap chain in
+     * the format fitting their material usage, and the result is stored in
+     * the cache directory as KTX2 files when SetCacheDirectory is enabled.
+     * Falls back to uncompressed textures when the formats are not supported.
+     * @param enabled true for block compressed textures
+     */
+    void SetTextureCompression(bool enabled);
+
+    /**
+     * @brief Select how the materials reference the scene textures, must be
+     * called before Initialize. With bindless textures the material buffer
+     * holds the resident handles of GL_ARB_bindless_texture. Otherwise, or
+     * when the extension is not supported, textures of the same size and
+     * format are copied into the layers of a texture array and the materials
+     * hold the array index and layer, the arrays used by the materials of a
+     * draw group are bound once per group. Render binds no texture per
+     * texture either way. Bindless textures are used by default.
+     * @param enabled true for bindless textures
+     */
+    void SetBindlessTextures(bool enabled);
+
+    /**
+     * @brief Select the skinning path, must be called before Initialize.
+     * With the vertex shader path vertex.glsl blends the joint matrices of
+     * each vertex in every draw. With the compute path the skinned positions
+     * and normals are written to a buffer once per animation update, so the
+     * passes drawing the scene several times do not skin again. Compute path
+     * is used by default.
+     * @param mode skinning path of the skinned primitives
+     */
+    void SetSkinningMode(SkinningMode mode);
+
+    /**
+     * @brief Select the culling path, must be called before Initialize.
+     * With the GPU path the instances are culled with the frustum and the
+     * depth pyramid of UpdateDepthPyramid, the levels of detail are selected
+     * and the surviving draws are compacted by compute shaders every Render,
+     * and drawn with glMultiDrawElementsIndirectCount. Blended primitives
+     * keep the back-to-front order of the CPU path. Falls back to the CPU
+     * path when GL_ARB_indirect_parameters is not supported. CPU path is used
+     * by default.
+     * @param mode culling path of the scene instances
+     */
+    void SetCullingMode(CullingMode mode);
+
+    /**
+     * @brief Build the hierarchical depth pyramid for the occlusion culling
+     * of the GPU path from the depth of the last frame. Must be called after
+     * the frame is drawn and before the depth is cleared, instances hidden
+     * behind the last frame depth are not drawn in the next Render.
+     * @param depthTexture depth attachment of the drawn frame
+     * @param viewProjection view projection matrix the frame is drawn with
+     */
+    void UpdateDepthPyramid(GLuint depthTexture,
+                            const glm::mat4& viewProjection);
+
+    /**
+     * @brief Set the view the draws are ordered from in Render, opaque and
+     * masked draws front-to-back and blended draws back-to-front. Does not
+     * enable the level of detail selection. Without the view, the distances
+     * are measured from the world origin.
+     * @param view view matrix of the camera
+     */
+    void SetView(const glm::mat4& view);
+
+    /**
+     * @brief Set the view used for selecting the level of detail of each
+     * primitive in Render, the draws are ordered from the view as with
+     * SetView. Without the view, the finest level is drawn.
+     * @param view view matrix of the camera
+     * @param projection perspective projection matrix of the camera
+     * @param viewportHeight height of the viewport in pixels
+     */
+    void SetLODView(const glm::mat4& view, const glm::mat4& projection,
+                    float viewportHeight);
+
+    /**
+     * @brief Set the maximum screen space error of the selected level of
+     * detail.
+     * @param pixels allowed projected simplification error in pixels
+     */
+    void SetLODThreshold(float pixels);
+
+    /**
+     * @brief Set the view frustum and enable the frustum culling. Primitive
+     * instances whose world space bounding box is outside of the frustum are
+     * not drawn by Render.
+     * @param frustum frustum planes of the camera in world space
+     */
+    void SetFrustum(const Common::Frustum& frustum);
+
+    /**
+     * @brief Enable or disable the frustum culling, disabled by default.
+     * @param enabled true for culling with the frustum of SetFrustum
+     */
+    void SetFrustumCulling(bool enabled);
+
+    /**
+     * @brief Returns the number of the draws and the visible and culled
+     * instances of the last Render and the number of the material or
+     * shader changes between its consecutive draws. The GPU culling path
+     * counts the blended draws only.
+     * @return const RenderStats& statistics of the draw commands
+     */
+    [[nodiscard]] const RenderStats& GetRenderStats() const;
+
     /**
      * @brief Update the scene for animating
      * @param dt delta time in microseconds
@@ -50,10 +195,27 @@ class Scene : public Common::GLTFScene
 
     /**
      * @brief Render the whole nodes of the parsed gltf-scene
+     * @details Primitives of the given alpha mode are drawn with one
+     * glMultiDrawElementsIndirect call per shader variant, the variant of
+     * the material features from Shader::GetVariant when the shader has the
+     * variant defines. Every draw of the indirect buffer covers the
+     * instances of a primitive at one level of detail, vertex.glsl reads the
+     * per-draw data of the command slot of drawBase + gl_DrawID and the
+     * matrix index of each instance at gl_BaseInstance + gl_InstanceID of
+     * the instance buffer. Draws are ordered by the sort keys of the render
+     * queue, opaque and masked draws grouped by shader variant and material
+     * and front-to-back,
+     * blended draws and their instances back-to-front. The GPU culling path
+     * compacts the opaque and masked commands and draws them with
+     * glMultiDrawElementsIndirectCount instead, without the depth order,
+     * and sorts the blended draws as the CPU path does. The blending and depth states of the
+     * alpha mode are set by the caller, and the shader is bound again when
+     * Render returns.
      * @param shader shader for gltf scene nodes rendering(must support pbr pipeline)
-     * @param alphaMode alphaMode flag for blending
+     * @param alphaMode alpha mode of the materials to be drawn, 0 : OPAQUE,
+     * 1 : MASK, 2 : BLEND
      */
-    void Render(const std::shared_ptr<Shader>& shader, GLenum alphaMode) const;
+    void Render(const std::shared_ptr<Shader>& shader, GLenum alphaMode);
     
     /**
      * @brief Clean up the generated resources
@@ -73,19 +235,385 @@ class Scene : public Common::GLTFScene
     void SetAnimIndex(size_t animIndex);
 
  private:
+    //! Scale and offset restoring quantized position of the primitive
+    struct PositionDequantization
+    {
+        glm::vec3 scale{ 1.0f };
+        glm::vec3 offset{ 0.0f };
+    };
+
+    //! Packed vertex attributes for uploading
+    struct QuantizedVertices
+    {
+        std::vector<std::uint64_t> positions;
+        std::vector<std::uint32_t> normals;
+        std::vector<std::uint32_t> tangents;
+        std::vector<std::uint32_t> colors;
+        std::vector<std::uint32_t> texCoords;
+    };
+
+    //! Blended morph target deltas of one vertex, layout of morph_targets.comp
+    struct MorphVertex
+    {
+        glm::vec4 position;
+        glm::vec4 normal;
+    };
+
+    //! Primitive of the node blended into its own range of the morph vertices
+    struct MorphInstance
+    {
+        unsigned int node;
+        unsigned int primMesh;
+        unsigned int vertexBegin;
+    };
+
+    //! Rest pose and joint influences of a skinned vertex, layout of
+    //! vertex.glsl and skin_vertices.comp
+    struct SkinRestVertex
+    {
+        glm::vec4 position;
+        glm::vec4 normal;
+        glm::uvec4 joints;
+        glm::vec4 weights;
+    };
+
+    //! Skinned primitive of the node. Rest vertices are shared by the nodes
+    //! instancing the primitive, skinned vertices are written per instance.
+    struct SkinInstance
+    {
+        unsigned int node;
+        unsigned int primMesh;
+        unsigned int restBegin;
+        unsigned int vertexBegin;
+        unsigned int jointBase;
+        int morphVertexBegin;  //! -1 for the primitive without morph targets
+    };
+
+    //! Instances sharing the primitive and its vertex data. Plain primitives
+    //! of all nodes are grouped, morphed or skinned primitive of a node has
+    //! its own vertex range and forms a batch with the instances of the node.
+    struct DrawBatch
+    {
+        unsigned int primMesh;
+        int morphInstance;  //! -1 for the primitive without morph targets
+        int skinInstance;   //! -1 for the primitive without skinning
+        unsigned int instanceBegin;
+        unsigned int instanceCount;
+        //! First of the draw commands of the batch, one per level of detail
+        unsigned int commandBegin;
+        unsigned int alphaMode;  //! 0 : OPAQUE, 1 : MASK, 2 : BLEND
+        //! Common::MaterialFeature bits selecting the shader variant
+        unsigned int features;
+        //! Texture set of the material, 0 with bindless textures
+        unsigned int textureSet;
+    };
+
+    //! Consecutive draws of an alpha mode sharing the shader variant and the
+    //! texture set
+    struct DrawGroup
+    {
+        unsigned int alphaMode;
+        unsigned int features;
+        unsigned int textureSet;
+        size_t drawBegin;
+        size_t drawCount;
+    };
+
+    //! Command layout of glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    //! Shared inputs of the instances of a draw command, layout of vertex.glsl
+    struct DrawData
+    {
+        glm::vec4 positionScale;
+        glm::vec4 positionOffset;
+        int materialIdx;
+        int morphEnabled;
+        int morphBase;
+        int skinMode;
+        int skinBase;
+        int jointBase;
+        int padding[2];
+    };
+
+    //! Instance of a batch in the culling shaders, layout of
+    //! cull_instances.comp
+    struct CullInstance
+    {
+        GLuint matrixIdx;
+        GLuint batch;
+    };
+
+    //! Node space bounds of a matrix, lower.w is 1 for the unbounded node
+    struct CullBounds
+    {
+        glm::vec4 lower;
+        glm::vec4 upper;
+    };
+
+    //! Bounding sphere and command range of a batch
+    struct CullBatch
+    {
+        glm::vec4 sphere;
+        GLuint commandBegin;
+        GLuint numLevels;
+        GLuint padding[2];
+    };
+
+    //! Static part of a command slot with its level of detail error
+    struct CullCommand
+    {
+        GLuint count;
+        GLuint firstIndex;
+        GLint baseVertex;
+        float error;
+        //! First command slot and instance of the batch of the slot
+        GLuint firstSlot;
+        GLuint instanceBegin;
+        //! Index of the group of the slot in _commandGroups and its first
+        //! draw, the draws of the group are compacted from there
+        GLuint group;
+        GLuint drawBegin;
+    };
+
+    /**
+     * @brief Create the compute shaders and the static buffers of the GPU
+     * culling path from the draw batches.
+     * @return true if the culling shaders are compiled
+     * @return false if compiling the culling shaders failed
+     */
+    bool InitializeGPUCulling();
+
+    /**
+     * @brief Cull the instances and select their levels of detail, then
+     * compact the draw commands and scatter the matrix indices of the
+     * visible instances into the instance buffer with compute shaders.
+     */
+    void DispatchGPUCulling();
+
+    /**
+     * @brief Group the primitives of the scene nodes into draw batches and
+     * create the indirect command buffer with the per-draw data.
+     * @details Batches are sorted by blending, shader variant, material and
+     * primitive. Each batch owns a fixed range of commands, one per level of
+     * detail, and a fixed range of the instance buffer, so the draws can be
+     * updated in place.
+     */
+    void BuildDrawBatches();
+
+    /**
+     * @brief Cull the instances with the frustum and reassign the levels of
+     * detail of the visible ones, then upload the commands and instance
+     * ranges changed by the reassignment. With the GPU culling path only the
+     * blended batches are updated, their sorted draws are written after the
+     * command slots of the other batches.
+     */
+    void UpdateDrawCommands();
+
     /**
-     * @brief Update matrix buffer with modified scene nodes
+     * @brief Update the world space bounding boxes of the instances of the
+     * node from their matrices. Boxes of the skinned and morphed nodes are
+     * unbounded because their vertices move away from the rest pose.
+     * @param node index of the node with primitives
+     */
+    void UpdateInstanceBounds(size_t node);
+
+    /**
+     * @brief Update matrix buffer with the nodes changed by the last
+     * animation update.
+     * @details Matrix buffer is persistently mapped and split into regions
+     * used in round robin, guarded by fences. Only the matrices changed since
+     * the region was last written are copied into it, and normal matrices are
+     * computed only for the changed nodes.
      */
     void UpdateMatrixBuffer();
 
+    /**
+     * @brief Blend the morph targets of the given nodes into the morph vertex
+     * buffer with the compute shader.
+     * @details Each primitive instance is cleared and one dispatch per target
+     * with non-zero weight accumulates its sparse deltas, so the cost follows
+     * the number of active deltas instead of the number of targets times
+     * vertices.
+     * @param nodes sorted indices of the nodes whose weights are changed
+     */
+    void UpdateMorphTargets(const std::vector<unsigned int>& nodes);
+
+    /**
+     * @brief Upload the joint matrices of the changed skinned nodes, and
+     * skin their primitives with the compute shader in the compute path.
+     * @param skinNodes sorted skinned nodes whose joint matrices are changed
+     * @param morphNodes sorted nodes whose morph targets are blended again,
+     * their skinned vertices are recomputed in the compute path
+     */
+    void UpdateSkins(const std::vector<unsigned int>& skinNodes,
+                     const std::vector<unsigned int>& morphNodes);
+
+    /**
+     * @brief Select the coarsest level of detail of the primitive whose
+     * projected error does not exceed the threshold.
+     * @param world world matrix of the instance of the primitive
+     * @param primMesh primitive to be drawn
+     * @return unsigned int 0 for the full detail, otherwise the index of the
+     * selected level in primMesh.lods plus one
+     */
+    [[nodiscard]] unsigned int SelectLOD(const glm::mat4& world,
+                                         const GLTFPrimMesh& primMesh) const;
+
+    /**
+     * @brief Make the scene textures resident, or pack them into texture
+     * arrays and release the source textures. The texture set of each
+     * material is created from the arrays of its textures.
+     * @param textureRefs returns the texture reference of each texture index
+     * in the layout of GltfShadeMaterial
+     */
+    void CreateTextureReferences(std::vector<glm::uvec2>& textureRefs);
+
+    /**
+     * @brief Quantize the parsed vertex attributes and compute the position
+     * dequantization parameters of each primitive.
+     * @param quantized returns packed vertex attributes
+     */
+    void QuantizeVertices(QuantizedVertices& quantized);
+
+    /**
+     * @brief Create the block compressed texture of the image, loading the
+     * encoded result from the cache directory when it exists.
+     * @param image decoded RGBA8 image
+     * @param role usage of the image in the scene materials
+     * @return GLuint created texture object, 0 if compression is unsupported
+     */
+    GLuint CreateCompressedTexture(const tinygltf::Image& image,
+                                   Common::TextureRole role) const;
+
     std::vector<GLuint> _textures;
+    //! Resident handles of _textures in the bindless path
+    std::vector<GLuint64> _textureHandles;
+    //! Textures packed by size and format without the bindless path
+    std::vector<GLuint> _textureArrays;
+    //! Texture array of each texture reference of GltfShadeMaterial per
+    //! texture set, 0 for the unused references
+    std::vector<GLuint> _textureSets;
+    //! Index of the texture set of each material in the array path
+    std::vector<unsigned int> _materialTextureSets;
     std::vector<GLuint> _buffers;
+    std::vector<PositionDequantization> _positionDequantizations;
+    std::vector<NodeMatrix> _nodeMatrices;
+    //! Index of the first matrix of the node in _nodeMatrices, -1 for the
+    //! node without primitives. Node with instance transforms has one matrix
+    //! per instance in a row.
+    std::vector<int> _nodeMatrixIndices;
+    //! Bounding box of the primitives of each node in node space
+    std::vector<std::pair<glm::vec3, glm::vec3>> _nodeBounds;
+    //! World space bounding boxes parallel to _nodeMatrices
+    Common::AABBArray _instanceBounds;
+    std::vector<unsigned char> _instanceVisibility;
+    //! Matrices written by the last update of each matrix buffer region
+    std::vector<std::vector<unsigned int>> _modifiedMatrices;
+    std::vector<GLsync> _matrixFences;
+    //! Morphed primitive instances sorted by node
+    std::vector<MorphInstance> _morphInstances;
+    //! Index of the instance in _morphInstances parallel to the primitives of
+    //! _sceneNodes, -1 for the primitive without morph targets
+    std::vector<int> _morphInstanceIndices;
+    std::shared_ptr<Shader> _morphShader;
+    //! Skinned primitive instances sorted by node
+    std::vector<SkinInstance> _skinInstances;
+    //! Index of the instance in _skinInstances parallel to the primitives of
+    //! _sceneNodes, -1 for the primitive without skinning
+    std::vector<int> _skinInstanceIndices;
+    //! Temporary storages for updating skins
+    std::vector<glm::mat4> _jointMatrices;
+    std::vector<unsigned int> _skinUpdateNodes;
+    std::shared_ptr<Shader> _skinShader;
+    std::vector<DrawBatch> _drawBatches;
+    //! Matrix indices of the batch instances
+    std::vector<unsigned int> _batchInstances;
+    //! Contents of the indirect command and instance buffers, instances of
+    //! each batch are ordered by their level of detail
+    std::vector<DrawElementsIndirectCommand> _drawCommands;
+    std::vector<unsigned int> _drawInstances;
+    //! Temporary storages for reassigning the levels of detail
+    std::vector<unsigned int> _instanceLevels;
+    std::vector<unsigned int> _levelOffsets;
+    //! Sorted draws of the non-empty command slots and their contents
+    Common::RenderQueue _renderQueue;
+    std::vector<DrawElementsIndirectCommand> _queueCommands;
+    std::vector<GLuint> _queueSlots;
+    //! Temporary storages for updating matrices
+    std::vector<unsigned int> _changedMatrices;
+    std::vector<glm::mat4> _changedWorlds;
+    std::vector<glm::mat4> _changedNormals;
     DebugUtils _debug;
     GLuint _vao{ 0 }, _ebo{ 0 };
     GLuint _matrixBuffer{ 0 };
+    unsigned char* _mappedMatrices{ nullptr };
+    size_t _matrixRegionSize{ 0 };
+    size_t _currentMatrixRegion{ 0 };
     GLuint _materialBuffer{ 0 };
+    GLuint _instanceBuffer{ 0 };
+    GLuint _commandBuffer{ 0 };
+    GLuint _drawDataBuffer{ 0 };
+    //! Command slot of each draw, identity for the CPU path
+    GLuint _drawSlotBuffer{ 0 };
+    //! Command slots of each group, opaque, masked and then blended. The
+    //! GPU path compacts the draws of a group at its first slot.
+    std::vector<DrawGroup> _commandGroups;
+    //! Sorted draws of each group in the indirect buffer of the CPU path
+    std::vector<DrawGroup> _drawGroups;
+    //! Texture set of the batch of each command slot
+    std::vector<unsigned int> _commandTextureSets;
+    //! First command slot and instance of the blended batches
+    size_t _blendCommandBegin{ 0 };
+    size_t _blendInstanceBegin{ 0 };
+    bool _drawCommandsDirty{ false };
+    Common::Frustum _frustum{};
+    bool _frustumCulling{ false };
+    RenderStats _renderStats;
+    CullingMode _cullingMode{ CullingMode::CPU };
+    std::shared_ptr<Shader> _cullShader;
+    std::shared_ptr<Shader> _buildDrawsShader;
+    std::shared_ptr<Shader> _scatterShader;
+    std::shared_ptr<Shader> _depthPyramidShader;
+    GLuint _cullInstanceBuffer{ 0 };
+    GLuint _cullBoundsBuffer{ 0 };
+    GLuint _cullBatchBuffer{ 0 };
+    GLuint _cullCommandBuffer{ 0 };
+    //! Instance count and scatter cursor of each command slot
+    GLuint _drawCounterBuffer{ 0 };
+    GLuint _instanceLevelBuffer{ 0 };
+    //! Number of the compacted draws of each group
+    GLuint _drawCountBuffer{ 0 };
+    GLuint _depthPyramid{ 0 };
+    GLsizei _depthPyramidWidth{ 0 };
+    GLsizei _depthPyramidHeight{ 0 };
+    GLsizei _depthPyramidLevels{ 0 };
+    //! View projection of the frame the depth pyramid is built from
+    glm::mat4 _occlusionViewProjection{ 1.0f };
+    bool _occlusionCulling{ false };
+    GLuint _morphDeltaBuffer{ 0 };
+    GLuint _morphVertexBuffer{ 0 };
+    GLuint _jointMatrixBuffer{ 0 };
+    GLuint _skinVertexBuffer{ 0 };
+    GLuint _skinnedVertexBuffer{ 0 };
+    //! Camera position of SetView, the origin of the sort depth
+    glm::vec3 _viewEye{ 0.0f };
+    glm::vec3 _lodEye{ 0.0f };
+    float _lodProjectionScale{ 0.0f };
+    float _lodThreshold{ 1.0f };
     double _timeElapsed{ 0.0 };
     size_t _animIndex{ 0 };
+    bool _quantizeVertices{ false };
+    bool _compressTextures{ false };
+    bool _bindlessTextures{ true };
+    SkinningMode _skinningMode{ SkinningMode::Compute };
 };
 
 };  // namespace GL3
@@ -1,9 +1,14 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+#include <Common/ShaderSourceCache.hpp>
 #include <GL3/GLTypes.hpp>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace GL3
 {
@@ -17,6 +22,9 @@ namespace GL3
 class Shader
 {
  public:
+    //! Pairs of macro name and its value injected into every stage
+    using Defines = Common::ShaderSourceCache::Defines;
+
     /**
      * @brief Construct a new Shader object
      */
@@ -29,12 +37,88 @@ class Shader
 
     /**
      * @brief Compile given shader files link the program
-     *
+     * @details When the binary cache directory is set, the linked program is
+     * loaded from the cached program binary keyed by the preprocessed sources
+     * and the driver, and compiled only when the binary is missing or
+     * rejected by the driver.
      * @param sources pairs of shader type and shader file path collection.
+     * @param defines macros injected after the #version line of each stage
      * @return true if shader compile successful
      * @return false if shader compile failed
      */
-    bool Initialize(const std::unordered_map<GLenum, std::string>& sources);
+    bool Initialize(const std::unordered_map<GLenum, std::string>& sources,
+                    const Defines& defines = {});
+
+    /**
+     * @brief Submit the shader files for compiling and linking without
+     * waiting for the results.
+     * @details With GL_KHR_parallel_shader_compile the driver compiles on its
+     * own threads, so the caller can submit all programs up front and keep
+     * loading the assets. Results are checked by Wait, which must be called
+     * before using the program. A program restored from the binary cache is
+     * ready immediately. Sources are preprocessed through the global
+     * ShaderSourceCache, so the shared includes are read only once.
+     * @param sources pairs of shader type and shader file path collection.
+     * @param defines macros injected after the #version line of each stage
+     * @return true if the program is submitted
+     */
+    bool InitializeAsync(
+        const std::unordered_map<GLenum, std::string>& sources,
+        const Defines& defines = {});
+
+    /**
+     * @brief Resubmit the program if ShaderSourceCache::Refresh dropped any
+     * of its sources, the programs of unchanged files are kept.
+     * @return true if the program is resubmitted, Wait must be called
+     * before using it
+     */
+    bool Reload();
+
+    /**
+     * @brief Set the #defines of the variant feature bits, enabling
+     * GetVariant for this program.
+     * @param featureDefines define names indexed by the feature bit
+     */
+    void SetVariantDefines(std::vector<std::string> featureDefines);
+
+    /**
+     * @brief Returns the permutation of this program with the defines of the
+     * given feature bits and SHADER_VARIANT, so the features fixed per draw
+     * are resolved by the compiler instead of branching per fragment.
+     * @details Variants are submitted on the first request and cached, this
+     * program is returned until the variant finishes compiling or when it
+     * failed. Variants are compiled from the sources and defines of this
+     * program, uniform values and block bindings set on this program are not
+     * copied, so the bindings are expected in the layout qualifiers.
+     * @param features combination of the feature bits
+     * @return Shader* the variant ready to draw, or this program
+     */
+    [[nodiscard]] Shader* GetVariant(std::uint32_t features);
+
+    /**
+     * @brief Poll the completion of the submitted program without blocking.
+     * @return true if Wait would return without blocking, always true when
+     * GL_KHR_parallel_shader_compile is not supported
+     */
+    [[nodiscard]] bool IsReady() const;
+
+    /**
+     * @brief Block until the submitted program is linked and check the
+     * results, the program is cleaned up on failure.
+     * @return true if shader compile successful
+     * @return false if shader compile failed
+     */
+    bool Wait();
+
+    /**
+     * @brief Set the directory of the program binary cache shared by all
+     * shaders. Binaries are stored with glGetProgramBinary after linking and
+     * restored with glProgramBinary, a driver update or other renderer makes
+     * a different key and falls back to compilation.
+     * @param directory existing directory where the program binaries are
+     * stored, empty string disables the cache.
+     */
+    static void SetBinaryCacheDirectory(const std::string& directory);
 
     /**
      * @brief Bind generated shader program.
@@ -100,7 +184,43 @@ class Shader
     [[nodiscard]] GLuint GetResourceID() const;
 
  private:
+    //! Shader type and preprocessed source of each stage
+    using ShaderStages = std::vector<std::pair<GLenum, std::string>>;
+
+    /**
+     * @brief Start compiling the preprocessed stages and linking the program,
+     * results are checked by Wait.
+     * @param stages shader stages sorted by the shader type
+     * @param retrievable true for retrieving the binary of the program
+     */
+    void SubmitProgram(const ShaderStages& stages, bool retrievable);
+
+    /**
+     * @brief Create the program from the cached program binary.
+     * @param path path of the cached binary
+     * @param key cache key of the sources and the driver
+     * @return true if the binary exists and is accepted by the driver
+     */
+    bool LoadProgramBinary(const std::string& path, std::uint64_t key);
+
+    /**
+     * @brief Store the binary of the linked program in the cache.
+     * @param path path of the cached binary
+     * @param key cache key of the sources and the driver
+     */
+    void SaveProgramBinary(const std::string& path, std::uint64_t key) const;
+
     std::unordered_map<std::string, GLint> _uniformCache;
+    std::unordered_map<GLenum, std::string> _sourcePaths;
+    Defines _defines;
+    std::vector<std::string> _variantDefines;
+    //! Lazily compiled permutations keyed by the feature bits
+    std::unordered_map<std::uint32_t, std::unique_ptr<Shader>> _variants;
+    //! Shaders of the submitted program until Wait checks them
+    std::vector<GLuint> _pendingShaders;
+    //! Cache entry the binary is stored to after linking, empty if disabled
+    std::string _binaryPath;
+    std::uint64_t _binaryKey;
     GLuint _programID;
 };
 
@@ -102,20 +102,23 @@ class SkyDome
     /**
      * @brief baking BRDF lookup table
      * @param dim desired brdf LUT texture dimension
+     * @param shader submitted integrate_brdf shader
      */
-    void IntegrateBRDF(unsigned int dim);
+    void IntegrateBRDF(unsigned int dim, Shader& shader);
 
     /**
      * @brief baking diffuse map texture
      * @param dim desired diffuse map texture dimension
+     * @param shader submitted prefilter_diffuse shader
      */
-    void PrefilterDiffuse(unsigned int dim);
+    void PrefilterDiffuse(unsigned int dim, Shader& shader);
 
     /**
      * @brief baking glossy map texture
      * @param dim desired glossy texture dimension
+     * @param shader submitted prefilter_glossy shader
      */
-    void PrefilterGlossy(unsigned int dim);
+    void PrefilterGlossy(unsigned int dim, Shader& shader);
 
     IBLTextureSet _textureSet;
     GLuint _vao{ 0 }, _vbo{ 0 }, _ebo{ 0 };
@@ -0,0 +1,69 @@
+#ifndef TEXTURE_UPLOADER_HPP
+#define TEXTURE_UPLOADER_HPP
+
+#include <GL3/GLTypes.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace GL3
+{
+/**
+ * @brief Streaming texture uploader with ring of pixel unpack buffers
+ * @details Persistently mapped pixel buffer is split into segments, each
+ * upload copies the pixels into the next segment and issues the asynchronous
+ * transfer from it. Segment is reused after the fence of its previous
+ * transfer is signaled, so the CPU copy of the next image overlaps the
+ * transfer of the previous one.
+ */
+class TextureUploader
+{
+ public:
+    /**
+     * @brief Construct a new Texture Uploader object
+     */
+    TextureUploader() = default;
+
+    /**
+     * @brief Destroy the Texture Uploader object
+     */
+    ~TextureUploader();
+
+    /**
+     * @brief Create the persistently mapped pixel unpack buffer
+     * @param segmentSize size of one segment in bytes, larger images are
+     * uploaded directly from the client memory
+     * @param numSegments number of segments in the ring
+     * @return true if buffer creation and mapping success
+     * @return false if buffer creation or mapping failed
+     */
+    bool Initialize(size_t segmentSize, size_t numSegments = 3);
+
+    /**
+     * @brief Upload the pixels into the base level of the texture
+     * @param texture texture with immutable storage
+     * @param width width of the base level
+     * @param height height of the base level
+     * @param format pixel format of the data
+     * @param type pixel type of the data
+     * @param data pixels to be uploaded
+     * @param size size of the data in bytes
+     */
+    void Upload(GLuint texture, GLsizei width, GLsizei height, GLenum format,
+                GLenum type, const void* data, size_t size);
+
+    /**
+     * @brief Wait for the pending transfers and release the buffer
+     */
+    void CleanUp();
+
+ private:
+    std::vector<GLsync> _fences;
+    unsigned char* _mapped{ nullptr };
+    size_t _segmentSize{ 0 };
+    size_t _currentSegment{ 0 };
+    GLuint _buffer{ 0 };
+};
+
+};  // namespace GL3
+
+#endif  //! end of TextureUploader.hpp
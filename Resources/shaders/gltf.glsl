@@ -27,5 +27,16 @@ struct GltfShadeMaterial
 	int   occlusionTexture; //112
 	float occlusionTextureStrength; //116
 	int shadingModel;  // 120, 0: metallic-roughness, 1: specular-glossiness 
-	int padding[2];
+	int padding[2]; // 128
+
+	// Texture references of the texture indices above, resident bindless
+	// handle or texture array index and layer
+	uvec2 pbrBaseColorTextureRef; //136
+	uvec2 pbrMetallicRoughnessTextureRef; //144
+	uvec2 khrDiffuseTextureRef; //152
+	uvec2 khrSpecularGlossinessTextureRef; //160
+	uvec2 emissiveTextureRef; //168
+	uvec2 normalTextureRef; //176
+	uvec2 occlusionTextureRef; //184
+	uvec2 textureRefPadding; //192
 };
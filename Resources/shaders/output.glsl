@@ -1,5 +1,6 @@
 #version 450 core
 #extension GL_ARB_shading_language_include : require
+#extension GL_ARB_bindless_texture : enable
 
 //! This PBR shader largely referenced on two sources.
 //! 1. https://github.com/SaschaWillems/Vulkan-glTF-PBR/blob/master/data/shaders/pbr_khr.frag
@@ -11,6 +12,7 @@ layout(location = 0) in VSOUT
 	vec3 normal;
 	vec4 color;
 	vec2 texCoord;
+	flat int materialIdx;
 } fs_in;
 
 layout(location = 0) out vec4 fragColor;
@@ -39,13 +41,36 @@ layout(std430, binding = 3) readonly buffer UBOMaterial
 	GltfShadeMaterial materials[];
 };
 
-#define MAX_TEXTURES 20
+// Texture references of GltfShadeMaterial in order, the array of each
+// reference is bound per draw group so the sampler index stays constant
+#define TEXTURE_BASE_COLOR          0
+#define TEXTURE_METALLIC_ROUGHNESS  1
+#define TEXTURE_DIFFUSE             2
+#define TEXTURE_SPECULAR_GLOSSINESS 3
+#define TEXTURE_EMISSIVE            4
+#define TEXTURE_NORMAL              5
+#define TEXTURE_OCCLUSION           6
+#define NUM_MATERIAL_TEXTURES       7
 layout ( binding = 0 ) uniform samplerCube samplerIrradiance;
 layout ( binding = 1 ) uniform sampler2D samplerBRDFLUT;
 layout ( binding = 2 ) uniform samplerCube prefilteredMap;
-layout ( binding = 3 ) uniform sampler2D textures[MAX_TEXTURES];
+// Scene textures packed by size and format, used without bindless textures
+layout ( binding = 3 ) uniform sampler2DArray textureArrays[NUM_MATERIAL_TEXTURES];
 
-uniform int materialIdx = 0;
+// 1 : texture references of the materials are resident bindless handles,
+// 0 : texture array index and layer
+uniform int bindlessTextures = 0;
+
+vec4 SampleTexture(int textureSlot, uvec2 textureRef, vec2 texCoord)
+{
+#ifdef GL_ARB_bindless_texture
+	if (bindlessTextures != 0)
+	{
+		return texture(sampler2D(textureRef), texCoord);
+	}
+#endif
+	return texture(textureArrays[textureSlot], vec3(texCoord, float(textureRef.y)));
+}
 
 #include tonemapping.glsl
 #include utils.glsl
@@ -55,6 +80,39 @@ uniform int materialIdx = 0;
 #define PBR_METALLIC_ROUGHNESS_MODEL  0
 #define PBR_SPECULAR_GLOSSINESS_MODEL 1
 
+// Material features are fixed by the defines of the shader variants from
+// Shader::GetVariant, so the compiler removes the dead fetches and branches.
+// Base program without SHADER_VARIANT tests them per fragment.
+#ifdef SHADER_VARIANT
+#ifndef MATERIAL_SPECULAR_GLOSSINESS
+#define MATERIAL_SPECULAR_GLOSSINESS 0
+#endif
+#ifndef HAS_BASE_COLOR_TEXTURE
+#define HAS_BASE_COLOR_TEXTURE 0
+#endif
+#ifndef HAS_METALLIC_ROUGHNESS_TEXTURE
+#define HAS_METALLIC_ROUGHNESS_TEXTURE 0
+#endif
+#ifndef HAS_NORMAL_TEXTURE
+#define HAS_NORMAL_TEXTURE 0
+#endif
+#ifndef HAS_OCCLUSION_TEXTURE
+#define HAS_OCCLUSION_TEXTURE 0
+#endif
+#ifndef HAS_EMISSIVE_TEXTURE
+#define HAS_EMISSIVE_TEXTURE 0
+#endif
+#ifndef HAS_ALPHA_CUTOFF
+#define HAS_ALPHA_CUTOFF 0
+#endif
+#ifndef HAS_DIFFUSE_TEXTURE
+#define HAS_DIFFUSE_TEXTURE 0
+#endif
+#define MATERIAL_FEATURE(feature, runtimeTest) (feature != 0)
+#else
+#define MATERIAL_FEATURE(feature, runtimeTest) (runtimeTest)
+#endif
+
 // Calculation of the lighting contribution from an optional Image Based Light source.
 // Precomputed Environment Maps are required uniform inputs and are computed as outlined in [1].
 // See our README.md on Environment Maps [3] for additional discussion.
@@ -86,17 +144,32 @@ void main()
 	float perceptualRoughness;
 	float metallic;
 
-	GltfShadeMaterial material = materials[materialIdx];
-
-	if (material.shadingModel == PBR_METALLIC_ROUGHNESS_MODEL)
+	GltfShadeMaterial material = materials[fs_in.materialIdx];
+
+#ifdef SHADER_VARIANT
+	bool specularGlossiness = MATERIAL_SPECULAR_GLOSSINESS != 0;
+	bool metallicRoughness = !specularGlossiness;
+#else
+	bool specularGlossiness = material.shadingModel == PBR_SPECULAR_GLOSSINESS_MODEL;
+	bool metallicRoughness = material.shadingModel == PBR_METALLIC_ROUGHNESS_MODEL;
+#endif
+	bool hasBaseColorTexture = MATERIAL_FEATURE(HAS_BASE_COLOR_TEXTURE, material.pbrBaseColorTexture > -1);
+	bool hasMetallicRoughnessTexture = MATERIAL_FEATURE(HAS_METALLIC_ROUGHNESS_TEXTURE, material.pbrMetallicRoughnessTexture > -1);
+	bool hasNormalTexture = MATERIAL_FEATURE(HAS_NORMAL_TEXTURE, material.normalTexture > -1);
+	bool hasOcclusionTexture = MATERIAL_FEATURE(HAS_OCCLUSION_TEXTURE, material.occlusionTexture > -1);
+	bool hasEmissiveTexture = MATERIAL_FEATURE(HAS_EMISSIVE_TEXTURE, material.emissiveTexture > -1);
+	bool hasAlphaCutoff = MATERIAL_FEATURE(HAS_ALPHA_CUTOFF, material.alphaMode > 0);
+	bool hasDiffuseTexture = MATERIAL_FEATURE(HAS_DIFFUSE_TEXTURE, material.khrDiffuseTexture > -1);
+
+	if (metallicRoughness)
 	{
 		perceptualRoughness = material.pbrRoughnessFactor;
 		metallic = material.pbrMetallicFactor;
 		//! Roughness is stored in the 'g' channel, metallic is stored in the 'b' channel
 		//! This layout intentionally reserves the 'r' channel for (optional) occlusion map data
-		if (material.pbrMetallicRoughnessTexture > -1)
+		if (hasMetallicRoughnessTexture)
 		{
-			vec4 mrSample = texture(textures[material.pbrMetallicRoughnessTexture], fs_in.texCoord);
+			vec4 mrSample = SampleTexture(TEXTURE_METALLIC_ROUGHNESS, material.pbrMetallicRoughnessTextureRef, fs_in.texCoord);
 			perceptualRoughness *= mrSample.g;
 			metallic *= mrSample.b;
 		}
@@ -107,31 +180,36 @@ void main()
 		}
 
 		baseColor = material.pbrBaseColorFactor;
-		if (material.pbrBaseColorTexture > -1)
-			baseColor *= SRGBtoLinear(texture(textures[material.pbrBaseColorTexture], fs_in.texCoord), 2.2);
+		if (hasBaseColorTexture)
+			baseColor *= SRGBtoLinear(SampleTexture(TEXTURE_BASE_COLOR, material.pbrBaseColorTextureRef, fs_in.texCoord), 2.2);
 	}
 
-	if (material.shadingModel == PBR_SPECULAR_GLOSSINESS_MODEL)
+	if (specularGlossiness)
 	{
-		if (material.pbrMetallicRoughnessTexture > -1)
+		if (hasMetallicRoughnessTexture)
 		{
-			perceptualRoughness = 1.0 - texture(textures[material.pbrMetallicRoughnessTexture], fs_in.texCoord).a;
+			perceptualRoughness = 1.0 - SampleTexture(TEXTURE_METALLIC_ROUGHNESS, material.pbrMetallicRoughnessTextureRef, fs_in.texCoord).a;
 		}
 		else
 		{
 			perceptualRoughness = 0.0;
 		}
 
-		vec4 diffuse = SRGBtoLinear(texture(textures[material.khrDiffuseTexture], fs_in.texCoord), 2.2);
-		vec3 specular = SRGBtoLinear(texture(textures[material.pbrMetallicRoughnessTexture], fs_in.texCoord), 2.2).rgb;
+		// Missing textures leave the factors alone, their references are not valid
+		vec4 diffuse = material.khrDiffuseFactor;
+		if (hasDiffuseTexture)
+			diffuse *= SRGBtoLinear(SampleTexture(TEXTURE_DIFFUSE, material.khrDiffuseTextureRef, fs_in.texCoord), 2.2);
+		vec3 specular = material.khrSpecularFactor;
+		if (hasMetallicRoughnessTexture)
+			specular *= SRGBtoLinear(SampleTexture(TEXTURE_METALLIC_ROUGHNESS, material.pbrMetallicRoughnessTextureRef, fs_in.texCoord), 2.2).rgb;
 
 		float maxSpecular = max(max(specular.r, specular.g), specular.b);
 
 		//! Convert metallic value from sepcular glossiness inputs
 		metallic = convertMetallic(diffuse.rgb, specular, maxSpecular);
 
-		vec3 baseColorDiffusePart = diffuse.rgb * ((1.0 - maxSpecular) / (1.0 - MIN_ROUGHNESS) / max(1 - metallic, EPSILON)) * material.khrDiffuseFactor.rgb;
-		vec3 baseColorSpecularPart = specular - (vec3(MIN_ROUGHNESS) * (1.0 - metallic) * (1.0 / max(metallic, EPSILON))) * material.khrSpecularFactor.rgb;
+		vec3 baseColorDiffusePart = diffuse.rgb * ((1.0 - maxSpecular) / (1.0 - MIN_ROUGHNESS) / max(1 - metallic, EPSILON));
+		vec3 baseColorSpecularPart = specular - (vec3(MIN_ROUGHNESS) * (1.0 - metallic) * (1.0 / max(metallic, EPSILON)));
 		baseColor = vec4(mix(baseColorDiffusePart, baseColorSpecularPart, metallic * metallic), diffuse.a);
 	}
 
@@ -139,7 +217,7 @@ void main()
 	diffuseColor = baseColor.rgb * (vec3(1.0) - f0) * (1.0 - metallic);
 	specularColor = mix(f0, baseColor.rgb, metallic);
 
-	if (material.alphaMode > 0 && baseColor.a < material.alphaCutoff)
+	if (hasAlphaCutoff && baseColor.a < material.alphaCutoff)
 		discard;
 
 	//! Roughness is authored as perceptual roughness; as is convention
@@ -153,8 +231,7 @@ void main()
 	vec3 specularEnvironmentR90 = vec3(clamp(reflectance * 50.0, 0.0, 1.0));
 
 	//! Lighting start
-	vec3 normal = material.normalTexture > -1 ? getNormal(material.normalTexture) :
-												normalize(fs_in.normal);
+	vec3 normal = getNormal(hasNormalTexture, material.normalTextureRef);
 	vec3 view = normalize(uboCamera.camPos - fs_in.worldPos);
 	vec3 light = normalize(uboScene.lightDir.xyz);
 	vec3 h = normalize(light + view);
@@ -188,15 +265,15 @@ void main()
 	color += getIBLContribution(pbr, normal, reflection);
 
 	//! Apply optinal PBR terms for additional (optional) shading
-	if (material.occlusionTexture > -1)
+	if (hasOcclusionTexture)
 	{
-		float ao = texture(textures[material.occlusionTexture], fs_in.texCoord).r;
+		float ao = SampleTexture(TEXTURE_OCCLUSION, material.occlusionTextureRef, fs_in.texCoord).r;
 		color = mix(color, color * ao, material.occlusionTextureStrength);
 	}
 
-	if (material.emissiveTexture > -1)
+	if (hasEmissiveTexture)
 	{
-		vec3 emissive = SRGBtoLinear(texture(textures[material.emissiveTexture], fs_in.texCoord), 2.2).rgb * material.emissiveFactor;
+		vec3 emissive = SRGBtoLinear(SampleTexture(TEXTURE_EMISSIVE, material.emissiveTextureRef, fs_in.texCoord), 2.2).rgb * material.emissiveFactor;
 		color += emissive;
 	}
 
@@ -213,7 +290,7 @@ void main()
 		break;
 
 	case DEBUG_NORMAL:
-		fragColor.rgb = getNormal(material.normalTexture);
+		fragColor.rgb = getNormal(hasNormalTexture, material.normalTextureRef);
 		break;
 
 	case DEBUG_BASECOLOR:
@@ -221,15 +298,15 @@ void main()
 		break;
 
 	case DEBUG_OCCLUSION:
-		if (material.occlusionTexture > -1)
-			fragColor.rgb = texture(textures[material.occlusionTexture], fs_in.texCoord).rrr;
+		if (hasOcclusionTexture)
+			fragColor.rgb = SampleTexture(TEXTURE_OCCLUSION, material.occlusionTextureRef, fs_in.texCoord).rrr;
 		else
 			fragColor.rgb = vec3(1);
 		break;
 
 	case DEBUG_EMISSIVE:
-		if (material.emissiveTexture > -1)
-			fragColor.rgb = texture(textures[material.emissiveTexture], fs_in.texCoord).rrr;
+		if (hasEmissiveTexture)
+			fragColor.rgb = SampleTexture(TEXTURE_EMISSIVE, material.emissiveTextureRef, fs_in.texCoord).rrr;
 		else
 			fragColor.rgb = vec3(0);
 		break;
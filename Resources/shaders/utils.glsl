@@ -35,14 +35,18 @@ float convertMetallic(vec3 diffuse, vec3 specular, float maxSpecular)
 //! Find the normal for this fragment, pulling either from a predefined normal map
 //! or from the interpolated mesh normal and tangent attributes.
 //! See http://www.thetenthplanet.de/archives/1180
-vec3 getNormal(int normalTexture)
+vec3 getNormal(bool hasNormalTexture, uvec2 normalTextureRef)
 {
-	if (normalTexture > -1)
+	if (hasNormalTexture)
 	{
-		vec3 tangentNormal = texture(textures[normalTexture], fs_in.texCoord).xyz;
-		if (length(tangentNormal) <= 0.01)
+		// Z is reconstructed from XY, block compressed normal maps store
+		// only two channels.
+		vec2 tangentNormalXY = SampleTexture(TEXTURE_NORMAL, normalTextureRef, fs_in.texCoord).xy;
+		if (length(tangentNormalXY) <= 0.01)
 			return fs_in.normal;
-		tangentNormal = tangentNormal * 2.0 - 1.0;
+		tangentNormalXY = tangentNormalXY * 2.0 - 1.0;
+		vec3 tangentNormal = vec3(tangentNormalXY,
+		                          sqrt(max(1.0 - dot(tangentNormalXY, tangentNormalXY), 0.0)));
 		vec3 q1 = dFdx(fs_in.worldPos);
 		vec3 q2 = dFdy(fs_in.worldPos);
 		vec2 st1 = dFdx(fs_in.texCoord);
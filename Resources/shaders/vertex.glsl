@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -13,6 +14,13 @@ layout(std140, binding = 0) uniform UBOCamera
 	vec3 camPos;	 // 208
 } uboCamera;
 
+// Matrix index of each instance of the draws, the instances of a draw start
+// at its base instance
+layout(std430, binding = 1) readonly buffer UBOInstanceIndex
+{
+	uint instanceMatrices[];
+};
+
 struct InstanceMat 
 {
 	mat4 model;	  //  64
@@ -24,23 +32,122 @@ layout(std430, binding = 2) readonly buffer UBOinstance
 	InstanceMat matrices[];
 };
 
+struct MorphVertex
+{
+	vec4 position; // 16
+	vec4 normal;   // 32
+};
+
+layout(std430, binding = 4) readonly buffer UBOMorph
+{
+	MorphVertex morphVertices[];
+};
+
+struct SkinRestVertex
+{
+	vec4 position; // 16
+	vec4 normal;   // 32
+	uvec4 joints;  // 48
+	vec4 weights;  // 64
+};
+
+layout(std430, binding = 5) readonly buffer UBOJoint
+{
+	mat4 jointMatrices[];
+};
+
+layout(std430, binding = 6) readonly buffer UBOSkin
+{
+	SkinRestVertex skinVertices[];
+};
+
+// Output of skin_vertices.comp, morph targets are already applied
+layout(std430, binding = 7) readonly buffer UBOSkinned
+{
+	MorphVertex skinnedVertices[];
+};
+
+struct DrawData
+{
+	// Dequantization of the 16-bit snorm positions, identity for float positions
+	vec4 positionScale;  // 16
+	vec4 positionOffset; // 32
+	int materialIdx;	 // 36
+	// Blended morph target deltas of the primitive start at morphBase + gl_VertexID
+	int morphEnabled;	 // 40
+	int morphBase;		 // 44
+	// 0 : no skinning, 1 : blend joint matrices here, 2 : read skinned vertices.
+	// Skinned data of the primitive start at skinBase + gl_VertexID
+	int skinMode;		 // 48
+	int skinBase;		 // 52
+	int jointBase;		 // 56
+	int padding[2];		 // 64
+};
+
+// Shared inputs of the instances of each draw of the multi draw
+layout(std430, binding = 8) readonly buffer UBODraw
+{
+	DrawData draws[];
+};
+
+// Command slot of each draw, identity unless the draws are compacted by the
+// culling pass. gl_DrawID restarts in each multi draw, drawBase is the first
+// draw of the call.
+layout(std430, binding = 9) readonly buffer UBODrawSlot
+{
+	uint drawSlots[];
+};
+
+uniform int drawBase = 0;
+
 layout(location = 0) out VSOUT
 {
 	vec3 worldPos;
 	vec3 normal;
 	vec4 color;
 	vec2 texCoord;
+	flat int materialIdx;
 } vs_out;
 
-uniform int instanceIdx = 0;
-
 void main()
 {
-	vec4 worldPos = matrices[instanceIdx].model * vec4(position, 1.0);
+	DrawData draw = draws[drawSlots[drawBase + gl_DrawIDARB]];
+	uint instanceIdx = instanceMatrices[gl_BaseInstanceARB + gl_InstanceID];
+	vec3 localPos = draw.positionOffset.xyz + position * draw.positionScale.xyz;
+	vec3 localNormal = normal;
+	if (draw.skinMode == 2)
+	{
+		MorphVertex skinned = skinnedVertices[draw.skinBase + gl_VertexID];
+		localPos = skinned.position.xyz;
+		localNormal = skinned.normal.xyz;
+	}
+	else
+	{
+		if (draw.morphEnabled != 0)
+		{
+			MorphVertex morph = morphVertices[draw.morphBase + gl_VertexID];
+			localPos += morph.position.xyz;
+			localNormal += morph.normal.xyz;
+		}
+		if (draw.skinMode == 1)
+		{
+			SkinRestVertex skin = skinVertices[draw.skinBase + gl_VertexID];
+			int jointBase = draw.jointBase;
+			mat4 skinMatrix =
+				skin.weights.x * jointMatrices[jointBase + skin.joints.x] +
+				skin.weights.y * jointMatrices[jointBase + skin.joints.y] +
+				skin.weights.z * jointMatrices[jointBase + skin.joints.z] +
+				skin.weights.w * jointMatrices[jointBase + skin.joints.w];
+			localPos = (skinMatrix * vec4(localPos, 1.0)).xyz;
+			localNormal = mat3(skinMatrix) * localNormal;
+		}
+	}
+	vec4 worldPos = matrices[instanceIdx].model * vec4(localPos, 1.0);
 	vs_out.worldPos = worldPos.xyz;
-	vs_out.normal	= (matrices[instanceIdx].modelIT * vec4(normal, 1.0)).xyz;
+	vs_out.normal	= (matrices[instanceIdx].modelIT * vec4(localNormal, 1.0)).xyz;
 	vs_out.color	= color;
 	vs_out.texCoord = texCoord;
+	vs_out.materialIdx = draw.materialIdx;
 
 	gl_Position = uboCamera.viewProj * worldPos;
 }
\ No newline at end of file
@@ -1,4 +1,8 @@
 #include <Common/AssetLoader.hpp>
+#include <Common/MappedFile.hpp>
+#include <Common/MeshUtils.hpp>
+#include <Common/ObjParser.hpp>
+#include <Common/ThreadPool.hpp>
 #include <GL3/DebugUtils.hpp>
 #include <algorithm>
 #include <array>
@@ -10,62 +14,100 @@
 
 #include <tinygltf/stb_image.h>
 
-bool CheckTriangle(const glm::vec3 v1, const glm::vec3 v2, const glm::vec3 v3)
+namespace Common
 {
-    return (v2.x - v1.x) * (v3.y - v2.y) != (v3.x - v2.x) * (v2.y - v1.y);
-}
-
-glm::vec3 CalculateNormal(const glm::vec3 v1, const glm::vec3 v2,
-                          const glm::vec3 v3)
+namespace  //! Anonymous namespace for file-specific helper functions
 {
-    if (!CheckTriangle(v1, v2, v3))
+/**
+ * @brief Weld the face corners and append the unique vertices in the given
+ * format and the indices to the output arrays. Attributes not in the format
+ * are cleared first, so they do not split the welded vertices.
+ */
+void AppendWeldedVertices(std::vector<PackedVertex>& corners,
+                          Common::VertexFormat format,
+                          std::vector<float>& vertices,
+                          std::vector<unsigned int>& indices)
+{
+    ThreadPool& pool = ThreadPool::GetGlobalPool();
+    const bool hasPosition =
+        static_cast<bool>(format & Common::VertexFormat::Position3);
+    const bool hasNormal =
+        static_cast<bool>(format & Common::VertexFormat::Normal3);
+    const bool hasTexCoord =
+        static_cast<bool>(format & Common::VertexFormat::TexCoord2);
+    const size_t stride = VertexHelper::GetNumberOfFloats(format);
+
+    if (!hasPosition || !hasNormal || !hasTexCoord)
     {
-        return glm::vec3(0.0f);
+        pool.ParallelForRange(0, corners.size(), [&](size_t begin,
+                                                     size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (!hasPosition)
+                {
+                    corners[i].position = glm::vec3(0.0f);
+                }
+                if (!hasNormal)
+                {
+                    corners[i].normal = glm::vec3(0.0f);
+                }
+                if (!hasTexCoord)
+                {
+                    corners[i].texCoord = glm::vec2(0.0f);
+                }
+            }
+        });
     }
 
-    glm::vec3 edge1 = v2 - v1;
-    glm::vec3 edge2 = v3 - v2;
-    return glm::normalize(glm::cross(edge1, edge2));
-}
+    //! Weld the corners, each unique vertex is emitted once.
+    std::vector<unsigned int> remap;
+    std::vector<unsigned int> uniques;
+    const size_t numUniques =
+        MeshUtils::WeldVertices(corners, remap, uniques);
 
-struct PackedVertex
-{
-    glm::vec3 position;
-    glm::vec2 texCoord;
-    glm::vec3 normal;
+    const size_t vertexBase = vertices.size() / stride;
+    const size_t indexBase = indices.size();
+    vertices.resize(vertices.size() + numUniques * stride);
+    indices.resize(indexBase + corners.size());
 
-    PackedVertex(glm::vec3 pos, glm::vec2 uv, glm::vec3 n)
-        : position(pos), texCoord(uv), normal(n){};
-};
+    pool.ParallelForRange(0, numUniques, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const PackedVertex& vertex = corners[uniques[i]];
+            float* dst = &vertices[(vertexBase + i) * stride];
+            if (hasPosition)
+            {
+                *dst++ = vertex.position.x;
+                *dst++ = vertex.position.y;
+                *dst++ = vertex.position.z;
+            }
+            if (hasNormal)
+            {
+                *dst++ = vertex.normal.x;
+                *dst++ = vertex.normal.y;
+                *dst++ = vertex.normal.z;
+            }
+            if (hasTexCoord)
+            {
+                *dst++ = vertex.texCoord.x;
+                *dst++ = vertex.texCoord.y;
+            }
+        }
+    });
 
-//! lexicographically sorting vector.
-inline bool operator<(const PackedVertex& v1, const PackedVertex& v2)
-{
-    if (std::fabs(v1.position.x - v2.position.x) >= 0.001f)
-        return v1.position.x < v2.position.x;
-    if (std::fabs(v1.position.y - v2.position.y) >= 0.001f)
-        return v1.position.y < v2.position.y;
-    if (std::fabs(v1.position.z - v2.position.z) >= 0.001f)
-        return v1.position.z < v2.position.z;
-    if (std::fabs(v1.texCoord.x - v2.texCoord.x) >= 0.1f)
-        return v1.texCoord.x < v2.texCoord.x;
-    if (std::fabs(v1.texCoord.y - v2.texCoord.y) >= 0.1f)
-        return v1.texCoord.y < v2.texCoord.y;
-    if (std::fabs(v1.normal.x - v2.normal.x) >= 0.3f)
-        return v1.normal.x < v2.normal.x;
-    if (std::fabs(v1.normal.y - v2.normal.y) >= 0.3f)
-        return v1.normal.y < v2.normal.y;
-    if (std::fabs(v1.normal.z - v2.normal.z) >= 0.3f)
-        return v1.normal.z < v2.normal.z;
-    return false;
+    pool.ParallelForRange(0, corners.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            indices[indexBase + i] =
+                static_cast<unsigned int>(vertexBase + remap[i]);
+        }
+    });
 }
 
-namespace Common
-{
-bool AssetLoader::LoadObjFile(const std::string& path,
-                              std::vector<float>& vertices,
-                              std::vector<unsigned int>& indices,
-                              Common::VertexFormat format)
+bool LoadObjFileTinyObj(const std::string& path,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        Common::VertexFormat format)
 {
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
@@ -91,162 +133,183 @@ bool AssetLoader::LoadObjFile(const std::string& path,
         return false;
     }
 
+    //! Corners of all shapes are welded at once as the native parser does,
+    //! so both paths give the same buffers for the same file.
+    size_t numCorners = 0;
+    for (const auto& shape : shapes)
+    {
+        numCorners += shape.mesh.indices.size() / 3 * 3;
+    }
+    std::vector<PackedVertex> corners(numCorners);
+
+    ThreadPool& pool = ThreadPool::GetGlobalPool();
+    size_t cornerBase = 0;
     for (auto& shape : shapes)
     {
-        std::map<PackedVertex, unsigned int> packedVerticesMap;
-        for (size_t faceIndex = 0; faceIndex < shape.mesh.indices.size() / 3;
-             ++faceIndex)
-        {
-            /*
-            idx0 (pos (float3), normal(float3), texcoords(float2))
-            |\
-            | \
-            |  \
-            |   \ idx2 (pos (float3), normal(float3), texcoords(float2))
-            |   /
-            |  /
-            | /
-            |/
-            idx1 (pos (float3), normal(float3), texcoords(float2))
-            */
-            tinyobj::index_t idx0 = shape.mesh.indices[3 * faceIndex + 0];
-            tinyobj::index_t idx1 = shape.mesh.indices[3 * faceIndex + 1];
-            tinyobj::index_t idx2 = shape.mesh.indices[3 * faceIndex + 2];
+        //! Expand face corners into packed vertices in parallel.
+        const size_t numFaces = shape.mesh.indices.size() / 3;
+        pool.ParallelForRange(0, numFaces, [&](size_t faceBegin,
+                                               size_t faceEnd) {
+            for (size_t faceIndex = faceBegin; faceIndex < faceEnd; ++faceIndex)
+            {
+                /*
+                idx0 (pos (float3), normal(float3), texcoords(float2))
+                |\
+                | \
+                |  \
+                |   \ idx2 (pos (float3), normal(float3), texcoords(float2))
+                |   /
+                |  /
+                | /
+                |/
+                idx1 (pos (float3), normal(float3), texcoords(float2))
+                */
+                tinyobj::index_t idx0 = shape.mesh.indices[3 * faceIndex + 0];
+                tinyobj::index_t idx1 = shape.mesh.indices[3 * faceIndex + 1];
+                tinyobj::index_t idx2 = shape.mesh.indices[3 * faceIndex + 2];
 
-            std::array<glm::vec3, 3> position;
-            std::array<glm::vec2, 3> texCoord;
-            std::array<glm::vec3, 3> normal;
+                std::array<glm::vec3, 3> position{ glm::vec3(0.0f),
+                                                   glm::vec3(0.0f),
+                                                   glm::vec3(0.0f) };
+                std::array<glm::vec2, 3> texCoord{ glm::vec2(0.0f),
+                                                   glm::vec2(0.0f),
+                                                   glm::vec2(0.0f) };
+                std::array<glm::vec3, 3> normal{ glm::vec3(0.0f),
+                                                 glm::vec3(0.0f),
+                                                 glm::vec3(0.0f) };
 
-            if (static_cast<int>(format & Common::VertexFormat::Position3))
-            {
-                for (int k = 0; k < 3; k++)
+                if (static_cast<int>(format & Common::VertexFormat::Position3))
                 {
-                    int f0 = idx0.vertex_index;
-                    int f1 = idx1.vertex_index;
-                    int f2 = idx2.vertex_index;
-                    assert(f0 >= 0 && f1 >= 0 && f2 >= 0);
+                    for (int k = 0; k < 3; k++)
+                    {
+                        int f0 = idx0.vertex_index;
+                        int f1 = idx1.vertex_index;
+                        int f2 = idx2.vertex_index;
+                        assert(f0 >= 0 && f1 >= 0 && f2 >= 0);
 
-                    position[0][k] = attrib.vertices[3 * f0 + k];
-                    position[1][k] = attrib.vertices[3 * f1 + k];
-                    position[2][k] = attrib.vertices[3 * f2 + k];
+                        position[0][k] = attrib.vertices[3 * f0 + k];
+                        position[1][k] = attrib.vertices[3 * f1 + k];
+                        position[2][k] = attrib.vertices[3 * f2 + k];
+                    }
                 }
-            }
 
-            if (static_cast<int>(format & Common::VertexFormat::Normal3))
-            {
-                bool invalidNormal = false;
-                if (!attrib.normals.empty())
+                if (static_cast<int>(format & Common::VertexFormat::Normal3))
                 {
-                    int f0 = idx0.normal_index;
-                    int f1 = idx1.normal_index;
-                    int f2 = idx2.normal_index;
-                    if (f0 < 0 || f1 < 0 || f2 < 0)
+                    bool invalidNormal = false;
+                    if (!attrib.normals.empty())
                     {
-                        invalidNormal = true;
+                        int f0 = idx0.normal_index;
+                        int f1 = idx1.normal_index;
+                        int f2 = idx2.normal_index;
+                        if (f0 < 0 || f1 < 0 || f2 < 0)
+                        {
+                            invalidNormal = true;
+                        }
+                        else
+                        {
+                            for (unsigned int k = 0; k < 3; k++)
+                            {
+                                assert(size_t(3 * f0 + k) < attrib.normals.size());
+                                assert(size_t(3 * f1 + k) < attrib.normals.size());
+                                assert(size_t(3 * f2 + k) < attrib.normals.size());
+                                normal[0][k] = attrib.normals[3 * f0 + k];
+                                normal[1][k] = attrib.normals[3 * f1 + k];
+                                normal[2][k] = attrib.normals[3 * f2 + k];
+                            }
+                        }
                     }
                     else
                     {
-                        for (unsigned int k = 0; k < 3; k++)
-                        {
-                            assert(size_t(3 * f0 + k) < attrib.normals.size());
-                            assert(size_t(3 * f1 + k) < attrib.normals.size());
-                            assert(size_t(3 * f2 + k) < attrib.normals.size());
-                            normal[0][k] = attrib.normals[3 * f0 + k];
-                            normal[1][k] = attrib.normals[3 * f1 + k];
-                            normal[2][k] = attrib.normals[3 * f2 + k];
-                        }
+                        invalidNormal = true;
+                    }
+                    if (invalidNormal)
+                    {
+                        normal[0] =
+                            MeshUtils::CalculateFaceNormal(position[0], position[1], position[2]);
+                        normal[1] = normal[0];
+                        normal[2] = normal[0];
                     }
                 }
-                else
-                {
-                    invalidNormal = true;
-                }
-                if (invalidNormal)
-                {
-                    normal[0] =
-                        CalculateNormal(position[0], position[1], position[2]);
-                    normal[1] = normal[0];
-                    normal[2] = normal[0];
-                }
-            }
 
-            if (static_cast<int>(format & Common::VertexFormat::TexCoord2))
-            {
-                if (!attrib.texcoords.empty())
+                if (static_cast<int>(format & Common::VertexFormat::TexCoord2))
                 {
-                    int f0 = idx0.texcoord_index;
-                    int f1 = idx1.texcoord_index;
-                    int f2 = idx2.texcoord_index;
+                    if (!attrib.texcoords.empty())
+                    {
+                        int f0 = idx0.texcoord_index;
+                        int f1 = idx1.texcoord_index;
+                        int f2 = idx2.texcoord_index;
 
-                    if (f0 < 0 || f1 < 0 || f2 < 0)
+                        if (f0 < 0 || f1 < 0 || f2 < 0)
+                        {
+                            texCoord[0] = glm::vec2(0.0f, 0.0f);
+                            texCoord[1] = glm::vec2(0.0f, 0.0f);
+                            texCoord[2] = glm::vec2(0.0f, 0.0f);
+                        }
+                        else
+                        {
+                            assert(attrib.texcoords.size() > size_t(2 * f0 + 1));
+                            assert(attrib.texcoords.size() > size_t(2 * f1 + 1));
+                            assert(attrib.texcoords.size() > size_t(2 * f2 + 1));
+
+                            //! Flip Y coord.
+                            texCoord[0] =
+                                glm::vec2(attrib.texcoords[2 * f0],
+                                          1.0f - attrib.texcoords[2 * f0 + 1]);
+                            texCoord[1] =
+                                glm::vec2(attrib.texcoords[2 * f1],
+                                          1.0f - attrib.texcoords[2 * f1 + 1]);
+                            texCoord[2] =
+                                glm::vec2(attrib.texcoords[2 * f2],
+                                          1.0f - attrib.texcoords[2 * f2 + 1]);
+                        }
+                    }
+                    else
                     {
                         texCoord[0] = glm::vec2(0.0f, 0.0f);
                         texCoord[1] = glm::vec2(0.0f, 0.0f);
                         texCoord[2] = glm::vec2(0.0f, 0.0f);
                     }
-                    else
-                    {
-                        assert(attrib.texcoords.size() > size_t(2 * f0 + 1));
-                        assert(attrib.texcoords.size() > size_t(2 * f1 + 1));
-                        assert(attrib.texcoords.size() > size_t(2 * f2 + 1));
-
-                        //! Flip Y coord.
-                        texCoord[0] =
-                            glm::vec2(attrib.texcoords[2 * f0],
-                                      1.0f - attrib.texcoords[2 * f0 + 1]);
-                        texCoord[1] =
-                            glm::vec2(attrib.texcoords[2 * f1],
-                                      1.0f - attrib.texcoords[2 * f1 + 1]);
-                        texCoord[2] =
-                            glm::vec2(attrib.texcoords[2 * f2],
-                                      1.0f - attrib.texcoords[2 * f2 + 1]);
-                    }
                 }
-                else
+
+                for (unsigned int k = 0; k < 3; ++k)
                 {
-                    texCoord[0] = glm::vec2(0.0f, 0.0f);
-                    texCoord[1] = glm::vec2(0.0f, 0.0f);
-                    texCoord[2] = glm::vec2(0.0f, 0.0f);
+                    PackedVertex& corner =
+                        corners[cornerBase + 3 * faceIndex + k];
+                    corner.position = position[k];
+                    corner.texCoord = texCoord[k];
+                    corner.normal = normal[k];
                 }
             }
+        });
+        cornerBase += numFaces * 3;
+    }
 
-            //! From now on, vertices in one face allocated.
-            for (unsigned int k = 0; k < 3; ++k)
-            {
-                PackedVertex vertex(position[k], texCoord[k], normal[k]);
-
-                auto iter = packedVerticesMap.find(vertex);
+    AppendWeldedVertices(corners, format, vertices, indices);
+    return true;
+}
+}  // namespace
 
-                if (iter == packedVerticesMap.end())
-                {
-                    if (static_cast<int>(format &
-                                         Common::VertexFormat::Position3))
-                        vertices.insert(
-                            vertices.end(),
-                            { position[k].x, position[k].y, position[k].z });
-                    if (static_cast<int>(format &
-                                         Common::VertexFormat::Normal3))
-                        vertices.insert(
-                            vertices.end(),
-                            { normal[k].x, normal[k].y, normal[k].z });
-                    if (static_cast<int>(format &
-                                         Common::VertexFormat::TexCoord2))
-                        vertices.insert(vertices.end(),
-                                        { texCoord[k].x, texCoord[k].y });
-                    auto newIndex =
-                        static_cast<unsigned int>(vertices.size() - 1);
-                    indices.push_back(newIndex);
-                    packedVerticesMap[vertex] = newIndex;
-                }
-                else
-                {
-                    indices.push_back(iter->second);
-                }
-            }
+bool AssetLoader::LoadObjFile(const std::string& path,
+                              std::vector<float>& vertices,
+                              std::vector<unsigned int>& indices,
+                              Common::VertexFormat format)
+{
+    //! Fast path, parse the memory mapped file directly.
+    MappedFile file;
+    if (file.Open(path))
+    {
+        std::vector<PackedVertex> corners;
+        if (ObjParser::Parse(file.GetData(), file.GetSize(), corners) &&
+            !corners.empty())
+        {
+            AppendWeldedVertices(corners, format, vertices, indices);
+            return true;
         }
     }
 
-    return true;
+    //! Fallback to tinyobjloader for the records native parser does not
+    //! support, it also reports the detailed errors.
+    return LoadObjFileTinyObj(path, vertices, indices, format);
 }
 
 bool AssetLoader::LoadRawFile(const std::string& path, std::vector<char>& data)
@@ -0,0 +1,181 @@
+#include <Common/Culling.hpp>
+#include <Common/Macros.hpp>
+#include <cmath>
+
+#if defined(SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(SIMD_SSE2)
+#include <xmmintrin.h>
+#endif
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Returns true if the corner of the box farthest along the plane normal is
+//! inside the plane
+bool TestPlane(const glm::vec4& plane, const AABBArray& boxes, size_t i)
+{
+    const float x = plane.x >= 0.0f ? boxes.maxX[i] : boxes.minX[i];
+    const float y = plane.y >= 0.0f ? boxes.maxY[i] : boxes.minY[i];
+    const float z = plane.z >= 0.0f ? boxes.maxZ[i] : boxes.minZ[i];
+    return plane.x * x + plane.y * y + plane.z * z + plane.w >= 0.0f;
+}
+}  // namespace
+
+void AABBArray::Resize(size_t count)
+{
+    minX.resize(count, 0.0f);
+    minY.resize(count, 0.0f);
+    minZ.resize(count, 0.0f);
+    maxX.resize(count, 0.0f);
+    maxY.resize(count, 0.0f);
+    maxZ.resize(count, 0.0f);
+}
+
+void AABBArray::Set(size_t index, const glm::vec3& lower,
+                    const glm::vec3& upper)
+{
+    minX[index] = lower.x;
+    minY[index] = lower.y;
+    minZ[index] = lower.z;
+    maxX[index] = upper.x;
+    maxY[index] = upper.y;
+    maxZ[index] = upper.z;
+}
+
+Frustum ExtractFrustum(const glm::mat4& viewProjection)
+{
+    //! Rows of the matrix, glm matrices are column major
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r)
+    {
+        rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r],
+                            viewProjection[2][r], viewProjection[3][r]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    frustum.planes[4] = rows[3] + rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+    for (auto& plane : frustum.planes)
+    {
+        const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y +
+                                       plane.z * plane.z);
+        if (length > 0.0f)
+        {
+            plane /= length;
+        }
+    }
+    return frustum;
+}
+
+void TransformAABB(const glm::mat4& matrix, const glm::vec3& lower,
+                   const glm::vec3& upper, glm::vec3& worldLower,
+                   glm::vec3& worldUpper)
+{
+    const glm::vec3 center = (lower + upper) * 0.5f;
+    const glm::vec3 extent = (upper - lower) * 0.5f;
+
+    glm::vec3 worldCenter(matrix[3]);
+    glm::vec3 worldExtent(0.0f);
+    for (int c = 0; c < 3; ++c)
+    {
+        const glm::vec3 column(matrix[c]);
+        worldCenter += column * center[c];
+        worldExtent += glm::vec3(std::abs(column.x), std::abs(column.y),
+                                 std::abs(column.z)) *
+                       extent[c];
+    }
+    worldLower = worldCenter - worldExtent;
+    worldUpper = worldCenter + worldExtent;
+}
+
+size_t CullAABBs(const Frustum& frustum, const AABBArray& boxes,
+                 unsigned char* visible)
+{
+    const size_t count = boxes.Size();
+    size_t numVisible = 0;
+    size_t i = 0;
+#if defined(SIMD_AVX2)
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 minX = _mm256_loadu_ps(boxes.minX.data() + i);
+        const __m256 minY = _mm256_loadu_ps(boxes.minY.data() + i);
+        const __m256 minZ = _mm256_loadu_ps(boxes.minZ.data() + i);
+        const __m256 maxX = _mm256_loadu_ps(boxes.maxX.data() + i);
+        const __m256 maxY = _mm256_loadu_ps(boxes.maxY.data() + i);
+        const __m256 maxZ = _mm256_loadu_ps(boxes.maxZ.data() + i);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto& plane : frustum.planes)
+        {
+            const __m256 x = plane.x >= 0.0f ? maxX : minX;
+            const __m256 y = plane.y >= 0.0f ? maxY : minY;
+            const __m256 z = plane.z >= 0.0f ? maxZ : minZ;
+            const __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), x),
+                              _mm256_mul_ps(_mm256_set1_ps(plane.y), y)),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), z),
+                              _mm256_set1_ps(plane.w)));
+            inside = _mm256_and_ps(
+                inside,
+                _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        const int mask = _mm256_movemask_ps(inside);
+        for (int k = 0; k < 8; ++k)
+        {
+            visible[i + k] = static_cast<unsigned char>((mask >> k) & 1);
+            numVisible += static_cast<size_t>((mask >> k) & 1);
+        }
+    }
+#elif defined(SIMD_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 minX = _mm_loadu_ps(boxes.minX.data() + i);
+        const __m128 minY = _mm_loadu_ps(boxes.minY.data() + i);
+        const __m128 minZ = _mm_loadu_ps(boxes.minZ.data() + i);
+        const __m128 maxX = _mm_loadu_ps(boxes.maxX.data() + i);
+        const __m128 maxY = _mm_loadu_ps(boxes.maxY.data() + i);
+        const __m128 maxZ = _mm_loadu_ps(boxes.maxZ.data() + i);
+
+        __m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+        for (const auto& plane : frustum.planes)
+        {
+            const __m128 x = plane.x >= 0.0f ? maxX : minX;
+            const __m128 y = plane.y >= 0.0f ? maxY : minY;
+            const __m128 z = plane.z >= 0.0f ? maxZ : minZ;
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x),
+                           _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z),
+                           _mm_set1_ps(plane.w)));
+            inside = _mm_and_ps(inside,
+                                _mm_cmpge_ps(distance, _mm_setzero_ps()));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        for (int k = 0; k < 4; ++k)
+        {
+            visible[i + k] = static_cast<unsigned char>((mask >> k) & 1);
+            numVisible += static_cast<size_t>((mask >> k) & 1);
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        bool inside = true;
+        for (const auto& plane : frustum.planes)
+        {
+            inside = inside && TestPlane(plane, boxes, i);
+        }
+        visible[i] = inside ? 1 : 0;
+        numVisible += inside ? 1 : 0;
+    }
+    return numVisible;
+}
+};  // namespace Common
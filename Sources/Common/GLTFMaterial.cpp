@@ -6,6 +6,7 @@ namespace Common
 bool GLTFExtension::CheckRequiredExtension(const std::string& extension)
 {
     static std::unordered_set<std::string> kSupportedExtensions{
+        EXT_MESH_GPU_INSTANCING_EXTENSION_NAME,
         KHR_LIGHTS_PUNCTUAL_EXTENSION_NAME,
         KHR_MATERIALS_CLEARCOAT_EXTENSION_NAME,
         KHR_MATERIALS_PBR_SPECULAR_GLOSSINESS_EXTENSION_NAME,
@@ -20,4 +21,58 @@ bool GLTFExtension::CheckRequiredExtension(const std::string& extension)
     return kSupportedExtensions.find(extension) != kSupportedExtensions.end();
 }
 
+unsigned int GetMaterialFeatures(const GLTFMaterial& material)
+{
+    //! Tests of output.glsl evaluated once per material
+    unsigned int features = 0;
+    if (material.shadingModel == 1)
+    {
+        features |= MaterialFeature::SpecularGlossiness;
+    }
+    if (material.baseColorTexture > -1)
+    {
+        features |= MaterialFeature::BaseColorTexture;
+    }
+    if (material.metallicRoughnessTexture > -1)
+    {
+        features |= MaterialFeature::MetallicRoughnessTexture;
+    }
+    if (material.normalTexture > -1)
+    {
+        features |= MaterialFeature::NormalTexture;
+    }
+    if (material.occlusionTexture > -1)
+    {
+        features |= MaterialFeature::OcclusionTexture;
+    }
+    if (material.emissiveTexture > -1)
+    {
+        features |= MaterialFeature::EmissiveTexture;
+    }
+    if (material.alphaMode > 0)
+    {
+        features |= MaterialFeature::AlphaCutoff;
+    }
+    if (material.specularGlossiness.diffuseTexture > -1)
+    {
+        features |= MaterialFeature::DiffuseTexture;
+    }
+    return features;
+}
+
+const std::vector<std::string>& GetMaterialFeatureDefines()
+{
+    static const std::vector<std::string> kFeatureDefines{
+        "MATERIAL_SPECULAR_GLOSSINESS",
+        "HAS_BASE_COLOR_TEXTURE",
+        "HAS_METALLIC_ROUGHNESS_TEXTURE",
+        "HAS_NORMAL_TEXTURE",
+        "HAS_OCCLUSION_TEXTURE",
+        "HAS_EMISSIVE_TEXTURE",
+        "HAS_ALPHA_CUTOFF",
+        "HAS_DIFFUSE_TEXTURE",
+    };
+    return kFeatureDefines;
+}
+
 }  // namespace Common
\ No newline at end of file
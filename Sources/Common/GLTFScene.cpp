@@ -1,5 +1,9 @@
 #include <Common/GLTFScene.hpp>
+#include <Common/Macros.hpp>
 #include <Common/MathUtils.hpp>
+#include <Common/MeshUtils.hpp>
+#include <Common/ThreadPool.hpp>
+#include <algorithm>
 #include <cassert>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -14,14 +18,33 @@
 
 namespace Common
 {
+namespace  //! Anonymous namespace for file-specific constants
+{
+//! Each level of detail targets this ratio of the previous level triangles
+constexpr float kLodReductionRatio = 0.25f;
+//! Stop generating levels when the level removes less triangles than this
+constexpr float kLodMinReduction = 0.2f;
+//! Maximum simplification error relative to the primitive bounding radius
+constexpr float kLodMaxRelativeError = 0.1f;
+//! Keyframe segments the cached cursor advances before binary search
+constexpr int kMaxCursorSteps = 4;
+}  // namespace
+
 bool GLTFScene::Initialize(const std::string& filename, VertexFormat format,
                            const ImageCallback& imageCallback)
 {
     assert(static_cast<int>(format & Common::VertexFormat::Position3) &&
            "Scene model must contain Position attribute");
 
+    //! Skip parsing if valid cache exists.
+    if (!_cacheDirectory.empty() && LoadCache(filename, format, imageCallback))
+    {
+        return true;
+    }
+
     tinygltf::Model model;
-    if (!LoadModel(&model, filename))
+    EncodedImages encodedImages;
+    if (!LoadModel(&model, filename, &encodedImages))
     {
         return false;
     }
@@ -36,11 +59,19 @@ bool GLTFScene::Initialize(const std::string& filename, VertexFormat format,
         }
     }
 
+    //! Decode images on the worker threads while geometry is processed.
+    std::vector<std::future<bool>> imageDecodes =
+        DecodeImages(model, encodedImages);
+
     size_t numVertices{ 0 };
     size_t numIndices{ 0 };
     size_t primCount{ 0 };
     size_t meshCount{ 0 };
+    bool hasSkinnedPrims{ false };
 
+    //! Pre-pass computes the exact output range of each primitive, so the
+    //! primitives can be processed concurrently.
+    std::vector<const tinygltf::Primitive*> primitives;
     for (const auto& mesh : model.meshes)
     {
         std::vector<size_t> vPrim;
@@ -52,49 +83,78 @@ bool GLTFScene::Initialize(const std::string& filename, VertexFormat format,
             }
             const auto& posAccessor =
                 model.accessors[prim.attributes.find("POSITION")->second];
-            numVertices += posAccessor.count;
-            if (prim.indices > -1)
-            {
-                const auto& indexAccessor = model.accessors[prim.indices];
-                numIndices += indexAccessor.count;
-            }
-            else
-            {
-                numIndices += posAccessor.count;
-            }
+
+            GLTFPrimMesh primMesh;
+            primMesh.name = mesh.name;
+            primMesh.materialIndex = prim.material < 0 ? 0 : prim.material;
+            primMesh.vertexOffset = static_cast<unsigned int>(numVertices);
+            primMesh.vertexCount = static_cast<unsigned int>(posAccessor.count);
+            primMesh.firstIndex = static_cast<unsigned int>(numIndices);
+            primMesh.indexCount = static_cast<unsigned int>(
+                prim.indices > -1 ? model.accessors[prim.indices].count
+                                  : posAccessor.count);
+            primMesh.skinned =
+                !model.skins.empty() &&
+                prim.attributes.find("JOINTS_0") != prim.attributes.end() &&
+                prim.attributes.find("WEIGHTS_0") != prim.attributes.end();
+            hasSkinnedPrims |= primMesh.skinned;
+            numVertices += primMesh.vertexCount;
+            numIndices += primMesh.indexCount;
+
+            _scenePrimMeshes.emplace_back(std::move(primMesh));
+            primitives.push_back(&prim);
             vPrim.push_back(primCount++);
         }
         _meshToPrimMap[meshCount++] = std::move(vPrim);
     }
 
-    _positions.reserve(numVertices);
-    _indices.reserve(numIndices);
+    _positions.resize(numVertices);
+    _indices.resize(numIndices);
     if (static_cast<bool>(format & VertexFormat::Normal3))
     {
-        _normals.reserve(numVertices);
+        _normals.resize(numVertices);
     }
     if (static_cast<bool>(format & VertexFormat::Tangent4))
     {
-        _tangents.reserve(numVertices);
+        _tangents.resize(numVertices);
     }
     if (static_cast<bool>(format & VertexFormat::Color4))
     {
-        _colors.reserve(numVertices);
+        _colors.resize(numVertices);
     }
     if (static_cast<bool>(format & VertexFormat::TexCoord2))
     {
-        _texCoords.reserve(numVertices);
+        _texCoords.resize(numVertices);
+    }
+    if (hasSkinnedPrims)
+    {
+        _skinVertices.resize(numVertices);
     }
 
     //! Convert all mesh/primitves+ to a single primitive per mesh.
-    for (const auto& mesh : model.meshes)
+    //! Each primitive writes only into its own range of the shared arrays.
+    ThreadPool::GetGlobalPool().ParallelFor(0, primCount, [&](size_t i) {
+        ProcessMesh(model, *primitives[i], format, _scenePrimMeshes[i]);
+    });
+
+    //! Morph targets are appended to the shared pools in primitive order
+    for (size_t i = 0; i < primCount; ++i)
     {
-        for (const auto& prim : mesh.primitives)
+        if (!primitives[i]->targets.empty())
         {
-            ProcessMesh(model, prim, format, mesh.name);
+            ProcessMorphTargets(model, *primitives[i], _scenePrimMeshes[i]);
         }
     }
 
+    if (_optimizeMeshes)
+    {
+        OptimizePrimMeshes();
+    }
+    if (_numLodLevels > 0)
+    {
+        GeneratePrimMeshLods();
+    }
+
     //! Transforming the scene hierarchy to a flat list.
     int defaultScene = model.defaultScene > -1 ? model.defaultScene : 0;
     const auto& scene = model.scenes[defaultScene];
@@ -102,6 +162,8 @@ bool GLTFScene::Initialize(const std::string& filename, VertexFormat format,
     {
         ProcessNode(model, nodeIdx, -1);
     }
+    ProcessSkins(model);
+    SanitizeSkinVertices();
 
     //! Convert all channels & samplers into each single vectors,
     //! make animation node point to base & stride of them.
@@ -117,40 +179,236 @@ bool GLTFScene::Initialize(const std::string& filename, VertexFormat format,
 
     //! Clear all temporal resources.
     _meshToPrimMap.clear();
-    _u8Buffer.clear();
-    _u16Buffer.clear();
-    _u32Buffer.clear();
 
     //! Import materials from the model
     ImportMaterials(model);
 
-    //! Finally import images from the model
-    if (imageCallback != nullptr)
+    //! Finally import images from the model in order, each one as soon as
+    //! its decoding is finished.
+    for (size_t i = 0; i < model.images.size(); ++i)
     {
-        for (const auto& image : model.images)
+        if (imageDecodes[i].valid())
+        {
+            ThreadPool::GetGlobalPool().Wait(imageDecodes[i]);
+        }
+        if (imageCallback != nullptr)
         {
-            imageCallback(image);
+            imageCallback(model.images[i]);
         }
     }
 
+    if (!_cacheDirectory.empty())
+    {
+        SaveCache(filename, format, model);
+    }
+
     return true;
 }
 
-void GLTFScene::ProcessMesh(const tinygltf::Model& model,
-                            const tinygltf::Primitive& mesh,
-                            VertexFormat format, const std::string& name)
+void GLTFScene::SetCacheDirectory(const std::string& directory)
 {
-    GLTFPrimMesh resultMesh;
-    resultMesh.name = name;
-    resultMesh.materialIndex = mesh.material < 0 ? 0 : mesh.material;
-    resultMesh.vertexOffset = static_cast<unsigned int>(_positions.size());
-    resultMesh.firstIndex = static_cast<unsigned int>(_indices.size());
+    _cacheDirectory = directory;
+}
+
+const std::string& GLTFScene::GetCacheDirectory() const
+{
+    return _cacheDirectory;
+}
 
-    //! Only triangles supported.
-    if (mesh.mode != TINYGLTF_MODE_TRIANGLES)
+TextureRole GLTFScene::GetTextureRole(int textureIndex) const
+{
+    //! Roles in order of precedence, the first one referencing the texture
+    //! in any material wins.
+    const std::pair<TextureRole, std::function<bool(const GLTFMaterial&)>>
+        roles[] = {
+            { TextureRole::Normal,
+              [=](const GLTFMaterial& material) {
+                  return material.normalTexture == textureIndex ||
+                         material.clearcoat.normalTexture == textureIndex;
+              } },
+            { TextureRole::BaseColor,
+              [=](const GLTFMaterial& material) {
+                  return material.baseColorTexture == textureIndex ||
+                         material.specularGlossiness.diffuseTexture ==
+                             textureIndex;
+              } },
+            { TextureRole::Emissive,
+              [=](const GLTFMaterial& material) {
+                  return material.emissiveTexture == textureIndex;
+              } },
+            { TextureRole::MetallicRoughness,
+              [=](const GLTFMaterial& material) {
+                  return material.metallicRoughnessTexture == textureIndex ||
+                         material.specularGlossiness
+                                 .specularGlossinessTexture == textureIndex;
+              } },
+            { TextureRole::Occlusion,
+              [=](const GLTFMaterial& material) {
+                  return material.occlusionTexture == textureIndex;
+              } }
+        };
+
+    for (const auto& [role, references] : roles)
     {
-        return;
+        if (std::any_of(_sceneMaterials.begin(), _sceneMaterials.end(),
+                        references))
+        {
+            return role;
+        }
+    }
+    return TextureRole::Unknown;
+}
+
+void GLTFScene::SetMeshOptimization(bool enable)
+{
+    _optimizeMeshes = enable;
+}
+
+void GLTFScene::SetLODGeneration(unsigned int numLevels)
+{
+    _numLodLevels = numLevels;
+}
+
+void GLTFScene::OptimizePrimMeshes()
+{
+    const size_t primCount = _scenePrimMeshes.size();
+    ThreadPool::GetGlobalPool().ParallelFor(0, primCount, [&](size_t i) {
+        const GLTFPrimMesh& primMesh = _scenePrimMeshes[i];
+        unsigned int* indices = _indices.data() + primMesh.firstIndex;
+        const size_t indexCount = primMesh.indexCount;
+        const size_t vertexCount = primMesh.vertexCount;
+        const size_t offset = primMesh.vertexOffset;
+
+        //! Indices are local to the primitive as drawn with base vertex.
+        if (indexCount == 0 || indexCount % 3 != 0 ||
+            std::any_of(indices, indices + indexCount,
+                        [vertexCount](unsigned int index) {
+                            return index >= vertexCount;
+                        }))
+        {
+            return;
+        }
+
+        MeshUtils::OptimizeVertexCache(indices, indexCount, vertexCount);
+        MeshUtils::OptimizeOverdraw(indices, indexCount,
+                                    _positions.data() + offset, vertexCount);
+
+        std::vector<unsigned int> remap;
+        MeshUtils::OptimizeVertexFetch(indices, indexCount, vertexCount,
+                                       remap);
+        MeshUtils::RemapVertexStream(_positions.data() + offset, remap);
+        if (!_normals.empty())
+        {
+            MeshUtils::RemapVertexStream(_normals.data() + offset, remap);
+        }
+        if (!_tangents.empty())
+        {
+            MeshUtils::RemapVertexStream(_tangents.data() + offset, remap);
+        }
+        if (!_colors.empty())
+        {
+            MeshUtils::RemapVertexStream(_colors.data() + offset, remap);
+        }
+        if (!_texCoords.empty())
+        {
+            MeshUtils::RemapVertexStream(_texCoords.data() + offset, remap);
+        }
+        if (!_skinVertices.empty())
+        {
+            MeshUtils::RemapVertexStream(_skinVertices.data() + offset, remap);
+        }
+
+        //! Morph deltas refer to the vertices by their local index
+        for (unsigned int t = primMesh.morphTargetBegin;
+             t < primMesh.morphTargetBegin + primMesh.morphTargetCount; ++t)
+        {
+            const GLTFMorphTarget& target = _sceneMorphTargets[t];
+            for (unsigned int d = target.deltaBegin;
+                 d < target.deltaBegin + target.deltaCount; ++d)
+            {
+                _morphDeltas[d].vertex = remap[_morphDeltas[d].vertex];
+            }
+        }
+    });
+}
+
+void GLTFScene::GeneratePrimMeshLods()
+{
+    const size_t primCount = _scenePrimMeshes.size();
+    std::vector<std::vector<unsigned int>> lodIndices(primCount *
+                                                      _numLodLevels);
+
+    ThreadPool::GetGlobalPool().ParallelFor(0, primCount, [&](size_t i) {
+        GLTFPrimMesh& primMesh = _scenePrimMeshes[i];
+        const unsigned int* indices = _indices.data() + primMesh.firstIndex;
+        const glm::vec3* positions = _positions.data() + primMesh.vertexOffset;
+        const float maxError =
+            glm::length(primMesh.max - primMesh.min) * 0.5f *
+            kLodMaxRelativeError;
+
+        std::vector<unsigned int> previous(indices,
+                                           indices + primMesh.indexCount);
+        float error = 0.0f;
+        for (unsigned int level = 0; level < _numLodLevels; ++level)
+        {
+            const size_t targetIndexCount =
+                static_cast<size_t>(previous.size() / 3 * kLodReductionRatio) *
+                3;
+            std::vector<unsigned int>& simplified =
+                lodIndices[i * _numLodLevels + level];
+            const float levelError = MeshUtils::SimplifyMesh(
+                previous.data(), previous.size(), positions,
+                primMesh.vertexCount, targetIndexCount, maxError, simplified);
+            if (simplified.empty() ||
+                simplified.size() >
+                    previous.size() * (1.0f - kLodMinReduction))
+            {
+                simplified.clear();
+                break;
+            }
+
+            if (_optimizeMeshes)
+            {
+                MeshUtils::OptimizeVertexCache(simplified.data(),
+                                               simplified.size(),
+                                               primMesh.vertexCount);
+            }
+
+            //! Each level is simplified from the previous one, so the sum
+            //! of the level errors bounds the error against the original
+            error += levelError;
+            primMesh.lods.push_back({ 0, static_cast<unsigned int>(
+                                             simplified.size()),
+                                      error });
+            previous = simplified;
+        }
+    });
+
+    //! Append the generated levels after the original indices
+    size_t numLodIndices = 0;
+    for (const auto& indices : lodIndices)
+    {
+        numLodIndices += indices.size();
     }
+    _indices.reserve(_indices.size() + numLodIndices);
+    for (size_t i = 0; i < primCount; ++i)
+    {
+        GLTFPrimMesh& primMesh = _scenePrimMeshes[i];
+        for (size_t level = 0; level < primMesh.lods.size(); ++level)
+        {
+            const auto& indices = lodIndices[i * _numLodLevels + level];
+            primMesh.lods[level].firstIndex =
+                static_cast<unsigned int>(_indices.size());
+            _indices.insert(_indices.end(), indices.begin(), indices.end());
+        }
+    }
+}
+
+void GLTFScene::ProcessMesh(const tinygltf::Model& model,
+                            const tinygltf::Primitive& mesh,
+                            VertexFormat format, GLTFPrimMesh& resultMesh)
+{
+    unsigned int* indices = _indices.data() + resultMesh.firstIndex;
 
     //! Indices
     if (mesh.indices > -1)
@@ -159,69 +417,56 @@ void GLTFScene::ProcessMesh(const tinygltf::Model& model,
         const tinygltf::BufferView& bufferView =
             model.bufferViews[indexAccessor.bufferView];
         const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+        const unsigned char* bufData =
+            &buffer.data[indexAccessor.byteOffset + bufferView.byteOffset];
 
-        resultMesh.indexCount = static_cast<unsigned int>(indexAccessor.count);
+        //! Widen the indices into the pre-sized range directly.
         switch (indexAccessor.componentType)
         {
             case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
-                _u32Buffer.resize(indexAccessor.count);
-                std::memcpy(&_u32Buffer[0],
-                            &buffer.data[indexAccessor.byteOffset +
-                                         bufferView.byteOffset],
+                std::memcpy(indices, bufData,
                             indexAccessor.count * sizeof(unsigned int));
-                _indices.insert(_indices.end(),
-                                std::make_move_iterator(_u32Buffer.begin()),
-                                std::make_move_iterator(_u32Buffer.end()));
                 break;
             case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-                _u16Buffer.resize(indexAccessor.count);
-                std::memcpy(&_u16Buffer[0],
-                            &buffer.data[indexAccessor.byteOffset +
-                                         bufferView.byteOffset],
-                            indexAccessor.count * sizeof(unsigned short));
-                _indices.insert(_indices.end(),
-                                std::make_move_iterator(_u16Buffer.begin()),
-                                std::make_move_iterator(_u16Buffer.end()));
+            {
+                const auto* src =
+                    reinterpret_cast<const unsigned short*>(bufData);
+                std::copy(src, src + indexAccessor.count, indices);
                 break;
+            }
             case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
-                _u8Buffer.resize(indexAccessor.count);
-                std::memcpy(&_u8Buffer[0],
-                            &buffer.data[indexAccessor.byteOffset +
-                                         bufferView.byteOffset],
-                            indexAccessor.count * sizeof(unsigned char));
-                _indices.insert(_indices.end(),
-                                std::make_move_iterator(_u8Buffer.begin()),
-                                std::make_move_iterator(_u8Buffer.end()));
+                std::copy(bufData, bufData + indexAccessor.count, indices);
                 break;
             default:
                 std::cerr << "Unknown index component type : "
                           << indexAccessor.componentType << " is not supported"
                           << std::endl;
+                resultMesh.indexCount = 0;
                 return;
         }
     }
     else
     {
         //! Primitive without indices, creating them
-        const auto& accessor =
-            model.accessors[mesh.attributes.find("POSITION")->second];
-        for (unsigned int i = 0; i < accessor.count; ++i)
+        for (unsigned int i = 0; i < resultMesh.indexCount; ++i)
         {
-            _indices.push_back(i);
+            indices[i] = i;
         }
-        resultMesh.indexCount = static_cast<unsigned int>(accessor.count);
     }
 
+    const unsigned int vertexCount = resultMesh.vertexCount;
+    const size_t vertexOffset = resultMesh.vertexOffset;
+
     //! POSITION
     {
-        [[maybe_unused]] bool result =
-            GetAttributes<glm::vec3>(model, mesh, _positions, "POSITION");
+        glm::vec3* meshPositions = _positions.data() + vertexOffset;
+        [[maybe_unused]] bool result = GetAttributes<glm::vec3>(
+            model, mesh.attributes, meshPositions, vertexCount, "POSITION");
 
         //! Keeping the size of this primitive (spec says this is required
         //! information)
         const auto& accessor =
             model.accessors[mesh.attributes.find("POSITION")->second];
-        resultMesh.vertexCount = static_cast<unsigned int>(accessor.count);
         if (!accessor.minValues.empty())
         {
             resultMesh.min =
@@ -239,41 +484,27 @@ void GLTFScene::ProcessMesh(const tinygltf::Model& model,
     //! NORMAL
     if (static_cast<bool>(format & VertexFormat::Normal3))
     {
-        if (!GetAttributes<glm::vec3>(model, mesh, _normals, "NORMAL"))
+        glm::vec3* meshNormals = _normals.data() + vertexOffset;
+        if (!GetAttributes<glm::vec3>(model, mesh.attributes, meshNormals,
+                                      vertexCount, "NORMAL"))
         {
-            //! You need to compute the normals
-            std::vector<glm::vec3> meshNormals(resultMesh.vertexCount,
-                                               glm::vec3(0.0f));
-            for (size_t i = 0; i < resultMesh.indexCount; i += 3)
-            {
-                unsigned int idx0 = _indices[resultMesh.firstIndex + i + 0];
-                unsigned int idx1 = _indices[resultMesh.firstIndex + i + 1];
-                unsigned int idx2 = _indices[resultMesh.firstIndex + i + 2];
-                const auto& pos0 = _positions[resultMesh.vertexOffset + idx0];
-                const auto& pos1 = _positions[resultMesh.vertexOffset + idx1];
-                const auto& pos2 = _positions[resultMesh.vertexOffset + idx2];
-                const auto edge0 = glm::normalize(pos1 - pos0);
-                const auto edge1 = glm::normalize(pos2 - pos0);
-                const auto n = glm::normalize(glm::cross(edge0, edge1));
-                meshNormals[idx0] += n;
-                meshNormals[idx1] += n;
-                meshNormals[idx2] += n;
-            }
-            _normals.insert(_normals.end(),
-                            std::make_move_iterator(meshNormals.begin()),
-                            std::make_move_iterator(meshNormals.end()));
+            MeshUtils::GenerateNormals(indices, resultMesh.indexCount,
+                                       _positions.data() + vertexOffset,
+                                       vertexCount, meshNormals);
         }
     }
 
     //! TEXCOORD2
     if (static_cast<bool>(format & VertexFormat::TexCoord2))
     {
-        if (!GetAttributes<glm::vec2>(model, mesh, _texCoords, "TEXCOORD_0"))
+        glm::vec2* meshTexCoords = _texCoords.data() + vertexOffset;
+        if (!GetAttributes<glm::vec2>(model, mesh.attributes, meshTexCoords,
+                                      vertexCount, "TEXCOORD_0"))
         {
             //! CubeMap projection
-            for (unsigned int i = 0; i < resultMesh.vertexCount; ++i)
+            for (unsigned int i = 0; i < vertexCount; ++i)
             {
-                const auto& pos = _positions[resultMesh.vertexOffset + i];
+                const auto& pos = _positions[vertexOffset + i];
                 float absX = std::fabs(pos.x);
                 float absY = std::fabs(pos.y);
                 float absZ = std::fabs(pos.z);
@@ -344,7 +575,7 @@ void GLTFScene::ProcessMesh(const tinygltf::Model& model,
                 float u = (uc / mapAxis + 1.0f) * 0.5f;
                 float v = (vc / mapAxis + 1.0f) * 0.5f;
 
-                _texCoords.emplace_back(u, v);
+                meshTexCoords[i] = glm::vec2(u, v);
             }
         }
     }
@@ -352,110 +583,225 @@ void GLTFScene::ProcessMesh(const tinygltf::Model& model,
     //! TANGENT
     if (static_cast<bool>(format & VertexFormat::Tangent4))
     {
-        if (!GetAttributes(model, mesh, _tangents, "TANGENT"))
+        glm::vec4* meshTangents = _tangents.data() + vertexOffset;
+        if (!GetAttributes(model, mesh.attributes, meshTangents, vertexCount,
+                           "TANGENT"))
         {
-            //! Implementation in "Foundations of Game Engine Development :
-            //! Volume2 Rendering"
-            std::vector<glm::vec3> tangents(resultMesh.vertexCount,
-                                            glm::vec3(0.0f));
-            std::vector<glm::vec3> bitangents(resultMesh.vertexCount,
-                                              glm::vec3(0.0f));
-            for (size_t i = 0; i < resultMesh.indexCount; i += 3)
+            //! Tangents are defined on the tangent plane of the normals,
+            //! generate temporary ones when the format has no normals.
+            std::vector<glm::vec3> generatedNormals;
+            const glm::vec3* meshNormals = nullptr;
+            if (_normals.empty())
             {
-                //! Local index
-                unsigned int idx0 = _indices[resultMesh.firstIndex + i + 0];
-                unsigned int idx1 = _indices[resultMesh.firstIndex + i + 1];
-                unsigned int idx2 = _indices[resultMesh.firstIndex + i + 2];
-                //! Global index
-                unsigned int gidx0 = idx0 + resultMesh.vertexOffset;
-                unsigned int gidx1 = idx1 + resultMesh.vertexOffset;
-                unsigned int gidx2 = idx2 + resultMesh.vertexOffset;
-
-                const auto& pos0 = _positions[gidx0];
-                const auto& pos1 = _positions[gidx1];
-                const auto& pos2 = _positions[gidx2];
-
-                const auto& uv0 = _texCoords[gidx0];
-                const auto& uv1 = _texCoords[gidx1];
-                const auto& uv2 = _texCoords[gidx2];
-
-                glm::vec3 e1 = pos1 - pos0;
-                glm::vec3 e2 = pos2 - pos0;
-                float x1 = uv1.x - uv0.x;
-                float x2 = uv2.x - uv0.x;
-                float y1 = uv1.y - uv0.y;
-                float y2 = uv2.y - uv0.y;
-
-                const float r = 1.0f / (x1 * y2 - x2 * y1);
-                glm::vec3 tangent = (e1 * y2 - e2 * y1) * r;
-                glm::vec3 bitangent = (e2 * x1 - e1 * x2) * r;
-
-                //! In case of degenerated UV coordinates
-                if (x1 == 0 || x2 == 0 || y1 == 0 || y2 == 0)
-                {
-                    const auto& nrm0 = _normals[gidx0];
-                    const auto& nrm1 = _normals[gidx1];
-                    const auto& nrm2 = _normals[gidx2];
-                    const auto N = (nrm0 + nrm1 + nrm2) / glm::vec3(3.0f);
-
-                    if (std::abs(N.x) > std::abs(N.y))
-                    {
-                        tangent = glm::vec3(N.z, 0, -N.x) /
-                                  std::sqrt(N.x * N.x + N.z * N.z);
-                    }
-                    else
-                    {
-                        tangent = glm::vec3(0, -N.z, N.y) /
-                                  std::sqrt(N.y * N.y + N.z * N.z);
-                    }
-                    bitangent = glm::cross(N, tangent);
-                }
-
-                tangents[idx0] += tangent;
-                tangents[idx1] += tangent;
-                tangents[idx2] += tangent;
-                bitangents[idx0] += bitangent;
-                bitangents[idx1] += bitangent;
-                bitangents[idx2] += bitangent;
+                generatedNormals.resize(vertexCount);
+                MeshUtils::GenerateNormals(
+                    indices, resultMesh.indexCount,
+                    _positions.data() + vertexOffset, vertexCount,
+                    generatedNormals.data());
+                meshNormals = generatedNormals.data();
             }
-
-            for (unsigned int i = 0; i < resultMesh.vertexCount; ++i)
+            else
             {
-                const auto& n = _normals[resultMesh.vertexOffset + i];
-                const auto& t = tangents[i];
-                const auto& b = bitangents[i];
-
-                //! Gram schmidt orthogonalize
-                glm::vec3 tangent =
-                    glm::normalize(t - n * glm::vec3(glm::dot(n, t)));
-                //! Calculate the handedness
-                float handedness =
-                    (glm::dot(glm::cross(t, b), n) > 0.0f) ? 1.0f : -1.0f;
-                _tangents.emplace_back(tangent.x, tangent.y, tangent.z,
-                                       handedness);
+                meshNormals = _normals.data() + vertexOffset;
             }
+
+            MeshUtils::GenerateTangents(
+                indices, resultMesh.indexCount,
+                _positions.data() + vertexOffset, meshNormals,
+                _texCoords.empty() ? nullptr
+                                   : _texCoords.data() + vertexOffset,
+                vertexCount, meshTangents);
         }
     }
 
     //! COLOR
     if (static_cast<bool>(format & VertexFormat::Color4))
     {
-        if (!GetAttributes(model, mesh, _colors, "COLOR_0"))
+        glm::vec4* meshColors = _colors.data() + vertexOffset;
+        if (!GetAttributes(model, mesh.attributes, meshColors, vertexCount,
+                           "COLOR_0"))
+        {
+            std::fill(meshColors, meshColors + vertexCount, glm::vec4(1.0f));
+        }
+    }
+
+    //! JOINTS_0 and WEIGHTS_0
+    if (resultMesh.skinned)
+    {
+        std::vector<glm::vec4> joints(vertexCount, glm::vec4(0.0f));
+        std::vector<glm::vec4> weights(vertexCount, glm::vec4(0.0f));
+        GetAttributes(model, mesh.attributes, joints.data(), vertexCount,
+                      "JOINTS_0");
+        GetAttributes(model, mesh.attributes, weights.data(), vertexCount,
+                      "WEIGHTS_0");
+
+        SkinVertex* meshSkinVertices = _skinVertices.data() + vertexOffset;
+        for (unsigned int i = 0; i < vertexCount; ++i)
+        {
+            meshSkinVertices[i].joints = glm::uvec4(joints[i]);
+            meshSkinVertices[i].weights = weights[i];
+        }
+    }
+}
+
+void GLTFScene::ProcessMorphTargets(const tinygltf::Model& model,
+                                    const tinygltf::Primitive& primitive,
+                                    GLTFPrimMesh& primMesh)
+{
+    const unsigned int vertexCount = primMesh.vertexCount;
+    std::vector<glm::vec3> positions(vertexCount);
+    std::vector<glm::vec3> normals(vertexCount);
+
+    primMesh.morphTargetBegin =
+        static_cast<unsigned int>(_sceneMorphTargets.size());
+    primMesh.morphTargetCount =
+        static_cast<unsigned int>(primitive.targets.size());
+
+    glm::vec3 minDisplacement(0.0f), maxDisplacement(0.0f);
+    for (const auto& target : primitive.targets)
+    {
+        if (!GetMorphAttributes(model, target, positions.data(), vertexCount,
+                                "POSITION"))
+        {
+            std::fill(positions.begin(), positions.end(), glm::vec3(0.0f));
+        }
+        if (!GetMorphAttributes(model, target, normals.data(), vertexCount,
+                                "NORMAL"))
         {
-            _colors.insert(_colors.end(), resultMesh.vertexCount,
-                           glm::vec4(1.0f));
+            std::fill(normals.begin(), normals.end(), glm::vec3(0.0f));
         }
+
+        //! Keep only the vertices displaced by this target
+        GLTFMorphTarget& morphTarget = _sceneMorphTargets.emplace_back();
+        morphTarget.deltaBegin = static_cast<unsigned int>(_morphDeltas.size());
+        glm::vec3 targetMin(0.0f), targetMax(0.0f);
+        for (unsigned int v = 0; v < vertexCount; ++v)
+        {
+            if (positions[v] == glm::vec3(0.0f) &&
+                normals[v] == glm::vec3(0.0f))
+            {
+                continue;
+            }
+
+            GLTFMorphDelta& delta = _morphDeltas.emplace_back();
+            delta.position = positions[v];
+            delta.vertex = v;
+            delta.normal = normals[v];
+            targetMin = glm::min(targetMin, positions[v]);
+            targetMax = glm::max(targetMax, positions[v]);
+        }
+        morphTarget.deltaCount = static_cast<unsigned int>(
+            _morphDeltas.size() - morphTarget.deltaBegin);
+
+        minDisplacement += targetMin;
+        maxDisplacement += targetMax;
+    }
+
+    //! Bounding box covers the targets blended with weights in [0, 1]
+    primMesh.min += minDisplacement;
+    primMesh.max += maxDisplacement;
+}
+
+bool GLTFScene::GetMorphAttributes(const tinygltf::Model& model,
+                                   const std::map<std::string, int>& target,
+                                   glm::vec3* displacements, size_t maxCount,
+                                   const std::string& name)
+{
+    auto iter = target.find(name);
+    if (iter == target.end())
+    {
+        return false;
+    }
+
+    //! Sparse accessor without buffer view is initialized with zeros
+    const tinygltf::Accessor& accessor = model.accessors[iter->second];
+    if (accessor.bufferView < 0)
+    {
+        std::fill(displacements, displacements + maxCount, glm::vec3(0.0f));
+    }
+    else if (!GetAttributes(model, target, displacements, maxCount, name))
+    {
+        return false;
     }
 
-    _scenePrimMeshes.emplace_back(resultMesh);
+    if (!accessor.sparse.isSparse)
+    {
+        return true;
+    }
+    if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+    {
+        std::cerr << "[GLTFScene:GetMorphAttributes] Sparse " << name
+                  << " of component type " << accessor.componentType
+                  << " is not supported" << std::endl;
+        return false;
+    }
+
+    const auto& sparse = accessor.sparse;
+    const tinygltf::BufferView& indexView =
+        model.bufferViews[sparse.indices.bufferView];
+    const tinygltf::BufferView& valueView =
+        model.bufferViews[sparse.values.bufferView];
+    const unsigned char* indexData =
+        &model.buffers[indexView.buffer]
+             .data[indexView.byteOffset + sparse.indices.byteOffset];
+    const unsigned char* valueData =
+        &model.buffers[valueView.buffer]
+             .data[valueView.byteOffset + sparse.values.byteOffset];
+    const int indexSize = tinygltf::GetComponentSizeInBytes(
+        static_cast<uint32_t>(sparse.indices.componentType));
+
+    for (int i = 0; i < sparse.count; ++i)
+    {
+        unsigned int index = 0;
+        if (indexSize == 1)
+        {
+            index = indexData[i];
+        }
+        else if (indexSize == 2)
+        {
+            unsigned short shortIndex;
+            std::memcpy(&shortIndex, indexData + i * 2, sizeof(shortIndex));
+            index = shortIndex;
+        }
+        else
+        {
+            std::memcpy(&index, indexData + i * 4, sizeof(index));
+        }
+
+        if (index < maxCount)
+        {
+            std::memcpy(&displacements[index],
+                        valueData + i * sizeof(glm::vec3), sizeof(glm::vec3));
+        }
+    }
+    return true;
 }
 
-bool GLTFScene::LoadModel(tinygltf::Model* model, const std::string& filename)
+bool GLTFScene::LoadModel(tinygltf::Model* model, const std::string& filename,
+                          EncodedImages* encodedImages)
 {
     tinygltf::TinyGLTF loader;
     std::string err;
     std::string warn;
 
+    //! Keep the encoded bytes only, decoding is deferred to DecodeImages.
+    loader.SetImageLoader(
+        [](tinygltf::Image* image, const int imageIdx, std::string*,
+           std::string*, int reqWidth, int reqHeight,
+           const unsigned char* bytes, int size, void* userData) {
+            UNUSED_VARIABLE(image);
+            UNUSED_VARIABLE(reqWidth);
+            UNUSED_VARIABLE(reqHeight);
+            auto* encoded = static_cast<EncodedImages*>(userData);
+            if (encoded->size() <= static_cast<size_t>(imageIdx))
+            {
+                encoded->resize(imageIdx + 1);
+            }
+            (*encoded)[imageIdx].assign(bytes, bytes + size);
+            return true;
+        },
+        encodedImages);
+
     bool res = loader.LoadBinaryFromFile(model, &err, &warn, filename);
     if (!res)
     {
@@ -470,30 +816,63 @@ bool GLTFScene::LoadModel(tinygltf::Model* model, const std::string& filename)
     return res;
 }
 
+std::vector<std::future<bool>> GLTFScene::DecodeImages(
+    tinygltf::Model& model, EncodedImages& encodedImages)
+{
+    std::vector<std::future<bool>> decodes(model.images.size());
+    encodedImages.resize(model.images.size());
+    for (size_t i = 0; i < model.images.size(); ++i)
+    {
+        if (encodedImages[i].empty())
+        {
+            continue;
+        }
+
+        decodes[i] = ThreadPool::GetGlobalPool().Submit([&model, &encodedImages,
+                                                         i]() {
+            std::vector<unsigned char> bytes = std::move(encodedImages[i]);
+            std::string err;
+            if (!tinygltf::LoadImageData(&model.images[i], static_cast<int>(i),
+                                         &err, nullptr, 0, 0, bytes.data(),
+                                         static_cast<int>(bytes.size()),
+                                         nullptr))
+            {
+                std::cerr << "[GLTFScene:DecodeImages] " << err;
+                return false;
+            }
+            return true;
+        });
+    }
+    return decodes;
+}
+
 void GLTFScene::ProcessNode(const tinygltf::Model& model, int nodeIdx,
                             int parentIndex)
 {
     const auto& node = model.nodes[nodeIdx];
 
-    GLTFNode newNode;
     //! Gets transformation info from the given node
+    glm::vec3 translation{ 0.0f };
+    glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+    glm::vec3 scale{ 1.0f };
+    glm::mat4 matrix{ 1.0f };
     if (!node.translation.empty())
     {
-        newNode.translation = glm::vec3(
-            node.translation[0], node.translation[1], node.translation[2]);
+        translation = glm::vec3(node.translation[0], node.translation[1],
+                                node.translation[2]);
     }
     if (!node.scale.empty())
     {
-        newNode.scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+        scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
     }
     if (!node.rotation.empty())
     {
-        newNode.rotation = glm::dquat(node.rotation[3], node.rotation[0],
-                                      node.rotation[1], node.rotation[2]);
+        rotation = glm::dquat(node.rotation[3], node.rotation[0],
+                              node.rotation[1], node.rotation[2]);
     }
     if (!node.matrix.empty())
     {
-        float* nodeMatPtr = glm::value_ptr(newNode.local);
+        float* nodeMatPtr = glm::value_ptr(matrix);
         for (int i = 0; i < 16; ++i)
         {
             nodeMatPtr[i] = static_cast<float>(node.matrix[i]);
@@ -501,9 +880,11 @@ void GLTFScene::ProcessNode(const tinygltf::Model& model, int nodeIdx,
     }
 
     //! Calculate world matrix
-    glm::mat4 worldMat =
-        (parentIndex != -1 ? _sceneNodes[parentIndex].world : glm::mat4(1.0f)) *
-        GetLocalMatrix(newNode);
+    const glm::mat4 worldMat =
+        (parentIndex != -1 ? _sceneNodes.worlds[parentIndex]
+                           : glm::mat4(1.0f)) *
+        glm::translate(glm::mat4(1.0f), translation) * glm::toMat4(rotation) *
+        glm::scale(glm::mat4(1.0f), scale) * matrix;
 
     if (node.camera > -1)
     {
@@ -556,51 +937,336 @@ void GLTFScene::ProcessNode(const tinygltf::Model& model, int nodeIdx,
     }
     else
     {
+        //! Append the node after its parent, so that parents always precede
+        //! their children in the linear scene node arrays
+        const auto newNodeIndex = static_cast<int>(_sceneNodes.Size());
+        _sceneNodes.translations.push_back(translation);
+        _sceneNodes.rotations.push_back(rotation);
+        _sceneNodes.scales.push_back(scale);
+        _sceneNodes.matrices.push_back(matrix);
+        _sceneNodes.worlds.push_back(worldMat);
+        _sceneNodes.parents.push_back(parentIndex);
+        _sceneNodes.nodeIndices.push_back(nodeIdx);
+        _sceneNodes.dirty.push_back(0);
+        //! Skin index of the model, resolved by ProcessSkins
+        _sceneNodes.skins.push_back(node.mesh > -1 ? node.skin : -1);
         if (node.mesh > -1)
         {
-            newNode.primMeshes = std::move(_meshToPrimMap[node.mesh]);
+            const auto& prims = _meshToPrimMap[node.mesh];
+            _sceneNodes.primMeshes.insert(_sceneNodes.primMeshes.end(),
+                                          prims.begin(), prims.end());
+
+            //! Weights of the node override the default weights of the mesh
+            const auto& mesh = model.meshes[node.mesh];
+            size_t numTargets = 0;
+            for (const auto& primitive : mesh.primitives)
+            {
+                numTargets = std::max(numTargets, primitive.targets.size());
+            }
+            const std::vector<double>& weights =
+                node.weights.empty() ? mesh.weights : node.weights;
+            for (size_t i = 0; i < numTargets; ++i)
+            {
+                _sceneNodes.weights.push_back(
+                    i < weights.size() ? static_cast<float>(weights[i])
+                                       : 0.0f);
+            }
+
+            const auto instancing =
+                node.extensions.find(EXT_MESH_GPU_INSTANCING_EXTENSION_NAME);
+            if (instancing != node.extensions.end())
+            {
+                ProcessInstances(model, instancing->second);
+            }
         }
+        _sceneNodes.primMeshOffsets.push_back(
+            static_cast<unsigned int>(_sceneNodes.primMeshes.size()));
+        _sceneNodes.weightOffsets.push_back(
+            static_cast<unsigned int>(_sceneNodes.weights.size()));
+        _sceneNodes.instanceOffsets.push_back(
+            static_cast<unsigned int>(_sceneNodes.instances.size()));
 
-        newNode.world = worldMat;
-        newNode.nodeIndex = nodeIdx;
-        newNode.parentNode = parentIndex;
+        //! Call ProcessNode recursively to the childs of this newNode
+        for (int child : node.children)
+        {
+            ProcessNode(model, child, newNodeIndex);
+        }
+    }
+}
 
-        //! Push newnode to both linear scene node array and parent child array
-        const size_t newNodeIndex = _sceneNodes.size();
-        _sceneNodes.emplace_back(std::move(newNode));
-        if (parentIndex != -1)
+void GLTFScene::ProcessInstances(const tinygltf::Model& model,
+                                 const tinygltf::Value& extension)
+{
+    //! Attributes refer to the accessors by name like primitive attributes
+    const tinygltf::Value& attributeValues = extension.Get("attributes");
+    if (!attributeValues.IsObject())
+    {
+        return;
+    }
+    std::map<std::string, int> attributes;
+    size_t numInstances = std::numeric_limits<size_t>::max();
+    for (const std::string& name : attributeValues.Keys())
+    {
+        const int accessor = attributeValues.Get(name).GetNumberAsInt();
+        if (accessor < 0 || accessor >= static_cast<int>(model.accessors.size()))
         {
-            _sceneNodes[parentIndex].childNodes.push_back(newNodeIndex);
+            std::cerr << "[GLTFScene:ProcessInstances] Invalid accessor of "
+                      << name << std::endl;
+            return;
         }
+        attributes.emplace(name, accessor);
+        numInstances = std::min(numInstances, model.accessors[accessor].count);
+    }
+    if (attributes.empty() || numInstances == 0)
+    {
+        return;
+    }
 
-        //! Call ProcessNode recursively to the childs of this newNode
-        for (int child : node.children)
+    std::vector<glm::vec3> translations(numInstances, glm::vec3(0.0f));
+    std::vector<glm::vec4> rotations(numInstances,
+                                     glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    std::vector<glm::vec3> scales(numInstances, glm::vec3(1.0f));
+    GetAttributes(model, attributes, translations.data(), numInstances,
+                  "TRANSLATION");
+    GetAttributes(model, attributes, rotations.data(), numInstances,
+                  "ROTATION");
+    GetAttributes(model, attributes, scales.data(), numInstances, "SCALE");
+
+    for (size_t i = 0; i < numInstances; ++i)
+    {
+        const glm::vec4& r = rotations[i];
+        _sceneNodes.instances.push_back(
+            glm::translate(glm::mat4(1.0f), translations[i]) *
+            glm::toMat4(glm::quat(r.w, r.x, r.y, r.z)) *
+            glm::scale(glm::mat4(1.0f), scales[i]));
+    }
+}
+
+void GLTFScene::ProcessSkins(const tinygltf::Model& model)
+{
+    //! Nodes are instanced once in the scene, joints refer to them by the
+    //! index in the model
+    std::vector<int> sceneNodeIndices(model.nodes.size(), -1);
+    for (size_t i = 0; i < _sceneNodes.Size(); ++i)
+    {
+        sceneNodeIndices[_sceneNodes.nodeIndices[i]] = static_cast<int>(i);
+    }
+
+    std::vector<bool> validSkins(model.skins.size(), true);
+    for (size_t s = 0; s < model.skins.size(); ++s)
+    {
+        const tinygltf::Skin& skin = model.skins[s];
+        GLTFSkin sceneSkin;
+        sceneSkin.jointBegin = static_cast<unsigned int>(_skinJoints.size());
+        sceneSkin.jointCount = static_cast<unsigned int>(skin.joints.size());
+
+        for (int joint : skin.joints)
+        {
+            const int sceneNode =
+                joint >= 0 && joint < static_cast<int>(model.nodes.size())
+                    ? sceneNodeIndices[joint]
+                    : -1;
+            if (sceneNode == -1)
+            {
+                validSkins[s] = false;
+            }
+            _skinJoints.push_back(
+                static_cast<unsigned int>(std::max(sceneNode, 0)));
+        }
+
+        //! Inverse bind matrices default to identity
+        _inverseBindMatrices.resize(_skinJoints.size(), glm::mat4(1.0f));
+        if (skin.inverseBindMatrices > -1)
+        {
+            const auto& accessor = model.accessors[skin.inverseBindMatrices];
+            if (accessor.type != TINYGLTF_TYPE_MAT4 ||
+                accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+                accessor.bufferView < 0 || accessor.count < skin.joints.size())
+            {
+                std::cerr << "[GLTFScene:ProcessSkins] Invalid inverse bind "
+                             "matrices of the skin "
+                          << skin.name << std::endl;
+                validSkins[s] = false;
+            }
+            else
+            {
+                const auto& bufferView =
+                    model.bufferViews[accessor.bufferView];
+                const auto& buffer = model.buffers[bufferView.buffer];
+                const unsigned char* bufferByte =
+                    &buffer.data[accessor.byteOffset + bufferView.byteOffset];
+                const int byteStride = accessor.ByteStride(bufferView);
+                for (unsigned int j = 0; j < sceneSkin.jointCount; ++j)
+                {
+                    std::memcpy(glm::value_ptr(
+                                    _inverseBindMatrices[sceneSkin.jointBegin +
+                                                         j]),
+                                bufferByte, sizeof(glm::mat4));
+                    bufferByte += byteStride;
+                }
+            }
+        }
+
+        if (!validSkins[s])
+        {
+            std::cerr << "[GLTFScene:ProcessSkins] Skin " << skin.name
+                      << " is ignored" << std::endl;
+        }
+        _sceneSkins.push_back(sceneSkin);
+    }
+
+    for (int& skin : _sceneNodes.skins)
+    {
+        if (skin >= static_cast<int>(validSkins.size()) ||
+            (skin != -1 && !validSkins[skin]))
         {
-            ProcessNode(model, child, static_cast<int>(newNodeIndex));
+            skin = -1;
         }
     }
 }
 
-void GLTFScene::UpdateNode(size_t nodeIndex)
+void GLTFScene::SanitizeSkinVertices()
 {
-    auto& node = _sceneNodes[nodeIndex];
-    if (!node.primMeshes.empty())
+    if (_skinVertices.empty())
+    {
+        return;
+    }
+
+    for (size_t node = 0; node < _sceneNodes.Size(); ++node)
     {
-        node.world = GetLocalMatrix(node);
-        int parentNode = node.parentNode;
-        while (parentNode != -1)
+        const int skin = _sceneNodes.skins[node];
+        if (skin == -1)
         {
-            node.world = GetLocalMatrix(_sceneNodes[parentNode]) * node.world;
-            parentNode = _sceneNodes[parentNode].parentNode;
+            continue;
+        }
+
+        const unsigned int jointCount = _sceneSkins[skin].jointCount;
+        for (unsigned int i = _sceneNodes.primMeshOffsets[node];
+             i < _sceneNodes.primMeshOffsets[node + 1]; ++i)
+        {
+            const GLTFPrimMesh& primMesh =
+                _scenePrimMeshes[_sceneNodes.primMeshes[i]];
+            if (!primMesh.skinned)
+            {
+                continue;
+            }
+
+            SkinVertex* vertices = _skinVertices.data() + primMesh.vertexOffset;
+            for (unsigned int v = 0; v < primMesh.vertexCount; ++v)
+            {
+                SkinVertex& vertex = vertices[v];
+                float sum = 0.0f;
+                for (int k = 0; k < 4; ++k)
+                {
+                    if (vertex.joints[k] >= jointCount ||
+                        !(vertex.weights[k] > 0.0f))
+                    {
+                        vertex.joints[k] = 0;
+                        vertex.weights[k] = 0.0f;
+                    }
+                    sum += vertex.weights[k];
+                }
+
+                //! Vertex without influences follows the first joint
+                vertex.weights = sum > 0.0f
+                                     ? vertex.weights / sum
+                                     : glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+            }
         }
     }
+}
 
-    for (size_t child : node.childNodes)
+void GLTFScene::ComputeJointMatrices(size_t nodeIndex,
+                                     glm::mat4* jointMatrices) const
+{
+    const GLTFSkin& skin = _sceneSkins[_sceneNodes.skins[nodeIndex]];
+    const glm::mat4 inverseWorld = glm::inverse(_sceneNodes.worlds[nodeIndex]);
+    for (unsigned int j = 0; j < skin.jointCount; ++j)
     {
-        UpdateNode(child);
+        const unsigned int joint = skin.jointBegin + j;
+        jointMatrices[j] = inverseWorld *
+                           _sceneNodes.worlds[_skinJoints[joint]] *
+                           _inverseBindMatrices[joint];
     }
 }
 
+void GLTFScene::MarkNodeDirty(size_t nodeIndex)
+{
+    _sceneNodes.dirty[nodeIndex] = 1;
+    _firstDirtyNode = std::min(_firstDirtyNode, nodeIndex);
+}
+
+void GLTFScene::UpdateWorldMatrices()
+{
+    _changedNodes.clear();
+
+    //! Nodes before the first dirty one cannot be affected, and a dirty
+    //! parent is always visited before its children.
+    const size_t numNodes = _sceneNodes.Size();
+    for (size_t i = _firstDirtyNode; i < numNodes; ++i)
+    {
+        const int parent = _sceneNodes.parents[i];
+        if (parent != -1 && _sceneNodes.dirty[parent] != 0)
+        {
+            _sceneNodes.dirty[i] = 1;
+        }
+        if (_sceneNodes.dirty[i] == 0)
+        {
+            continue;
+        }
+
+        const glm::mat4 local = GetLocalMatrix(i);
+        _sceneNodes.worlds[i] =
+            parent != -1 ? _sceneNodes.worlds[parent] * local : local;
+        _changedNodes.push_back(static_cast<unsigned int>(i));
+    }
+
+    //! Joint matrices of the skinned node are relative to the node, they
+    //! change with the node itself as well as with any of its joints
+    _changedSkinNodes.clear();
+    for (size_t i = 0; i < numNodes && !_changedNodes.empty(); ++i)
+    {
+        const int skin = _sceneNodes.skins[i];
+        if (skin == -1)
+        {
+            continue;
+        }
+
+        const GLTFSkin& sceneSkin = _sceneSkins[skin];
+        bool changed = _sceneNodes.dirty[i] != 0;
+        for (unsigned int j = sceneSkin.jointBegin;
+             j < sceneSkin.jointBegin + sceneSkin.jointCount && !changed; ++j)
+        {
+            changed = _sceneNodes.dirty[_skinJoints[j]] != 0;
+        }
+        if (changed)
+        {
+            _changedSkinNodes.push_back(static_cast<unsigned int>(i));
+        }
+    }
+
+    for (unsigned int node : _changedNodes)
+    {
+        _sceneNodes.dirty[node] = 0;
+    }
+    _firstDirtyNode = std::numeric_limits<size_t>::max();
+}
+
+const std::vector<unsigned int>& GLTFScene::GetChangedNodes() const
+{
+    return _changedNodes;
+}
+
+const std::vector<unsigned int>& GLTFScene::GetChangedMorphNodes() const
+{
+    return _changedMorphNodes;
+}
+
+const std::vector<unsigned int>& GLTFScene::GetChangedSkinNodes() const
+{
+    return _changedSkinNodes;
+}
+
 bool GLTFScene::UpdateAnimation(size_t animIndex, double timeElapsed)
 {
     //! There is no animation corresponded to given index, therefore return.
@@ -609,87 +1275,174 @@ bool GLTFScene::UpdateAnimation(size_t animIndex, double timeElapsed)
         return false;
     }
 
-    bool sceneModified = false;
     const auto& anim = _sceneAnims[animIndex];
-
-    //! Get maximum interval from scene samplers
-    //! TODO(snowapril) : this can be precalculated
-    double maxAnimInterval = 0.0;
-    for (size_t s = anim.samplerIndex;
-         s < anim.samplerIndex + anim.samplerCount; ++s)
+    if (anim.duration <= 0.0f)
+    {
+        return false;
+    }
+    if (_channelCursors.size() != _sceneChannels.size())
     {
-        maxAnimInterval =
-            std::max(maxAnimInterval,
-                     static_cast<double>(_sceneSamplers[s].inputs.back()));
+        _channelCursors.assign(_sceneChannels.size(), 0);
     }
-    //! Calculate timeElapsed modulo max interval
-    const auto elapsed =
-        static_cast<float>(std::fmod(timeElapsed, maxAnimInterval));
 
+    //! Calculate timeElapsed modulo clip duration
+    const auto elapsed = static_cast<float>(
+        std::fmod(timeElapsed, static_cast<double>(anim.duration)));
+
+    bool sceneModified = false;
+    _changedMorphNodes.clear();
     for (size_t ch = anim.channelIndex;
          ch < anim.channelCount + anim.channelIndex; ++ch)
     {
         const auto& channel = _sceneChannels[ch];
         const auto& sampler = _sceneSamplers[channel.samplerIndex];
-        auto& node = _sceneNodes[channel.nodeIndex];
+        const auto node = static_cast<size_t>(channel.nodeIndex);
+        if (sampler.keyCount == 0)
+        {
+            continue;
+        }
 
-        for (size_t i = 0; i < sampler.inputs.size() - 1; ++i)
+        //! Weights sampler has a value per morph target of the node
+        if (channel.path == GLTFChannel::Path::Weights)
         {
-            if (sampler.inputs[i] <= elapsed && elapsed < sampler.inputs[i + 1])
+            _sampledWeights.resize(sampler.valueWidth);
+            EvaluateSampler(sampler, false, elapsed, _channelCursors[ch],
+                            _sampledWeights.data());
+
+            const unsigned int weightBegin = _sceneNodes.weightOffsets[node];
+            const unsigned int numWeights = std::min(
+                _sceneNodes.weightOffsets[node + 1] - weightBegin,
+                sampler.valueWidth);
+            for (unsigned int i = 0; i < numWeights; ++i)
             {
-                const float keyframe = std::max(
-                    0.0f, (elapsed - sampler.inputs[i]) /
-                              (sampler.inputs[i + 1] - sampler.inputs[i]));
-                if (keyframe <= 1.0f)
-                {
-                    switch (channel.path)
-                    {
-                        case GLTFChannel::Path::Translation:
-                            node.translation = Interpolation::Lerp(
-                                sampler.outputs[i], sampler.outputs[i + 1],
-                                keyframe);
-                            break;
-                        case GLTFChannel::Path::Rotation:
-                            node.rotation = glm::normalize(glm::slerp(
-                                glm::quat(
-                                    sampler.outputs[i].w, sampler.outputs[i].x,
-                                    sampler.outputs[i].y, sampler.outputs[i].z),
-                                glm::quat(sampler.outputs[i + 1].w,
-                                          sampler.outputs[i + 1].x,
-                                          sampler.outputs[i + 1].y,
-                                          sampler.outputs[i + 1].z),
-                                keyframe));
-                            break;
-                        case GLTFChannel::Path::Scale:
-                            node.scale = Interpolation::Lerp(
-                                sampler.outputs[i], sampler.outputs[i + 1],
-                                keyframe);
-                            break;
-                        case GLTFChannel::Path::Weights:
-                            std::cerr << "[GLTFScene::UpdateAnimation] Weights "
-                                         "not implemented yet"
-                                      << std::endl;
-                            return false;
-                            break;
-                    }
-
-                    sceneModified = true;
-                }
+                _sceneNodes.weights[weightBegin + i] = _sampledWeights[i].x;
             }
+            _changedMorphNodes.push_back(static_cast<unsigned int>(node));
+            sceneModified = true;
+            continue;
+        }
+        if (sampler.valueWidth != 1)
+        {
+            continue;
         }
-    }
 
-    if (sceneModified)
-    {
-        for (size_t i = 0; i < _sceneNodes.size(); ++i)
+        const bool isRotation = channel.path == GLTFChannel::Path::Rotation;
+        glm::vec4 value;
+        EvaluateSampler(sampler, isRotation, elapsed, _channelCursors[ch],
+                        &value);
+
+        switch (channel.path)
         {
-            UpdateNode(i);
+            case GLTFChannel::Path::Translation:
+                _sceneNodes.translations[node] = glm::vec3(value);
+                break;
+            case GLTFChannel::Path::Rotation:
+                _sceneNodes.rotations[node] =
+                    glm::quat(value.w, value.x, value.y, value.z);
+                break;
+            case GLTFChannel::Path::Scale:
+                _sceneNodes.scales[node] = glm::vec3(value);
+                break;
+            default:
+                break;
         }
+        MarkNodeDirty(node);
+        sceneModified = true;
     }
 
+    std::sort(_changedMorphNodes.begin(), _changedMorphNodes.end());
+    _changedMorphNodes.erase(
+        std::unique(_changedMorphNodes.begin(), _changedMorphNodes.end()),
+        _changedMorphNodes.end());
+    UpdateWorldMatrices();
+
     return sceneModified;
 }
 
+void GLTFScene::EvaluateSampler(const GLTFSampler& sampler, bool isRotation,
+                                float time, unsigned int& cursor,
+                                glm::vec4* result) const
+{
+    const float* times = _animKeyTimes.data() + sampler.keyBegin;
+    const glm::vec4* values = _animKeyValues.data() + sampler.valueBegin;
+    const unsigned int width = sampler.valueWidth;
+    const unsigned int lastKey = sampler.keyCount - 1;
+    const bool isCubic =
+        sampler.interpolation == GLTFSampler::Interpolation::Cubicspline;
+    //! Values of the key skip the in-tangents of cubic spline keys
+    auto keyValues = [=](unsigned int key) {
+        return values + (isCubic ? key * 3 + 1 : key) * width;
+    };
+
+    //! Values are clamped outside of the key times
+    if (time <= times[0] || lastKey == 0)
+    {
+        cursor = 0;
+        std::copy(keyValues(0), keyValues(0) + width, result);
+        return;
+    }
+    if (time >= times[lastKey])
+    {
+        cursor = lastKey - 1;
+        std::copy(keyValues(lastKey), keyValues(lastKey) + width, result);
+        return;
+    }
+
+    //! Advance the cached cursor by a few segments while playing forward,
+    //! otherwise binary search the segment containing the time.
+    unsigned int segment = std::min(cursor, lastKey - 1);
+    if (times[segment] <= time)
+    {
+        for (int step = 0; step < kMaxCursorSteps && times[segment + 1] <= time;
+             ++step)
+        {
+            ++segment;
+        }
+    }
+    if (time < times[segment] || times[segment + 1] <= time)
+    {
+        const float* upper = std::upper_bound(times, times + lastKey + 1, time);
+        segment = static_cast<unsigned int>(upper - times) - 1;
+    }
+    cursor = segment;
+
+    const float deltaTime = times[segment + 1] - times[segment];
+    const float keyframe = (time - times[segment]) / deltaTime;
+    const glm::vec4* prev = keyValues(segment);
+    const glm::vec4* next = keyValues(segment + 1);
+    //! Out-tangents follow the values, in-tangents precede them
+    const glm::vec4* prevOutTangents = prev + width;
+    const glm::vec4* nextInTangents = next - width;
+    for (unsigned int i = 0; i < width; ++i)
+    {
+        switch (sampler.interpolation)
+        {
+            case GLTFSampler::Interpolation::Step:
+                result[i] = prev[i];
+                break;
+            case GLTFSampler::Interpolation::Cubicspline:
+            {
+                result[i] = Interpolation::CubicSpline(
+                    prev[i], prevOutTangents[i], nextInTangents[i], next[i],
+                    keyframe, deltaTime);
+                if (isRotation)
+                {
+                    result[i] = glm::normalize(result[i]);
+                }
+                break;
+            }
+            case GLTFSampler::Interpolation::Linear:
+            default:
+                result[i] =
+                    isRotation
+                        ? glm::normalize(
+                              Interpolation::SLerp(prev[i], next[i], keyframe))
+                        : Interpolation::Lerp(prev[i], next[i], keyframe);
+                break;
+        }
+    }
+}
+
 void GLTFScene::ProcessAnimation(const tinygltf::Model& model,
                                  const tinygltf::Animation& anim,
                                  std::size_t channelOffset,
@@ -698,13 +1451,11 @@ void GLTFScene::ProcessAnimation(const tinygltf::Model& model,
     GLTFAnimation animation;
     animation.name = anim.name;
     animation.channelIndex = channelOffset;
-    animation.channelCount = static_cast<int>(anim.channels.size());
     animation.samplerIndex = samplerOffset;
-    animation.samplerCount = static_cast<int>(anim.samplers.size());
 
     for (const auto& channel : anim.channels)
     {
-        ProcessChannel(channel);
+        ProcessChannel(channel, samplerOffset);
     }
 
     for (const auto& sampler : anim.samplers)
@@ -712,20 +1463,38 @@ void GLTFScene::ProcessAnimation(const tinygltf::Model& model,
         ProcessSampler(model, sampler);
     }
 
+    //! Channels with unknown target path are skipped
+    animation.channelCount = _sceneChannels.size() - channelOffset;
+    animation.samplerCount = _sceneSamplers.size() - samplerOffset;
+
+    //! Duration of the clip is the last key time among its samplers
+    for (size_t s = samplerOffset; s < _sceneSamplers.size(); ++s)
+    {
+        const GLTFSampler& sampler = _sceneSamplers[s];
+        if (sampler.keyCount > 0)
+        {
+            animation.duration = std::max(
+                animation.duration,
+                _animKeyTimes[sampler.keyBegin + sampler.keyCount - 1]);
+        }
+    }
+
     _sceneAnims.emplace_back(std::move(animation));
 }
 
-void GLTFScene::ProcessChannel(const tinygltf::AnimationChannel& channel)
+void GLTFScene::ProcessChannel(const tinygltf::AnimationChannel& channel,
+                               std::size_t samplerOffset)
 {
     GLTFChannel newChannel;
-    newChannel.samplerIndex = channel.sampler;
+    newChannel.samplerIndex =
+        static_cast<int>(samplerOffset) + channel.sampler;
     //! Remapping gltf::channel::node_index to our node index
-    for (int i = 0; i < static_cast<int>(_sceneNodes.size()); ++i)
+    const auto& nodeIndices = _sceneNodes.nodeIndices;
+    const auto iter = std::find(nodeIndices.begin(), nodeIndices.end(),
+                                channel.target_node);
+    if (iter != nodeIndices.end())
     {
-        if (_sceneNodes[i].nodeIndex == channel.target_node)
-        {
-            newChannel.nodeIndex = i;
-        }
+        newChannel.nodeIndex = static_cast<int>(iter - nodeIndices.begin());
     }
     //! Assign matched channel path by comparing target_path string
     if (channel.target_path == "translation")
@@ -759,7 +1528,9 @@ void GLTFScene::ProcessChannel(const tinygltf::AnimationChannel& channel)
 void GLTFScene::ProcessSampler(const tinygltf::Model& model,
                                const tinygltf::AnimationSampler& sampler)
 {
-    GLTFSampler newSampler;
+    //! Invalid samplers are kept empty so channels still index the right one
+    GLTFSampler& newSampler = _sceneSamplers.emplace_back();
+
     //! Assign sampler interpolation method by comparing interpolation string
     if (sampler.interpolation == "LINEAR")
     {
@@ -783,22 +1554,19 @@ void GLTFScene::ProcessSampler(const tinygltf::Model& model,
     }
 
     //! Process sampler inputs
+    const tinygltf::Accessor& inputAccessor = model.accessors[sampler.input];
     {
-        const tinygltf::Accessor& accessor = model.accessors[sampler.input];
         const tinygltf::BufferView& bufferView =
-            model.bufferViews[accessor.bufferView];
+            model.bufferViews[inputAccessor.bufferView];
         const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
 
-        assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
+        assert(inputAccessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
 
-        const void* dataPtr =
-            &buffer.data[accessor.byteOffset + bufferView.byteOffset];
-
-        const auto* buf = static_cast<const float*>(dataPtr);
-        for (size_t i = 0; i < accessor.count; ++i)
-        {
-            newSampler.inputs.push_back(buf[i]);
-        }
+        const auto* buf = reinterpret_cast<const float*>(
+            &buffer.data[inputAccessor.byteOffset + bufferView.byteOffset]);
+        newSampler.keyBegin = static_cast<unsigned int>(_animKeyTimes.size());
+        _animKeyTimes.insert(_animKeyTimes.end(), buf,
+                             buf + inputAccessor.count);
     }
 
     //! Process sampler outputs
@@ -813,12 +1581,14 @@ void GLTFScene::ProcessSampler(const tinygltf::Model& model,
         const void* dataPtr =
             &buffer.data[accessor.byteOffset + bufferView.byteOffset];
 
+        newSampler.valueBegin =
+            static_cast<unsigned int>(_animKeyValues.size());
         if (accessor.type == TINYGLTF_TYPE_SCALAR)
         {
             const auto* buf = static_cast<const float*>(dataPtr);
             for (size_t i = 0; i < accessor.count; ++i)
             {
-                newSampler.outputs.emplace_back(buf[i], glm::vec3(0.0f));
+                _animKeyValues.emplace_back(buf[i], glm::vec3(0.0f));
             }
         }
         else if (accessor.type == TINYGLTF_TYPE_VEC3)
@@ -826,16 +1596,14 @@ void GLTFScene::ProcessSampler(const tinygltf::Model& model,
             const auto* buf = static_cast<const glm::vec3*>(dataPtr);
             for (size_t i = 0; i < accessor.count; ++i)
             {
-                newSampler.outputs.emplace_back(buf[i], 1.0);
+                _animKeyValues.emplace_back(buf[i], 1.0);
             }
         }
         else if (accessor.type == TINYGLTF_TYPE_VEC4)
         {
             const auto* buf = static_cast<const glm::vec4*>(dataPtr);
-            for (size_t i = 0; i < accessor.count; ++i)
-            {
-                newSampler.outputs.push_back(buf[i]);
-            }
+            _animKeyValues.insert(_animKeyValues.end(), buf,
+                                  buf + accessor.count);
         }
         else
         {
@@ -847,35 +1615,67 @@ void GLTFScene::ProcessSampler(const tinygltf::Model& model,
         }
     }
 
-    _sceneSamplers.emplace_back(std::move(newSampler));
+    //! Outputs hold valueWidth values per key, times three for cubic spline
+    const size_t numKeyValues =
+        inputAccessor.count *
+        (newSampler.interpolation == GLTFSampler::Interpolation::Cubicspline
+             ? 3
+             : 1);
+    const size_t numValues = _animKeyValues.size() - newSampler.valueBegin;
+    if (numKeyValues == 0 || numValues % numKeyValues != 0)
+    {
+        std::cerr << "[GLTFScene::ProcessAnimation] Sampler output count "
+                  << numValues << " does not match input count "
+                  << inputAccessor.count << '\n';
+        return;
+    }
+    newSampler.valueWidth = static_cast<unsigned int>(numValues / numKeyValues);
+    newSampler.keyCount = static_cast<unsigned int>(inputAccessor.count);
 }
 
-glm::mat4 GLTFScene::GetLocalMatrix(const GLTFNode& node)
+glm::mat4 GLTFScene::GetLocalMatrix(size_t nodeIndex) const
 {
-    return glm::translate(glm::mat4(1.0f), node.translation) *
-           glm::toMat4(node.rotation) *
-           glm::scale(glm::mat4(1.0f), node.scale) * node.local;
+    return glm::translate(glm::mat4(1.0f),
+                          _sceneNodes.translations[nodeIndex]) *
+           glm::toMat4(_sceneNodes.rotations[nodeIndex]) *
+           glm::scale(glm::mat4(1.0f), _sceneNodes.scales[nodeIndex]) *
+           _sceneNodes.matrices[nodeIndex];
 }
 
 void GLTFScene::CalculateSceneDimension()
 {
     auto bbMin = glm::vec3(std::numeric_limits<float>::max());
     auto bbMax = glm::vec3(std::numeric_limits<float>::min());
-    for (const auto& node : _sceneNodes)
+    for (size_t node = 0; node < _sceneNodes.Size(); ++node)
     {
-        for (size_t meshIdx : node.primMeshes)
+        //! Node without instance transforms is drawn once as it is
+        const unsigned int instanceBegin = _sceneNodes.instanceOffsets[node];
+        const unsigned int instanceEnd = std::max(
+            _sceneNodes.instanceOffsets[node + 1], instanceBegin + 1);
+        for (unsigned int instance = instanceBegin; instance < instanceEnd;
+             ++instance)
         {
-            const auto& mesh = _scenePrimMeshes[meshIdx];
-
-            auto localMin = node.world * glm::vec4(mesh.min, 1.0f);
-            auto localMax = node.world * glm::vec4(mesh.max, 1.0f);
-
-            bbMin = { std::min(bbMin.x, localMin.x),
-                      std::min(bbMin.z, localMin.z),
-                      std::min(bbMin.z, localMin.z) };
-            bbMax = { std::max(bbMax.x, localMax.x),
-                      std::max(bbMax.z, localMax.z),
-                      std::max(bbMax.z, localMax.z) };
+            const glm::mat4 world =
+                instance < _sceneNodes.instanceOffsets[node + 1]
+                    ? _sceneNodes.worlds[node] *
+                          _sceneNodes.instances[instance]
+                    : _sceneNodes.worlds[node];
+            for (unsigned int i = _sceneNodes.primMeshOffsets[node];
+                 i < _sceneNodes.primMeshOffsets[node + 1]; ++i)
+            {
+                const auto& mesh =
+                    _scenePrimMeshes[_sceneNodes.primMeshes[i]];
+
+                auto localMin = world * glm::vec4(mesh.min, 1.0f);
+                auto localMax = world * glm::vec4(mesh.max, 1.0f);
+
+                bbMin = { std::min(bbMin.x, localMin.x),
+                          std::min(bbMin.z, localMin.z),
+                          std::min(bbMin.z, localMin.z) };
+                bbMax = { std::max(bbMax.x, localMax.x),
+                          std::max(bbMax.z, localMax.z),
+                          std::max(bbMax.z, localMax.z) };
+            }
         }
     }
 
@@ -1052,5 +1852,7 @@ void GLTFScene::ReleaseSourceData()
     _colors.clear();
     _texCoords.clear();
     _indices.clear();
+    _morphDeltas.clear();
+    _skinVertices.clear();
 }
 };  // namespace Common
\ No newline at end of file
@@ -0,0 +1,983 @@
+#include <Common/GLTFScene.hpp>
+#include <Common/HashUtils.hpp>
+#include <Common/MappedFile.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Increase whenever the layout of the cache file or cached structs changes.
+constexpr std::uint32_t kCacheVersion = 8;
+constexpr char kCacheMagic[8] = { 'R', 'F', 'S', 'C', 'E', 'N', 'E', '\0' };
+
+//! Processing options which change the cached output, part of the cache key.
+constexpr std::uint32_t kOptimizedMeshesFlag = 1u << 0;
+constexpr std::uint32_t kLodLevelsShift = 8;
+
+//! Dependency hash recorded for the referenced file which does not exist.
+constexpr std::uint64_t kMissingFileHash = 0;
+
+//! Sections are aligned to the cache line, arrays can be used in-place.
+constexpr std::uint64_t kSectionAlignment = 64;
+
+enum class CacheSectionID : std::uint32_t
+{
+    Positions = 0,
+    Normals,
+    Tangents,
+    Colors,
+    TexCoords,
+    Indices,
+    PrimMeshes,
+    PrimMeshLods,
+    MorphTargets,
+    MorphDeltas,
+    SkinVertices,
+    Skins,
+    SkinJoints,
+    InverseBindMatrices,
+    NodeTranslations,
+    NodeRotations,
+    NodeScales,
+    NodeMatrices,
+    NodeWorlds,
+    NodeParents,
+    NodeIndices,
+    NodePrimMeshOffsets,
+    NodePrimMeshes,
+    NodeWeightOffsets,
+    NodeWeights,
+    NodeSkins,
+    NodeInstanceOffsets,
+    NodeInstances,
+    Materials,
+    Samplers,
+    SamplerInputs,
+    SamplerOutputs,
+    Channels,
+    Animations,
+    Cameras,
+    Lights,
+    Images,
+    ImageData,
+    SceneDimension,
+    Dependencies,
+    Strings,
+    Count
+};
+
+struct CacheHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t format;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    std::uint64_t sourceHash;
+    std::uint64_t numSections;
+};
+
+struct CacheSection
+{
+    std::uint32_t id;
+    std::uint32_t elementSize;
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+//! Range in the string section
+struct CachedString
+{
+    std::uint64_t offset{ 0 };
+    std::uint64_t length{ 0 };
+};
+
+struct CachedPrimMesh
+{
+    std::uint32_t firstIndex;
+    std::uint32_t indexCount;
+    std::uint32_t vertexOffset;
+    std::uint32_t vertexCount;
+    std::int32_t materialIndex;
+    glm::vec3 min;
+    glm::vec3 max;
+    CachedString name;
+    std::uint64_t lodBegin;
+    std::uint64_t lodCount;
+    std::uint32_t morphTargetBegin;
+    std::uint32_t morphTargetCount;
+    std::uint32_t skinned;
+};
+
+struct CachedAnimation
+{
+    CachedString name;
+    std::uint64_t samplerIndex;
+    std::uint64_t samplerCount;
+    std::uint64_t channelIndex;
+    std::uint64_t channelCount;
+    float duration;
+};
+
+struct CachedCamera
+{
+    glm::mat4 world;
+    glm::vec3 eye;
+    glm::vec3 center;
+    glm::vec3 up;
+    CachedString type;
+    CachedString name;
+    double perspective[4];   //! aspectRatio, yfov, zfar, znear
+    double orthographic[4];  //! xmag, ymag, zfar, znear
+};
+
+struct CachedLight
+{
+    glm::mat4 world;
+    CachedString name;
+    CachedString type;
+    double color[4];
+    std::uint64_t numColors;
+    double intensity;
+    double range;
+    double innerConeAngle;
+    double outerConeAngle;
+};
+
+struct CachedImage
+{
+    CachedString name;
+    std::int32_t width;
+    std::int32_t height;
+    std::int32_t component;
+    std::int32_t bits;
+    std::int32_t pixelType;
+    std::uint64_t dataOffset;
+    std::uint64_t dataSize;
+};
+
+struct CachedDependency
+{
+    CachedString path;
+    std::uint64_t hash;
+};
+
+bool HashFile(const std::string& path, std::uint64_t& hash)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        return false;
+    }
+
+    hash = HashUtils::HashBytes(file.GetData(), file.GetSize(), kCacheVersion);
+    return true;
+}
+
+//! Returns the directory part of the path including trailing separator.
+std::string GetBaseDirectory(const std::string& path)
+{
+    const size_t pos = path.find_last_of("/\\");
+    return pos == std::string::npos ? std::string() : path.substr(0, pos + 1);
+}
+
+//! Decode percent-encoded characters of the relative uri.
+std::string DecodeURI(const std::string& uri)
+{
+    std::string result;
+    result.reserve(uri.size());
+    for (size_t i = 0; i < uri.size(); ++i)
+    {
+        if (uri[i] == '%' && i + 2 < uri.size())
+        {
+            const std::string hex = uri.substr(i + 1, 2);
+            char* end = nullptr;
+            const long value = std::strtol(hex.c_str(), &end, 16);
+            if (end == hex.c_str() + 2)
+            {
+                result.push_back(static_cast<char>(value));
+                i += 2;
+                continue;
+            }
+        }
+        result.push_back(uri[i]);
+    }
+    return result;
+}
+
+bool GetCachePath(const std::string& cacheDirectory,
+                  const std::string& filename, VertexFormat format,
+                  std::uint32_t flags, std::string& cachePath,
+                  std::uint64_t& sourceHash)
+{
+    if (!HashFile(filename, sourceHash))
+    {
+        return false;
+    }
+
+    const size_t slash = filename.find_last_of("/\\");
+    std::string stem =
+        slash == std::string::npos ? filename : filename.substr(slash + 1);
+    stem = stem.substr(0, stem.find_last_of('.'));
+
+    char key[32];
+    std::snprintf(key, sizeof(key), "%016llx-%02x-%x",
+                  static_cast<unsigned long long>(sourceHash),
+                  static_cast<unsigned int>(format), flags);
+
+    cachePath = cacheDirectory;
+    if (!cachePath.empty() && cachePath.back() != '/' &&
+        cachePath.back() != '\\')
+    {
+        cachePath.push_back('/');
+    }
+    cachePath += stem + "-" + key + ".rfcache";
+    return true;
+}
+
+/**
+ * @brief Collect the sections and write them into the aligned cache file.
+ */
+class CacheWriter
+{
+ public:
+    template <typename Type>
+    void AddSection(CacheSectionID id, const Type* data, size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<Type>,
+                      "Cached type must be trivially copyable");
+        _sections.push_back({ static_cast<std::uint32_t>(id),
+                              static_cast<std::uint32_t>(sizeof(Type)), 0,
+                              static_cast<std::uint64_t>(count) });
+        _payloads.push_back(data);
+    }
+
+    template <typename Type>
+    void AddSection(CacheSectionID id, const std::vector<Type>& data)
+    {
+        AddSection(id, data.data(), data.size());
+    }
+
+    CachedString AddString(const std::string& str)
+    {
+        CachedString result{ _strings.size(), str.size() };
+        _strings += str;
+        return result;
+    }
+
+    bool Write(const std::string& path, VertexFormat format,
+               std::uint32_t flags, std::uint64_t sourceHash)
+    {
+        AddSection(CacheSectionID::Strings, _strings.data(), _strings.size());
+
+        CacheHeader header;
+        std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+        header.version = kCacheVersion;
+        header.format = static_cast<std::uint32_t>(format);
+        header.flags = flags;
+        header.reserved = 0;
+        header.sourceHash = sourceHash;
+        header.numSections = _sections.size();
+
+        std::uint64_t offset =
+            sizeof(CacheHeader) + _sections.size() * sizeof(CacheSection);
+        for (auto& section : _sections)
+        {
+            offset = AlignOffset(offset);
+            section.offset = offset;
+            offset += section.count * section.elementSize;
+        }
+
+        //! Write into the temporary file first so readers never see the
+        //! partially written cache.
+        const std::string tempPath = path + ".tmp";
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary |
+                                         std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(_sections.data()),
+                   _sections.size() * sizeof(CacheSection));
+
+        const char padding[kSectionAlignment] = {};
+        std::uint64_t written =
+            sizeof(CacheHeader) + _sections.size() * sizeof(CacheSection);
+        for (size_t i = 0; i < _sections.size(); ++i)
+        {
+            const CacheSection& section = _sections[i];
+            file.write(padding,
+                       static_cast<std::streamsize>(section.offset - written));
+            const std::uint64_t size = section.count * section.elementSize;
+            file.write(static_cast<const char*>(_payloads[i]),
+                       static_cast<std::streamsize>(size));
+            written = section.offset + size;
+        }
+
+        const bool success = file.good();
+        file.close();
+        if (!success)
+        {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+
+        std::remove(path.c_str());
+        return std::rename(tempPath.c_str(), path.c_str()) == 0;
+    }
+
+ private:
+    static std::uint64_t AlignOffset(std::uint64_t offset)
+    {
+        return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+    }
+
+    std::vector<CacheSection> _sections;
+    std::vector<const void*> _payloads;
+    std::string _strings;
+};
+
+/**
+ * @brief Map the cache file and validate the section table.
+ */
+class CacheReader
+{
+ public:
+    bool Open(const std::string& path, VertexFormat format,
+              std::uint32_t flags, std::uint64_t sourceHash)
+    {
+        if (!_file.Open(path) || _file.GetSize() < sizeof(CacheHeader))
+        {
+            return false;
+        }
+
+        CacheHeader header;
+        std::memcpy(&header, _file.GetData(), sizeof(header));
+        if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+            header.version != kCacheVersion ||
+            header.format != static_cast<std::uint32_t>(format) ||
+            header.flags != flags ||
+            header.sourceHash != sourceHash ||
+            header.numSections > static_cast<std::uint64_t>(
+                                     CacheSectionID::Count))
+        {
+            return false;
+        }
+
+        const std::uint64_t tableEnd =
+            sizeof(CacheHeader) + header.numSections * sizeof(CacheSection);
+        if (tableEnd > _file.GetSize())
+        {
+            return false;
+        }
+
+        _sections.resize(static_cast<size_t>(CacheSectionID::Count));
+        for (std::uint64_t i = 0; i < header.numSections; ++i)
+        {
+            CacheSection section;
+            std::memcpy(&section,
+                        _file.GetData() + sizeof(CacheHeader) +
+                            i * sizeof(CacheSection),
+                        sizeof(section));
+            if (section.id >= _sections.size() ||
+                section.offset + section.count * section.elementSize >
+                    _file.GetSize())
+            {
+                return false;
+            }
+            _sections[section.id] = section;
+            _sections[section.id].id = kValidSection;
+        }
+
+        return true;
+    }
+
+    template <typename Type>
+    bool Read(CacheSectionID id, std::vector<Type>& data) const
+    {
+        const Type* begin = nullptr;
+        size_t count = 0;
+        if (!Get(id, begin, count))
+        {
+            return false;
+        }
+        data.assign(begin, begin + count);
+        return true;
+    }
+
+    template <typename Type>
+    bool Get(CacheSectionID id, const Type*& data, size_t& count) const
+    {
+        static_assert(std::is_trivially_copyable_v<Type>,
+                      "Cached type must be trivially copyable");
+        const CacheSection& section = _sections[static_cast<size_t>(id)];
+        if (section.id != kValidSection || section.elementSize != sizeof(Type))
+        {
+            return false;
+        }
+        data = reinterpret_cast<const Type*>(_file.GetData() + section.offset);
+        count = static_cast<size_t>(section.count);
+        return true;
+    }
+
+    std::string GetString(const CachedString& str) const
+    {
+        if (str.offset + str.length > _strings.size())
+        {
+            return std::string();
+        }
+        return std::string(_strings.data() + str.offset, str.length);
+    }
+
+    bool LoadStrings()
+    {
+        return Read(CacheSectionID::Strings, _strings);
+    }
+
+ private:
+    static constexpr std::uint32_t kValidSection = 1;
+
+    MappedFile _file;
+    std::vector<CacheSection> _sections;
+    std::vector<char> _strings;
+};
+}  // namespace
+
+bool GLTFScene::LoadCache(const std::string& filename, VertexFormat format,
+                          const ImageCallback& imageCallback)
+{
+    const std::uint32_t flags = (_optimizeMeshes ? kOptimizedMeshesFlag : 0) |
+                                (_numLodLevels << kLodLevelsShift);
+    std::string cachePath;
+    std::uint64_t sourceHash = 0;
+    if (!GetCachePath(_cacheDirectory, filename, format, flags, cachePath,
+                      sourceHash))
+    {
+        return false;
+    }
+
+    CacheReader reader;
+    if (!reader.Open(cachePath, format, flags, sourceHash) || !reader.LoadStrings())
+    {
+        return false;
+    }
+
+    //! Partially loaded scene must not be mixed with the parsed one.
+    auto discard = [this]() {
+        ReleaseSourceData();
+        _sceneMaterials.clear();
+        _sceneNodes = GLTFNodes();
+        _scenePrimMeshes.clear();
+        _sceneCameras.clear();
+        _sceneLights.clear();
+        _sceneAnims.clear();
+        _sceneSamplers.clear();
+        _sceneChannels.clear();
+        _animKeyTimes.clear();
+        _animKeyValues.clear();
+        _sceneMorphTargets.clear();
+        _morphDeltas.clear();
+        _sceneSkins.clear();
+        _skinJoints.clear();
+        _inverseBindMatrices.clear();
+        _sceneDim = SceneDimension();
+        return false;
+    };
+
+    //! External buffers and images must not be modified after caching.
+    std::vector<CachedDependency> dependencies;
+    if (!reader.Read(CacheSectionID::Dependencies, dependencies))
+    {
+        return discard();
+    }
+    for (const auto& dependency : dependencies)
+    {
+        std::uint64_t hash = kMissingFileHash;
+        HashFile(reader.GetString(dependency.path), hash);
+        if (hash != dependency.hash)
+        {
+            return discard();
+        }
+    }
+
+    std::vector<CachedPrimMesh> primMeshes;
+    std::vector<GLTFLod> primMeshLods;
+    std::vector<CachedAnimation> animations;
+    std::vector<CachedCamera> cameras;
+    std::vector<CachedLight> lights;
+    std::vector<SceneDimension> sceneDim;
+    if (!reader.Read(CacheSectionID::Positions, _positions) ||
+        !reader.Read(CacheSectionID::Normals, _normals) ||
+        !reader.Read(CacheSectionID::Tangents, _tangents) ||
+        !reader.Read(CacheSectionID::Colors, _colors) ||
+        !reader.Read(CacheSectionID::TexCoords, _texCoords) ||
+        !reader.Read(CacheSectionID::Indices, _indices) ||
+        !reader.Read(CacheSectionID::PrimMeshes, primMeshes) ||
+        !reader.Read(CacheSectionID::PrimMeshLods, primMeshLods) ||
+        !reader.Read(CacheSectionID::NodeTranslations,
+                     _sceneNodes.translations) ||
+        !reader.Read(CacheSectionID::NodeRotations, _sceneNodes.rotations) ||
+        !reader.Read(CacheSectionID::NodeScales, _sceneNodes.scales) ||
+        !reader.Read(CacheSectionID::NodeMatrices, _sceneNodes.matrices) ||
+        !reader.Read(CacheSectionID::NodeWorlds, _sceneNodes.worlds) ||
+        !reader.Read(CacheSectionID::NodeParents, _sceneNodes.parents) ||
+        !reader.Read(CacheSectionID::NodeIndices, _sceneNodes.nodeIndices) ||
+        !reader.Read(CacheSectionID::NodePrimMeshOffsets,
+                     _sceneNodes.primMeshOffsets) ||
+        !reader.Read(CacheSectionID::NodePrimMeshes,
+                     _sceneNodes.primMeshes) ||
+        !reader.Read(CacheSectionID::NodeWeightOffsets,
+                     _sceneNodes.weightOffsets) ||
+        !reader.Read(CacheSectionID::NodeWeights, _sceneNodes.weights) ||
+        !reader.Read(CacheSectionID::NodeSkins, _sceneNodes.skins) ||
+        !reader.Read(CacheSectionID::NodeInstanceOffsets,
+                     _sceneNodes.instanceOffsets) ||
+        !reader.Read(CacheSectionID::NodeInstances, _sceneNodes.instances) ||
+        !reader.Read(CacheSectionID::MorphTargets, _sceneMorphTargets) ||
+        !reader.Read(CacheSectionID::MorphDeltas, _morphDeltas) ||
+        !reader.Read(CacheSectionID::SkinVertices, _skinVertices) ||
+        !reader.Read(CacheSectionID::Skins, _sceneSkins) ||
+        !reader.Read(CacheSectionID::SkinJoints, _skinJoints) ||
+        !reader.Read(CacheSectionID::InverseBindMatrices,
+                     _inverseBindMatrices) ||
+        !reader.Read(CacheSectionID::Materials, _sceneMaterials) ||
+        !reader.Read(CacheSectionID::Samplers, _sceneSamplers) ||
+        !reader.Read(CacheSectionID::SamplerInputs, _animKeyTimes) ||
+        !reader.Read(CacheSectionID::SamplerOutputs, _animKeyValues) ||
+        !reader.Read(CacheSectionID::Channels, _sceneChannels) ||
+        !reader.Read(CacheSectionID::Animations, animations) ||
+        !reader.Read(CacheSectionID::Cameras, cameras) ||
+        !reader.Read(CacheSectionID::Lights, lights) ||
+        !reader.Read(CacheSectionID::SceneDimension, sceneDim) ||
+        sceneDim.size() != 1)
+    {
+        return discard();
+    }
+    _sceneDim = sceneDim.front();
+
+    _scenePrimMeshes.resize(primMeshes.size());
+    for (size_t i = 0; i < primMeshes.size(); ++i)
+    {
+        const CachedPrimMesh& src = primMeshes[i];
+        GLTFPrimMesh& dst = _scenePrimMeshes[i];
+        dst.firstIndex = src.firstIndex;
+        dst.indexCount = src.indexCount;
+        dst.vertexOffset = src.vertexOffset;
+        dst.vertexCount = src.vertexCount;
+        dst.materialIndex = src.materialIndex;
+        dst.min = src.min;
+        dst.max = src.max;
+        dst.name = reader.GetString(src.name);
+        if (src.lodBegin + src.lodCount > primMeshLods.size())
+        {
+            return discard();
+        }
+        dst.lods.assign(primMeshLods.begin() + src.lodBegin,
+                        primMeshLods.begin() + src.lodBegin + src.lodCount);
+
+        //! Morph deltas must stay in the vertex range of the primitive
+        if (static_cast<size_t>(src.morphTargetBegin) + src.morphTargetCount >
+            _sceneMorphTargets.size())
+        {
+            return discard();
+        }
+        dst.morphTargetBegin = src.morphTargetBegin;
+        dst.morphTargetCount = src.morphTargetCount;
+        dst.skinned = src.skinned != 0;
+        if (dst.skinned &&
+            static_cast<size_t>(dst.vertexOffset) + dst.vertexCount >
+                _skinVertices.size())
+        {
+            return discard();
+        }
+        for (unsigned int t = dst.morphTargetBegin;
+             t < dst.morphTargetBegin + dst.morphTargetCount; ++t)
+        {
+            const GLTFMorphTarget& target = _sceneMorphTargets[t];
+            if (static_cast<size_t>(target.deltaBegin) + target.deltaCount >
+                _morphDeltas.size())
+            {
+                return discard();
+            }
+            for (unsigned int d = target.deltaBegin;
+                 d < target.deltaBegin + target.deltaCount; ++d)
+            {
+                if (_morphDeltas[d].vertex >= dst.vertexCount)
+                {
+                    return discard();
+                }
+            }
+        }
+    }
+
+    //! Node arrays must be parallel and parents must precede children
+    const size_t numNodes = _sceneNodes.Size();
+    if (_sceneNodes.translations.size() != numNodes ||
+        _sceneNodes.rotations.size() != numNodes ||
+        _sceneNodes.scales.size() != numNodes ||
+        _sceneNodes.matrices.size() != numNodes ||
+        _sceneNodes.worlds.size() != numNodes ||
+        _sceneNodes.nodeIndices.size() != numNodes ||
+        _sceneNodes.primMeshOffsets.size() != numNodes + 1 ||
+        _sceneNodes.primMeshOffsets.front() != 0 ||
+        _sceneNodes.primMeshOffsets.back() != _sceneNodes.primMeshes.size() ||
+        _sceneNodes.weightOffsets.size() != numNodes + 1 ||
+        _sceneNodes.weightOffsets.front() != 0 ||
+        _sceneNodes.weightOffsets.back() != _sceneNodes.weights.size() ||
+        _sceneNodes.skins.size() != numNodes ||
+        _sceneNodes.instanceOffsets.size() != numNodes + 1 ||
+        _sceneNodes.instanceOffsets.front() != 0 ||
+        _sceneNodes.instanceOffsets.back() != _sceneNodes.instances.size() ||
+        _inverseBindMatrices.size() != _skinJoints.size())
+    {
+        return discard();
+    }
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        const int parent = _sceneNodes.parents[i];
+        if (parent < -1 || parent >= static_cast<int>(i) ||
+            _sceneNodes.primMeshOffsets[i] >
+                _sceneNodes.primMeshOffsets[i + 1] ||
+            _sceneNodes.weightOffsets[i] > _sceneNodes.weightOffsets[i + 1] ||
+            _sceneNodes.instanceOffsets[i] >
+                _sceneNodes.instanceOffsets[i + 1] ||
+            _sceneNodes.skins[i] < -1 ||
+            _sceneNodes.skins[i] >= static_cast<int>(_sceneSkins.size()))
+        {
+            return discard();
+        }
+    }
+    for (const GLTFSkin& skin : _sceneSkins)
+    {
+        if (static_cast<size_t>(skin.jointBegin) + skin.jointCount >
+            _skinJoints.size())
+        {
+            return discard();
+        }
+    }
+    for (unsigned int joint : _skinJoints)
+    {
+        if (joint >= numNodes)
+        {
+            return discard();
+        }
+    }
+    for (unsigned int primMesh : _sceneNodes.primMeshes)
+    {
+        if (primMesh >= _scenePrimMeshes.size())
+        {
+            return discard();
+        }
+    }
+    _sceneNodes.dirty.assign(numNodes, 0);
+    SanitizeSkinVertices();
+
+    for (const GLTFSampler& sampler : _sceneSamplers)
+    {
+        const size_t numValues =
+            (sampler.interpolation == GLTFSampler::Interpolation::Cubicspline
+                 ? sampler.keyCount * size_t{ 3 }
+                 : sampler.keyCount) *
+            sampler.valueWidth;
+        if (static_cast<size_t>(sampler.keyBegin) + sampler.keyCount >
+                _animKeyTimes.size() ||
+            static_cast<size_t>(sampler.valueBegin) + numValues >
+                _animKeyValues.size())
+        {
+            return discard();
+        }
+    }
+    for (const GLTFChannel& channel : _sceneChannels)
+    {
+        if (channel.samplerIndex < 0 ||
+            static_cast<size_t>(channel.samplerIndex) >=
+                _sceneSamplers.size() ||
+            channel.nodeIndex < 0 ||
+            static_cast<size_t>(channel.nodeIndex) >= _sceneNodes.Size())
+        {
+            return discard();
+        }
+    }
+
+    _sceneAnims.resize(animations.size());
+    for (size_t i = 0; i < animations.size(); ++i)
+    {
+        const CachedAnimation& src = animations[i];
+        GLTFAnimation& dst = _sceneAnims[i];
+        dst.name = reader.GetString(src.name);
+        dst.samplerIndex = src.samplerIndex;
+        dst.samplerCount = src.samplerCount;
+        dst.channelIndex = src.channelIndex;
+        dst.channelCount = src.channelCount;
+        dst.duration = src.duration;
+    }
+
+    _sceneCameras.resize(cameras.size());
+    for (size_t i = 0; i < cameras.size(); ++i)
+    {
+        const CachedCamera& src = cameras[i];
+        GLTFCamera& dst = _sceneCameras[i];
+        dst.world = src.world;
+        dst.eye = src.eye;
+        dst.center = src.center;
+        dst.up = src.up;
+        dst.camera.type = reader.GetString(src.type);
+        dst.camera.name = reader.GetString(src.name);
+        dst.camera.perspective.aspectRatio = src.perspective[0];
+        dst.camera.perspective.yfov = src.perspective[1];
+        dst.camera.perspective.zfar = src.perspective[2];
+        dst.camera.perspective.znear = src.perspective[3];
+        dst.camera.orthographic.xmag = src.orthographic[0];
+        dst.camera.orthographic.ymag = src.orthographic[1];
+        dst.camera.orthographic.zfar = src.orthographic[2];
+        dst.camera.orthographic.znear = src.orthographic[3];
+    }
+
+    _sceneLights.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        const CachedLight& src = lights[i];
+        GLTFLight& dst = _sceneLights[i];
+        dst.world = src.world;
+        dst.light.name = reader.GetString(src.name);
+        dst.light.type = reader.GetString(src.type);
+        dst.light.color.assign(src.color,
+                               src.color + std::min<std::uint64_t>(
+                                               src.numColors, 4));
+        dst.light.intensity = src.intensity;
+        dst.light.range = src.range;
+        dst.light.spot.innerConeAngle = src.innerConeAngle;
+        dst.light.spot.outerConeAngle = src.outerConeAngle;
+    }
+
+    //! Hand decoded images to the callback without decoding them again.
+    if (imageCallback != nullptr)
+    {
+        std::vector<CachedImage> images;
+        const unsigned char* imageData = nullptr;
+        size_t imageDataSize = 0;
+        if (!reader.Read(CacheSectionID::Images, images) ||
+            !reader.Get(CacheSectionID::ImageData, imageData, imageDataSize))
+        {
+            return discard();
+        }
+
+        tinygltf::Image image;
+        for (const auto& cachedImage : images)
+        {
+            if (cachedImage.dataOffset + cachedImage.dataSize > imageDataSize)
+            {
+                return discard();
+            }
+            image.name = reader.GetString(cachedImage.name);
+            image.width = cachedImage.width;
+            image.height = cachedImage.height;
+            image.component = cachedImage.component;
+            image.bits = cachedImage.bits;
+            image.pixel_type = cachedImage.pixelType;
+            image.image.assign(
+                imageData + cachedImage.dataOffset,
+                imageData + cachedImage.dataOffset + cachedImage.dataSize);
+            imageCallback(image);
+        }
+    }
+
+    return true;
+}
+
+bool GLTFScene::SaveCache(const std::string& filename, VertexFormat format,
+                          const tinygltf::Model& model) const
+{
+    const std::uint32_t flags = (_optimizeMeshes ? kOptimizedMeshesFlag : 0) |
+                                (_numLodLevels << kLodLevelsShift);
+    std::string cachePath;
+    std::uint64_t sourceHash = 0;
+    if (!GetCachePath(_cacheDirectory, filename, format, flags, cachePath,
+                      sourceHash))
+    {
+        return false;
+    }
+
+    CacheWriter writer;
+
+    //! Collect external files referenced by the scene.
+    const std::string baseDirectory = GetBaseDirectory(filename);
+    std::vector<std::string> uris;
+    for (const auto& buffer : model.buffers)
+    {
+        uris.push_back(buffer.uri);
+    }
+    for (const auto& image : model.images)
+    {
+        uris.push_back(image.uri);
+    }
+
+    std::vector<CachedDependency> dependencies;
+    for (const auto& uri : uris)
+    {
+        if (uri.empty() || uri.compare(0, 5, "data:") == 0)
+        {
+            continue;
+        }
+
+        const std::string path = baseDirectory + DecodeURI(uri);
+        //! Missing files are recorded too, cache is invalidated once they
+        //! are added.
+        CachedDependency dependency;
+        dependency.hash = kMissingFileHash;
+        HashFile(path, dependency.hash);
+        dependency.path = writer.AddString(path);
+        dependencies.push_back(dependency);
+    }
+
+    std::vector<CachedPrimMesh> primMeshes;
+    std::vector<GLTFLod> primMeshLods;
+    primMeshes.reserve(_scenePrimMeshes.size());
+    for (const auto& primMesh : _scenePrimMeshes)
+    {
+        primMeshes.push_back({ primMesh.firstIndex, primMesh.indexCount,
+                               primMesh.vertexOffset, primMesh.vertexCount,
+                               primMesh.materialIndex, primMesh.min,
+                               primMesh.max, writer.AddString(primMesh.name),
+                               primMeshLods.size(), primMesh.lods.size(),
+                               primMesh.morphTargetBegin,
+                               primMesh.morphTargetCount,
+                               primMesh.skinned ? 1u : 0u });
+        primMeshLods.insert(primMeshLods.end(), primMesh.lods.begin(),
+                            primMesh.lods.end());
+    }
+
+    std::vector<CachedAnimation> animations;
+    animations.reserve(_sceneAnims.size());
+    for (const auto& anim : _sceneAnims)
+    {
+        animations.push_back({ writer.AddString(anim.name), anim.samplerIndex,
+                               anim.samplerCount, anim.channelIndex,
+                               anim.channelCount, anim.duration });
+    }
+
+    std::vector<CachedCamera> cameras;
+    cameras.reserve(_sceneCameras.size());
+    for (const auto& camera : _sceneCameras)
+    {
+        const auto& perspective = camera.camera.perspective;
+        const auto& orthographic = camera.camera.orthographic;
+        cameras.push_back(
+            { camera.world,
+              camera.eye,
+              camera.center,
+              camera.up,
+              writer.AddString(camera.camera.type),
+              writer.AddString(camera.camera.name),
+              { perspective.aspectRatio, perspective.yfov, perspective.zfar,
+                perspective.znear },
+              { orthographic.xmag, orthographic.ymag, orthographic.zfar,
+                orthographic.znear } });
+    }
+
+    std::vector<CachedLight> lights;
+    lights.reserve(_sceneLights.size());
+    for (const auto& light : _sceneLights)
+    {
+        CachedLight cachedLight{};
+        cachedLight.world = light.world;
+        cachedLight.name = writer.AddString(light.light.name);
+        cachedLight.type = writer.AddString(light.light.type);
+        cachedLight.numColors = std::min<size_t>(light.light.color.size(), 4);
+        std::copy(light.light.color.begin(),
+                  light.light.color.begin() + cachedLight.numColors,
+                  cachedLight.color);
+        cachedLight.intensity = light.light.intensity;
+        cachedLight.range = light.light.range;
+        cachedLight.innerConeAngle = light.light.spot.innerConeAngle;
+        cachedLight.outerConeAngle = light.light.spot.outerConeAngle;
+        lights.push_back(cachedLight);
+    }
+
+    //! Decoded images are stored contiguously in a single section.
+    std::vector<CachedImage> images;
+    std::vector<unsigned char> imageData;
+    size_t imageDataSize = 0;
+    for (const auto& image : model.images)
+    {
+        imageDataSize += image.image.size();
+    }
+    imageData.reserve(imageDataSize);
+    images.reserve(model.images.size());
+    for (const auto& image : model.images)
+    {
+        images.push_back({ writer.AddString(image.name), image.width,
+                           image.height, image.component, image.bits,
+                           image.pixel_type, imageData.size(),
+                           image.image.size() });
+        imageData.insert(imageData.end(), image.image.begin(),
+                         image.image.end());
+    }
+
+    writer.AddSection(CacheSectionID::Positions, _positions);
+    writer.AddSection(CacheSectionID::Normals, _normals);
+    writer.AddSection(CacheSectionID::Tangents, _tangents);
+    writer.AddSection(CacheSectionID::Colors, _colors);
+    writer.AddSection(CacheSectionID::TexCoords, _texCoords);
+    writer.AddSection(CacheSectionID::Indices, _indices);
+    writer.AddSection(CacheSectionID::PrimMeshes, primMeshes);
+    writer.AddSection(CacheSectionID::PrimMeshLods, primMeshLods);
+    writer.AddSection(CacheSectionID::MorphTargets, _sceneMorphTargets);
+    writer.AddSection(CacheSectionID::MorphDeltas, _morphDeltas);
+    writer.AddSection(CacheSectionID::SkinVertices, _skinVertices);
+    writer.AddSection(CacheSectionID::Skins, _sceneSkins);
+    writer.AddSection(CacheSectionID::SkinJoints, _skinJoints);
+    writer.AddSection(CacheSectionID::InverseBindMatrices,
+                      _inverseBindMatrices);
+    writer.AddSection(CacheSectionID::NodeTranslations,
+                      _sceneNodes.translations);
+    writer.AddSection(CacheSectionID::NodeRotations, _sceneNodes.rotations);
+    writer.AddSection(CacheSectionID::NodeScales, _sceneNodes.scales);
+    writer.AddSection(CacheSectionID::NodeMatrices, _sceneNodes.matrices);
+    writer.AddSection(CacheSectionID::NodeWorlds, _sceneNodes.worlds);
+    writer.AddSection(CacheSectionID::NodeParents, _sceneNodes.parents);
+    writer.AddSection(CacheSectionID::NodeIndices, _sceneNodes.nodeIndices);
+    writer.AddSection(CacheSectionID::NodePrimMeshOffsets,
+                      _sceneNodes.primMeshOffsets);
+    writer.AddSection(CacheSectionID::NodePrimMeshes, _sceneNodes.primMeshes);
+    writer.AddSection(CacheSectionID::NodeWeightOffsets,
+                      _sceneNodes.weightOffsets);
+    writer.AddSection(CacheSectionID::NodeWeights, _sceneNodes.weights);
+    writer.AddSection(CacheSectionID::NodeSkins, _sceneNodes.skins);
+    writer.AddSection(CacheSectionID::NodeInstanceOffsets,
+                      _sceneNodes.instanceOffsets);
+    writer.AddSection(CacheSectionID::NodeInstances, _sceneNodes.instances);
+    writer.AddSection(CacheSectionID::Materials, _sceneMaterials);
+    writer.AddSection(CacheSectionID::Samplers, _sceneSamplers);
+    writer.AddSection(CacheSectionID::SamplerInputs, _animKeyTimes);
+    writer.AddSection(CacheSectionID::SamplerOutputs, _animKeyValues);
+    writer.AddSection(CacheSectionID::Channels, _sceneChannels);
+    writer.AddSection(CacheSectionID::Animations, animations);
+    writer.AddSection(CacheSectionID::Cameras, cameras);
+    writer.AddSection(CacheSectionID::Lights, lights);
+    writer.AddSection(CacheSectionID::Images, images);
+    writer.AddSection(CacheSectionID::ImageData, imageData);
+    writer.AddSection(CacheSectionID::SceneDimension, &_sceneDim, 1);
+    writer.AddSection(CacheSectionID::Dependencies, dependencies);
+
+    if (!writer.Write(cachePath, format, flags, sourceHash))
+    {
+        std::cerr << "[GLTFScene:SaveCache] Failed to write cache " << cachePath
+                  << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace Common
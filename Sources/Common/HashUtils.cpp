@@ -0,0 +1,36 @@
+#include <Common/HashUtils.hpp>
+#include <cstring>
+
+namespace Common
+{
+std::uint64_t HashUtils::HashBytes(const void* data, size_t size,
+                                   std::uint64_t seed)
+{
+    constexpr std::uint64_t kPrime = 0x9e3779b97f4a7c15ULL;
+    const auto* bytes = static_cast<const unsigned char*>(data);
+
+    //! Process eight bytes at once, multiplicative hashing with rotation.
+    std::uint64_t hash = seed ^ (size * kPrime);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash ^= word * kPrime;
+        hash = ((hash << 31) | (hash >> 33)) * 0xc2b2ae3d27d4eb4fULL;
+    }
+    for (; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+}  // namespace Common
@@ -0,0 +1,156 @@
+#include <Common/Macros.hpp>
+#include <Common/MappedFile.hpp>
+
+#if defined(WINDOWS)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Common
+{
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#if defined(WINDOWS)
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    HANDLE file =
+        CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    _fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        Close();
+        return false;
+    }
+    _size = static_cast<size_t>(fileSize.QuadPart);
+
+    //! Empty file cannot be mapped, but it is still valid file.
+    if (_size == 0)
+    {
+        return true;
+    }
+
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+    _mappingHandle = mapping;
+
+    _data = static_cast<const char*>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (_data)
+    {
+        UnmapViewOfFile(_data);
+        _data = nullptr;
+    }
+    if (_mappingHandle)
+    {
+        CloseHandle(static_cast<HANDLE>(_mappingHandle));
+        _mappingHandle = nullptr;
+    }
+    if (_fileHandle)
+    {
+        CloseHandle(static_cast<HANDLE>(_fileHandle));
+        _fileHandle = nullptr;
+    }
+    _size = 0;
+}
+#else
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    _fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (_fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(_fileDescriptor, &fileStat) != 0)
+    {
+        Close();
+        return false;
+    }
+    _size = static_cast<size_t>(fileStat.st_size);
+
+    //! Empty file cannot be mapped, but it is still valid file.
+    if (_size == 0)
+    {
+        return true;
+    }
+
+    void* data =
+        mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    _data = static_cast<const char*>(data);
+
+    //! Chunks of the file are read by several threads at once, prefetch all.
+    madvise(data, _size, MADV_WILLNEED);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (_data)
+    {
+        munmap(const_cast<char*>(_data), _size);
+        _data = nullptr;
+    }
+    if (_fileDescriptor >= 0)
+    {
+        close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+    _size = 0;
+}
+#endif
+
+const char* MappedFile::GetData() const
+{
+    return _data;
+}
+
+size_t MappedFile::GetSize() const
+{
+    return _size;
+}
+
+}  // namespace Common
@@ -0,0 +1,120 @@
+#include <Common/Macros.hpp>
+#include <Common/MathUtils.hpp>
+#include <cfloat>
+#include <cmath>
+#include <glm/geometric.hpp>
+
+#ifdef SIMD_SSE2
+#include <xmmintrin.h>
+#endif
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Returns the reciprocal of the determinant, 1 for the singular matrix so
+//! that the cofactors are kept finite
+float InverseDeterminant(float det)
+{
+    return std::abs(det) > FLT_MIN ? 1.0f / det : 1.0f;
+}
+
+void ComputeNormalMatrix(const glm::mat4& matrix, glm::mat4& normalMatrix)
+{
+    const glm::vec3 a(matrix[0]), b(matrix[1]), c(matrix[2]);
+    const glm::vec3 bc = glm::cross(b, c);
+    const glm::vec3 ca = glm::cross(c, a);
+    const glm::vec3 ab = glm::cross(a, b);
+    const float invDet = InverseDeterminant(glm::dot(a, bc));
+
+    normalMatrix[0] = glm::vec4(bc * invDet, 0.0f);
+    normalMatrix[1] = glm::vec4(ca * invDet, 0.0f);
+    normalMatrix[2] = glm::vec4(ab * invDet, 0.0f);
+    normalMatrix[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+#ifdef SIMD_SSE2
+//! Column of four matrices transposed to structure of arrays
+struct ColumnBatch
+{
+    __m128 x, y, z;
+};
+
+ColumnBatch LoadColumns(const glm::mat4* matrices, int column)
+{
+    __m128 x = _mm_loadu_ps(&matrices[0][column][0]);
+    __m128 y = _mm_loadu_ps(&matrices[1][column][0]);
+    __m128 z = _mm_loadu_ps(&matrices[2][column][0]);
+    __m128 w = _mm_loadu_ps(&matrices[3][column][0]);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    return { x, y, z };
+}
+
+void StoreColumns(const ColumnBatch& batch, __m128 scale,
+                  glm::mat4* normalMatrices, int column)
+{
+    __m128 x = _mm_mul_ps(batch.x, scale);
+    __m128 y = _mm_mul_ps(batch.y, scale);
+    __m128 z = _mm_mul_ps(batch.z, scale);
+    __m128 w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(&normalMatrices[0][column][0], x);
+    _mm_storeu_ps(&normalMatrices[1][column][0], y);
+    _mm_storeu_ps(&normalMatrices[2][column][0], z);
+    _mm_storeu_ps(&normalMatrices[3][column][0], w);
+}
+
+ColumnBatch Cross(const ColumnBatch& a, const ColumnBatch& b)
+{
+    return { _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)),
+             _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)),
+             _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x)) };
+}
+
+void ComputeNormalMatrices4(const glm::mat4* matrices,
+                            glm::mat4* normalMatrices)
+{
+    const ColumnBatch a = LoadColumns(matrices, 0);
+    const ColumnBatch b = LoadColumns(matrices, 1);
+    const ColumnBatch c = LoadColumns(matrices, 2);
+    const ColumnBatch bc = Cross(b, c);
+    const ColumnBatch ca = Cross(c, a);
+    const ColumnBatch ab = Cross(a, b);
+
+    const __m128 det =
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, bc.x), _mm_mul_ps(a.y, bc.y)),
+                   _mm_mul_ps(a.z, bc.z));
+    const __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+    const __m128 regular = _mm_cmpgt_ps(absDet, _mm_set1_ps(FLT_MIN));
+    const __m128 invDet =
+        _mm_or_ps(_mm_and_ps(regular, _mm_div_ps(_mm_set1_ps(1.0f), det)),
+                  _mm_andnot_ps(regular, _mm_set1_ps(1.0f)));
+
+    StoreColumns(bc, invDet, normalMatrices, 0);
+    StoreColumns(ca, invDet, normalMatrices, 1);
+    StoreColumns(ab, invDet, normalMatrices, 2);
+    for (int i = 0; i < 4; ++i)
+    {
+        normalMatrices[i][3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+#endif
+}  // namespace
+
+void ComputeNormalMatrices(const glm::mat4* matrices, size_t count,
+                           glm::mat4* normalMatrices)
+{
+    size_t i = 0;
+#ifdef SIMD_SSE2
+    for (; i + 4 <= count; i += 4)
+    {
+        ComputeNormalMatrices4(matrices + i, normalMatrices + i);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        ComputeNormalMatrix(matrices[i], normalMatrices[i]);
+    }
+}
+
+}  // namespace Common
@@ -0,0 +1,1550 @@
+#include <Common/Macros.hpp>
+#include <Common/MeshUtils.hpp>
+#include <Common/ThreadPool.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+#ifdef SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Welding tolerances of each attribute
+constexpr float kPositionEpsilon = 1e-3f;
+constexpr float kTexCoordEpsilon = 1e-1f;
+constexpr float kNormalEpsilon = 3e-1f;
+
+//! Minimum number of vertices handled by one partition
+constexpr size_t kMinPartitionSize = 1 << 14;
+
+constexpr unsigned int kInvalidIndex = std::numeric_limits<unsigned int>::max();
+
+using QuantizedKey = std::array<int, 8>;
+
+int Quantize(float value, float epsilon)
+{
+    return static_cast<int>(std::floor(value / epsilon + 0.5f));
+}
+
+QuantizedKey MakeKey(const PackedVertex& vertex)
+{
+    return { Quantize(vertex.position.x, kPositionEpsilon),
+             Quantize(vertex.position.y, kPositionEpsilon),
+             Quantize(vertex.position.z, kPositionEpsilon),
+             Quantize(vertex.texCoord.x, kTexCoordEpsilon),
+             Quantize(vertex.texCoord.y, kTexCoordEpsilon),
+             Quantize(vertex.normal.x, kNormalEpsilon),
+             Quantize(vertex.normal.y, kNormalEpsilon),
+             Quantize(vertex.normal.z, kNormalEpsilon) };
+}
+
+std::uint64_t HashKey(const QuantizedKey& key)
+{
+    //! FNV-1a followed by murmur3 finalizer for well distributed low bits.
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int component : key)
+    {
+        hash ^= static_cast<std::uint32_t>(component);
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+size_t NextPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief Open-addressing hash table mapping quantized keys to welded vertex.
+ * Slots store partition-local unique id, keys are looked up from the first
+ * occurrence of the unique vertex.
+ */
+class WeldTable
+{
+ public:
+    WeldTable(const std::vector<QuantizedKey>& keys,
+              const std::vector<std::uint64_t>& hashes, size_t expectedSize)
+        : _keys(keys),
+          _hashes(hashes),
+          _slots(NextPowerOfTwo(expectedSize * 2 + 16), kInvalidIndex)
+    {
+        _uniques.reserve(expectedSize);
+    }
+
+    unsigned int Insert(unsigned int vertex)
+    {
+        //! Keep load factor under 0.5
+        if ((_uniques.size() + 1) * 2 > _slots.size())
+        {
+            Grow();
+        }
+
+        const size_t mask = _slots.size() - 1;
+        size_t slot = static_cast<size_t>(_hashes[vertex]) & mask;
+        while (true)
+        {
+            const unsigned int id = _slots[slot];
+            if (id == kInvalidIndex)
+            {
+                const auto newId = static_cast<unsigned int>(_uniques.size());
+                _uniques.push_back(vertex);
+                _slots[slot] = newId;
+                return newId;
+            }
+            const unsigned int representative = _uniques[id];
+            if (_hashes[representative] == _hashes[vertex] &&
+                _keys[representative] == _keys[vertex])
+            {
+                return id;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    [[nodiscard]] size_t GetNumUniques() const
+    {
+        return _uniques.size();
+    }
+
+ private:
+    void Grow()
+    {
+        std::vector<unsigned int> slots(_slots.size() * 2, kInvalidIndex);
+        const size_t mask = slots.size() - 1;
+        for (size_t id = 0; id < _uniques.size(); ++id)
+        {
+            size_t slot = static_cast<size_t>(_hashes[_uniques[id]]) & mask;
+            while (slots[slot] != kInvalidIndex)
+            {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = static_cast<unsigned int>(id);
+        }
+        _slots = std::move(slots);
+    }
+
+    const std::vector<QuantizedKey>& _keys;
+    const std::vector<std::uint64_t>& _hashes;
+    std::vector<unsigned int> _slots;
+    std::vector<unsigned int> _uniques;
+};
+
+bool CheckTriangle(const glm::vec3& v1, const glm::vec3& v2,
+                   const glm::vec3& v3)
+{
+    return (v2.x - v1.x) * (v3.y - v2.y) != (v3.x - v2.x) * (v2.y - v1.y);
+}
+
+//! Forsyth vertex cache optimization parameters
+constexpr size_t kMaxCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+constexpr size_t kMaxValence = 64;
+
+//! Precomputed vertex score tables of Forsyth algorithm
+struct VertexScoreTable
+{
+    VertexScoreTable()
+    {
+        for (size_t i = 0; i < kMaxCacheSize; ++i)
+        {
+            if (i < 3)
+            {
+                cacheScores[i] = kLastTriScore;
+            }
+            else
+            {
+                const float scaler = 1.0f / (kMaxCacheSize - 3);
+                cacheScores[i] = std::pow(1.0f - (i - 3) * scaler,
+                                          kCacheDecayPower);
+            }
+        }
+
+        valenceScores[0] = 0.0f;
+        for (size_t i = 1; i < kMaxValence; ++i)
+        {
+            valenceScores[i] =
+                kValenceBoostScale *
+                std::pow(static_cast<float>(i), -kValenceBoostPower);
+        }
+    }
+
+    float GetScore(int cachePosition, unsigned int remainingTriangles) const
+    {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+        score += valenceScores[std::min<size_t>(remainingTriangles,
+                                                kMaxValence - 1)];
+        return score;
+    }
+
+    std::array<float, kMaxCacheSize> cacheScores{};
+    std::array<float, kMaxValence> valenceScores{};
+};
+
+//! Triangle to vertex adjacency in compressed sparse row layout
+struct TriangleAdjacency
+{
+    TriangleAdjacency(const unsigned int* indices, size_t indexCount,
+                      size_t vertexCount)
+        : counts(vertexCount, 0), offsets(vertexCount + 1, 0)
+    {
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            ++counts[indices[i]];
+        }
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            offsets[v + 1] = offsets[v] + counts[v];
+        }
+
+        triangles.resize(indexCount);
+        std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            triangles[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+    }
+
+    std::vector<unsigned int> counts;
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> triangles;
+};
+
+//! Symmetric 4x4 quadric of plane distances, accumulated with area weight
+struct Quadric
+{
+    double a00{ 0.0 }, a01{ 0.0 }, a02{ 0.0 }, a11{ 0.0 }, a12{ 0.0 },
+        a22{ 0.0 };
+    double b0{ 0.0 }, b1{ 0.0 }, b2{ 0.0 }, c{ 0.0 };
+    double weight{ 0.0 };
+
+    void AddPlane(const glm::vec3& normal, float distance, float area)
+    {
+        const double nx = normal.x, ny = normal.y, nz = normal.z;
+        const double d = distance, w = area;
+        a00 += w * nx * nx;
+        a01 += w * nx * ny;
+        a02 += w * nx * nz;
+        a11 += w * ny * ny;
+        a12 += w * ny * nz;
+        a22 += w * nz * nz;
+        b0 += w * nx * d;
+        b1 += w * ny * d;
+        b2 += w * nz * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        a00 += other.a00;
+        a01 += other.a01;
+        a02 += other.a02;
+        a11 += other.a11;
+        a12 += other.a12;
+        a22 += other.a22;
+        b0 += other.b0;
+        b1 += other.b1;
+        b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+        return *this;
+    }
+
+    //! Returns the weighted mean squared distance to the accumulated planes
+    double Evaluate(const glm::vec3& point) const
+    {
+        const double x = point.x, y = point.y, z = point.z;
+        const double error = a00 * x * x + a11 * y * y + a22 * z * z +
+                             2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                             2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+    }
+};
+
+//! Candidate edge collapse moving vertex from onto vertex to
+struct EdgeCollapse
+{
+    unsigned int from;
+    unsigned int to;
+    float error;
+};
+
+//! Returns true if moving vertex from onto vertex to flips any triangle
+//! adjacent to vertex from, triangles containing both are removed instead.
+bool HasFlippedTriangle(const std::vector<unsigned int>& indices,
+                        const TriangleAdjacency& adjacency,
+                        const glm::vec3* positions, unsigned int from,
+                        unsigned int to)
+{
+    const unsigned int begin = adjacency.offsets[from];
+    const unsigned int end = begin + adjacency.counts[from];
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        const unsigned int* triangle = &indices[3 * adjacency.triangles[i]];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+        {
+            continue;
+        }
+
+        glm::vec3 p[3];
+        for (size_t k = 0; k < 3; ++k)
+        {
+            p[k] = positions[triangle[k]];
+        }
+        const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        for (size_t k = 0; k < 3; ++k)
+        {
+            if (triangle[k] == from)
+            {
+                p[k] = positions[to];
+            }
+        }
+        const glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+        //! Reject rotations of the normal over ~75 degrees as well
+        if (glm::dot(before, after) <=
+            0.25f * glm::length(before) * glm::length(after))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IsValidTriangleList(const unsigned int* indices, size_t indexCount,
+                         size_t vertexCount)
+{
+    if (indexCount % 3 != 0)
+    {
+        return false;
+    }
+    return std::all_of(indices, indices + indexCount,
+                       [vertexCount](unsigned int index) {
+                           return index < vertexCount;
+                       });
+}
+
+//! Minimum number of triangles or vertices handled by one task of the
+//! attribute generation
+constexpr size_t kAttributeGrainSize = 1 << 12;
+
+//! Lengths and areas at or below this are treated as zero
+constexpr float kAttributeEpsilon = std::numeric_limits<float>::min();
+
+//! Single lane batch, used for the remainder of the batched loops
+struct ScalarBatch
+{
+    static constexpr size_t kWidth = 1;
+    float v;
+
+    static ScalarBatch Broadcast(float value)
+    {
+        return { value };
+    }
+
+    //! Loads the component of the corner vertex of the triangle
+    static ScalarBatch Gather(const float* base, const unsigned int* triangles,
+                              size_t corner, size_t stride, size_t component)
+    {
+        return { base[triangles[corner] * stride + component] };
+    }
+
+    void Store(float* dst) const
+    {
+        *dst = v;
+    }
+
+    friend ScalarBatch operator+(ScalarBatch a, ScalarBatch b)
+    {
+        return { a.v + b.v };
+    }
+    friend ScalarBatch operator-(ScalarBatch a, ScalarBatch b)
+    {
+        return { a.v - b.v };
+    }
+    friend ScalarBatch operator*(ScalarBatch a, ScalarBatch b)
+    {
+        return { a.v * b.v };
+    }
+    friend ScalarBatch Sqrt(ScalarBatch a)
+    {
+        return { std::sqrt(a.v) };
+    }
+    friend ScalarBatch Abs(ScalarBatch a)
+    {
+        return { std::abs(a.v) };
+    }
+    //! 1 / a where a > epsilon, otherwise 0
+    friend ScalarBatch SafeInverse(ScalarBatch a)
+    {
+        return { a.v > kAttributeEpsilon ? 1.0f / a.v : 0.0f };
+    }
+    //! 1 where a > epsilon, otherwise 0
+    friend ScalarBatch NonZero(ScalarBatch a)
+    {
+        return { a.v > kAttributeEpsilon ? 1.0f : 0.0f };
+    }
+    //! 1 where a > 0, otherwise -1
+    friend ScalarBatch Sign(ScalarBatch a)
+    {
+        return { a.v > 0.0f ? 1.0f : -1.0f };
+    }
+};
+
+#ifdef SIMD_SSE2
+//! Four triangles per batch with SSE2
+struct SSE2Batch
+{
+    static constexpr size_t kWidth = 4;
+    __m128 v;
+
+    static SSE2Batch Broadcast(float value)
+    {
+        return { _mm_set1_ps(value) };
+    }
+
+    static SSE2Batch Gather(const float* base, const unsigned int* triangles,
+                            size_t corner, size_t stride, size_t component)
+    {
+        const auto load = [&](size_t lane) {
+            return base[triangles[lane * 3 + corner] * stride + component];
+        };
+        return { _mm_setr_ps(load(0), load(1), load(2), load(3)) };
+    }
+
+    void Store(float* dst) const
+    {
+        _mm_storeu_ps(dst, v);
+    }
+
+    friend SSE2Batch operator+(SSE2Batch a, SSE2Batch b)
+    {
+        return { _mm_add_ps(a.v, b.v) };
+    }
+    friend SSE2Batch operator-(SSE2Batch a, SSE2Batch b)
+    {
+        return { _mm_sub_ps(a.v, b.v) };
+    }
+    friend SSE2Batch operator*(SSE2Batch a, SSE2Batch b)
+    {
+        return { _mm_mul_ps(a.v, b.v) };
+    }
+    friend SSE2Batch Sqrt(SSE2Batch a)
+    {
+        return { _mm_sqrt_ps(a.v) };
+    }
+    friend SSE2Batch Abs(SSE2Batch a)
+    {
+        return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) };
+    }
+    friend SSE2Batch SafeInverse(SSE2Batch a)
+    {
+        const __m128 mask = _mm_cmpgt_ps(a.v, _mm_set1_ps(kAttributeEpsilon));
+        return { _mm_and_ps(mask, _mm_div_ps(_mm_set1_ps(1.0f), a.v)) };
+    }
+    friend SSE2Batch NonZero(SSE2Batch a)
+    {
+        const __m128 mask = _mm_cmpgt_ps(a.v, _mm_set1_ps(kAttributeEpsilon));
+        return { _mm_and_ps(mask, _mm_set1_ps(1.0f)) };
+    }
+    friend SSE2Batch Sign(SSE2Batch a)
+    {
+        const __m128 mask = _mm_cmpgt_ps(a.v, _mm_setzero_ps());
+        return { _mm_or_ps(_mm_and_ps(mask, _mm_set1_ps(1.0f)),
+                           _mm_andnot_ps(mask, _mm_set1_ps(-1.0f))) };
+    }
+};
+#endif
+
+#ifdef SIMD_AVX2
+//! Eight triangles per batch with AVX2 gathers
+struct AVX2Batch
+{
+    static constexpr size_t kWidth = 8;
+    __m256 v;
+
+    static AVX2Batch Broadcast(float value)
+    {
+        return { _mm256_set1_ps(value) };
+    }
+
+    static AVX2Batch Gather(const float* base, const unsigned int* triangles,
+                            size_t corner, size_t stride, size_t component)
+    {
+        const __m256i lanes = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+        const __m256i vertices = _mm256_i32gather_epi32(
+            reinterpret_cast<const int*>(triangles + corner), lanes, 4);
+        const __m256i offsets = _mm256_add_epi32(
+            _mm256_mullo_epi32(vertices,
+                               _mm256_set1_epi32(static_cast<int>(stride))),
+            _mm256_set1_epi32(static_cast<int>(component)));
+        return { _mm256_i32gather_ps(base, offsets, 4) };
+    }
+
+    void Store(float* dst) const
+    {
+        _mm256_storeu_ps(dst, v);
+    }
+
+    friend AVX2Batch operator+(AVX2Batch a, AVX2Batch b)
+    {
+        return { _mm256_add_ps(a.v, b.v) };
+    }
+    friend AVX2Batch operator-(AVX2Batch a, AVX2Batch b)
+    {
+        return { _mm256_sub_ps(a.v, b.v) };
+    }
+    friend AVX2Batch operator*(AVX2Batch a, AVX2Batch b)
+    {
+        return { _mm256_mul_ps(a.v, b.v) };
+    }
+    friend AVX2Batch Sqrt(AVX2Batch a)
+    {
+        return { _mm256_sqrt_ps(a.v) };
+    }
+    friend AVX2Batch Abs(AVX2Batch a)
+    {
+        return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) };
+    }
+    friend AVX2Batch SafeInverse(AVX2Batch a)
+    {
+        const __m256 mask = _mm256_cmp_ps(
+            a.v, _mm256_set1_ps(kAttributeEpsilon), _CMP_GT_OQ);
+        return { _mm256_and_ps(mask,
+                               _mm256_div_ps(_mm256_set1_ps(1.0f), a.v)) };
+    }
+    friend AVX2Batch NonZero(AVX2Batch a)
+    {
+        const __m256 mask = _mm256_cmp_ps(
+            a.v, _mm256_set1_ps(kAttributeEpsilon), _CMP_GT_OQ);
+        return { _mm256_and_ps(mask, _mm256_set1_ps(1.0f)) };
+    }
+    friend AVX2Batch Sign(AVX2Batch a)
+    {
+        const __m256 mask =
+            _mm256_cmp_ps(a.v, _mm256_setzero_ps(), _CMP_GT_OQ);
+        return { _mm256_blendv_ps(_mm256_set1_ps(-1.0f),
+                                  _mm256_set1_ps(1.0f), mask) };
+    }
+};
+#endif
+
+//! Three component vector of batches
+template <typename Batch>
+struct BatchVec3
+{
+    Batch x, y, z;
+
+    friend BatchVec3 operator-(const BatchVec3& a, const BatchVec3& b)
+    {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+    friend BatchVec3 operator*(const BatchVec3& a, Batch s)
+    {
+        return { a.x * s, a.y * s, a.z * s };
+    }
+    friend Batch Dot(const BatchVec3& a, const BatchVec3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+    friend BatchVec3 Cross(const BatchVec3& a, const BatchVec3& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+                 a.x * b.y - a.y * b.x };
+    }
+};
+
+template <typename Batch>
+BatchVec3<Batch> GatherPosition(const glm::vec3* positions,
+                                const unsigned int* triangles, size_t corner)
+{
+    const auto* base = reinterpret_cast<const float*>(positions);
+    return { Batch::Gather(base, triangles, corner, 3, 0),
+             Batch::Gather(base, triangles, corner, 3, 1),
+             Batch::Gather(base, triangles, corner, 3, 2) };
+}
+
+//! Cosine of the angle between two edges, zero for degenerate edges
+template <typename Batch>
+Batch CornerCosine(const BatchVec3<Batch>& a, const BatchVec3<Batch>& b)
+{
+    return Dot(a, b) * SafeInverse(Sqrt(Dot(a, a) * Dot(b, b)));
+}
+
+//! Run the kernel over the triangles in the range, widest batches first
+template <typename Kernel>
+void ForEachTriangleBatch(size_t begin, size_t end, const Kernel& kernel)
+{
+    size_t triangle = begin;
+#ifdef SIMD_AVX2
+    for (; triangle + AVX2Batch::kWidth <= end;
+         triangle += AVX2Batch::kWidth)
+    {
+        kernel(AVX2Batch{}, triangle);
+    }
+#endif
+#ifdef SIMD_SSE2
+    for (; triangle + SSE2Batch::kWidth <= end;
+         triangle += SSE2Batch::kWidth)
+    {
+        kernel(SSE2Batch{}, triangle);
+    }
+#endif
+    for (; triangle < end; ++triangle)
+    {
+        kernel(ScalarBatch{}, triangle);
+    }
+}
+
+//! Returns arbitrary unit vector perpendicular to the normal
+glm::vec3 GetPerpendicular(const glm::vec3& normal)
+{
+    const glm::vec3 tangent = std::abs(normal.x) > std::abs(normal.y)
+                                  ? glm::vec3(normal.z, 0.0f, -normal.x)
+                                  : glm::vec3(0.0f, -normal.z, normal.y);
+    const float length = glm::length(tangent);
+    return length > 0.0f ? tangent / length : glm::vec3(1.0f, 0.0f, 0.0f);
+}
+}  // namespace
+
+glm::vec3 MeshUtils::CalculateFaceNormal(const glm::vec3& v1,
+                                         const glm::vec3& v2,
+                                         const glm::vec3& v3)
+{
+    if (!CheckTriangle(v1, v2, v3))
+    {
+        return glm::vec3(0.0f);
+    }
+
+    glm::vec3 edge1 = v2 - v1;
+    glm::vec3 edge2 = v3 - v2;
+    return glm::normalize(glm::cross(edge1, edge2));
+}
+
+void MeshUtils::GenerateNormals(const unsigned int* indices, size_t indexCount,
+                                const glm::vec3* positions, size_t vertexCount,
+                                glm::vec3* normals)
+{
+    std::fill(normals, normals + vertexCount, glm::vec3(0.0f));
+    if (!IsValidTriangleList(indices, indexCount, vertexCount))
+    {
+        return;
+    }
+
+    //! Unnormalized face normals in structure of arrays, their length is
+    //! twice the area of the triangle.
+    const size_t numTriangles = indexCount / 3;
+    std::vector<float> faceNormals(numTriangles * 3);
+    float* faceNormalX = faceNormals.data();
+    float* faceNormalY = faceNormalX + numTriangles;
+    float* faceNormalZ = faceNormalY + numTriangles;
+
+    ThreadPool& pool = ThreadPool::GetGlobalPool();
+    pool.ParallelForRange(
+        0, numTriangles,
+        [&](size_t begin, size_t end) {
+            ForEachTriangleBatch(begin, end, [&](auto batch, size_t triangle) {
+                using Batch = decltype(batch);
+                const unsigned int* triangles = indices + triangle * 3;
+                const auto p0 = GatherPosition<Batch>(positions, triangles, 0);
+                const auto p1 = GatherPosition<Batch>(positions, triangles, 1);
+                const auto p2 = GatherPosition<Batch>(positions, triangles, 2);
+                const auto normal = Cross(p1 - p0, p2 - p0);
+                normal.x.Store(faceNormalX + triangle);
+                normal.y.Store(faceNormalY + triangle);
+                normal.z.Store(faceNormalZ + triangle);
+            });
+        },
+        kAttributeGrainSize);
+
+    //! Each vertex sums the normals of its own triangles, so no two tasks
+    //! write the same vertex.
+    const TriangleAdjacency adjacency(indices, indexCount, vertexCount);
+    pool.ParallelForRange(
+        0, vertexCount,
+        [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v)
+            {
+                glm::vec3 normal(0.0f);
+                const unsigned int first = adjacency.offsets[v];
+                const unsigned int last = first + adjacency.counts[v];
+                for (unsigned int i = first; i < last; ++i)
+                {
+                    const unsigned int triangle = adjacency.triangles[i];
+                    normal += glm::vec3(faceNormalX[triangle],
+                                        faceNormalY[triangle],
+                                        faceNormalZ[triangle]);
+                }
+
+                const float length = glm::length(normal);
+                normals[v] = length > 0.0f ? normal / length : normal;
+            }
+        },
+        kAttributeGrainSize);
+}
+
+void MeshUtils::GenerateTangents(const unsigned int* indices,
+                                 size_t indexCount, const glm::vec3* positions,
+                                 const glm::vec3* normals,
+                                 const glm::vec2* texCoords,
+                                 size_t vertexCount, glm::vec4* tangents)
+{
+    //! Streams of the per triangle data in structure of arrays
+    enum TriangleStream
+    {
+        TangentX = 0,
+        TangentY,
+        TangentZ,
+        Orientation,
+        Cosine0,
+        Cosine1,
+        Cosine2,
+        NumStreams
+    };
+
+    std::fill(tangents, tangents + vertexCount, glm::vec4(0.0f));
+    if (!IsValidTriangleList(indices, indexCount, vertexCount))
+    {
+        return;
+    }
+
+    const size_t numTriangles = indexCount / 3;
+    std::vector<float> triangleData(texCoords ? numTriangles * NumStreams : 0);
+    float* streams[NumStreams] = {};
+    for (size_t s = 0; s < NumStreams && texCoords; ++s)
+    {
+        streams[s] = triangleData.data() + s * numTriangles;
+    }
+
+    ThreadPool& pool = ThreadPool::GetGlobalPool();
+    if (texCoords)
+    {
+        const auto* uvs = reinterpret_cast<const float*>(texCoords);
+        pool.ParallelForRange(
+            0, numTriangles,
+            [&](size_t begin, size_t end) {
+                ForEachTriangleBatch(begin, end, [&](auto batch,
+                                                     size_t triangle) {
+                    using Batch = decltype(batch);
+                    const unsigned int* triangles = indices + triangle * 3;
+                    const auto p0 =
+                        GatherPosition<Batch>(positions, triangles, 0);
+                    const auto p1 =
+                        GatherPosition<Batch>(positions, triangles, 1);
+                    const auto p2 =
+                        GatherPosition<Batch>(positions, triangles, 2);
+                    //! V axis of glTF points down while MikkTSpace assumes
+                    //! it points up, so the V differences are negated.
+                    const Batch u0 = Batch::Gather(uvs, triangles, 0, 2, 0);
+                    const Batch v0 = Batch::Gather(uvs, triangles, 0, 2, 1);
+                    const Batch du1 =
+                        Batch::Gather(uvs, triangles, 1, 2, 0) - u0;
+                    const Batch dv1 =
+                        v0 - Batch::Gather(uvs, triangles, 1, 2, 1);
+                    const Batch du2 =
+                        Batch::Gather(uvs, triangles, 2, 2, 0) - u0;
+                    const Batch dv2 =
+                        v0 - Batch::Gather(uvs, triangles, 2, 2, 1);
+
+                    //! Tangent is normalized and flipped by the orientation
+                    //! of the texture mapping as MikkTSpace does, triangles
+                    //! with degenerate mapping contribute nothing.
+                    const auto e1 = p1 - p0;
+                    const auto e2 = p2 - p0;
+                    const Batch signedArea = du1 * dv2 - du2 * dv1;
+                    const Batch orientation = Sign(signedArea);
+                    const auto tangent = e1 * dv2 - e2 * dv1;
+                    const Batch inverseLength =
+                        SafeInverse(Sqrt(Dot(tangent, tangent)));
+                    const Batch scale = orientation * inverseLength *
+                                        NonZero(Abs(signedArea));
+                    (tangent.x * scale).Store(streams[TangentX] + triangle);
+                    (tangent.y * scale).Store(streams[TangentY] + triangle);
+                    (tangent.z * scale).Store(streams[TangentZ] + triangle);
+                    orientation.Store(streams[Orientation] + triangle);
+
+                    const auto e3 = p2 - p1;
+                    CornerCosine(e1, e2).Store(streams[Cosine0] + triangle);
+                    CornerCosine(e3, p0 - p1)
+                        .Store(streams[Cosine1] + triangle);
+                    CornerCosine(p0 - p2, p1 - p2)
+                        .Store(streams[Cosine2] + triangle);
+                });
+            },
+            kAttributeGrainSize);
+    }
+
+    //! Each vertex gathers the tangents of its own triangles projected onto
+    //! its tangent plane and weighted by the corner angle.
+    const TriangleAdjacency adjacency(indices, indexCount, vertexCount);
+    pool.ParallelForRange(
+        0, vertexCount,
+        [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v)
+            {
+                const glm::vec3& normal = normals[v];
+                glm::vec3 tangent(0.0f);
+                float orientation = 0.0f;
+                const unsigned int first = adjacency.offsets[v];
+                const unsigned int last =
+                    texCoords ? first + adjacency.counts[v] : first;
+                for (unsigned int i = first; i < last; ++i)
+                {
+                    const unsigned int triangle = adjacency.triangles[i];
+                    const glm::vec3 faceTangent(
+                        streams[TangentX][triangle],
+                        streams[TangentY][triangle],
+                        streams[TangentZ][triangle]);
+                    const glm::vec3 projected =
+                        faceTangent - normal * glm::dot(normal, faceTangent);
+                    const float length = glm::length(projected);
+                    if (length <= kAttributeEpsilon)
+                    {
+                        continue;
+                    }
+
+                    const unsigned int* corners = indices + triangle * 3;
+                    const size_t corner =
+                        corners[0] == v ? 0 : (corners[1] == v ? 1 : 2);
+                    const float angle = std::acos(std::clamp(
+                        streams[Cosine0 + corner][triangle], -1.0f, 1.0f));
+                    tangent += projected * (angle / length);
+                    orientation += angle * streams[Orientation][triangle];
+                }
+
+                const float length = glm::length(tangent);
+                if (length > kAttributeEpsilon)
+                {
+                    tangent /= length;
+                }
+                else
+                {
+                    tangent = GetPerpendicular(normal);
+                }
+                tangents[v] =
+                    glm::vec4(tangent, orientation >= 0.0f ? 1.0f : -1.0f);
+            }
+        },
+        kAttributeGrainSize);
+}
+
+size_t MeshUtils::WeldVertices(const std::vector<PackedVertex>& vertices,
+                               std::vector<unsigned int>& remap,
+                               std::vector<unsigned int>& uniques)
+{
+    const size_t numVertices = vertices.size();
+    remap.resize(numVertices);
+    uniques.clear();
+    if (numVertices == 0)
+    {
+        return 0;
+    }
+
+    ThreadPool& pool = ThreadPool::GetGlobalPool();
+
+    //! Each partition owns disjoint set of keys selected by the high bits of
+    //! the hash, so there is no duplicated vertex across the partitions.
+    const size_t numPartitions = std::max<size_t>(
+        1, std::min(pool.GetNumThreads(), numVertices / kMinPartitionSize));
+
+    //! Quantize attributes and hash them in parallel.
+    std::vector<QuantizedKey> keys(numVertices);
+    std::vector<std::uint64_t> hashes(numVertices);
+    std::vector<unsigned int> partitions(numVertices);
+    pool.ParallelForRange(0, numVertices, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            keys[i] = MakeKey(vertices[i]);
+            hashes[i] = HashKey(keys[i]);
+            partitions[i] = static_cast<unsigned int>((hashes[i] >> 32) %
+                                                      numPartitions);
+        }
+    });
+
+    //! Vertices are split into fixed chunks, the vertex count of each
+    //! partition and chunk is stored at [partition * numChunks + chunk + 1]
+    //! so the prefix sum gives the write offset of every chunk.
+    const size_t numChunks = numPartitions;
+    const size_t chunkSize = (numVertices + numChunks - 1) / numChunks;
+    auto chunkRange = [numVertices, chunkSize](size_t chunk) {
+        const size_t begin = std::min(chunk * chunkSize, numVertices);
+        return std::make_pair(begin, std::min(begin + chunkSize, numVertices));
+    };
+
+    std::vector<size_t> chunkOffsets(numPartitions * numChunks + 1, 0);
+    pool.ParallelFor(0, numChunks, [&](size_t chunk) {
+        const auto [begin, end] = chunkRange(chunk);
+        for (size_t i = begin; i < end; ++i)
+        {
+            ++chunkOffsets[partitions[i] * numChunks + chunk + 1];
+        }
+    });
+    for (size_t idx = 1; idx < chunkOffsets.size(); ++idx)
+    {
+        chunkOffsets[idx] += chunkOffsets[idx - 1];
+    }
+
+    //! Scatter the vertices into the lists of their partitions, each list
+    //! keeps the vertex order.
+    std::vector<unsigned int> partitionVertices(numVertices);
+    pool.ParallelFor(0, numChunks, [&](size_t chunk) {
+        std::vector<size_t> cursors(numPartitions);
+        for (size_t p = 0; p < numPartitions; ++p)
+        {
+            cursors[p] = chunkOffsets[p * numChunks + chunk];
+        }
+        const auto [begin, end] = chunkRange(chunk);
+        for (size_t i = begin; i < end; ++i)
+        {
+            partitionVertices[cursors[partitions[i]]++] =
+                static_cast<unsigned int>(i);
+        }
+    });
+
+    //! Vertices are inserted in ascending order, so the first vertex of each
+    //! unique key is its first occurrence.
+    std::vector<std::vector<unsigned int>> partitionIndices(numPartitions);
+    std::vector<std::uint8_t> isFirst(numVertices, 0);
+    pool.ParallelFor(0, numPartitions, [&](size_t partition) {
+        const size_t begin = chunkOffsets[partition * numChunks];
+        const size_t end = chunkOffsets[(partition + 1) * numChunks];
+        WeldTable table(keys, hashes, end - begin);
+        for (size_t idx = begin; idx < end; ++idx)
+        {
+            const unsigned int vertex = partitionVertices[idx];
+            const size_t numUniques = table.GetNumUniques();
+            remap[vertex] = table.Insert(vertex);
+            isFirst[vertex] = table.GetNumUniques() != numUniques ? 1 : 0;
+        }
+        partitionIndices[partition].resize(table.GetNumUniques());
+    });
+
+    //! Renumber unique vertices in order of first occurrence, the index of
+    //! a first occurrence is the number of first occurrences before it.
+    std::vector<size_t> chunkUniques(numChunks + 1, 0);
+    pool.ParallelFor(0, numChunks, [&](size_t chunk) {
+        const auto [begin, end] = chunkRange(chunk);
+        chunkUniques[chunk + 1] = static_cast<size_t>(
+            std::count(isFirst.begin() + begin, isFirst.begin() + end, 1));
+    });
+    for (size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        chunkUniques[chunk + 1] += chunkUniques[chunk];
+    }
+    const size_t numUniques = chunkUniques[numChunks];
+
+    uniques.resize(numUniques);
+    pool.ParallelFor(0, numChunks, [&](size_t chunk) {
+        auto newIndex = static_cast<unsigned int>(chunkUniques[chunk]);
+        const auto [begin, end] = chunkRange(chunk);
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (isFirst[i] != 0)
+            {
+                partitionIndices[partitions[i]][remap[i]] = newIndex;
+                uniques[newIndex++] = static_cast<unsigned int>(i);
+            }
+        }
+    });
+
+    pool.ParallelForRange(0, numVertices, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            remap[i] = partitionIndices[partitions[i]][remap[i]];
+        }
+    });
+
+    return numUniques;
+}
+
+float MeshUtils::CalculateACMR(const unsigned int* indices, size_t indexCount,
+                               size_t vertexCount, size_t cacheSize)
+{
+    if (indexCount < 3)
+    {
+        return 0.0f;
+    }
+
+    //! Vertex is in the FIFO cache if it was inserted within the last
+    //! cacheSize misses.
+    std::vector<size_t> insertedTime(vertexCount, 0);
+    size_t time = cacheSize + 1;
+    size_t misses = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        const unsigned int index = indices[i];
+        if (time - insertedTime[index] > cacheSize)
+        {
+            insertedTime[index] = time++;
+            ++misses;
+        }
+    }
+
+    return static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+}
+
+void MeshUtils::OptimizeVertexCache(unsigned int* indices, size_t indexCount,
+                                    size_t vertexCount)
+{
+    if (!IsValidTriangleList(indices, indexCount, vertexCount))
+    {
+        return;
+    }
+
+    static const VertexScoreTable kScoreTable;
+    const size_t numTriangles = indexCount / 3;
+    TriangleAdjacency adjacency(indices, indexCount, vertexCount);
+
+    //! Remaining triangles of each vertex are kept at the front of its
+    //! adjacency range.
+    std::vector<unsigned int>& remaining = adjacency.counts;
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScores[v] = kScoreTable.GetScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScores(numTriangles);
+    std::vector<bool> emitted(numTriangles, false);
+    for (size_t t = 0; t < numTriangles; ++t)
+    {
+        triangleScores[t] = vertexScores[indices[3 * t + 0]] +
+                            vertexScores[indices[3 * t + 1]] +
+                            vertexScores[indices[3 * t + 2]];
+    }
+
+    std::vector<unsigned int> output(indexCount);
+    std::array<unsigned int, kMaxCacheSize + 3> cache{};
+    std::array<unsigned int, kMaxCacheSize + 3> newCache{};
+    size_t cacheSize = 0;
+
+    size_t bestTriangle = static_cast<size_t>(
+        std::max_element(triangleScores.begin(), triangleScores.end()) -
+        triangleScores.begin());
+    size_t inputCursor = 0;
+
+    for (size_t outputTriangle = 0; outputTriangle < numTriangles;
+         ++outputTriangle)
+    {
+        //! No candidate in the cache, pick next triangle in input order.
+        if (bestTriangle == numTriangles)
+        {
+            while (emitted[inputCursor])
+            {
+                ++inputCursor;
+            }
+            bestTriangle = inputCursor;
+        }
+
+        const unsigned int* triangle = &indices[3 * bestTriangle];
+        std::copy(triangle, triangle + 3, &output[3 * outputTriangle]);
+        emitted[bestTriangle] = true;
+
+        //! Remove the emitted triangle from the adjacency of its vertices.
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const unsigned int vertex = triangle[k];
+            unsigned int* begin = &adjacency.triangles[adjacency.offsets[vertex]];
+            unsigned int* end = begin + remaining[vertex];
+            unsigned int* found = std::find(
+                begin, end, static_cast<unsigned int>(bestTriangle));
+            if (found != end)
+            {
+                std::swap(*found, *(end - 1));
+                --remaining[vertex];
+            }
+        }
+
+        //! Emitted vertices move to the front of the LRU cache.
+        size_t newCacheSize = 0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            if (std::find(newCache.begin(), newCache.begin() + newCacheSize,
+                          triangle[k]) == newCache.begin() + newCacheSize)
+            {
+                newCache[newCacheSize++] = triangle[k];
+            }
+        }
+        for (size_t i = 0; i < cacheSize; ++i)
+        {
+            const unsigned int vertex = cache[i];
+            if (vertex != triangle[0] && vertex != triangle[1] &&
+                vertex != triangle[2])
+            {
+                newCache[newCacheSize++] = vertex;
+            }
+        }
+
+        //! Update scores of the vertices in the cache and the vertices pushed
+        //! out of the cache, then find the best triangle among the candidates.
+        float bestScore = -1.0f;
+        bestTriangle = numTriangles;
+        for (size_t i = 0; i < newCacheSize; ++i)
+        {
+            const unsigned int vertex = newCache[i];
+            cachePositions[vertex] = i < kMaxCacheSize ? static_cast<int>(i) : -1;
+
+            const float score =
+                kScoreTable.GetScore(cachePositions[vertex], remaining[vertex]);
+            const float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            const unsigned int* adjacent =
+                &adjacency.triangles[adjacency.offsets[vertex]];
+            for (unsigned int j = 0; j < remaining[vertex]; ++j)
+            {
+                const unsigned int t = adjacent[j];
+                triangleScores[t] += delta;
+                if (i < kMaxCacheSize && triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheSize = std::min(newCacheSize, kMaxCacheSize);
+        std::copy(newCache.begin(), newCache.begin() + cacheSize,
+                  cache.begin());
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshUtils::OptimizeOverdraw(unsigned int* indices, size_t indexCount,
+                                 const glm::vec3* positions,
+                                 size_t vertexCount, float threshold)
+{
+    if (!IsValidTriangleList(indices, indexCount, vertexCount) ||
+        indexCount < 6)
+    {
+        return;
+    }
+
+    constexpr size_t kCacheSize = 16;
+    const size_t numTriangles = indexCount / 3;
+
+    //! Hard boundaries, triangles which miss all of their vertices start the
+    //! new strip-like region of the cache optimized order.
+    std::vector<size_t> triangleMisses(numTriangles, 0);
+    {
+        std::vector<size_t> insertedTime(vertexCount, 0);
+        size_t time = kCacheSize + 1;
+        for (size_t t = 0; t < numTriangles; ++t)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const unsigned int index = indices[3 * t + k];
+                if (time - insertedTime[index] > kCacheSize)
+                {
+                    insertedTime[index] = time++;
+                    ++triangleMisses[t];
+                }
+            }
+        }
+    }
+
+    std::vector<size_t> hardBoundaries;
+    for (size_t t = 0; t < numTriangles; ++t)
+    {
+        if (t == 0 || triangleMisses[t] == 3)
+        {
+            hardBoundaries.push_back(t);
+        }
+    }
+    hardBoundaries.push_back(numTriangles);
+
+    //! Soft boundaries, split the hard cluster wherever the ACMR of the run
+    //! simulated from the cold cache stays under the threshold of the hard
+    //! cluster ACMR, so that reordering runs does not hurt the cache much.
+    std::vector<size_t> clusters;
+    std::vector<size_t> insertedTime(vertexCount, 0);
+    size_t time = kCacheSize + 1;
+    for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+    {
+        const size_t begin = hardBoundaries[h];
+        const size_t end = hardBoundaries[h + 1];
+
+        size_t clusterMisses = 0;
+        for (size_t t = begin; t < end; ++t)
+        {
+            clusterMisses += triangleMisses[t];
+        }
+        const float clusterACMR =
+            static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+        clusters.push_back(begin);
+        time += kCacheSize + 1;
+        size_t runMisses = 0;
+        size_t runTriangles = 0;
+        for (size_t t = begin; t < end; ++t)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const unsigned int index = indices[3 * t + k];
+                if (time - insertedTime[index] > kCacheSize)
+                {
+                    insertedTime[index] = time++;
+                    ++runMisses;
+                }
+            }
+            ++runTriangles;
+
+            if (t + 1 < end &&
+                static_cast<float>(runMisses) <=
+                    static_cast<float>(runTriangles) * clusterACMR * threshold)
+            {
+                clusters.push_back(t + 1);
+                time += kCacheSize + 1;
+                runMisses = 0;
+                runTriangles = 0;
+            }
+        }
+    }
+    const size_t numClusters = clusters.size();
+    clusters.push_back(numTriangles);
+
+    //! Area weighted centroid of the whole mesh
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> clusterCentroids(numClusters, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(numClusters, glm::vec3(0.0f));
+    for (size_t c = 0; c < numClusters; ++c)
+    {
+        float clusterArea = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+        {
+            const glm::vec3& p0 = positions[indices[3 * t + 0]];
+            const glm::vec3& p1 = positions[indices[3 * t + 1]];
+            const glm::vec3& p2 = positions[indices[3 * t + 2]];
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float area = glm::length(normal);
+            const glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
+
+            clusterCentroids[c] += centroid * area;
+            clusterNormals[c] += normal;
+            clusterArea += area;
+        }
+
+        meshCentroid += clusterCentroids[c];
+        meshArea += clusterArea;
+        if (clusterArea > 0.0f)
+        {
+            clusterCentroids[c] /= clusterArea;
+        }
+        const float normalLength = glm::length(clusterNormals[c]);
+        if (normalLength > 0.0f)
+        {
+            clusterNormals[c] /= normalLength;
+        }
+    }
+    if (meshArea > 0.0f)
+    {
+        meshCentroid /= meshArea;
+    }
+
+    //! Clusters facing outward from the mesh centroid occlude the others,
+    //! draw them first.
+    std::vector<float> sortKeys(numClusters);
+    std::vector<size_t> order(numClusters);
+    for (size_t c = 0; c < numClusters; ++c)
+    {
+        sortKeys[c] =
+            glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return sortKeys[lhs] > sortKeys[rhs];
+    });
+
+    std::vector<unsigned int> output;
+    output.reserve(indexCount);
+    for (size_t c : order)
+    {
+        output.insert(output.end(), indices + 3 * clusters[c],
+                      indices + 3 * clusters[c + 1]);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshUtils::OptimizeVertexFetch(unsigned int* indices, size_t indexCount,
+                                    size_t vertexCount,
+                                    std::vector<unsigned int>& remap)
+{
+    remap.assign(vertexCount, kInvalidIndex);
+
+    unsigned int nextVertex = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        unsigned int& newIndex = remap[indices[i]];
+        if (newIndex == kInvalidIndex)
+        {
+            newIndex = nextVertex++;
+        }
+        indices[i] = newIndex;
+    }
+
+    //! Keep unreferenced vertices at the end, vertex count is not changed.
+    for (auto& newIndex : remap)
+    {
+        if (newIndex == kInvalidIndex)
+        {
+            newIndex = nextVertex++;
+        }
+    }
+}
+
+float MeshUtils::SimplifyMesh(const unsigned int* indices, size_t indexCount,
+                              const glm::vec3* positions, size_t vertexCount,
+                              size_t targetIndexCount, float targetError,
+                              std::vector<unsigned int>& result)
+{
+    result.assign(indices, indices + indexCount);
+    if (!IsValidTriangleList(indices, indexCount, vertexCount) ||
+        indexCount <= targetIndexCount)
+    {
+        return 0.0f;
+    }
+
+    //! Vertices sharing the same position are attribute seams, lock them
+    //! so the collapses never tear the surface apart.
+    std::vector<unsigned int> canonical(vertexCount);
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::vector<unsigned int> order(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            order[v] = static_cast<unsigned int>(v);
+        }
+        auto less = [positions](unsigned int lhs, unsigned int rhs) {
+            const glm::vec3& a = positions[lhs];
+            const glm::vec3& b = positions[rhs];
+            return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+        };
+        std::sort(order.begin(), order.end(), less);
+
+        for (size_t begin = 0, end = 0; begin < vertexCount; begin = end)
+        {
+            end = begin + 1;
+            while (end < vertexCount && positions[order[end]] ==
+                                            positions[order[begin]])
+            {
+                ++end;
+            }
+            for (size_t i = begin; i < end; ++i)
+            {
+                canonical[order[i]] = order[begin];
+                locked[order[i]] = end - begin > 1;
+            }
+        }
+    }
+
+    //! Lock vertices of the open border and non-manifold edges, every
+    //! interior edge of the welded surface is shared by two triangles.
+    {
+        std::unordered_map<std::uint64_t, unsigned int> edgeCounts;
+        edgeCounts.reserve(indexCount);
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                unsigned int a = canonical[indices[i + k]];
+                unsigned int b = canonical[indices[i + (k + 1) % 3]];
+                if (a > b)
+                {
+                    std::swap(a, b);
+                }
+                ++edgeCounts[(static_cast<std::uint64_t>(a) << 32) | b];
+            }
+        }
+        for (const auto& edge : edgeCounts)
+        {
+            if (edge.second != 2)
+            {
+                const auto a = static_cast<unsigned int>(edge.first >> 32);
+                const auto b = static_cast<unsigned int>(edge.first);
+                locked[a] = true;
+                locked[b] = true;
+            }
+        }
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            locked[v] = locked[v] || locked[canonical[v]];
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indexCount; i += 3)
+    {
+        const glm::vec3& p0 = positions[indices[i + 0]];
+        const glm::vec3& p1 = positions[indices[i + 1]];
+        const glm::vec3& p2 = positions[indices[i + 2]];
+        const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const float length = glm::length(normal);
+        if (length <= 0.0f)
+        {
+            continue;
+        }
+
+        const glm::vec3 unitNormal = normal / length;
+        const float distance = -glm::dot(unitNormal, p0);
+        for (size_t k = 0; k < 3; ++k)
+        {
+            quadrics[indices[i + k]].AddPlane(unitNormal, distance,
+                                              length * 0.5f);
+        }
+    }
+
+    float resultError = 0.0f;
+    std::vector<unsigned int> collapseRemap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<EdgeCollapse> collapses;
+
+    //! Each pass collapses the cheapest independent edges, then rebuilds the
+    //! triangle list without degenerate triangles.
+    while (result.size() > targetIndexCount)
+    {
+        TriangleAdjacency adjacency(result.data(), result.size(), vertexCount);
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const unsigned int a = result[i + k];
+                const unsigned int b = result[i + (k + 1) % 3];
+                //! Interior edges are visited from both triangles
+                if (a > b || (locked[a] && locked[b]))
+                {
+                    continue;
+                }
+
+                Quadric quadric = quadrics[a];
+                quadric += quadrics[b];
+                const float errorA = locked[a] || locked[b]
+                                         ? std::numeric_limits<float>::max()
+                                         : static_cast<float>(std::sqrt(
+                                               quadric.Evaluate(positions[b])));
+                const float errorB = locked[b]
+                                         ? std::numeric_limits<float>::max()
+                                         : static_cast<float>(std::sqrt(
+                                               quadric.Evaluate(positions[a])));
+                if (errorA <= errorB)
+                {
+                    collapses.push_back({ a, b, errorA });
+                }
+                else
+                {
+                    collapses.push_back({ b, a, errorB });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const EdgeCollapse& lhs, const EdgeCollapse& rhs) {
+                      return lhs.error < rhs.error;
+                  });
+
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            collapseRemap[v] = static_cast<unsigned int>(v);
+        }
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t triangleCount = result.size() / 3;
+        size_t numCollapses = 0;
+        for (const auto& collapse : collapses)
+        {
+            if (collapse.error > targetError ||
+                triangleCount * 3 <= targetIndexCount)
+            {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to] ||
+                locked[collapse.from] ||
+                HasFlippedTriangle(result, adjacency, positions,
+                                   collapse.from, collapse.to))
+            {
+                continue;
+            }
+
+            //! Lock the neighborhood for the rest of the pass, because the
+            //! adjacency and positions of its triangles are changed.
+            const unsigned int begin = adjacency.offsets[collapse.from];
+            const unsigned int end = begin + adjacency.counts[collapse.from];
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                const unsigned int* triangle =
+                    &result[3 * adjacency.triangles[i]];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to ||
+                    triangle[2] == collapse.to)
+                {
+                    --triangleCount;
+                }
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    touched[triangle[k]] = true;
+                }
+            }
+
+            collapseRemap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            resultError = std::max(resultError, collapse.error);
+            ++numCollapses;
+        }
+
+        if (numCollapses == 0)
+        {
+            break;
+        }
+
+        size_t writeIndex = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            const unsigned int a = collapseRemap[result[i + 0]];
+            const unsigned int b = collapseRemap[result[i + 1]];
+            const unsigned int c = collapseRemap[result[i + 2]];
+            if (a != b && b != c && c != a)
+            {
+                result[writeIndex++] = a;
+                result[writeIndex++] = b;
+                result[writeIndex++] = c;
+            }
+        }
+        result.resize(writeIndex);
+    }
+
+    return resultError;
+}
+
+}  // namespace Common
@@ -0,0 +1,560 @@
+#include <Common/ObjParser.hpp>
+#include <Common/ThreadPool.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Minimum size of the text parsed by one task
+constexpr size_t kMinChunkSize = 1 << 20;
+
+constexpr int kInvalidIndex = -1;
+
+//! Exactly representable powers of ten in double precision
+constexpr std::array<double, 23> kPowersOfTen = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+enum class RecordType
+{
+    Position,
+    TexCoord,
+    Normal,
+    Face,
+    Other
+};
+
+//! Zero-based attribute indices of one face corner
+struct CornerIndex
+{
+    int position{ kInvalidIndex };
+    int texCoord{ kInvalidIndex };
+    int normal{ kInvalidIndex };
+};
+
+//! Line-aligned range of the text and the number of records in it
+struct Chunk
+{
+    const char* begin{ nullptr };
+    const char* end{ nullptr };
+    size_t numPositions{ 0 };
+    size_t numTexCoords{ 0 };
+    size_t numNormals{ 0 };
+    size_t numTriangles{ 0 };
+    bool valid{ true };
+};
+
+bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+const char* SkipSpaces(const char* p, const char* end)
+{
+    while (p < end && IsSpace(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+const char* FindLineEnd(const char* p, const char* end)
+{
+    const void* newLine = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return newLine ? static_cast<const char*>(newLine) : end;
+}
+
+bool IsEndOfRecord(const char* p, const char* end)
+{
+    return p >= end || *p == '\n' || *p == '#';
+}
+
+//! Classify the record at the beginning of the line and skip the keyword.
+RecordType ReadRecordType(const char*& p, const char* end)
+{
+    const size_t remained = static_cast<size_t>(end - p);
+    if (remained >= 2 && p[0] == 'v' && IsSpace(p[1]))
+    {
+        p += 2;
+        return RecordType::Position;
+    }
+    if (remained >= 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+    {
+        p += 3;
+        return RecordType::TexCoord;
+    }
+    if (remained >= 3 && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+    {
+        p += 3;
+        return RecordType::Normal;
+    }
+    if (remained >= 2 && p[0] == 'f' && IsSpace(p[1]))
+    {
+        p += 2;
+        return RecordType::Face;
+    }
+    return RecordType::Other;
+}
+
+//! Returns true if the line is continued with trailing backslash.
+bool HasLineContinuation(const char* lineBegin, const char* lineEnd)
+{
+    while (lineEnd > lineBegin && IsSpace(*(lineEnd - 1)))
+    {
+        --lineEnd;
+    }
+    return lineEnd > lineBegin && *(lineEnd - 1) == '\\';
+}
+
+//! Parse decimal floating point number regardless of the current locale.
+bool ParseFloat(const char*& p, const char* end, float& value)
+{
+    p = SkipSpaces(p, end);
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    //! Accumulate up to 19 significant digits, remained digits only shift
+    //! the exponent.
+    std::uint64_t mantissa = 0;
+    int exponent = 0;
+    int numDigits = 0;
+    int numSignificant = 0;
+    for (; p < end && IsDigit(*p); ++p, ++numDigits)
+    {
+        if (numSignificant < 19)
+        {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+            numSignificant += (mantissa != 0);
+        }
+        else
+        {
+            ++exponent;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && IsDigit(*p); ++p, ++numDigits)
+        {
+            if (numSignificant < 19)
+            {
+                mantissa =
+                    mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+                numSignificant += (mantissa != 0);
+                --exponent;
+            }
+        }
+    }
+    if (numDigits == 0)
+    {
+        return false;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = (*p == '-');
+            ++p;
+        }
+        if (p >= end || !IsDigit(*p))
+        {
+            return false;
+        }
+        int explicitExponent = 0;
+        for (; p < end && IsDigit(*p); ++p)
+        {
+            if (explicitExponent < 10000)
+            {
+                explicitExponent = explicitExponent * 10 + (*p - '0');
+            }
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa != 0 && exponent != 0)
+    {
+        const int absExponent = std::abs(exponent);
+        const double scale =
+            absExponent < static_cast<int>(kPowersOfTen.size())
+                ? kPowersOfTen[absExponent]
+                : std::pow(10.0, absExponent);
+        result = exponent < 0 ? result / scale : result * scale;
+    }
+
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+}
+
+bool ParseInt(const char*& p, const char* end, int& value)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p >= end || !IsDigit(*p))
+    {
+        return false;
+    }
+
+    std::int64_t result = 0;
+    for (; p < end && IsDigit(*p); ++p)
+    {
+        result = result * 10 + (*p - '0');
+        if (result > INT32_MAX)
+        {
+            return false;
+        }
+    }
+
+    value = static_cast<int>(negative ? -result : result);
+    return true;
+}
+
+//! Convert one-based or relative obj index into zero-based absolute index.
+bool ResolveIndex(int index, size_t numDefined, int& resolved)
+{
+    if (index > 0)
+    {
+        resolved = index - 1;
+        return true;
+    }
+    if (index < 0 && static_cast<size_t>(-index) <= numDefined)
+    {
+        resolved = static_cast<int>(numDefined) + index;
+        return true;
+    }
+    return false;
+}
+
+//! Parse one "v", "v/vt", "v//vn" or "v/vt/vn" corner of the face record.
+bool ParseCorner(const char*& p, const char* end, const Chunk& base,
+                 CornerIndex& corner)
+{
+    int index = 0;
+    if (!ParseInt(p, end, index) ||
+        !ResolveIndex(index, base.numPositions, corner.position))
+    {
+        return false;
+    }
+    corner.texCoord = kInvalidIndex;
+    corner.normal = kInvalidIndex;
+
+    if (p < end && *p == '/')
+    {
+        ++p;
+        if (p < end && *p != '/')
+        {
+            if (!ParseInt(p, end, index) ||
+                !ResolveIndex(index, base.numTexCoords, corner.texCoord))
+            {
+                return false;
+            }
+        }
+        if (p < end && *p == '/')
+        {
+            ++p;
+            if (!ParseInt(p, end, index) ||
+                !ResolveIndex(index, base.numNormals, corner.normal))
+            {
+                return false;
+            }
+        }
+    }
+
+    return p >= end || IsSpace(*p) || *p == '\n' || *p == '#';
+}
+
+//! Split the text into line-aligned chunks.
+std::vector<Chunk> SplitChunks(const char* data, size_t size,
+                               size_t maxChunks)
+{
+    const size_t numChunks =
+        std::max<size_t>(1, std::min(maxChunks, size / kMinChunkSize));
+    const char* end = data + size;
+
+    std::vector<Chunk> chunks;
+    chunks.reserve(numChunks);
+    const char* begin = data;
+    for (size_t i = 1; i <= numChunks && begin < end; ++i)
+    {
+        const char* chunkEnd = end;
+        if (i < numChunks)
+        {
+            chunkEnd = std::max(begin, data + size * i / numChunks);
+            chunkEnd = FindLineEnd(chunkEnd, end);
+            chunkEnd = std::min(chunkEnd + 1, end);
+        }
+
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = chunkEnd;
+        chunks.push_back(chunk);
+        begin = chunkEnd;
+    }
+
+    return chunks;
+}
+
+//! First pass, count the records of the chunk.
+void CountRecords(Chunk& chunk)
+{
+    const char* p = chunk.begin;
+    while (p < chunk.end)
+    {
+        const char* lineEnd = FindLineEnd(p, chunk.end);
+        const char* cursor = SkipSpaces(p, lineEnd);
+        const RecordType type = ReadRecordType(cursor, lineEnd);
+        if (type != RecordType::Other && HasLineContinuation(cursor, lineEnd))
+        {
+            chunk.valid = false;
+            return;
+        }
+
+        switch (type)
+        {
+            case RecordType::Position:
+                ++chunk.numPositions;
+                break;
+            case RecordType::TexCoord:
+                ++chunk.numTexCoords;
+                break;
+            case RecordType::Normal:
+                ++chunk.numNormals;
+                break;
+            case RecordType::Face:
+            {
+                size_t numCorners = 0;
+                cursor = SkipSpaces(cursor, lineEnd);
+                while (!IsEndOfRecord(cursor, lineEnd))
+                {
+                    ++numCorners;
+                    while (cursor < lineEnd && !IsSpace(*cursor))
+                    {
+                        ++cursor;
+                    }
+                    cursor = SkipSpaces(cursor, lineEnd);
+                }
+                chunk.numTriangles += numCorners >= 3 ? numCorners - 2 : 0;
+                break;
+            }
+            default:
+                break;
+        }
+
+        p = lineEnd + 1;
+    }
+}
+
+//! Second pass, parse the records of the chunk into the shared arrays at the
+//! offsets given by the prefix sum of the first pass.
+void ParseRecords(Chunk& chunk, const Chunk& base,
+                  std::vector<glm::vec3>& positions,
+                  std::vector<glm::vec2>& texCoords,
+                  std::vector<glm::vec3>& normals,
+                  std::vector<CornerIndex>& cornerIndices)
+{
+    Chunk cursorBase = base;
+    std::vector<CornerIndex> polygon;
+
+    const char* p = chunk.begin;
+    while (p < chunk.end && chunk.valid)
+    {
+        const char* lineEnd = FindLineEnd(p, chunk.end);
+        const char* cursor = SkipSpaces(p, lineEnd);
+        switch (ReadRecordType(cursor, lineEnd))
+        {
+            case RecordType::Position:
+            {
+                glm::vec3& position = positions[cursorBase.numPositions++];
+                chunk.valid = ParseFloat(cursor, lineEnd, position.x) &&
+                              ParseFloat(cursor, lineEnd, position.y) &&
+                              ParseFloat(cursor, lineEnd, position.z);
+                break;
+            }
+            case RecordType::TexCoord:
+            {
+                glm::vec2& texCoord = texCoords[cursorBase.numTexCoords++];
+                chunk.valid = ParseFloat(cursor, lineEnd, texCoord.x);
+                //! Second coordinate is optional.
+                if (chunk.valid && !ParseFloat(cursor, lineEnd, texCoord.y))
+                {
+                    texCoord.y = 0.0f;
+                }
+                break;
+            }
+            case RecordType::Normal:
+            {
+                glm::vec3& normal = normals[cursorBase.numNormals++];
+                chunk.valid = ParseFloat(cursor, lineEnd, normal.x) &&
+                              ParseFloat(cursor, lineEnd, normal.y) &&
+                              ParseFloat(cursor, lineEnd, normal.z);
+                break;
+            }
+            case RecordType::Face:
+            {
+                polygon.clear();
+                cursor = SkipSpaces(cursor, lineEnd);
+                while (chunk.valid && !IsEndOfRecord(cursor, lineEnd))
+                {
+                    CornerIndex corner;
+                    chunk.valid = ParseCorner(cursor, lineEnd, cursorBase,
+                                              corner);
+                    polygon.push_back(corner);
+                    cursor = SkipSpaces(cursor, lineEnd);
+                }
+
+                //! Fan triangulation, same as the counting pass.
+                for (size_t i = 2; chunk.valid && i < polygon.size(); ++i)
+                {
+                    CornerIndex* triangle =
+                        &cornerIndices[3 * cursorBase.numTriangles++];
+                    triangle[0] = polygon[0];
+                    triangle[1] = polygon[i - 1];
+                    triangle[2] = polygon[i];
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        p = lineEnd + 1;
+    }
+}
+}  // namespace
+
+bool ObjParser::Parse(const char* data, size_t size,
+                      std::vector<PackedVertex>& corners)
+{
+    corners.clear();
+    if (data == nullptr || size == 0)
+    {
+        return true;
+    }
+
+    ThreadPool& pool = ThreadPool::GetGlobalPool();
+    std::vector<Chunk> chunks =
+        SplitChunks(data, size, std::max<size_t>(pool.GetNumThreads(), 1) * 4);
+    const size_t numChunks = chunks.size();
+
+    pool.ParallelFor(0, numChunks,
+                     [&chunks](size_t i) { CountRecords(chunks[i]); });
+
+    //! Exclusive prefix sum of the record counts.
+    std::vector<Chunk> bases(numChunks + 1);
+    for (size_t i = 0; i < numChunks; ++i)
+    {
+        if (!chunks[i].valid)
+        {
+            return false;
+        }
+        bases[i + 1].numPositions =
+            bases[i].numPositions + chunks[i].numPositions;
+        bases[i + 1].numTexCoords =
+            bases[i].numTexCoords + chunks[i].numTexCoords;
+        bases[i + 1].numNormals = bases[i].numNormals + chunks[i].numNormals;
+        bases[i + 1].numTriangles =
+            bases[i].numTriangles + chunks[i].numTriangles;
+    }
+    const Chunk& total = bases[numChunks];
+
+    std::vector<glm::vec3> positions(total.numPositions);
+    std::vector<glm::vec2> texCoords(total.numTexCoords);
+    std::vector<glm::vec3> normals(total.numNormals);
+    std::vector<CornerIndex> cornerIndices(total.numTriangles * 3);
+
+    pool.ParallelFor(0, numChunks, [&](size_t i) {
+        ParseRecords(chunks[i], bases[i], positions, texCoords, normals,
+                     cornerIndices);
+    });
+    for (const Chunk& chunk : chunks)
+    {
+        if (!chunk.valid)
+        {
+            return false;
+        }
+    }
+
+    //! Gather attributes of each triangle. Forward references are allowed,
+    //! so the indices are validated after all chunks are parsed.
+    std::atomic<bool> valid{ true };
+    corners.resize(cornerIndices.size());
+    pool.ParallelForRange(0, total.numTriangles, [&](size_t begin, size_t end) {
+        for (size_t triangle = begin; triangle < end; ++triangle)
+        {
+            const CornerIndex* indices = &cornerIndices[3 * triangle];
+            PackedVertex* vertices = &corners[3 * triangle];
+
+            bool hasTexCoord = true;
+            bool hasNormal = true;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const CornerIndex& index = indices[k];
+                if (static_cast<size_t>(index.position) >= positions.size() ||
+                    (index.texCoord != kInvalidIndex &&
+                     static_cast<size_t>(index.texCoord) >= texCoords.size()) ||
+                    (index.normal != kInvalidIndex &&
+                     static_cast<size_t>(index.normal) >= normals.size()))
+                {
+                    valid = false;
+                    return;
+                }
+                hasTexCoord &= (index.texCoord != kInvalidIndex);
+                hasNormal &= (index.normal != kInvalidIndex);
+            }
+
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const CornerIndex& index = indices[k];
+                vertices[k].position = positions[index.position];
+                if (hasTexCoord)
+                {
+                    //! Flip Y coord.
+                    const glm::vec2& texCoord = texCoords[index.texCoord];
+                    vertices[k].texCoord =
+                        glm::vec2(texCoord.x, 1.0f - texCoord.y);
+                }
+                if (hasNormal)
+                {
+                    vertices[k].normal = normals[index.normal];
+                }
+            }
+
+            if (!hasNormal)
+            {
+                const glm::vec3 faceNormal = MeshUtils::CalculateFaceNormal(
+                    vertices[0].position, vertices[1].position,
+                    vertices[2].position);
+                vertices[0].normal = faceNormal;
+                vertices[1].normal = faceNormal;
+                vertices[2].normal = faceNormal;
+            }
+        }
+    });
+
+    return valid;
+}
+
+}  // namespace Common
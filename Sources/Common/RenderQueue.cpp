@@ -0,0 +1,123 @@
+#include <Common/RenderQueue.hpp>
+#include <array>
+#include <cstring>
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+constexpr std::uint64_t kDepthMask = (1ULL << 24) - 1;
+
+//! Quantize the distance into 24 bits keeping its order. Bits of the
+//! non-negative floats are ordered like their values, the sign bit and the
+//! lowest mantissa bits are dropped.
+std::uint64_t QuantizeDepth(float depth)
+{
+    if (!(depth > 0.0f))
+    {
+        return 0;
+    }
+    std::uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return (bits >> 7) & kDepthMask;
+}
+}  // namespace
+
+std::uint64_t RenderQueue::MakeSortKey(unsigned int pass, int alphaMode,
+                                       unsigned int shader, int material,
+                                       unsigned int mesh, float depth)
+{
+    //! Default material -1 is ordered before the others
+    const std::uint64_t materialBits =
+        static_cast<std::uint64_t>(material + 1) & 0xFFFF;
+    const std::uint64_t shaderBits = shader & 0xFF;
+    const std::uint64_t meshBits = mesh & 0x3FF;
+    const std::uint64_t depthBits = QuantizeDepth(depth);
+
+    std::uint64_t key = (static_cast<std::uint64_t>(pass & 0xF) << 60) |
+                        (static_cast<std::uint64_t>(alphaMode & 0x3) << 58);
+    if (alphaMode == 2)
+    {
+        key |= ((kDepthMask - depthBits) << 34) | (shaderBits << 26) |
+               (materialBits << 10) | meshBits;
+    }
+    else
+    {
+        key |= (shaderBits << 50) | (materialBits << 34) | (meshBits << 24) |
+               depthBits;
+    }
+    return key;
+}
+
+int RenderQueue::GetAlphaMode(std::uint64_t key)
+{
+    return static_cast<int>((key >> 58) & 0x3);
+}
+
+unsigned int RenderQueue::GetShader(std::uint64_t key)
+{
+    const int shift = GetAlphaMode(key) == 2 ? 26 : 50;
+    return static_cast<unsigned int>((key >> shift) & 0xFF);
+}
+
+std::uint32_t RenderQueue::GetState(std::uint64_t key)
+{
+    const int shift = GetAlphaMode(key) == 2 ? 10 : 34;
+    return static_cast<std::uint32_t>((key >> shift) & 0xFFFFFF);
+}
+
+void RenderQueue::Clear()
+{
+    _items.clear();
+}
+
+void RenderQueue::Push(std::uint64_t key, std::uint32_t payload)
+{
+    _items.push_back({ key, payload });
+}
+
+void RenderQueue::Sort()
+{
+    constexpr size_t kNumDigits = sizeof(std::uint64_t);
+    const size_t count = _items.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    std::array<std::array<size_t, 256>, kNumDigits> histograms{};
+    for (const Item& item : _items)
+    {
+        for (size_t digit = 0; digit < kNumDigits; ++digit)
+        {
+            ++histograms[digit][(item.key >> (digit * 8)) & 0xFF];
+        }
+    }
+
+    _scratch.resize(count);
+    for (size_t digit = 0; digit < kNumDigits; ++digit)
+    {
+        auto& histogram = histograms[digit];
+        const size_t shift = digit * 8;
+
+        //! Every key has the same digit, the order is already correct
+        if (histogram[(_items.front().key >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t& bucket : histogram)
+        {
+            const size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (const Item& item : _items)
+        {
+            _scratch[histogram[(item.key >> shift) & 0xFF]++] = item;
+        }
+        _items.swap(_scratch);
+    }
+}
+}  // namespace Common
@@ -0,0 +1,354 @@
+#include <Common/HashUtils.hpp>
+#include <Common/ShaderSourceCache.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Collapse the separators, "." and ".." components, so the same file
+//! included from different directories has the same key
+std::string NormalizePath(const std::string& path)
+{
+    std::vector<std::string> components;
+    size_t begin = 0;
+    while (begin <= path.size())
+    {
+        size_t end = path.find_first_of("/\\", begin);
+        if (end == std::string::npos)
+        {
+            end = path.size();
+        }
+
+        std::string component = path.substr(begin, end - begin);
+        if (component == "..")
+        {
+            if (!components.empty() && components.back() != "..")
+            {
+                components.pop_back();
+            }
+            else
+            {
+                components.push_back(std::move(component));
+            }
+        }
+        else if (!component.empty() && component != ".")
+        {
+            components.push_back(std::move(component));
+        }
+        begin = end + 1;
+    }
+
+    std::string normalized;
+    if (!path.empty() && (path.front() == '/' || path.front() == '\\'))
+    {
+        normalized.push_back('/');
+    }
+    for (size_t idx = 0; idx < components.size(); ++idx)
+    {
+        if (idx != 0)
+        {
+            normalized.push_back('/');
+        }
+        normalized += components[idx];
+    }
+    return normalized;
+}
+
+std::string GetPathDirectory(const std::string& path)
+{
+    const size_t pos = path.find_last_of('/');
+    return pos == std::string::npos ? std::string() : path.substr(0, pos + 1);
+}
+
+bool ReadFile(const std::string& path, std::string& contents)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>());
+    return true;
+}
+
+//! Returns the directive name if the line is a preprocessor directive,
+//! and stores the rest of the line to the argument
+std::string ParseDirective(const std::string& line, std::string& argument)
+{
+    size_t pos = line.find_first_not_of(" \t");
+    if (pos == std::string::npos || line[pos] != '#')
+    {
+        return std::string();
+    }
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos)
+    {
+        return std::string();
+    }
+    const size_t nameEnd = line.find_first_of(" \t\r", pos);
+    const std::string name = line.substr(pos, nameEnd - pos);
+
+    argument.clear();
+    const size_t argBegin = nameEnd == std::string::npos
+                                ? std::string::npos
+                                : line.find_first_not_of(" \t", nameEnd);
+    if (argBegin != std::string::npos)
+    {
+        const size_t argEnd = line.find_last_not_of(" \t\r");
+        argument = line.substr(argBegin, argEnd - argBegin + 1);
+    }
+    return name;
+}
+}  // namespace
+
+const std::string& ShaderSourceCache::GetSource(const std::string& path,
+                                                const Defines& defines)
+{
+    const std::string root = NormalizePath(path);
+    const std::string key = MakeSourceKey(root, defines);
+    auto iter = _sources.find(key);
+    if (iter != _sources.end())
+    {
+        return iter->second.contents;
+    }
+
+    ExpandedSource expanded;
+    expanded.root = root;
+    std::unordered_set<std::string> included;
+    std::vector<std::string> stack;
+    if (!Expand(root, included, stack, expanded.contents,
+                expanded.dependencies))
+    {
+        std::cerr << "[ShaderSourceCache:GetSource] Failed to preprocess "
+                  << path << std::endl;
+    }
+
+    //! Defines are placed after the #version line, which must come first
+    if (!defines.empty())
+    {
+        Defines sortedDefines = defines;
+        std::sort(sortedDefines.begin(), sortedDefines.end());
+
+        std::string defineLines;
+        for (const auto& [name, value] : sortedDefines)
+        {
+            defineLines += "#define " + name + ' ' + value + '\n';
+        }
+
+        size_t insertPos = 0;
+        const size_t versionPos = expanded.contents.find("#version");
+        if (versionPos != std::string::npos)
+        {
+            const size_t lineEnd = expanded.contents.find('\n', versionPos);
+            insertPos = lineEnd == std::string::npos
+                            ? expanded.contents.size()
+                            : lineEnd + 1;
+        }
+        expanded.contents.insert(insertPos, defineLines);
+    }
+
+    //! Failed sources are cached as well, Refresh retries them when the
+    //! missing file appears
+    for (const std::string& dependency : expanded.dependencies)
+    {
+        _dependents[dependency].insert(key);
+    }
+    return _sources.emplace(key, std::move(expanded)).first->second.contents;
+}
+
+bool ShaderSourceCache::Contains(const std::string& path,
+                                 const Defines& defines) const
+{
+    return _sources.count(MakeSourceKey(NormalizePath(path), defines)) != 0;
+}
+
+std::vector<std::string> ShaderSourceCache::GetDependencies(
+    const std::string& path, const Defines& defines) const
+{
+    auto iter = _sources.find(MakeSourceKey(NormalizePath(path), defines));
+    return iter == _sources.end() ? std::vector<std::string>()
+                                  : iter->second.dependencies;
+}
+
+std::vector<std::string> ShaderSourceCache::Refresh()
+{
+    std::unordered_set<std::string> droppedKeys;
+    for (const auto& [path, dependents] : _dependents)
+    {
+        std::string contents;
+        const bool readable = ReadFile(path, contents);
+        auto iter = _files.find(path);
+        if (readable == (iter != _files.end()) &&
+            (!readable || iter->second.hash == HashUtils::HashBytes(
+                                                   contents.data(),
+                                                   contents.size())))
+        {
+            continue;
+        }
+
+        //! Reloaded on the next use
+        if (iter != _files.end())
+        {
+            _files.erase(iter);
+        }
+        droppedKeys.insert(dependents.begin(), dependents.end());
+    }
+
+    std::vector<std::string> changedRoots;
+    for (const std::string& key : droppedKeys)
+    {
+        auto iter = _sources.find(key);
+        for (const std::string& dependency : iter->second.dependencies)
+        {
+            auto dependents = _dependents.find(dependency);
+            dependents->second.erase(key);
+            if (dependents->second.empty())
+            {
+                _dependents.erase(dependents);
+            }
+        }
+        if (std::find(changedRoots.begin(), changedRoots.end(),
+                      iter->second.root) == changedRoots.end())
+        {
+            changedRoots.push_back(iter->second.root);
+        }
+        _sources.erase(iter);
+    }
+    return changedRoots;
+}
+
+void ShaderSourceCache::Clear()
+{
+    _files.clear();
+    _sources.clear();
+    _dependents.clear();
+}
+
+ShaderSourceCache& ShaderSourceCache::GetGlobalCache()
+{
+    static ShaderSourceCache kGlobalCache;
+    return kGlobalCache;
+}
+
+const ShaderSourceCache::SourceFile* ShaderSourceCache::LoadFile(
+    const std::string& path)
+{
+    auto iter = _files.find(path);
+    if (iter != _files.end())
+    {
+        return &iter->second;
+    }
+
+    std::string contents;
+    if (!ReadFile(path, contents))
+    {
+        return nullptr;
+    }
+
+    //! Split the file at its include directives, so the expansion only
+    //! concatenates the segments
+    SourceFile file;
+    file.hash = HashUtils::HashBytes(contents.data(), contents.size());
+    file.segments.emplace_back();
+    const std::string directory = GetPathDirectory(path);
+    std::string argument;
+    size_t begin = 0;
+    while (begin < contents.size())
+    {
+        size_t end = contents.find('\n', begin);
+        if (end == std::string::npos)
+        {
+            end = contents.size();
+        }
+        const std::string line = contents.substr(begin, end - begin);
+        begin = end + 1;
+
+        const std::string directive = ParseDirective(line, argument);
+        if (directive == "include" && !argument.empty())
+        {
+            if ((argument.front() == '"' || argument.front() == '<') &&
+                argument.size() >= 2)
+            {
+                argument = argument.substr(1, argument.size() - 2);
+            }
+            file.segments.back().include = NormalizePath(directory + argument);
+            file.segments.emplace_back();
+        }
+        else if (directive == "pragma" && argument == "once")
+        {
+            file.pragmaOnce = true;
+        }
+        else
+        {
+            file.segments.back().text += line;
+            file.segments.back().text.push_back('\n');
+        }
+    }
+
+    return &_files.emplace(path, std::move(file)).first->second;
+}
+
+bool ShaderSourceCache::Expand(const std::string& path,
+                               std::unordered_set<std::string>& included,
+                               std::vector<std::string>& stack,
+                               std::string& source,
+                               std::vector<std::string>& dependencies)
+{
+    if (std::find(dependencies.begin(), dependencies.end(), path) ==
+        dependencies.end())
+    {
+        dependencies.push_back(path);
+    }
+
+    const SourceFile* file = LoadFile(path);
+    if (file == nullptr)
+    {
+        std::cerr << "[ShaderSourceCache:Expand] Failed to open " << path
+                  << std::endl;
+        return false;
+    }
+    if (file->pragmaOnce && included.count(path) != 0)
+    {
+        return true;
+    }
+    if (std::find(stack.begin(), stack.end(), path) != stack.end())
+    {
+        std::cerr << "[ShaderSourceCache:Expand] Recursive include of "
+                  << path << std::endl;
+        return false;
+    }
+
+    included.insert(path);
+    stack.push_back(path);
+    for (const Segment& segment : file->segments)
+    {
+        source += segment.text;
+        if (!segment.include.empty() &&
+            !Expand(segment.include, included, stack, source, dependencies))
+        {
+            return false;
+        }
+    }
+    stack.pop_back();
+    return true;
+}
+
+std::string ShaderSourceCache::MakeSourceKey(const std::string& path,
+                                             const Defines& defines)
+{
+    Defines sortedDefines = defines;
+    std::sort(sortedDefines.begin(), sortedDefines.end());
+
+    std::string key = path;
+    for (const auto& [name, value] : sortedDefines)
+    {
+        key += '\n' + name + '=' + value;
+    }
+    return key;
+}
+}  // namespace Common
@@ -0,0 +1,131 @@
+#include <Common/Macros.hpp>
+#include <Common/Skinning.hpp>
+#include <cstring>
+
+#if defined(SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(SIMD_SSE2)
+#include <xmmintrin.h>
+#endif
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+#if defined(SIMD_AVX2)
+//! Blended joint matrix, first and second column pairs in one register each
+struct BlendedMatrix
+{
+    __m256 c01, c23;
+};
+
+BlendedMatrix BlendJoints(const SkinVertex& vertex,
+                          const glm::mat4* jointMatrices)
+{
+    __m256 c01 = _mm256_setzero_ps();
+    __m256 c23 = _mm256_setzero_ps();
+    for (int k = 0; k < 4; ++k)
+    {
+        const float* joint = &jointMatrices[vertex.joints[k]][0][0];
+        const __m256 weight = _mm256_set1_ps(vertex.weights[k]);
+        c01 = _mm256_add_ps(c01,
+                            _mm256_mul_ps(weight, _mm256_loadu_ps(joint)));
+        c23 = _mm256_add_ps(c23,
+                            _mm256_mul_ps(weight, _mm256_loadu_ps(joint + 8)));
+    }
+    return { c01, c23 };
+}
+
+//! Returns c0 * v.x + c1 * v.y + c2 * v.z + c3 * w
+__m128 TransformVector(const BlendedMatrix& matrix, const glm::vec3& v,
+                       float w)
+{
+    const __m256 xy = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_set1_ps(v.x)), _mm_set1_ps(v.y), 1);
+    const __m256 zw = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_set1_ps(v.z)), _mm_set1_ps(w), 1);
+    const __m256 sum = _mm256_add_ps(_mm256_mul_ps(matrix.c01, xy),
+                                     _mm256_mul_ps(matrix.c23, zw));
+    return _mm_add_ps(_mm256_castps256_ps128(sum),
+                      _mm256_extractf128_ps(sum, 1));
+}
+#elif defined(SIMD_SSE2)
+//! Blended joint matrix, one column in each register
+struct BlendedMatrix
+{
+    __m128 c[4];
+};
+
+BlendedMatrix BlendJoints(const SkinVertex& vertex,
+                          const glm::mat4* jointMatrices)
+{
+    BlendedMatrix result{ { _mm_setzero_ps(), _mm_setzero_ps(),
+                            _mm_setzero_ps(), _mm_setzero_ps() } };
+    for (int k = 0; k < 4; ++k)
+    {
+        const glm::mat4& joint = jointMatrices[vertex.joints[k]];
+        const __m128 weight = _mm_set1_ps(vertex.weights[k]);
+        for (int c = 0; c < 4; ++c)
+        {
+            result.c[c] =
+                _mm_add_ps(result.c[c],
+                           _mm_mul_ps(weight, _mm_loadu_ps(&joint[c][0])));
+        }
+    }
+    return result;
+}
+
+//! Returns c0 * v.x + c1 * v.y + c2 * v.z + c3 * w
+__m128 TransformVector(const BlendedMatrix& matrix, const glm::vec3& v,
+                       float w)
+{
+    __m128 sum = _mm_mul_ps(matrix.c[0], _mm_set1_ps(v.x));
+    sum = _mm_add_ps(sum, _mm_mul_ps(matrix.c[1], _mm_set1_ps(v.y)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(matrix.c[2], _mm_set1_ps(v.z)));
+    return _mm_add_ps(sum, _mm_mul_ps(matrix.c[3], _mm_set1_ps(w)));
+}
+#endif
+
+#if defined(SIMD_AVX2) || defined(SIMD_SSE2)
+void StoreVector(__m128 value, glm::vec3& result)
+{
+    float components[4];
+    _mm_storeu_ps(components, value);
+    std::memcpy(&result, components, sizeof(glm::vec3));
+}
+#endif
+}  // namespace
+
+void SkinVertices(const glm::vec3* positions, const glm::vec3* normals,
+                  const SkinVertex* skinVertices,
+                  const glm::mat4* jointMatrices, size_t count,
+                  glm::vec3* skinnedPositions, glm::vec3* skinnedNormals)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const SkinVertex& vertex = skinVertices[i];
+#if defined(SIMD_AVX2) || defined(SIMD_SSE2)
+        const BlendedMatrix matrix = BlendJoints(vertex, jointMatrices);
+        StoreVector(TransformVector(matrix, positions[i], 1.0f),
+                    skinnedPositions[i]);
+        if (normals != nullptr)
+        {
+            StoreVector(TransformVector(matrix, normals[i], 0.0f),
+                        skinnedNormals[i]);
+        }
+#else
+        glm::mat4 matrix(0.0f);
+        for (int k = 0; k < 4; ++k)
+        {
+            matrix += jointMatrices[vertex.joints[k]] * vertex.weights[k];
+        }
+        skinnedPositions[i] = glm::vec3(matrix * glm::vec4(positions[i], 1.0f));
+        if (normals != nullptr)
+        {
+            skinnedNormals[i] = glm::vec3(matrix * glm::vec4(normals[i], 0.0f));
+        }
+#endif
+    }
+}
+
+}  // namespace Common
@@ -0,0 +1,723 @@
+#include <Common/HashUtils.hpp>
+#include <Common/Macros.hpp>
+#include <Common/TextureCompressor.hpp>
+#include <Common/ThreadPool.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#ifdef SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Increase whenever the encoders change, part of the cache key.
+constexpr std::uint64_t kEncoderVersion = 1;
+
+constexpr size_t kBlockDim = 4;
+constexpr size_t kBlockPixels = kBlockDim * kBlockDim;
+
+//! Interpolation weights of the 4-bit BC7 indices in 1/64 units
+constexpr std::array<int, 16> kBC7Weights = { 0,  4,  9,  13, 17, 21, 26, 30,
+                                              34, 38, 43, 47, 51, 55, 60, 64 };
+
+//! Pixels of one block in structure of arrays layout for vectorized search
+struct BlockPixels
+{
+    alignas(16) float channels[4][kBlockPixels];
+};
+
+//! Palette of the block in structure of arrays layout
+struct BlockPalette
+{
+    float colors[16][4];
+    size_t size{ 0 };
+};
+
+//! Writes bit fields into the 128-bit block from the least significant bit
+class BlockBitWriter
+{
+ public:
+    explicit BlockBitWriter(unsigned char* out) : _out(out)
+    {
+        std::memset(_out, 0, 16);
+    }
+
+    void Write(unsigned int value, unsigned int numBits)
+    {
+        for (unsigned int i = 0; i < numBits; ++i, ++_position)
+        {
+            if ((value >> i) & 1u)
+            {
+                _out[_position >> 3] |=
+                    static_cast<unsigned char>(1u << (_position & 7));
+            }
+        }
+    }
+
+ private:
+    unsigned char* _out;
+    unsigned int _position{ 0 };
+};
+
+/**
+ * @brief Find the nearest palette entry of each pixel in the block.
+ * @param block pixels of the block
+ * @param palette candidate colors
+ * @param numChannels number of channels compared, from the first channel
+ * @param indices returns index of the nearest entry for each pixel
+ * @return float sum of squared errors of the block
+ */
+float FindNearestIndices(const BlockPixels& block, const BlockPalette& palette,
+                         size_t numChannels, unsigned char* indices)
+{
+#ifdef SIMD_SSE2
+    float totalError = 0.0f;
+    for (size_t group = 0; group < kBlockPixels; group += 4)
+    {
+        __m128 pixels[4];
+        for (size_t c = 0; c < numChannels; ++c)
+        {
+            pixels[c] = _mm_load_ps(&block.channels[c][group]);
+        }
+
+        __m128 bestError = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128i bestIndex = _mm_setzero_si128();
+        for (size_t p = 0; p < palette.size; ++p)
+        {
+            __m128 error = _mm_setzero_ps();
+            for (size_t c = 0; c < numChannels; ++c)
+            {
+                const __m128 diff =
+                    _mm_sub_ps(pixels[c], _mm_set1_ps(palette.colors[p][c]));
+                error = _mm_add_ps(error, _mm_mul_ps(diff, diff));
+            }
+
+            const __m128i closer =
+                _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+            bestError = _mm_min_ps(error, bestError);
+            bestIndex = _mm_or_si128(
+                _mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(p))),
+                _mm_andnot_si128(closer, bestIndex));
+        }
+
+        alignas(16) std::int32_t groupIndices[4];
+        alignas(16) float groupErrors[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(groupIndices), bestIndex);
+        _mm_store_ps(groupErrors, bestError);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            indices[group + i] = static_cast<unsigned char>(groupIndices[i]);
+            totalError += groupErrors[i];
+        }
+    }
+    return totalError;
+#else
+    float totalError = 0.0f;
+    for (size_t i = 0; i < kBlockPixels; ++i)
+    {
+        float bestError = std::numeric_limits<float>::max();
+        for (size_t p = 0; p < palette.size; ++p)
+        {
+            float error = 0.0f;
+            for (size_t c = 0; c < numChannels; ++c)
+            {
+                const float diff = block.channels[c][i] - palette.colors[p][c];
+                error += diff * diff;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                indices[i] = static_cast<unsigned char>(p);
+            }
+        }
+        totalError += bestError;
+    }
+    return totalError;
+#endif
+}
+
+//! Principal axis of the block colors by power iteration on the covariance
+void ComputePrincipalAxis(const BlockPixels& block, size_t numChannels,
+                          float* mean, float* axis)
+{
+    float minValues[4], maxValues[4];
+    for (size_t c = 0; c < numChannels; ++c)
+    {
+        const float* values = block.channels[c];
+        mean[c] = 0.0f;
+        minValues[c] = maxValues[c] = values[0];
+        for (size_t i = 0; i < kBlockPixels; ++i)
+        {
+            mean[c] += values[i];
+            minValues[c] = std::min(minValues[c], values[i]);
+            maxValues[c] = std::max(maxValues[c], values[i]);
+        }
+        mean[c] /= static_cast<float>(kBlockPixels);
+    }
+
+    float covariance[4][4] = {};
+    for (size_t i = 0; i < kBlockPixels; ++i)
+    {
+        for (size_t a = 0; a < numChannels; ++a)
+        {
+            const float da = block.channels[a][i] - mean[a];
+            for (size_t b = a; b < numChannels; ++b)
+            {
+                covariance[a][b] += da * (block.channels[b][i] - mean[b]);
+            }
+        }
+    }
+    for (size_t a = 0; a < numChannels; ++a)
+    {
+        for (size_t b = 0; b < a; ++b)
+        {
+            covariance[a][b] = covariance[b][a];
+        }
+    }
+
+    //! Start from the bounding box diagonal, converges in few iterations
+    for (size_t c = 0; c < numChannels; ++c)
+    {
+        axis[c] = maxValues[c] - minValues[c];
+    }
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[4] = {};
+        float length = 0.0f;
+        for (size_t a = 0; a < numChannels; ++a)
+        {
+            for (size_t b = 0; b < numChannels; ++b)
+            {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length = std::max(length, std::abs(next[a]));
+        }
+        if (length <= 0.0f)
+        {
+            break;
+        }
+        for (size_t c = 0; c < numChannels; ++c)
+        {
+            axis[c] = next[c] / length;
+        }
+    }
+}
+
+//! Returns the endpoints of the block along the principal axis
+void ComputeEndpoints(const BlockPixels& block, size_t numChannels,
+                      float* endpoint0, float* endpoint1)
+{
+    float mean[4], axis[4];
+    ComputePrincipalAxis(block, numChannels, mean, axis);
+
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < kBlockPixels; ++i)
+    {
+        float projection = 0.0f;
+        for (size_t c = 0; c < numChannels; ++c)
+        {
+            projection += (block.channels[c][i] - mean[c]) * axis[c];
+        }
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    float axisLength = 0.0f;
+    for (size_t c = 0; c < numChannels; ++c)
+    {
+        axisLength += axis[c] * axis[c];
+    }
+    const float scale = axisLength > 0.0f ? 1.0f / axisLength : 0.0f;
+    for (size_t c = 0; c < numChannels; ++c)
+    {
+        endpoint0[c] = mean[c] + axis[c] * maxProjection * scale;
+        endpoint1[c] = mean[c] + axis[c] * minProjection * scale;
+    }
+}
+
+int QuantizeChannel(float value, int maxValue)
+{
+    const float normalized = std::clamp(value / 255.0f, 0.0f, 1.0f);
+    return static_cast<int>(normalized * maxValue + 0.5f);
+}
+
+std::uint16_t PackRGB565(const float* color)
+{
+    return static_cast<std::uint16_t>((QuantizeChannel(color[0], 31) << 11) |
+                                      (QuantizeChannel(color[1], 63) << 5) |
+                                      QuantizeChannel(color[2], 31));
+}
+
+void UnpackRGB565(std::uint16_t packed, float* color)
+{
+    const int r = (packed >> 11) & 31;
+    const int g = (packed >> 5) & 63;
+    const int b = packed & 31;
+    color[0] = static_cast<float>((r << 3) | (r >> 2));
+    color[1] = static_cast<float>((g << 2) | (g >> 4));
+    color[2] = static_cast<float>((b << 3) | (b >> 2));
+}
+
+//! Build four color palette of the packed endpoints, c0 > c1 is assumed
+void BuildBC1Palette(std::uint16_t color0, std::uint16_t color1,
+                     BlockPalette& palette)
+{
+    palette.size = 4;
+    UnpackRGB565(color0, palette.colors[0]);
+    UnpackRGB565(color1, palette.colors[1]);
+    for (size_t c = 0; c < 3; ++c)
+    {
+        const float c0 = palette.colors[0][c];
+        const float c1 = palette.colors[1][c];
+        palette.colors[2][c] = std::floor((2.0f * c0 + c1) / 3.0f);
+        palette.colors[3][c] = std::floor((c0 + 2.0f * c1) / 3.0f);
+    }
+}
+
+//! Encode the packed endpoints and search indices, returns the block error
+float EncodeBC1Endpoints(const BlockPixels& block, std::uint16_t color0,
+                         std::uint16_t color1, unsigned char* out)
+{
+    //! Four color mode requires color0 > color1, swapping the endpoints
+    //! just reorders the palette.
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    //! Equal endpoints would select the three color mode, keep index 0 only
+    BlockPalette palette;
+    BuildBC1Palette(color0, color1, palette);
+    if (color0 == color1)
+    {
+        palette.size = 1;
+    }
+    unsigned char indices[kBlockPixels] = {};
+    const float error = FindNearestIndices(block, palette, 3, indices);
+
+    std::uint32_t packedIndices = 0;
+    for (size_t i = 0; i < kBlockPixels; ++i)
+    {
+        packedIndices |= static_cast<std::uint32_t>(indices[i]) << (2 * i);
+    }
+    out[0] = static_cast<unsigned char>(color0 & 0xFF);
+    out[1] = static_cast<unsigned char>(color0 >> 8);
+    out[2] = static_cast<unsigned char>(color1 & 0xFF);
+    out[3] = static_cast<unsigned char>(color1 >> 8);
+    std::memcpy(out + 4, &packedIndices, sizeof(packedIndices));
+    return error;
+}
+
+//! Encode RGB of the block into 8 bytes BC1 block in four color mode
+void EncodeBC1(const BlockPixels& block, unsigned char* out)
+{
+    float endpoint0[4], endpoint1[4];
+    ComputeEndpoints(block, 3, endpoint0, endpoint1);
+
+    //! Inset the endpoints a little, extreme colors are rarely hit exactly
+    for (size_t c = 0; c < 3; ++c)
+    {
+        const float inset = (endpoint0[c] - endpoint1[c]) / 16.0f;
+        endpoint0[c] -= inset;
+        endpoint1[c] += inset;
+    }
+    float error = EncodeBC1Endpoints(block, PackRGB565(endpoint0),
+                                     PackRGB565(endpoint1), out);
+    if (error <= 0.0f)
+    {
+        return;
+    }
+
+    //! Refine the endpoints once with least squares fit of the indices
+    static constexpr float kWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f,
+                                           1.0f / 3.0f };
+    std::uint32_t packedIndices;
+    std::memcpy(&packedIndices, out + 4, sizeof(packedIndices));
+    float a = 0.0f, b = 0.0f, d = 0.0f;
+    float rhs0[3] = {}, rhs1[3] = {};
+    for (size_t i = 0; i < kBlockPixels; ++i)
+    {
+        const float w = kWeights[(packedIndices >> (2 * i)) & 3];
+        a += w * w;
+        b += w * (1.0f - w);
+        d += (1.0f - w) * (1.0f - w);
+        for (size_t c = 0; c < 3; ++c)
+        {
+            rhs0[c] += w * block.channels[c][i];
+            rhs1[c] += (1.0f - w) * block.channels[c][i];
+        }
+    }
+    const float determinant = a * d - b * b;
+    if (std::abs(determinant) < 1e-6f)
+    {
+        return;
+    }
+    for (size_t c = 0; c < 3; ++c)
+    {
+        endpoint0[c] = (d * rhs0[c] - b * rhs1[c]) / determinant;
+        endpoint1[c] = (a * rhs1[c] - b * rhs0[c]) / determinant;
+    }
+
+    unsigned char refined[8];
+    const float refinedError = EncodeBC1Endpoints(
+        block, PackRGB565(endpoint0), PackRGB565(endpoint1), refined);
+    if (refinedError < error)
+    {
+        std::memcpy(out, refined, sizeof(refined));
+    }
+}
+
+//! Encode one channel of the block into 8 bytes BC4 block in 8 value mode
+void EncodeBC4(const float* values, unsigned char* out)
+{
+    const auto [minIt, maxIt] = std::minmax_element(values, values + 16);
+    const int maxValue = static_cast<int>(*maxIt + 0.5f);
+    const int minValue = static_cast<int>(*minIt + 0.5f);
+
+    out[0] = static_cast<unsigned char>(maxValue);
+    out[1] = static_cast<unsigned char>(minValue);
+
+    std::uint64_t packedIndices = 0;
+    if (maxValue > minValue)
+    {
+        //! Index 0 and 1 are the endpoints, 2..7 interpolate from a0 to a1
+        float palette[8];
+        palette[0] = static_cast<float>(maxValue);
+        palette[1] = static_cast<float>(minValue);
+        for (int k = 1; k < 7; ++k)
+        {
+            palette[k + 1] = static_cast<float>(
+                ((7 - k) * maxValue + k * minValue) / 7);
+        }
+
+        for (size_t i = 0; i < kBlockPixels; ++i)
+        {
+            std::uint64_t bestIndex = 0;
+            float bestError = std::numeric_limits<float>::max();
+            for (std::uint64_t k = 0; k < 8; ++k)
+            {
+                const float error = std::abs(values[i] - palette[k]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = k;
+                }
+            }
+            packedIndices |= bestIndex << (3 * i);
+        }
+    }
+
+    for (size_t i = 0; i < 6; ++i)
+    {
+        out[2 + i] = static_cast<unsigned char>(packedIndices >> (8 * i));
+    }
+}
+
+//! Encode RGBA of the block into 16 bytes BC7 mode 6 block
+void EncodeBC7Mode6(const BlockPixels& block, unsigned char* out)
+{
+    float endpoint0[4], endpoint1[4];
+    ComputeEndpoints(block, 4, endpoint0, endpoint1);
+
+    //! Try all combinations of the p-bits, they select between the odd and
+    //! even 8-bit values of the 7-bit endpoints.
+    int bestQuantized[2][4] = {};
+    int bestPBits[2] = {};
+    unsigned char bestIndices[kBlockPixels] = {};
+    float bestError = std::numeric_limits<float>::max();
+    for (int pBit0 = 0; pBit0 < 2; ++pBit0)
+    {
+        for (int pBit1 = 0; pBit1 < 2; ++pBit1)
+        {
+            int quantized[2][4];
+            int unpacked[2][4];
+            for (size_t c = 0; c < 4; ++c)
+            {
+                quantized[0][c] = std::clamp(
+                    static_cast<int>((endpoint0[c] - pBit0) * 0.5f + 0.5f), 0,
+                    127);
+                quantized[1][c] = std::clamp(
+                    static_cast<int>((endpoint1[c] - pBit1) * 0.5f + 0.5f), 0,
+                    127);
+                unpacked[0][c] = (quantized[0][c] << 1) | pBit0;
+                unpacked[1][c] = (quantized[1][c] << 1) | pBit1;
+            }
+
+            BlockPalette palette;
+            palette.size = 16;
+            for (size_t k = 0; k < 16; ++k)
+            {
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    palette.colors[k][c] = static_cast<float>(
+                        ((64 - kBC7Weights[k]) * unpacked[0][c] +
+                         kBC7Weights[k] * unpacked[1][c] + 32) >>
+                        6);
+                }
+            }
+
+            unsigned char indices[kBlockPixels];
+            const float error = FindNearestIndices(block, palette, 4, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                std::memcpy(bestQuantized, quantized, sizeof(quantized));
+                bestPBits[0] = pBit0;
+                bestPBits[1] = pBit1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+    }
+
+    //! Most significant bit of the anchor index is implicitly zero
+    if (bestIndices[0] >= 8)
+    {
+        std::swap(bestQuantized[0], bestQuantized[1]);
+        std::swap(bestPBits[0], bestPBits[1]);
+        for (auto& index : bestIndices)
+        {
+            index = static_cast<unsigned char>(15 - index);
+        }
+    }
+
+    BlockBitWriter writer(out);
+    writer.Write(1u << 6, 7);  //! mode 6
+    for (size_t c = 0; c < 4; ++c)
+    {
+        writer.Write(static_cast<unsigned int>(bestQuantized[0][c]), 7);
+        writer.Write(static_cast<unsigned int>(bestQuantized[1][c]), 7);
+    }
+    writer.Write(static_cast<unsigned int>(bestPBits[0]), 1);
+    writer.Write(static_cast<unsigned int>(bestPBits[1]), 1);
+    writer.Write(bestIndices[0], 3);
+    for (size_t i = 1; i < kBlockPixels; ++i)
+    {
+        writer.Write(bestIndices[i], 4);
+    }
+}
+
+//! Gather the 4x4 block, pixels outside of the image are clamped to edge
+void LoadBlock(const unsigned char* pixels, size_t width, size_t height,
+               size_t blockX, size_t blockY, BlockPixels& block)
+{
+    for (size_t y = 0; y < kBlockDim; ++y)
+    {
+        const size_t py = std::min(blockY * kBlockDim + y, height - 1);
+        for (size_t x = 0; x < kBlockDim; ++x)
+        {
+            const size_t px = std::min(blockX * kBlockDim + x, width - 1);
+            const unsigned char* pixel = pixels + (py * width + px) * 4;
+            for (size_t c = 0; c < 4; ++c)
+            {
+                block.channels[c][y * kBlockDim + x] =
+                    static_cast<float>(pixel[c]);
+            }
+        }
+    }
+}
+
+void EncodeBlock(const BlockPixels& block, BlockFormat format,
+                 unsigned char* out)
+{
+    switch (format)
+    {
+        case BlockFormat::BC1:
+            EncodeBC1(block, out);
+            break;
+        case BlockFormat::BC3:
+            EncodeBC4(block.channels[3], out);
+            EncodeBC1(block, out + 8);
+            break;
+        case BlockFormat::BC5:
+            EncodeBC4(block.channels[0], out);
+            EncodeBC4(block.channels[1], out + 8);
+            break;
+        case BlockFormat::BC7:
+            EncodeBC7Mode6(block, out);
+            break;
+    }
+}
+
+//! Downsample the level with 2x2 box filter, normal vectors are renormalized
+void GenerateMipLevel(const unsigned char* src, size_t srcWidth,
+                      size_t srcHeight, TextureRole role, unsigned char* dst,
+                      size_t dstWidth, size_t dstHeight)
+{
+    ThreadPool::GetGlobalPool().ParallelForRange(
+        0, dstHeight,
+        [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y)
+            {
+                const size_t y0 = std::min(y * 2, srcHeight - 1);
+                const size_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+                for (size_t x = 0; x < dstWidth; ++x)
+                {
+                    const size_t x0 = std::min(x * 2, srcWidth - 1);
+                    const size_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+                    const unsigned char* samples[4] = {
+                        src + (y0 * srcWidth + x0) * 4,
+                        src + (y0 * srcWidth + x1) * 4,
+                        src + (y1 * srcWidth + x0) * 4,
+                        src + (y1 * srcWidth + x1) * 4
+                    };
+
+                    float sum[4] = {};
+                    for (const unsigned char* sample : samples)
+                    {
+                        for (size_t c = 0; c < 4; ++c)
+                        {
+                            sum[c] += sample[c];
+                        }
+                    }
+
+                    unsigned char* pixel = dst + (y * dstWidth + x) * 4;
+                    if (role == TextureRole::Normal)
+                    {
+                        float normal[3], length = 0.0f;
+                        for (size_t c = 0; c < 3; ++c)
+                        {
+                            normal[c] = sum[c] / (4.0f * 127.5f) - 1.0f;
+                            length += normal[c] * normal[c];
+                        }
+                        length = length > 0.0f ? std::sqrt(length) : 1.0f;
+                        for (size_t c = 0; c < 3; ++c)
+                        {
+                            sum[c] = (normal[c] / length + 1.0f) * 127.5f * 4.0f;
+                        }
+                    }
+                    for (size_t c = 0; c < 4; ++c)
+                    {
+                        pixel[c] = static_cast<unsigned char>(
+                            std::clamp(sum[c] * 0.25f + 0.5f, 0.0f, 255.0f));
+                    }
+                }
+            }
+        },
+        16);
+}
+}  // namespace
+
+BlockFormat TextureCompressor::ChooseFormat(TextureRole role,
+                                            const unsigned char* pixels,
+                                            size_t width, size_t height)
+{
+    switch (role)
+    {
+        case TextureRole::BaseColor:
+        {
+            const size_t numPixels = width * height;
+            for (size_t i = 0; i < numPixels; ++i)
+            {
+                if (pixels[i * 4 + 3] != 255)
+                {
+                    return BlockFormat::BC3;
+                }
+            }
+            return BlockFormat::BC7;
+        }
+        case TextureRole::Normal:
+            return BlockFormat::BC5;
+        case TextureRole::Occlusion:
+        case TextureRole::Emissive:
+            return BlockFormat::BC1;
+        case TextureRole::MetallicRoughness:
+        case TextureRole::Unknown:
+        default:
+            return BlockFormat::BC7;
+    }
+}
+
+void TextureCompressor::Compress(const unsigned char* pixels, size_t width,
+                                 size_t height, BlockFormat format,
+                                 TextureRole role, CompressedTexture& result)
+{
+    result.format = format;
+    result.width = static_cast<std::uint32_t>(width);
+    result.height = static_cast<std::uint32_t>(height);
+    result.levels.clear();
+    result.data.clear();
+
+    const size_t blockSize = GetBlockSize(format);
+    std::vector<unsigned char> level(pixels, pixels + width * height * 4);
+    std::vector<unsigned char> nextLevel;
+    while (true)
+    {
+        const size_t blocksX = (width + kBlockDim - 1) / kBlockDim;
+        const size_t blocksY = (height + kBlockDim - 1) / kBlockDim;
+
+        CompressedTexture::Level levelInfo;
+        levelInfo.width = static_cast<std::uint32_t>(width);
+        levelInfo.height = static_cast<std::uint32_t>(height);
+        levelInfo.offset = result.data.size();
+        levelInfo.size = blocksX * blocksY * blockSize;
+        result.levels.push_back(levelInfo);
+        result.data.resize(levelInfo.offset + levelInfo.size);
+
+        unsigned char* out = result.data.data() + levelInfo.offset;
+        ThreadPool::GetGlobalPool().ParallelForRange(
+            0, blocksY,
+            [&](size_t begin, size_t end) {
+                BlockPixels block;
+                for (size_t by = begin; by < end; ++by)
+                {
+                    for (size_t bx = 0; bx < blocksX; ++bx)
+                    {
+                        LoadBlock(level.data(), width, height, bx, by, block);
+                        EncodeBlock(block, format,
+                                    out + (by * blocksX + bx) * blockSize);
+                    }
+                }
+            },
+            4);
+
+        if (width == 1 && height == 1)
+        {
+            break;
+        }
+
+        const size_t nextWidth = std::max<size_t>(width / 2, 1);
+        const size_t nextHeight = std::max<size_t>(height / 2, 1);
+        nextLevel.resize(nextWidth * nextHeight * 4);
+        GenerateMipLevel(level.data(), width, height, role, nextLevel.data(),
+                         nextWidth, nextHeight);
+        level.swap(nextLevel);
+        width = nextWidth;
+        height = nextHeight;
+    }
+}
+
+size_t TextureCompressor::GetBlockSize(BlockFormat format)
+{
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+std::string TextureCompressor::GetCachePath(const std::string& directory,
+                                            const unsigned char* pixels,
+                                            size_t width, size_t height,
+                                            TextureRole role)
+{
+    const std::uint64_t hash =
+        HashUtils::HashBytes(pixels, width * height * 4, kEncoderVersion);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%zux%zu-%u.ktx2",
+                  static_cast<unsigned long long>(hash), width, height,
+                  static_cast<unsigned int>(role));
+
+    std::string path = directory;
+    if (!path.empty() && path.back() != '/' && path.back() != '\\')
+    {
+        path.push_back('/');
+    }
+    return path + name;
+}
+
+}  // namespace Common
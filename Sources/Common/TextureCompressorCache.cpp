@@ -0,0 +1,240 @@
+#include <Common/MappedFile.hpp>
+#include <Common/TextureCompressor.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace Common
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+constexpr unsigned char kKTX2Identifier[12] = { 0xAB, 'K',  'T',  'X',
+                                                ' ',  '2',  '0',  0xBB,
+                                                '\r', '\n', 0x1A, '\n' };
+
+//! Level data alignment, multiple of both block sizes and 4 bytes
+constexpr std::uint64_t kLevelAlignment = 16;
+
+//! VkFormat values of the block formats
+constexpr std::uint32_t kVkFormatBC1RGBUnorm = 131;
+constexpr std::uint32_t kVkFormatBC3Unorm = 137;
+constexpr std::uint32_t kVkFormatBC5Unorm = 141;
+constexpr std::uint32_t kVkFormatBC7Unorm = 145;
+
+//! Header and index of the KTX2 container. Data format descriptor and
+//! key/value data are omitted, the files are only read back by LoadKTX2.
+struct KTX2Header
+{
+    unsigned char identifier[12];
+    std::uint32_t vkFormat;
+    std::uint32_t typeSize;
+    std::uint32_t pixelWidth;
+    std::uint32_t pixelHeight;
+    std::uint32_t pixelDepth;
+    std::uint32_t layerCount;
+    std::uint32_t faceCount;
+    std::uint32_t levelCount;
+    std::uint32_t supercompressionScheme;
+    std::uint32_t dfdByteOffset;
+    std::uint32_t dfdByteLength;
+    std::uint32_t kvdByteOffset;
+    std::uint32_t kvdByteLength;
+    std::uint64_t sgdByteOffset;
+    std::uint64_t sgdByteLength;
+};
+static_assert(sizeof(KTX2Header) == 80, "KTX2 header must be 80 bytes");
+
+struct KTX2LevelIndex
+{
+    std::uint64_t byteOffset;
+    std::uint64_t byteLength;
+    std::uint64_t uncompressedByteLength;
+};
+
+std::uint32_t ToVkFormat(BlockFormat format)
+{
+    switch (format)
+    {
+        case BlockFormat::BC1:
+            return kVkFormatBC1RGBUnorm;
+        case BlockFormat::BC3:
+            return kVkFormatBC3Unorm;
+        case BlockFormat::BC5:
+            return kVkFormatBC5Unorm;
+        case BlockFormat::BC7:
+        default:
+            return kVkFormatBC7Unorm;
+    }
+}
+
+bool FromVkFormat(std::uint32_t vkFormat, BlockFormat& format)
+{
+    switch (vkFormat)
+    {
+        case kVkFormatBC1RGBUnorm:
+            format = BlockFormat::BC1;
+            return true;
+        case kVkFormatBC3Unorm:
+            format = BlockFormat::BC3;
+            return true;
+        case kVkFormatBC5Unorm:
+            format = BlockFormat::BC5;
+            return true;
+        case kVkFormatBC7Unorm:
+            format = BlockFormat::BC7;
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::uint64_t AlignOffset(std::uint64_t offset)
+{
+    return (offset + kLevelAlignment - 1) & ~(kLevelAlignment - 1);
+}
+}  // namespace
+
+bool TextureCompressor::SaveKTX2(const std::string& path,
+                                 const CompressedTexture& texture)
+{
+    KTX2Header header{};
+    std::memcpy(header.identifier, kKTX2Identifier, sizeof(kKTX2Identifier));
+    header.vkFormat = ToVkFormat(texture.format);
+    header.typeSize = 1;
+    header.pixelWidth = texture.width;
+    header.pixelHeight = texture.height;
+    header.faceCount = 1;
+    header.levelCount = static_cast<std::uint32_t>(texture.levels.size());
+
+    //! Level index lists the base level first while the data is laid out
+    //! from the smallest level as the specification requires.
+    std::vector<KTX2LevelIndex> levelIndices(texture.levels.size());
+    std::uint64_t offset =
+        sizeof(KTX2Header) + levelIndices.size() * sizeof(KTX2LevelIndex);
+    for (size_t i = texture.levels.size(); i-- > 0;)
+    {
+        offset = AlignOffset(offset);
+        levelIndices[i].byteOffset = offset;
+        levelIndices[i].byteLength = texture.levels[i].size;
+        levelIndices[i].uncompressedByteLength = texture.levels[i].size;
+        offset += texture.levels[i].size;
+    }
+
+    const std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(levelIndices.data()),
+               levelIndices.size() * sizeof(KTX2LevelIndex));
+
+    const char padding[kLevelAlignment] = {};
+    std::uint64_t written =
+        sizeof(KTX2Header) + levelIndices.size() * sizeof(KTX2LevelIndex);
+    for (size_t i = texture.levels.size(); i-- > 0;)
+    {
+        file.write(padding, static_cast<std::streamsize>(
+                                levelIndices[i].byteOffset - written));
+        file.write(reinterpret_cast<const char*>(texture.data.data() +
+                                                 texture.levels[i].offset),
+                   static_cast<std::streamsize>(texture.levels[i].size));
+        written = levelIndices[i].byteOffset + texture.levels[i].size;
+    }
+
+    const bool success = file.good();
+    file.close();
+    if (!success)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::remove(path.c_str());
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+bool TextureCompressor::LoadKTX2(const std::string& path,
+                                 CompressedTexture& texture)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        return false;
+    }
+
+    const char* data = file.GetData();
+    const size_t size = file.GetSize();
+    KTX2Header header;
+    if (size < sizeof(KTX2Header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    BlockFormat format;
+    if (std::memcmp(header.identifier, kKTX2Identifier,
+                    sizeof(kKTX2Identifier)) != 0 ||
+        !FromVkFormat(header.vkFormat, format) || header.pixelWidth == 0 ||
+        header.pixelHeight == 0 || header.pixelDepth != 0 ||
+        header.layerCount != 0 || header.faceCount != 1 ||
+        header.levelCount == 0 || header.levelCount > 32 ||
+        header.supercompressionScheme != 0)
+    {
+        std::cerr << "[TextureCompressor:LoadKTX2] Unsupported file " << path
+                  << std::endl;
+        return false;
+    }
+
+    const std::uint64_t indexEnd =
+        sizeof(KTX2Header) + header.levelCount * sizeof(KTX2LevelIndex);
+    if (size < indexEnd)
+    {
+        return false;
+    }
+    std::vector<KTX2LevelIndex> levelIndices(header.levelCount);
+    std::memcpy(levelIndices.data(), data + sizeof(KTX2Header),
+                levelIndices.size() * sizeof(KTX2LevelIndex));
+
+    texture.format = format;
+    texture.width = header.pixelWidth;
+    texture.height = header.pixelHeight;
+    texture.levels.resize(header.levelCount);
+
+    const size_t blockSize = GetBlockSize(format);
+    std::uint64_t totalSize = 0;
+    for (std::uint32_t i = 0; i < header.levelCount; ++i)
+    {
+        CompressedTexture::Level& level = texture.levels[i];
+        level.width = std::max(header.pixelWidth >> i, 1u);
+        level.height = std::max(header.pixelHeight >> i, 1u);
+        level.offset = totalSize;
+        level.size = static_cast<std::uint64_t>((level.width + 3) / 4) *
+                     ((level.height + 3) / 4) * blockSize;
+
+        const KTX2LevelIndex& index = levelIndices[i];
+        if (index.byteLength != level.size || index.byteOffset < indexEnd ||
+            index.byteOffset > size || size - index.byteOffset < level.size)
+        {
+            std::cerr << "[TextureCompressor:LoadKTX2] Corrupted level " << i
+                      << " in " << path << std::endl;
+            return false;
+        }
+        totalSize += level.size;
+    }
+
+    texture.data.resize(totalSize);
+    for (std::uint32_t i = 0; i < header.levelCount; ++i)
+    {
+        std::memcpy(texture.data.data() + texture.levels[i].offset,
+                    data + levelIndices[i].byteOffset, texture.levels[i].size);
+    }
+    return true;
+}
+
+}  // namespace Common
@@ -0,0 +1,83 @@
+#include <Common/ThreadPool.hpp>
+
+namespace Common
+{
+ThreadPool::ThreadPool(size_t numThreads)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    _workers.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        _workers.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::GetNumThreads() const
+{
+    return _workers.size();
+}
+
+ThreadPool& ThreadPool::GetGlobalPool()
+{
+    static ThreadPool kGlobalPool;
+    return kGlobalPool;
+}
+
+bool ThreadPool::RunPendingTask()
+{
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(_tasks.front());
+        _tasks.pop_front();
+    }
+
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+
+            //! Drain the remained tasks before exiting
+            if (_stop && _tasks.empty())
+            {
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+}  // namespace Common
@@ -12,6 +12,7 @@ Camera::Camera()
       _position(0.0f),
       _direction(0.0f, -1.0f, 0.0f),
       _up(0.0f, 1.0f, 0.0f),
+      _frustum(Common::ExtractFrustum(glm::mat4(1.0f))),
       _speed(0.03f),
       _uniformBuffer(0)
 {
@@ -63,6 +64,11 @@ void Camera::UnbindCamera()
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
+const Common::Frustum& Camera::GetFrustum() const
+{
+    return _frustum;
+}
+
 GLuint Camera::GetUniformBuffer() const
 {
     return _uniformBuffer;
@@ -74,6 +80,7 @@ void Camera::UpdateMatrix()
                               this->_position + this->_direction, this->_up);
 
     OnUpdateMatrix();
+    _frustum = Common::ExtractFrustum(_projection * _view);
 
     if (_uniformBuffer)
     {
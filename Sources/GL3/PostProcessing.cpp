@@ -38,13 +38,18 @@ bool PostProcessing::Initialize()
 
     glCreateVertexArrays(1, &_vao);
     _shader = std::make_unique<GL3::Shader>();
-    if (!_shader->Initialize(
-            { { GL_VERTEX_SHADER, RESOURCES_DIR "/shaders/quad.glsl" },
-              { GL_FRAGMENT_SHADER,
-                RESOURCES_DIR "/shaders/postprocessing.glsl" } }))
+    return _shader->InitializeAsync(
+        { { GL_VERTEX_SHADER, RESOURCES_DIR "/shaders/quad.glsl" },
+          { GL_FRAGMENT_SHADER,
+            RESOURCES_DIR "/shaders/postprocessing.glsl" } });
+}
+
+bool PostProcessing::WaitShader()
+{
+    if (!_shader->Wait())
     {
         DebugUtils::PrintStack();
-        std::cerr << "[PostProcessing:Initialize] Failed to create "
+        std::cerr << "[PostProcessing:WaitShader] Failed to create "
                      "postprocessing shader"
                   << std::endl;
         return false;
@@ -50,8 +50,13 @@ bool Renderer::Initialize(const cxxopts::ParseResult& configure)
     }
     _postProcessing->Resize(_mainWindow->GetWindowExtent());
 
-    //! Initialize implementation parts
-    return OnInitialize(configure);
+    //! Initialize implementation parts while the postprocessing shader is
+    //! being compiled
+    if (!OnInitialize(configure))
+    {
+        return false;
+    }
+    return _postProcessing->WaitShader();
 }
 
 bool Renderer::AddApplication(const std::shared_ptr<Application>& app,
@@ -1,44 +1,174 @@
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <Common/GLTFMaterial.hpp>
 #include <Common/Macros.hpp>
+#include <Common/MathUtils.hpp>
 #include <GL3/Scene.hpp>
+#include <Common/TextureCompressor.hpp>
+#include <Common/ThreadPool.hpp>
 #include <GL3/Shader.hpp>
+#include <GL3/TextureUploader.hpp>
 #include <algorithm>
 #include <bitset>
 #include <chrono>
+#include <iterator>
+#include <glm/gtc/packing.hpp>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <tuple>
 
 using namespace glm;
 #include <gltf.glsl>
 
 namespace GL3
 {
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Vertex attribute locations declared in vertex.glsl
+constexpr GLuint kPositionLocation = 0;
+constexpr GLuint kNormalLocation = 1;
+constexpr GLuint kColorLocation = 2;
+constexpr GLuint kTexCoordLocation = 3;
+constexpr GLuint kTangentLocation = 4;
+
+//! Segment of the texture upload ring fits one 2048x2048 RGBA8 image
+constexpr size_t kTextureUploadSegmentSize = 2048 * 2048 * 4;
+
+//! Number of matrix buffer regions in flight, one is written by CPU while
+//! the others may still be read by the queued frames
+constexpr size_t kNumMatrixRegions = 3;
+
+//! First texture unit of the texture arrays declared in output.glsl, one
+//! unit per texture reference of GltfShadeMaterial
+constexpr GLuint kTextureArrayUnit = 3;
+constexpr size_t kNumMaterialTextures = 7;
+
+//! Local work group size declared in morph_targets.comp
+constexpr GLuint kMorphGroupSize = 64;
+
+//! Local work group size declared in skin_vertices.comp
+constexpr GLuint kSkinGroupSize = 64;
+
+//! Local work group size declared in cull_instances.comp, build_draws.comp
+//! and scatter_instances.comp
+constexpr GLuint kCullGroupSize = 64;
+
+//! Local work group size declared in depth_pyramid.comp
+constexpr GLuint kDepthPyramidGroupSize = 8;
+
+//! Texture unit of the depth samplers of the culling shaders, above the units
+//! of the scene textures
+constexpr GLuint kDepthPyramidTextureUnit = 31;
+
+//! OPAQUE, MASK and BLEND
+constexpr GLenum kNumAlphaModes = 3;
+
+//! Values of skinMode of the per-draw data in vertex.glsl
+constexpr int kSkinModeNone = 0;
+constexpr int kSkinModeVertexShader = 1;
+constexpr int kSkinModeSkinned = 2;
+
+//! S3TC formats are exposed only through the extension
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+//! Returns the internal format of the block format, 0 if not supported
+GLenum GetCompressedFormat(Common::BlockFormat format)
+{
+    static const bool s3tcSupported =
+        glfwExtensionSupported("GL_EXT_texture_compression_s3tc") ==
+        GLFW_TRUE;
+
+    switch (format)
+    {
+        case Common::BlockFormat::BC1:
+            return s3tcSupported ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+        case Common::BlockFormat::BC3:
+            return s3tcSupported ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+        case Common::BlockFormat::BC5:
+            return GL_COMPRESSED_RG_RGTC2;
+        case Common::BlockFormat::BC7:
+            return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default:
+            return 0;
+    }
+}
+
+//! Returns the number of levels of the full mipmap chain
+GLsizei GetNumMipLevels(GLsizei width, GLsizei height)
+{
+    GLsizei levels = 1;
+    for (GLsizei size = std::max(width, height); size > 1; size >>= 1)
+    {
+        ++levels;
+    }
+    return levels;
+}
+}  // namespace
+
 bool Scene::Initialize(const std::string& filename, Common::VertexFormat format)
 {
     auto timerStart = std::chrono::high_resolution_clock::now();
 
+    //! Images are decoded on the worker threads and handed over in order,
+    //! stream them through the pixel buffer ring.
+    TextureUploader uploader;
+    uploader.Initialize(kTextureUploadSegmentSize);
+
     auto imageCallback = [&](const tinygltf::Image& image) {
         std::string name = image.name.empty()
                                ? std::string("texture") +
                                      std::to_string(this->_textures.size())
                                : image.name;
-        GLuint texture;
-        glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+        const bool hasPixels = !image.image.empty() && image.width > 0 &&
+                               image.height > 0;
+        const GLsizei width = hasPixels ? image.width : 1;
+        const GLsizei height = hasPixels ? image.height : 1;
+        const bool is16Bit = image.bits == 16;
+
+        //! Texture index of the materials equals to the image index, the
+        //! compressed texture already contains all mipmap levels.
+        GLuint texture = 0;
+        if (_compressTextures && hasPixels && !is16Bit && image.component == 4)
+        {
+            texture = CreateCompressedTexture(
+                image,
+                GetTextureRole(static_cast<int>(this->_textures.size())));
+        }
+
+        if (texture == 0)
+        {
+            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+            glTextureStorage2D(texture, GetNumMipLevels(width, height),
+                               is16Bit ? GL_RGBA16 : GL_RGBA8, width, height);
+            if (hasPixels)
+            {
+                uploader.Upload(texture, width, height, GL_RGBA,
+                                is16Bit ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE,
+                                image.image.data(), image.image.size());
+                glGenerateTextureMipmap(texture);
+            }
+        }
         glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER,
                             GL_LINEAR_MIPMAP_LINEAR);
         glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTextureStorage2D(texture, 1, GL_RGBA8, image.width, image.height);
-        glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height,
-                            GL_RGBA, GL_UNSIGNED_BYTE, &image.image[0]);
-        glGenerateTextureMipmap(texture);
         DebugUtils::SetObjectName(GL_TEXTURE, texture, name);
         _textures.emplace_back(texture);
     };
-    
+
+
     if (!Common::GLTFScene::Initialize(filename, format, imageCallback))
     {
         return false;
     }
+    uploader.CleanUp();
 
     auto timerEnd = std::chrono::high_resolution_clock::now();
     auto elapsed =
@@ -63,21 +193,21 @@ bool Scene::Initialize(const std::string& filename, Common::VertexFormat format)
     DebugUtils::SetObjectName(GL_VERTEX_ARRAY, _vao, "Scene Vertex Array Object");
     glCreateBuffers(static_cast<GLsizei>(_buffers.size()), _buffers.data());
 
-    //! Temporary buffer binding lambda function
-    auto bindingBuffer = [&](void* data, size_t num,
-                             Common::VertexFormat attribute) {
+    //! Temporary buffer binding lambda function. Attribute location and
+    //! binding index follow the input locations of vertex.glsl
+    auto bindingBuffer = [&](const void* data, size_t num, GLsizei stride,
+                             Common::VertexFormat attribute, GLuint location,
+                             GLint size, GLenum type, GLboolean normalized) {
         if (static_cast<bool>(format & attribute))
         {
-            const auto numFloats = static_cast<GLsizei>(
-                Common::VertexHelper::GetNumberOfFloats(attribute));
-            const GLsizei stride = numFloats * sizeof(float);
             glNamedBufferStorage(_buffers[index], num * stride, data,
                                  GL_MAP_READ_BIT);
-            glVertexArrayVertexBuffer(_vao, index, _buffers[index], 0, stride);
-            glEnableVertexArrayAttrib(_vao, index);
-            glVertexArrayAttribFormat(_vao, index, numFloats, GL_FLOAT,
-                                      GL_FALSE, 0);
-            glVertexArrayAttribBinding(_vao, index, index);
+            glVertexArrayVertexBuffer(_vao, location, _buffers[index], 0,
+                                      stride);
+            glEnableVertexArrayAttrib(_vao, location);
+            glVertexArrayAttribFormat(_vao, location, size, type, normalized,
+                                      0);
+            glVertexArrayAttribBinding(_vao, location, location);
             DebugUtils::SetObjectName(GL_BUFFER, _buffers[index],
                                  "Scene Buffer #" + std::to_string(index));
             ++index;
@@ -85,15 +215,45 @@ bool Scene::Initialize(const std::string& filename, Common::VertexFormat format)
     };
 
     //! Create & Bind the vertex buffers
-    bindingBuffer(_positions.data(), _positions.size(),
-                  Common::VertexFormat::Position3);
-    bindingBuffer(_normals.data(), _normals.size(),
-                  Common::VertexFormat::Normal3);
-    bindingBuffer(_tangents.data(), _tangents.size(),
-                  Common::VertexFormat::Tangent4);
-    bindingBuffer(_colors.data(), _colors.size(), Common::VertexFormat::Color4);
-    bindingBuffer(_texCoords.data(), _texCoords.size(),
-                  Common::VertexFormat::TexCoord2);
+    if (_quantizeVertices)
+    {
+        QuantizedVertices quantized;
+        QuantizeVertices(quantized);
+
+        bindingBuffer(quantized.positions.data(), quantized.positions.size(),
+                      sizeof(std::uint64_t), Common::VertexFormat::Position3,
+                      kPositionLocation, 4, GL_SHORT, GL_TRUE);
+        bindingBuffer(quantized.normals.data(), quantized.normals.size(),
+                      sizeof(std::uint32_t), Common::VertexFormat::Normal3,
+                      kNormalLocation, 4, GL_INT_2_10_10_10_REV, GL_TRUE);
+        bindingBuffer(quantized.tangents.data(), quantized.tangents.size(),
+                      sizeof(std::uint32_t), Common::VertexFormat::Tangent4,
+                      kTangentLocation, 4, GL_INT_2_10_10_10_REV, GL_TRUE);
+        bindingBuffer(quantized.colors.data(), quantized.colors.size(),
+                      sizeof(std::uint32_t), Common::VertexFormat::Color4,
+                      kColorLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE);
+        bindingBuffer(quantized.texCoords.data(), quantized.texCoords.size(),
+                      sizeof(std::uint32_t), Common::VertexFormat::TexCoord2,
+                      kTexCoordLocation, 2, GL_HALF_FLOAT, GL_FALSE);
+    }
+    else
+    {
+        bindingBuffer(_positions.data(), _positions.size(), sizeof(glm::vec3),
+                      Common::VertexFormat::Position3, kPositionLocation, 3,
+                      GL_FLOAT, GL_FALSE);
+        bindingBuffer(_normals.data(), _normals.size(), sizeof(glm::vec3),
+                      Common::VertexFormat::Normal3, kNormalLocation, 3,
+                      GL_FLOAT, GL_FALSE);
+        bindingBuffer(_tangents.data(), _tangents.size(), sizeof(glm::vec4),
+                      Common::VertexFormat::Tangent4, kTangentLocation, 4,
+                      GL_FLOAT, GL_FALSE);
+        bindingBuffer(_colors.data(), _colors.size(), sizeof(glm::vec4),
+                      Common::VertexFormat::Color4, kColorLocation, 4,
+                      GL_FLOAT, GL_FALSE);
+        bindingBuffer(_texCoords.data(), _texCoords.size(), sizeof(glm::vec2),
+                      Common::VertexFormat::TexCoord2, kTexCoordLocation, 2,
+                      GL_FLOAT, GL_FALSE);
+    }
 
     //! Create buffers for indices
     glCreateBuffers(1, &_ebo);
@@ -102,22 +262,107 @@ bool Scene::Initialize(const std::string& filename, Common::VertexFormat format)
     glVertexArrayElementBuffer(_vao, _ebo);
     DebugUtils::SetObjectName(GL_BUFFER, _ebo, "Scene Element Buffer");
 
-    //! Create shader storage buffer object for matrices of scene nodes
-    const size_t numMatrices = std::count_if(
-        _sceneNodes.begin(), _sceneNodes.end(),
-        [](const GLTFNode& node) { return !node.primMeshes.empty(); });
-    glGenBuffers(1, &_matrixBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _matrixBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, numMatrices * sizeof(NodeMatrix),
-                 nullptr, GL_STATIC_COPY);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _matrixBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-    DebugUtils::SetObjectName(GL_BUFFER, _matrixBuffer, "Scene Instance Buffer");
+    //! Matrices are stored only for the nodes with primitives, one for each
+    //! instance transform of EXT_mesh_gpu_instancing
+    std::vector<glm::mat4> worlds;
+    _nodeMatrixIndices.assign(_sceneNodes.Size(), -1);
+    for (size_t node = 0; node < _sceneNodes.Size(); ++node)
+    {
+        if (_sceneNodes.primMeshOffsets[node] !=
+            _sceneNodes.primMeshOffsets[node + 1])
+        {
+            _nodeMatrixIndices[node] = static_cast<int>(worlds.size());
+            const unsigned int instanceBegin =
+                _sceneNodes.instanceOffsets[node];
+            const unsigned int instanceEnd =
+                _sceneNodes.instanceOffsets[node + 1];
+            if (instanceBegin == instanceEnd)
+            {
+                worlds.push_back(_sceneNodes.worlds[node]);
+            }
+            for (unsigned int i = instanceBegin; i < instanceEnd; ++i)
+            {
+                worlds.push_back(_sceneNodes.worlds[node] *
+                                 _sceneNodes.instances[i]);
+            }
+        }
+    }
+    std::vector<glm::mat4> normalMatrices(worlds.size());
+    Common::ComputeNormalMatrices(worlds.data(), worlds.size(),
+                                  normalMatrices.data());
+    _nodeMatrices.resize(worlds.size());
+    for (size_t i = 0; i < worlds.size(); ++i)
+    {
+        _nodeMatrices[i] = NodeMatrix(worlds[i], normalMatrices[i]);
+    }
+
+    //! Bounding boxes of the nodes merge their primitives
+    _nodeBounds.assign(_sceneNodes.Size(),
+                       { glm::vec3(0.0f), glm::vec3(0.0f) });
+    _instanceBounds.Resize(worlds.size());
+    for (size_t node = 0; node < _sceneNodes.Size(); ++node)
+    {
+        if (_nodeMatrixIndices[node] == -1)
+        {
+            continue;
+        }
+        auto& bounds = _nodeBounds[node];
+        bounds.first = glm::vec3(std::numeric_limits<float>::max());
+        bounds.second = glm::vec3(std::numeric_limits<float>::lowest());
+        for (unsigned int i = _sceneNodes.primMeshOffsets[node];
+             i < _sceneNodes.primMeshOffsets[node + 1]; ++i)
+        {
+            const auto& primMesh = _scenePrimMeshes[_sceneNodes.primMeshes[i]];
+            bounds.first = glm::min(bounds.first, primMesh.min);
+            bounds.second = glm::max(bounds.second, primMesh.max);
+        }
+        UpdateInstanceBounds(node);
+    }
 
-    //! Initialize matrix buffer contents
-    UpdateMatrixBuffer();
+    //! Create persistently mapped shader storage buffer object for matrices
+    //! of scene nodes, each region holds the whole matrix array
+    GLint alignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    const size_t matricesSize =
+        std::max<size_t>(worlds.size(), 1) * sizeof(NodeMatrix);
+    _matrixRegionSize = (matricesSize + alignment - 1) / alignment * alignment;
+    const GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &_matrixBuffer);
+    glNamedBufferStorage(
+        _matrixBuffer,
+        static_cast<GLsizeiptr>(_matrixRegionSize * kNumMatrixRegions),
+        nullptr, flags);
+    _mappedMatrices = static_cast<unsigned char*>(glMapNamedBufferRange(
+        _matrixBuffer, 0,
+        static_cast<GLsizeiptr>(_matrixRegionSize * kNumMatrixRegions),
+        flags));
+    if (_mappedMatrices == nullptr)
+    {
+        std::cerr << "[Scene:Initialize] Failed to map matrix buffer"
+                  << std::endl;
+        return false;
+    }
+    for (size_t region = 0; region < kNumMatrixRegions; ++region)
+    {
+        std::copy(_nodeMatrices.begin(), _nodeMatrices.end(),
+                  reinterpret_cast<NodeMatrix*>(_mappedMatrices +
+                                                region * _matrixRegionSize));
+    }
+    _matrixFences.assign(kNumMatrixRegions, nullptr);
+    _modifiedMatrices.assign(kNumMatrixRegions, {});
+    _currentMatrixRegion = 0;
+    DebugUtils::SetObjectName(GL_BUFFER, _matrixBuffer, "Scene Instance Buffer");
 
     //! Create shader storage buffer object for materials and fill it
+    std::vector<glm::uvec2> textureRefs;
+    CreateTextureReferences(textureRefs);
+    auto textureRef = [&textureRefs](int texture) {
+        return texture >= 0 && static_cast<size_t>(texture) < textureRefs.size()
+                   ? textureRefs[texture]
+                   : glm::uvec2(0);
+    };
+
     std::vector<GltfShadeMaterial> materials;
     materials.reserve(_sceneMaterials.size());
     for (const auto& material : _sceneMaterials)
@@ -143,7 +388,15 @@ bool Scene::Initialize(const std::string& filename, Common::VertexFormat format)
               material.occlusionTexture,
               material.occlusionTextureStrength,
               material.shadingModel,
-              0, 0 /* for padding */ });
+              0, 0 /* for padding */,
+              textureRef(material.baseColorTexture),
+              textureRef(material.metallicRoughnessTexture),
+              textureRef(material.specularGlossiness.diffuseTexture),
+              textureRef(material.specularGlossiness.specularGlossinessTexture),
+              textureRef(material.emissiveTexture),
+              textureRef(material.normalTexture),
+              textureRef(material.occlusionTexture),
+              glm::uvec2(0) /* for padding */ });
     }
     glGenBuffers(1, &_materialBuffer);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _materialBuffer);
@@ -154,12 +407,460 @@ bool Scene::Initialize(const std::string& filename, Common::VertexFormat format)
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
     DebugUtils::SetObjectName(GL_BUFFER, _materialBuffer, "Scene Material Buffer");
 
+    //! Each primitive instance of the morphed nodes gets its own range of
+    //! blended deltas, added to the vertices in vertex.glsl
+    _morphInstanceIndices.assign(_sceneNodes.primMeshes.size(), -1);
+    unsigned int numMorphVertices = 0;
+    for (size_t node = 0; node < _sceneNodes.Size(); ++node)
+    {
+        if (_sceneNodes.weightOffsets[node] ==
+            _sceneNodes.weightOffsets[node + 1])
+        {
+            continue;
+        }
+        for (unsigned int i = _sceneNodes.primMeshOffsets[node];
+             i < _sceneNodes.primMeshOffsets[node + 1]; ++i)
+        {
+            const unsigned int meshIdx = _sceneNodes.primMeshes[i];
+            const auto& primMesh = _scenePrimMeshes[meshIdx];
+            if (primMesh.morphTargetCount > 0)
+            {
+                _morphInstanceIndices[i] =
+                    static_cast<int>(_morphInstances.size());
+                _morphInstances.push_back({ static_cast<unsigned int>(node),
+                                            meshIdx, numMorphVertices });
+                numMorphVertices += primMesh.vertexCount;
+            }
+        }
+    }
+
+    if (!_morphInstances.empty())
+    {
+        _morphShader = std::make_shared<Shader>();
+        if (!_morphShader->Initialize(
+                { { GL_COMPUTE_SHADER,
+                    RESOURCES_DIR "/shaders/morph_targets.comp" } }))
+        {
+            std::cerr << "[Scene:Initialize] Failed to compile morph target "
+                         "shader"
+                      << std::endl;
+            return false;
+        }
+
+        //! Targets may have no delta at all, empty storage is invalid
+        const size_t deltaSize = _morphDeltas.size() * sizeof(GLTFMorphDelta);
+        glCreateBuffers(1, &_morphDeltaBuffer);
+        glNamedBufferStorage(_morphDeltaBuffer,
+                             std::max(deltaSize, sizeof(GLuint)),
+                             deltaSize > 0 ? _morphDeltas.data() : nullptr, 0);
+        DebugUtils::SetObjectName(GL_BUFFER, _morphDeltaBuffer,
+                                  "Scene Morph Delta Buffer");
+
+        glCreateBuffers(1, &_morphVertexBuffer);
+        glNamedBufferStorage(_morphVertexBuffer,
+                             numMorphVertices * sizeof(MorphVertex), nullptr,
+                             0);
+        DebugUtils::SetObjectName(GL_BUFFER, _morphVertexBuffer,
+                                  "Scene Morph Vertex Buffer");
+
+        std::vector<unsigned int> morphNodes;
+        for (const auto& instance : _morphInstances)
+        {
+            if (morphNodes.empty() || morphNodes.back() != instance.node)
+            {
+                morphNodes.push_back(instance.node);
+            }
+        }
+        UpdateMorphTargets(morphNodes);
+    }
+
+    //! Skinned primitives of the skinned nodes, each node gets its own range
+    //! of the joint matrix palette
+    _skinInstanceIndices.assign(_sceneNodes.primMeshes.size(), -1);
+    std::vector<int> restOffsets(_scenePrimMeshes.size(), -1);
+    std::vector<SkinRestVertex> restVertices;
+    std::vector<unsigned int> skinNodes;
+    unsigned int numJoints = 0, numSkinnedVertices = 0;
+    for (size_t node = 0; node < _sceneNodes.Size(); ++node)
+    {
+        const int skin = _sceneNodes.skins[node];
+        if (skin == -1)
+        {
+            continue;
+        }
+
+        const size_t numInstances = _skinInstances.size();
+        for (unsigned int i = _sceneNodes.primMeshOffsets[node];
+             i < _sceneNodes.primMeshOffsets[node + 1]; ++i)
+        {
+            const unsigned int meshIdx = _sceneNodes.primMeshes[i];
+            const auto& primMesh = _scenePrimMeshes[meshIdx];
+            if (!primMesh.skinned)
+            {
+                continue;
+            }
+
+            if (restOffsets[meshIdx] == -1)
+            {
+                restOffsets[meshIdx] = static_cast<int>(restVertices.size());
+                for (unsigned int v = primMesh.vertexOffset;
+                     v < primMesh.vertexOffset + primMesh.vertexCount; ++v)
+                {
+                    restVertices.push_back(
+                        { glm::vec4(_positions[v], 1.0f),
+                          glm::vec4(_normals.empty() ? glm::vec3(0.0f)
+                                                     : _normals[v],
+                                    0.0f),
+                          _skinVertices[v].joints, _skinVertices[v].weights });
+                }
+            }
+
+            const int morphIdx = _morphInstanceIndices[i];
+            _skinInstanceIndices[i] = static_cast<int>(_skinInstances.size());
+            _skinInstances.push_back(
+                { static_cast<unsigned int>(node), meshIdx,
+                  static_cast<unsigned int>(restOffsets[meshIdx]),
+                  numSkinnedVertices, numJoints,
+                  morphIdx != -1
+                      ? static_cast<int>(_morphInstances[morphIdx].vertexBegin)
+                      : -1 });
+            numSkinnedVertices += primMesh.vertexCount;
+        }
+
+        if (_skinInstances.size() != numInstances)
+        {
+            skinNodes.push_back(static_cast<unsigned int>(node));
+            numJoints += _sceneSkins[skin].jointCount;
+        }
+    }
+
+    if (!_skinInstances.empty())
+    {
+        glCreateBuffers(1, &_skinVertexBuffer);
+        glNamedBufferStorage(_skinVertexBuffer,
+                             restVertices.size() * sizeof(SkinRestVertex),
+                             restVertices.data(), 0);
+        DebugUtils::SetObjectName(GL_BUFFER, _skinVertexBuffer,
+                                  "Scene Skin Vertex Buffer");
+
+        glCreateBuffers(1, &_jointMatrixBuffer);
+        glNamedBufferStorage(_jointMatrixBuffer,
+                             std::max(numJoints, 1u) * sizeof(glm::mat4),
+                             nullptr, GL_DYNAMIC_STORAGE_BIT);
+        DebugUtils::SetObjectName(GL_BUFFER, _jointMatrixBuffer,
+                                  "Scene Joint Matrix Buffer");
+
+        if (_skinningMode == SkinningMode::Compute)
+        {
+            _skinShader = std::make_shared<Shader>();
+            if (!_skinShader->Initialize(
+                    { { GL_COMPUTE_SHADER,
+                        RESOURCES_DIR "/shaders/skin_vertices.comp" } }))
+            {
+                std::cerr << "[Scene:Initialize] Failed to compile skinning "
+                             "shader"
+                          << std::endl;
+                return false;
+            }
+
+            //! Skinned vertices share the layout of the morph vertices
+            glCreateBuffers(1, &_skinnedVertexBuffer);
+            glNamedBufferStorage(_skinnedVertexBuffer,
+                                 numSkinnedVertices * sizeof(MorphVertex),
+                                 nullptr, 0);
+            DebugUtils::SetObjectName(GL_BUFFER, _skinnedVertexBuffer,
+                                      "Scene Skinned Vertex Buffer");
+        }
+
+        UpdateSkins(skinNodes, {});
+    }
+
+    BuildDrawBatches();
+    if (_cullingMode == CullingMode::GPU && !InitializeGPUCulling())
+    {
+        return false;
+    }
+
     //! After uploading all required vertex data, We can release them to free
     ReleaseSourceData();
 
     return true;
 }
 
+void Scene::SetVertexQuantization(bool enabled)
+{
+    _quantizeVertices = enabled;
+}
+
+void Scene::SetTextureCompression(bool enabled)
+{
+    _compressTextures = enabled;
+}
+
+void Scene::SetBindlessTextures(bool enabled)
+{
+    _bindlessTextures = enabled;
+}
+
+void Scene::SetSkinningMode(SkinningMode mode)
+{
+    _skinningMode = mode;
+}
+
+void Scene::SetCullingMode(CullingMode mode)
+{
+    _cullingMode = mode;
+}
+
+GLuint Scene::CreateCompressedTexture(const tinygltf::Image& image,
+                                      Common::TextureRole role) const
+{
+    const auto* pixels = image.image.data();
+    const auto width = static_cast<size_t>(image.width);
+    const auto height = static_cast<size_t>(image.height);
+
+    //! Look up the encoded result before choosing the format, so cached
+    //! textures skip the alpha scan as well.
+    const std::string& cacheDirectory = GetCacheDirectory();
+    std::string cachePath;
+    Common::CompressedTexture compressed;
+    bool cached = false;
+    if (!cacheDirectory.empty())
+    {
+        cachePath = Common::TextureCompressor::GetCachePath(
+            cacheDirectory, pixels, width, height, role);
+        cached = Common::TextureCompressor::LoadKTX2(cachePath, compressed) &&
+                 compressed.width == width && compressed.height == height;
+    }
+
+    const Common::BlockFormat format =
+        cached ? compressed.format
+               : Common::TextureCompressor::ChooseFormat(role, pixels, width,
+                                                         height);
+    const GLenum internalFormat = GetCompressedFormat(format);
+    if (internalFormat == 0)
+    {
+        return 0;
+    }
+
+    if (!cached)
+    {
+        Common::TextureCompressor::Compress(pixels, width, height, format, role,
+                                            compressed);
+        if (!cachePath.empty() &&
+            !Common::TextureCompressor::SaveKTX2(cachePath, compressed))
+        {
+            std::cerr << "[Scene:CreateCompressedTexture] Failed to write "
+                      << cachePath << std::endl;
+        }
+    }
+
+    GLuint texture;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, static_cast<GLsizei>(compressed.levels.size()),
+                       internalFormat, image.width, image.height);
+    for (size_t level = 0; level < compressed.levels.size(); ++level)
+    {
+        const Common::CompressedTexture::Level& info =
+            compressed.levels[level];
+        glCompressedTextureSubImage2D(
+            texture, static_cast<GLint>(level), 0, 0,
+            static_cast<GLsizei>(info.width), static_cast<GLsizei>(info.height),
+            internalFormat, static_cast<GLsizei>(info.size),
+            compressed.data.data() + info.offset);
+    }
+    return texture;
+}
+
+void Scene::CreateTextureReferences(std::vector<glm::uvec2>& textureRefs)
+{
+    textureRefs.assign(_textures.size(), glm::uvec2(0));
+    if (_bindlessTextures &&
+        glfwExtensionSupported("GL_ARB_bindless_texture") != GLFW_TRUE)
+    {
+        std::cerr << "[Scene:CreateTextureReferences] GL_ARB_bindless_texture "
+                     "is not supported, falling back to texture arrays"
+                  << std::endl;
+        _bindlessTextures = false;
+    }
+
+    //! Handles are split into two 32-bit words, sampler2D(uvec2) in GLSL
+    if (_bindlessTextures)
+    {
+        _textureHandles.reserve(_textures.size());
+        for (size_t i = 0; i < _textures.size(); ++i)
+        {
+            const GLuint64 handle = glGetTextureHandleARB(_textures[i]);
+            glMakeTextureHandleResidentARB(handle);
+            _textureHandles.push_back(handle);
+            textureRefs[i] =
+                glm::uvec2(static_cast<GLuint>(handle & 0xFFFFFFFFu),
+                           static_cast<GLuint>(handle >> 32));
+        }
+        return;
+    }
+
+    //! Group the textures by width, height, number of levels and format
+    using TextureLayout = std::tuple<GLint, GLint, GLint, GLint>;
+    std::map<TextureLayout, std::vector<size_t>> groups;
+    for (size_t i = 0; i < _textures.size(); ++i)
+    {
+        GLint width = 0, height = 0, levels = 0, format = 0;
+        glGetTextureLevelParameteriv(_textures[i], 0, GL_TEXTURE_WIDTH, &width);
+        glGetTextureLevelParameteriv(_textures[i], 0, GL_TEXTURE_HEIGHT,
+                                     &height);
+        glGetTextureLevelParameteriv(_textures[i], 0,
+                                     GL_TEXTURE_INTERNAL_FORMAT, &format);
+        glGetTextureParameteriv(_textures[i], GL_TEXTURE_IMMUTABLE_LEVELS,
+                                &levels);
+        groups[{ width, height, levels, format }].push_back(i);
+    }
+
+    //! Arrays are bound per texture set, so any number of them is usable
+    for (const auto& [layout, textures] : groups)
+    {
+        const auto [width, height, levels, format] = layout;
+        const auto arrayIdx = static_cast<GLuint>(_textureArrays.size());
+
+        GLuint textureArray;
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &textureArray);
+        glTextureStorage3D(textureArray, levels, static_cast<GLenum>(format),
+                           width, height,
+                           static_cast<GLsizei>(textures.size()));
+        for (size_t layer = 0; layer < textures.size(); ++layer)
+        {
+            for (GLint level = 0; level < levels; ++level)
+            {
+                glCopyImageSubData(
+                    _textures[textures[layer]], GL_TEXTURE_2D, level, 0, 0, 0,
+                    textureArray, GL_TEXTURE_2D_ARRAY, level, 0, 0,
+                    static_cast<GLint>(layer), std::max(width >> level, 1),
+                    std::max(height >> level, 1), 1);
+            }
+            textureRefs[textures[layer]] =
+                glm::uvec2(arrayIdx, static_cast<GLuint>(layer));
+        }
+        glTextureParameteri(textureArray, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(textureArray, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTextureParameteri(textureArray, GL_TEXTURE_MIN_FILTER,
+                            GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(textureArray, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        DebugUtils::SetObjectName(GL_TEXTURE, textureArray,
+                                  "Scene Texture Array " +
+                                      std::to_string(width) + "x" +
+                                      std::to_string(height));
+        _textureArrays.push_back(textureArray);
+    }
+
+    //! Materials using the same array for each texture reference share the
+    //! texture set bound per draw group, the first set binds no array
+    std::map<std::vector<GLuint>, unsigned int> textureSets;
+    std::vector<GLuint> arrays(kNumMaterialTextures, 0);
+    textureSets.emplace(arrays, 0);
+    _textureSets = arrays;
+    _materialTextureSets.reserve(_sceneMaterials.size());
+    for (const auto& material : _sceneMaterials)
+    {
+        const int textures[kNumMaterialTextures] = {
+            material.baseColorTexture,
+            material.metallicRoughnessTexture,
+            material.specularGlossiness.diffuseTexture,
+            material.specularGlossiness.specularGlossinessTexture,
+            material.emissiveTexture,
+            material.normalTexture,
+            material.occlusionTexture
+        };
+        for (size_t k = 0; k < kNumMaterialTextures; ++k)
+        {
+            arrays[k] =
+                textures[k] >= 0 &&
+                        static_cast<size_t>(textures[k]) < textureRefs.size()
+                    ? _textureArrays[textureRefs[textures[k]].x]
+                    : 0;
+        }
+        const auto [iter, inserted] = textureSets.emplace(
+            arrays,
+            static_cast<unsigned int>(_textureSets.size() /
+                                      kNumMaterialTextures));
+        if (inserted)
+        {
+            _textureSets.insert(_textureSets.end(), arrays.begin(),
+                                arrays.end());
+        }
+        _materialTextureSets.push_back(iter->second);
+    }
+
+    //! Layers hold the copies, source textures are released
+    glDeleteTextures(static_cast<GLsizei>(_textures.size()), _textures.data());
+    _textures.clear();
+}
+
+void Scene::QuantizeVertices(QuantizedVertices& quantized)
+{
+    quantized.positions.resize(_positions.size());
+    quantized.normals.resize(_normals.size());
+    quantized.tangents.resize(_tangents.size());
+    quantized.colors.resize(_colors.size());
+    quantized.texCoords.resize(_texCoords.size());
+
+    //! Positions are quantized within the bounding box of each primitive.
+    _positionDequantizations.resize(_scenePrimMeshes.size());
+    Common::ThreadPool::GetGlobalPool().ParallelFor(
+        0, _scenePrimMeshes.size(), [&](size_t primIdx) {
+            const auto& primMesh = _scenePrimMeshes[primIdx];
+            const size_t begin = primMesh.vertexOffset;
+            const size_t end = begin + primMesh.vertexCount;
+
+            glm::vec3 minCorner(std::numeric_limits<float>::max());
+            glm::vec3 maxCorner(std::numeric_limits<float>::lowest());
+            for (size_t i = begin; i < end; ++i)
+            {
+                minCorner = glm::min(minCorner, _positions[i]);
+                maxCorner = glm::max(maxCorner, _positions[i]);
+            }
+
+            PositionDequantization& dequantization =
+                _positionDequantizations[primIdx];
+            if (begin < end)
+            {
+                dequantization.offset = (minCorner + maxCorner) * 0.5f;
+                dequantization.scale = glm::max(
+                    (maxCorner - minCorner) * 0.5f,
+                    glm::vec3(std::numeric_limits<float>::epsilon()));
+            }
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const glm::vec3 position =
+                    (_positions[i] - dequantization.offset) /
+                    dequantization.scale;
+                quantized.positions[i] =
+                    glm::packSnorm4x16(glm::vec4(position, 0.0f));
+            }
+            for (size_t i = begin; i < end && !_normals.empty(); ++i)
+            {
+                //! Unreferenced and degenerate vertices keep zero normals
+                const float length = glm::length(_normals[i]);
+                const glm::vec3 normal =
+                    length > 0.0f ? _normals[i] / length : glm::vec3(0.0f);
+                quantized.normals[i] =
+                    glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+            }
+            for (size_t i = begin; i < end && !_tangents.empty(); ++i)
+            {
+                quantized.tangents[i] = glm::packSnorm3x10_1x2(_tangents[i]);
+            }
+            for (size_t i = begin; i < end && !_colors.empty(); ++i)
+            {
+                quantized.colors[i] = glm::packUnorm4x8(_colors[i]);
+            }
+            for (size_t i = begin; i < end && !_texCoords.empty(); ++i)
+            {
+                quantized.texCoords[i] = glm::packHalf2x16(_texCoords[i]);
+            }
+        });
+}
+
 void Scene::Update(double dt)
 {
     bool sceneModified = UpdateAnimation(_animIndex, _timeElapsed);
@@ -168,98 +869,1309 @@ void Scene::Update(double dt)
     if (sceneModified)
     {
         UpdateMatrixBuffer();
+        UpdateMorphTargets(GetChangedMorphNodes());
+        UpdateSkins(GetChangedSkinNodes(), GetChangedMorphNodes());
     }
 
     _timeElapsed += dt;
 }
 
-void Scene::Render(const std::shared_ptr<Shader>& shader,
-                   GLenum alphaMode) const
+void Scene::Render(const std::shared_ptr<Shader>& shader, GLenum alphaMode)
 {
-    UNUSED_VARIABLE(alphaMode);
+    if (alphaMode >= kNumAlphaModes)
+    {
+        std::cerr << "[Scene:Render] Unknown alpha mode " << alphaMode
+                  << std::endl;
+        return;
+    }
+
+    //! Draws are updated once for the passes of all alpha modes. Blended
+    //! draws of the GPU path are sorted back-to-front by the render queue.
+    const bool gpuCulling = _cullingMode == CullingMode::GPU;
+    if (_drawCommandsDirty)
+    {
+        if (gpuCulling)
+        {
+            DispatchGPUCulling();
+        }
+        if (!gpuCulling || _blendCommandBegin < _drawCommands.size())
+        {
+            UpdateDrawCommands();
+        }
+    }
+
+    //! GPU culling compacts the draws of each group at the first command
+    //! slot of the group, the draw count is read from the buffer
+    const bool countedDraws = gpuCulling && alphaMode != 2;
+    const auto& groups = countedDraws ? _commandGroups : _drawGroups;
+    if (std::none_of(groups.begin(), groups.end(),
+                     [alphaMode](const DrawGroup& group) {
+                         return group.alphaMode == alphaMode &&
+                                group.drawCount > 0;
+                     }))
+    {
+        return;
+    }
 
     auto scope = _debug.ScopeLabel("Scene Rendering");
     glBindVertexArray(_vao);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _matrixBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _instanceBuffer);
+    glBindBufferRange(
+        GL_SHADER_STORAGE_BUFFER, 2, _matrixBuffer,
+        static_cast<GLintptr>(_currentMatrixRegion * _matrixRegionSize),
+        static_cast<GLsizeiptr>(_matrixRegionSize));
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _materialBuffer);
-
-    //! Use block-scope for calling destructor of scope label instance
+    if (_morphVertexBuffer != 0)
     {
-        auto textureScope = _debug.ScopeLabel("Scene Texture Binding");
-        for (int i = 0; i < static_cast<int>(_textures.size()); ++i)
-        {
-            glBindTextureUnit(i + 3, _textures[i]);
-        }
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _morphVertexBuffer);
+    }
+    if (_jointMatrixBuffer != 0)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _jointMatrixBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, _skinVertexBuffer);
+    }
+    if (_skinnedVertexBuffer != 0)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, _skinnedVertexBuffer);
     }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, _drawDataBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, _drawSlotBuffer);
 
-    int lastMaterialIdx = -1;
-    int instanceIdx = 0;
-    for (const auto& node : _sceneNodes)
+    //! Draws of a group share the shader variant, render states and the
+    //! texture arrays, so the arrays are selected by constant indices
+    auto drawScope = _debug.ScopeLabel("Draw Meshes");
+    size_t boundTextureSet = std::numeric_limits<size_t>::max();
+    if (countedDraws)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, _drawCountBuffer);
+    }
+    for (size_t idx = 0; idx < groups.size(); ++idx)
     {
-        shader->SendUniformVariable("instanceIdx", instanceIdx);
+        const auto& group = groups[idx];
+        if (group.alphaMode != alphaMode || group.drawCount == 0)
+        {
+            continue;
+        }
 
-        for (size_t meshIdx : node.primMeshes)
+        //! Resident textures need no binding, arrays are bound per group
+        if (!_bindlessTextures && group.textureSet != boundTextureSet)
         {
-            const auto& primMesh = _scenePrimMeshes[meshIdx];
-            if (primMesh.materialIndex != lastMaterialIdx)
-            {
-                auto materialScope = _debug.ScopeLabel(
-                    "Material Binding: " + std::to_string(instanceIdx));
-                shader->SendUniformVariable("materialIdx",
-                                            primMesh.materialIndex);
-                lastMaterialIdx = primMesh.materialIndex;
-            }
+            boundTextureSet = group.textureSet;
+            glBindTextures(kTextureArrayUnit,
+                           static_cast<GLsizei>(kNumMaterialTextures),
+                           _textureSets.data() +
+                               boundTextureSet * kNumMaterialTextures);
+        }
 
-            auto drawScope =
-                _debug.ScopeLabel("Draw Mesh: " + std::to_string(instanceIdx));
-            //! Draw elements with primitive mesh index informations.
-            glDrawElementsBaseVertex(
-                GL_TRIANGLES, primMesh.indexCount, GL_UNSIGNED_INT,
-                reinterpret_cast<const void*>(primMesh.firstIndex *
-                                              sizeof(unsigned int)),
-                primMesh.vertexOffset);
+        Shader* program = shader->GetVariant(group.features);
+        program->BindShaderProgram();
+        program->SendUniformVariable("bindlessTextures",
+                                     _bindlessTextures ? 1 : 0);
+        program->SendUniformVariable("drawBase",
+                                     static_cast<int>(group.drawBegin));
 
-            ++instanceIdx;
+        const auto* indirect = reinterpret_cast<const void*>(
+            group.drawBegin * sizeof(DrawElementsIndirectCommand));
+        if (countedDraws)
+        {
+            glMultiDrawElementsIndirectCountARB(
+                GL_TRIANGLES, GL_UNSIGNED_INT, indirect,
+                static_cast<GLintptr>(idx * sizeof(GLuint)),
+                static_cast<GLsizei>(group.drawCount), 0);
         }
+        else
+        {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                        indirect,
+                                        static_cast<GLsizei>(group.drawCount),
+                                        0);
+        }
+    }
+    if (countedDraws)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
     }
 
+    //! Culling shaders and variants replace the program of the caller
+    shader->BindShaderProgram();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
     glBindVertexArray(0);
 }
 
-void Scene::UpdateMatrixBuffer()
+void Scene::SetView(const glm::mat4& view)
 {
-    std::vector<NodeMatrix> matrices;
-    matrices.reserve(_sceneNodes.size());
-    for (const auto& node : _sceneNodes)
-    {
-        if (!node.primMeshes.empty())
-        {
-            NodeMatrix instance;
-            instance.first = node.world;
-            instance.second = glm::transpose(glm::inverse(instance.first));
-            matrices.emplace_back(std::move(instance));
-        }
-    }
+    _viewEye = glm::vec3(glm::inverse(view)[3]);
+    _drawCommandsDirty = true;
+}
 
-    //! TODO(snowapril) : mark only modified node and update the contents of
-    //! them
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _matrixBuffer);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
-                    matrices.size() * sizeof(NodeMatrix), matrices.data());
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+void Scene::SetLODView(const glm::mat4& view, const glm::mat4& projection,
+                       float viewportHeight)
+{
+    _lodEye = glm::vec3(glm::inverse(view)[3]);
+    _viewEye = _lodEye;
+    //! Pixels per unit length at unit distance, projection[1][1] is
+    //! cot(fovy / 2) of the perspective projection.
+    _lodProjectionScale = projection[1][1] * viewportHeight * 0.5f;
+    _drawCommandsDirty = true;
 }
 
-void Scene::CleanUp()
+void Scene::SetLODThreshold(float pixels)
 {
-    glDeleteTextures(static_cast<GLsizei>(_textures.size()), _textures.data());
-    _textures.clear();
+    _lodThreshold = pixels;
+    _drawCommandsDirty = true;
+}
 
-    glDeleteBuffers(1, &_matrixBuffer);
-    _matrixBuffer = 0;
+void Scene::SetFrustum(const Common::Frustum& frustum)
+{
+    _frustum = frustum;
+    _frustumCulling = true;
+    _drawCommandsDirty = true;
+}
+
+void Scene::SetFrustumCulling(bool enabled)
+{
+    _frustumCulling = enabled;
+    _drawCommandsDirty = true;
+}
+
+const Scene::RenderStats& Scene::GetRenderStats() const
+{
+    return _renderStats;
+}
+
+unsigned int Scene::SelectLOD(const glm::mat4& world,
+                              const GLTFPrimMesh& primMesh) const
+{
+    if (primMesh.lods.empty() || _lodProjectionScale <= 0.0f)
+    {
+        return 0;
+    }
+
+    //! Bounding sphere of the primitive in world space
+    const float scale = std::max({ glm::length(glm::vec3(world[0])),
+                                   glm::length(glm::vec3(world[1])),
+                                   glm::length(glm::vec3(world[2])) });
+    const glm::vec3 center = glm::vec3(
+        world * glm::vec4((primMesh.min + primMesh.max) * 0.5f, 1.0f));
+    const float radius = glm::length(primMesh.max - primMesh.min) * 0.5f * scale;
+    const float distance = glm::length(center - _lodEye) - radius;
+    if (distance <= 0.0f)
+    {
+        return 0;
+    }
+
+    const float pixelsPerUnit = _lodProjectionScale * scale / distance;
+    unsigned int level = 0;
+    for (const auto& lod : primMesh.lods)
+    {
+        if (lod.error * pixelsPerUnit > _lodThreshold)
+        {
+            break;
+        }
+        ++level;
+    }
+    return level;
+}
+
+void Scene::BuildDrawBatches()
+{
+    //! Plain primitives of all nodes are grouped by the primitive index
+    std::vector<int> plainBatches(_scenePrimMeshes.size(), -1);
+    std::vector<std::vector<unsigned int>> batchInstances;
+    for (size_t node = 0; node < _sceneNodes.Size(); ++node)
+    {
+        const int matrixIdx = _nodeMatrixIndices[node];
+        if (matrixIdx == -1)
+        {
+            continue;
+        }
+        const unsigned int numInstances =
+            std::max(_sceneNodes.instanceOffsets[node + 1] -
+                         _sceneNodes.instanceOffsets[node],
+                     1u);
+
+        for (unsigned int i = _sceneNodes.primMeshOffsets[node];
+             i < _sceneNodes.primMeshOffsets[node + 1]; ++i)
+        {
+            const unsigned int meshIdx = _sceneNodes.primMeshes[i];
+            const int morphIdx = _morphInstanceIndices[i];
+            const int skinIdx = _skinInstanceIndices[i];
+            const bool plain = morphIdx == -1 && skinIdx == -1;
+
+            int batch = plain ? plainBatches[meshIdx] : -1;
+            if (batch == -1)
+            {
+                const int material = _scenePrimMeshes[meshIdx].materialIndex;
+                const int alphaMode =
+                    material >= 0 ? _sceneMaterials[material].alphaMode : 0;
+                const unsigned int features =
+                    material >= 0
+                        ? Common::GetMaterialFeatures(_sceneMaterials[material])
+                        : 0;
+                const unsigned int textureSet =
+                    material >= 0 && static_cast<size_t>(material) <
+                                         _materialTextureSets.size()
+                        ? _materialTextureSets[material]
+                        : 0;
+                batch = static_cast<int>(_drawBatches.size());
+                _drawBatches.push_back(
+                    { meshIdx, morphIdx, skinIdx, 0, 0, 0,
+                      static_cast<unsigned int>(std::clamp(alphaMode, 0, 2)),
+                      features, textureSet });
+                batchInstances.emplace_back();
+                if (plain)
+                {
+                    plainBatches[meshIdx] = batch;
+                }
+            }
+            for (unsigned int k = 0; k < numInstances; ++k)
+            {
+                batchInstances[batch].push_back(
+                    static_cast<unsigned int>(matrixIdx) + k);
+            }
+        }
+    }
+
+    //! Command slots of each alpha mode, shader variant and texture set are
+    //! contiguous, consecutive batches share the material
+    std::vector<unsigned int> order(_drawBatches.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](unsigned int lhs, unsigned int rhs) {
+                         const auto& lhsMesh =
+                             _scenePrimMeshes[_drawBatches[lhs].primMesh];
+                         const auto& rhsMesh =
+                             _scenePrimMeshes[_drawBatches[rhs].primMesh];
+                         if (_drawBatches[lhs].alphaMode !=
+                             _drawBatches[rhs].alphaMode)
+                         {
+                             return _drawBatches[lhs].alphaMode <
+                                    _drawBatches[rhs].alphaMode;
+                         }
+                         if (_drawBatches[lhs].features !=
+                             _drawBatches[rhs].features)
+                         {
+                             return _drawBatches[lhs].features <
+                                    _drawBatches[rhs].features;
+                         }
+                         if (_drawBatches[lhs].textureSet !=
+                             _drawBatches[rhs].textureSet)
+                         {
+                             return _drawBatches[lhs].textureSet <
+                                    _drawBatches[rhs].textureSet;
+                         }
+                         if (lhsMesh.materialIndex != rhsMesh.materialIndex)
+                         {
+                             return lhsMesh.materialIndex <
+                                    rhsMesh.materialIndex;
+                         }
+                         return _drawBatches[lhs].primMesh <
+                                _drawBatches[rhs].primMesh;
+                     });
+
+    //! Every level of detail of the batch has its own command, starting with
+    //! all instances at the finest level
+    std::vector<DrawBatch> batches;
+    std::vector<DrawData> drawData;
+    batches.reserve(_drawBatches.size());
+    _batchInstances.clear();
+    _drawCommands.clear();
+    _commandTextureSets.clear();
+    _commandGroups.clear();
+    for (unsigned int idx : order)
+    {
+        DrawBatch batch = _drawBatches[idx];
+        batch.instanceBegin = static_cast<unsigned int>(_batchInstances.size());
+        batch.instanceCount =
+            static_cast<unsigned int>(batchInstances[idx].size());
+        batch.commandBegin = static_cast<unsigned int>(_drawCommands.size());
+        _batchInstances.insert(_batchInstances.end(),
+                               batchInstances[idx].begin(),
+                               batchInstances[idx].end());
+        batches.push_back(batch);
+
+        const auto& primMesh = _scenePrimMeshes[batch.primMesh];
+        DrawData data{};
+        data.positionScale = glm::vec4(1.0f);
+        data.positionOffset = glm::vec4(0.0f);
+        if (_quantizeVertices)
+        {
+            const auto& dequantization =
+                _positionDequantizations[batch.primMesh];
+            data.positionScale = glm::vec4(dequantization.scale, 1.0f);
+            data.positionOffset = glm::vec4(dequantization.offset, 0.0f);
+        }
+        data.materialIdx = primMesh.materialIndex;
+
+        //! gl_VertexID includes the base vertex, morphBase moves it to the
+        //! range of the instance in the morph vertex buffer
+        if (batch.morphInstance != -1)
+        {
+            data.morphEnabled = 1;
+            data.morphBase =
+                static_cast<int>(
+                    _morphInstances[batch.morphInstance].vertexBegin) -
+                static_cast<int>(primMesh.vertexOffset);
+        }
+
+        //! Skinned vertices of the compute path already contain the blended
+        //! morph targets
+        data.skinMode = kSkinModeNone;
+        if (batch.skinInstance != -1)
+        {
+            const auto& instance = _skinInstances[batch.skinInstance];
+            if (_skinningMode == SkinningMode::Compute)
+            {
+                data.skinMode = kSkinModeSkinned;
+                data.skinBase = static_cast<int>(instance.vertexBegin) -
+                                static_cast<int>(primMesh.vertexOffset);
+            }
+            else
+            {
+                data.skinMode = kSkinModeVertexShader;
+                data.skinBase = static_cast<int>(instance.restBegin) -
+                                static_cast<int>(primMesh.vertexOffset);
+                data.jointBase = static_cast<int>(instance.jointBase);
+            }
+        }
+
+        for (size_t level = 0; level <= primMesh.lods.size(); ++level)
+        {
+            DrawElementsIndirectCommand command{};
+            command.count = level == 0 ? primMesh.indexCount
+                                       : primMesh.lods[level - 1].indexCount;
+            command.firstIndex = level == 0
+                                     ? primMesh.firstIndex
+                                     : primMesh.lods[level - 1].firstIndex;
+            command.baseVertex = static_cast<GLint>(primMesh.vertexOffset);
+            command.baseInstance = batch.instanceBegin;
+            command.instanceCount = level == 0 ? batch.instanceCount : 0;
+            _drawCommands.push_back(command);
+            _commandTextureSets.push_back(batch.textureSet);
+            drawData.push_back(data);
+        }
+
+        if (_commandGroups.empty() ||
+            _commandGroups.back().alphaMode != batch.alphaMode ||
+            _commandGroups.back().features != batch.features ||
+            _commandGroups.back().textureSet != batch.textureSet)
+        {
+            _commandGroups.push_back({ batch.alphaMode, batch.features,
+                                       batch.textureSet, batch.commandBegin,
+                                       0 });
+        }
+        _commandGroups.back().drawCount += primMesh.lods.size() + 1;
+    }
+    _drawGroups = _commandGroups;
+
+    //! Blended batches come last, the GPU path leaves them to the render
+    //! queue
+    _blendCommandBegin = _drawCommands.size();
+    _blendInstanceBegin = _batchInstances.size();
+    for (const auto& batch : batches)
+    {
+        if (batch.alphaMode == 2)
+        {
+            _blendCommandBegin = batch.commandBegin;
+            _blendInstanceBegin = batch.instanceBegin;
+            break;
+        }
+    }
+    _drawBatches = std::move(batches);
+    _drawInstances = _batchInstances;
+
+    //! Matrix indices of the instances, reordered by the level of detail in
+    //! UpdateDrawCommands
+    glCreateBuffers(1, &_instanceBuffer);
+    glNamedBufferStorage(
+        _instanceBuffer,
+        std::max<size_t>(_drawInstances.size(), 1) * sizeof(unsigned int),
+        nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferSubData(
+        _instanceBuffer, 0,
+        static_cast<GLsizeiptr>(_drawInstances.size() * sizeof(unsigned int)),
+        _drawInstances.data());
+    DebugUtils::SetObjectName(GL_BUFFER, _instanceBuffer,
+                              "Scene Instance Index Buffer");
+
+    glCreateBuffers(1, &_commandBuffer);
+    glNamedBufferStorage(
+        _commandBuffer,
+        std::max<size_t>(_drawCommands.size(), 1) *
+            sizeof(DrawElementsIndirectCommand),
+        nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferSubData(_commandBuffer, 0,
+                         static_cast<GLsizeiptr>(
+                             _drawCommands.size() *
+                             sizeof(DrawElementsIndirectCommand)),
+                         _drawCommands.data());
+    DebugUtils::SetObjectName(GL_BUFFER, _commandBuffer,
+                              "Scene Draw Command Buffer");
+
+    glCreateBuffers(1, &_drawDataBuffer);
+    glNamedBufferStorage(
+        _drawDataBuffer, std::max<size_t>(drawData.size(), 1) * sizeof(DrawData),
+        drawData.empty() ? nullptr : drawData.data(), 0);
+    DebugUtils::SetObjectName(GL_BUFFER, _drawDataBuffer,
+                              "Scene Draw Data Buffer");
+
+    //! Draws are the command slots themselves until the render queue is
+    //! sorted
+    std::vector<GLuint> drawSlots(_drawCommands.size());
+    std::iota(drawSlots.begin(), drawSlots.end(), 0u);
+    glCreateBuffers(1, &_drawSlotBuffer);
+    glNamedBufferStorage(
+        _drawSlotBuffer, std::max<size_t>(drawSlots.size(), 1) * sizeof(GLuint),
+        nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferSubData(
+        _drawSlotBuffer, 0,
+        static_cast<GLsizeiptr>(drawSlots.size() * sizeof(GLuint)),
+        drawSlots.data());
+    DebugUtils::SetObjectName(GL_BUFFER, _drawSlotBuffer,
+                              "Scene Draw Slot Buffer");
+
+    //! Levels of detail are assigned once the view is set
+    _drawCommandsDirty = true;
+}
+
+void Scene::UpdateDrawCommands()
+{
+    _drawCommandsDirty = false;
+
+    //! Visibility of all instances is tested at once before the batches
+    if (_frustumCulling)
+    {
+        _instanceVisibility.resize(_instanceBounds.Size());
+        Common::CullAABBs(_frustum, _instanceBounds,
+                          _instanceVisibility.data());
+    }
+
+    //! Distance of the instance origin from the viewer, the sort depth
+    auto instanceDepth = [this](unsigned int matrixIdx) {
+        return glm::length(glm::vec3(_nodeMatrices[matrixIdx].first[3]) -
+                           _viewEye);
+    };
+
+    //! The GPU path compacts the other draws, the blended draws are queued
+    //! after its command slots
+    const bool gpuCulling = _cullingMode == CullingMode::GPU;
+    const size_t commandBase = gpuCulling ? _blendCommandBegin : 0;
+
+    //! Range of the instances changed by the reassignment
+    size_t instanceBegin = _drawInstances.size(), instanceEnd = 0;
+    _renderStats = RenderStats();
+    _renderQueue.Clear();
+    for (const auto& batch : _drawBatches)
+    {
+        if (gpuCulling && batch.alphaMode != 2)
+        {
+            continue;
+        }
+
+        const auto& primMesh = _scenePrimMeshes[batch.primMesh];
+        const size_t numLevels = primMesh.lods.size() + 1;
+
+        //! Counting sort of the instances by their level, culled instances
+        //! are moved after the last level
+        const unsigned int* instances =
+            _batchInstances.data() + batch.instanceBegin;
+        _instanceLevels.resize(batch.instanceCount);
+        _levelOffsets.assign(numLevels + 2, 0);
+        for (unsigned int i = 0; i < batch.instanceCount; ++i)
+        {
+            const unsigned int matrixIdx = instances[i];
+            _instanceLevels[i] =
+                _frustumCulling && _instanceVisibility[matrixIdx] == 0
+                    ? static_cast<unsigned int>(numLevels)
+                    : SelectLOD(_nodeMatrices[matrixIdx].first, primMesh);
+            ++_levelOffsets[_instanceLevels[i] + 1];
+        }
+        for (size_t level = 1; level < _levelOffsets.size(); ++level)
+        {
+            _levelOffsets[level] += _levelOffsets[level - 1];
+        }
+        _renderStats.visibleInstances += _levelOffsets[numLevels];
+        _renderStats.culledInstances +=
+            batch.instanceCount - _levelOffsets[numLevels];
+
+        for (size_t level = 0; level < numLevels; ++level)
+        {
+            auto& command = _drawCommands[batch.commandBegin + level];
+            command.baseInstance = batch.instanceBegin + _levelOffsets[level];
+            command.instanceCount =
+                _levelOffsets[level + 1] - _levelOffsets[level];
+        }
+        bool changed = false;
+        for (unsigned int i = 0; i < batch.instanceCount; ++i)
+        {
+            unsigned int& drawInstance =
+                _drawInstances[batch.instanceBegin +
+                               _levelOffsets[_instanceLevels[i]]++];
+            changed |= drawInstance != instances[i];
+            drawInstance = instances[i];
+        }
+
+        //! Queue the non-empty levels, blended instances within each level
+        //! are drawn back-to-front as well
+        const bool blended = batch.alphaMode == 2;
+        for (size_t level = 0; level < numLevels; ++level)
+        {
+            const size_t slot = batch.commandBegin + level;
+            const auto& command = _drawCommands[slot];
+            if (command.instanceCount == 0)
+            {
+                continue;
+            }
+
+            auto begin = _drawInstances.begin() + command.baseInstance;
+            auto end = begin + command.instanceCount;
+            if (blended && command.instanceCount > 1)
+            {
+                std::sort(begin, end,
+                          [&](unsigned int lhs, unsigned int rhs) {
+                              return instanceDepth(lhs) > instanceDepth(rhs);
+                          });
+                changed = true;
+            }
+
+            float depth = blended ? 0.0f : std::numeric_limits<float>::max();
+            for (auto instance = begin; instance != end; ++instance)
+            {
+                depth = blended ? std::max(depth, instanceDepth(*instance))
+                                : std::min(depth, instanceDepth(*instance));
+            }
+            _renderQueue.Push(Common::RenderQueue::MakeSortKey(
+                                  0, static_cast<int>(batch.alphaMode),
+                                  batch.features, primMesh.materialIndex,
+                                  batch.primMesh, depth),
+                              static_cast<std::uint32_t>(slot));
+        }
+
+        if (changed)
+        {
+            instanceBegin = std::min<size_t>(instanceBegin, batch.instanceBegin);
+            instanceEnd = std::max<size_t>(
+                instanceEnd, batch.instanceBegin + batch.instanceCount);
+        }
+    }
+
+    //! Sorted draws are compacted, draws of each alpha mode stay contiguous
+    //! because the alpha mode is the highest field of the key after the pass.
+    //! Opaque and masked draws of a shader variant are contiguous as well,
+    //! blended draws switch the variant wherever the depth order requires.
+    _renderQueue.Sort();
+    _queueCommands.clear();
+    _queueSlots.clear();
+    _drawGroups.clear();
+    std::uint32_t lastState = std::numeric_limits<std::uint32_t>::max();
+    for (const auto& item : _renderQueue.GetItems())
+    {
+        const auto alphaMode = static_cast<unsigned int>(
+            Common::RenderQueue::GetAlphaMode(item.key));
+        const unsigned int features =
+            Common::RenderQueue::GetShader(item.key);
+        const unsigned int textureSet = _commandTextureSets[item.payload];
+        if (_drawGroups.empty() || _drawGroups.back().alphaMode != alphaMode ||
+            _drawGroups.back().features != features ||
+            _drawGroups.back().textureSet != textureSet)
+        {
+            _drawGroups.push_back({ alphaMode, features, textureSet,
+                                    commandBase + _queueCommands.size(), 0 });
+        }
+        ++_drawGroups.back().drawCount;
+        _queueCommands.push_back(_drawCommands[item.payload]);
+        _queueSlots.push_back(item.payload);
+
+        const std::uint32_t state = Common::RenderQueue::GetState(item.key);
+        _renderStats.stateChanges += state != lastState ? 1 : 0;
+        lastState = state;
+    }
+    _renderStats.numDraws = _queueCommands.size();
+
+    if (!_queueCommands.empty())
+    {
+        glNamedBufferSubData(
+            _commandBuffer,
+            static_cast<GLintptr>(commandBase *
+                                  sizeof(DrawElementsIndirectCommand)),
+            static_cast<GLsizeiptr>(_queueCommands.size() *
+                                    sizeof(DrawElementsIndirectCommand)),
+            _queueCommands.data());
+        glNamedBufferSubData(
+            _drawSlotBuffer,
+            static_cast<GLintptr>(commandBase * sizeof(GLuint)),
+            static_cast<GLsizeiptr>(_queueSlots.size() * sizeof(GLuint)),
+            _queueSlots.data());
+    }
+    if (instanceBegin < instanceEnd)
+    {
+        glNamedBufferSubData(
+            _instanceBuffer,
+            static_cast<GLintptr>(instanceBegin * sizeof(unsigned int)),
+            static_cast<GLsizeiptr>((instanceEnd - instanceBegin) *
+                                    sizeof(unsigned int)),
+            _drawInstances.data() + instanceBegin);
+    }
+}
+
+bool Scene::InitializeGPUCulling()
+{
+    //! Compacted draws need the draw count read from the buffer
+    if (glfwExtensionSupported("GL_ARB_indirect_parameters") != GLFW_TRUE)
+    {
+        std::cerr << "[Scene:InitializeGPUCulling] GL_ARB_indirect_parameters "
+                     "is not supported, falling back to CPU culling"
+                  << std::endl;
+        _cullingMode = CullingMode::CPU;
+        return true;
+    }
+
+    const std::pair<std::shared_ptr<Shader>*, std::string> shaders[] = {
+        { &_cullShader, RESOURCES_DIR "/shaders/cull_instances.comp" },
+        { &_buildDrawsShader, RESOURCES_DIR "/shaders/build_draws.comp" },
+        { &_scatterShader, RESOURCES_DIR "/shaders/scatter_instances.comp" },
+        { &_depthPyramidShader, RESOURCES_DIR "/shaders/depth_pyramid.comp" }
+    };
+    //! All shaders are submitted before waiting, so the driver compiles
+    //! them in parallel
+    for (const auto& [shader, path] : shaders)
+    {
+        *shader = std::make_shared<Shader>();
+        (*shader)->InitializeAsync({ { GL_COMPUTE_SHADER, path } });
+    }
+    for (const auto& [shader, path] : shaders)
+    {
+        if (!(*shader)->Wait())
+        {
+            std::cerr << "[Scene:InitializeGPUCulling] Failed to compile "
+                      << path << std::endl;
+            return false;
+        }
+    }
+
+    //! Instances follow the order of _batchInstances, so the culling pass
+    //! writes the level of each instance at its batch instance index.
+    //! Blended batches are left to the render queue for the depth order.
+    std::vector<CullInstance> instances;
+    std::vector<CullBatch> batches;
+    std::vector<CullCommand> commands(_blendCommandBegin);
+    instances.reserve(_blendInstanceBegin);
+    batches.reserve(_drawBatches.size());
+    size_t group = 0;
+    for (size_t idx = 0; idx < _drawBatches.size(); ++idx)
+    {
+        const auto& batch = _drawBatches[idx];
+        if (batch.alphaMode == 2)
+        {
+            break;
+        }
+        const auto& primMesh = _scenePrimMeshes[batch.primMesh];
+        const size_t numLevels = primMesh.lods.size() + 1;
+        while (_commandGroups[group].drawBegin +
+                   _commandGroups[group].drawCount <=
+               batch.commandBegin)
+        {
+            ++group;
+        }
+
+        CullBatch cullBatch{};
+        cullBatch.sphere =
+            glm::vec4((primMesh.min + primMesh.max) * 0.5f,
+                      glm::length(primMesh.max - primMesh.min) * 0.5f);
+        cullBatch.commandBegin = batch.commandBegin;
+        cullBatch.numLevels = static_cast<GLuint>(numLevels);
+        batches.push_back(cullBatch);
+
+        for (size_t level = 0; level < numLevels; ++level)
+        {
+            const auto& draw = _drawCommands[batch.commandBegin + level];
+            auto& command = commands[batch.commandBegin + level];
+            command.count = draw.count;
+            command.firstIndex = draw.firstIndex;
+            command.baseVertex = draw.baseVertex;
+            command.error = level == 0 ? 0.0f : primMesh.lods[level - 1].error;
+            command.firstSlot = batch.commandBegin;
+            command.instanceBegin = batch.instanceBegin;
+            command.group = static_cast<GLuint>(group);
+            command.drawBegin =
+                static_cast<GLuint>(_commandGroups[group].drawBegin);
+        }
+        for (unsigned int i = 0; i < batch.instanceCount; ++i)
+        {
+            instances.push_back({ _batchInstances[batch.instanceBegin + i],
+                                  static_cast<GLuint>(idx) });
+        }
+    }
+
+    //! Node space bounds shared by the instances of each node, deformed
+    //! nodes are never culled as in UpdateInstanceBounds
+    std::vector<CullBounds> bounds(_nodeMatrices.size());
+    for (size_t node = 0; node < _sceneNodes.Size(); ++node)
+    {
+        const int matrixIdx = _nodeMatrixIndices[node];
+        if (matrixIdx == -1)
+        {
+            continue;
+        }
+        const unsigned int numInstances =
+            std::max(_sceneNodes.instanceOffsets[node + 1] -
+                         _sceneNodes.instanceOffsets[node],
+                     1u);
+        const bool unbounded = _sceneNodes.skins[node] != -1 ||
+                               _sceneNodes.weightOffsets[node] !=
+                                   _sceneNodes.weightOffsets[node + 1];
+
+        CullBounds bound{ glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f) };
+        if (!unbounded)
+        {
+            bound.lower = glm::vec4(_nodeBounds[node].first, 0.0f);
+            bound.upper = glm::vec4(_nodeBounds[node].second, 0.0f);
+        }
+        std::fill_n(bounds.begin() + matrixIdx, numInstances, bound);
+    }
+
+    auto createBuffer = [](GLuint& buffer, size_t size, const void* data,
+                           const char* name) {
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, std::max(size, sizeof(GLuint)),
+                             size > 0 ? data : nullptr, 0);
+        DebugUtils::SetObjectName(GL_BUFFER, buffer, name);
+    };
+    createBuffer(_cullInstanceBuffer, instances.size() * sizeof(CullInstance),
+                 instances.data(), "Scene Cull Instance Buffer");
+    createBuffer(_cullBoundsBuffer, bounds.size() * sizeof(CullBounds),
+                 bounds.data(), "Scene Cull Bounds Buffer");
+    createBuffer(_cullBatchBuffer, batches.size() * sizeof(CullBatch),
+                 batches.data(), "Scene Cull Batch Buffer");
+    createBuffer(_cullCommandBuffer, commands.size() * sizeof(CullCommand),
+                 commands.data(), "Scene Cull Command Buffer");
+    createBuffer(_drawCounterBuffer, commands.size() * 2 * sizeof(GLuint),
+                 nullptr, "Scene Draw Counter Buffer");
+    createBuffer(_instanceLevelBuffer, instances.size() * sizeof(GLuint),
+                 nullptr, "Scene Instance Level Buffer");
+    createBuffer(_drawCountBuffer, _commandGroups.size() * sizeof(GLuint),
+                 nullptr, "Scene Draw Count Buffer");
+
+    return true;
+}
+
+void Scene::DispatchGPUCulling()
+{
+    const auto numInstances = static_cast<GLuint>(_blendInstanceBegin);
+    const auto numSlots = static_cast<GLuint>(_blendCommandBegin);
+    auto scope = _debug.ScopeLabel("GPU Culling");
+    _drawCommandsDirty = false;
+
+    glClearNamedBufferData(_drawCounterBuffer, GL_R32UI, GL_RED_INTEGER,
+                           GL_UNSIGNED_INT, nullptr);
+    glClearNamedBufferData(_drawCountBuffer, GL_R32UI, GL_RED_INTEGER,
+                           GL_UNSIGNED_INT, nullptr);
+
+    //! Count the visible instances of each command slot
+    _cullShader->BindShaderProgram();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _cullInstanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _instanceLevelBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _drawCounterBuffer);
+    glBindBufferRange(
+        GL_SHADER_STORAGE_BUFFER, 3, _matrixBuffer,
+        static_cast<GLintptr>(_currentMatrixRegion * _matrixRegionSize),
+        static_cast<GLsizeiptr>(_matrixRegionSize));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _cullBoundsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _cullBatchBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, _cullCommandBuffer);
+    _cullShader->SendUniformVariable("instanceCount",
+                                     static_cast<int>(numInstances));
+    _cullShader->SendUniformVariable("frustumEnabled", _frustumCulling ? 1 : 0);
+    for (size_t i = 0; i < 6; ++i)
+    {
+        _cullShader->SendUniformVariable(
+            "frustumPlanes[" + std::to_string(i) + "]", _frustum.planes[i]);
+    }
+    _cullShader->SendUniformVariable("occlusionEnabled",
+                                     _occlusionCulling ? 1 : 0);
+    if (_occlusionCulling)
+    {
+        glBindTextureUnit(kDepthPyramidTextureUnit, _depthPyramid);
+        _cullShader->SendUniformVariable("occlusionViewProj",
+                                         _occlusionViewProjection);
+        _cullShader->SendUniformVariable("pyramidWidth", _depthPyramidWidth);
+        _cullShader->SendUniformVariable("pyramidHeight", _depthPyramidHeight);
+        _cullShader->SendUniformVariable("pyramidLevels", _depthPyramidLevels);
+    }
+    _cullShader->SendUniformVariable("lodEye", _lodEye);
+    _cullShader->SendUniformVariable("lodProjectionScale", _lodProjectionScale);
+    _cullShader->SendUniformVariable("lodThreshold", _lodThreshold);
+    glDispatchCompute((numInstances + kCullGroupSize - 1) / kCullGroupSize, 1,
+                      1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    //! Write the commands of the non-empty slots and their instance ranges
+    _buildDrawsShader->BindShaderProgram();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _cullCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _drawCounterBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _drawSlotBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _drawCountBuffer);
+    _buildDrawsShader->SendUniformVariable("slotCount",
+                                           static_cast<int>(numSlots));
+    glDispatchCompute((numSlots + kCullGroupSize - 1) / kCullGroupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    //! Fill the instance ranges with the matrix indices
+    _scatterShader->BindShaderProgram();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _cullInstanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _instanceLevelBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _drawCounterBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _cullBatchBuffer);
+    _scatterShader->SendUniformVariable("instanceCount",
+                                        static_cast<int>(numInstances));
+    glDispatchCompute((numInstances + kCullGroupSize - 1) / kCullGroupSize, 1,
+                      1);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    Shader::UnbindShaderProgram();
+}
+
+void Scene::UpdateDepthPyramid(GLuint depthTexture,
+                               const glm::mat4& viewProjection)
+{
+    if (_cullingMode != CullingMode::GPU)
+    {
+        return;
+    }
+
+    GLint width = 0, height = 0;
+    glGetTextureLevelParameteriv(depthTexture, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTextureLevelParameteriv(depthTexture, 0, GL_TEXTURE_HEIGHT, &height);
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    //! Farthest depth is kept in every level, so the pyramid is recreated
+    //! only when the depth attachment is resized
+    if (width != _depthPyramidWidth || height != _depthPyramidHeight)
+    {
+        glDeleteTextures(1, &_depthPyramid);
+        _depthPyramidWidth = width;
+        _depthPyramidHeight = height;
+        _depthPyramidLevels = GetNumMipLevels(width, height);
+        glCreateTextures(GL_TEXTURE_2D, 1, &_depthPyramid);
+        glTextureStorage2D(_depthPyramid, _depthPyramidLevels, GL_R32F, width,
+                           height);
+        glTextureParameteri(_depthPyramid, GL_TEXTURE_MIN_FILTER,
+                            GL_NEAREST_MIPMAP_NEAREST);
+        glTextureParameteri(_depthPyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(_depthPyramid, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(_depthPyramid, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        DebugUtils::SetObjectName(GL_TEXTURE, _depthPyramid,
+                                  "Scene Depth Pyramid");
+    }
+
+    auto scope = _debug.ScopeLabel("Depth Pyramid");
+    _depthPyramidShader->BindShaderProgram();
+    glBindTextureUnit(kDepthPyramidTextureUnit, depthTexture);
+    for (GLint level = 0; level < _depthPyramidLevels; ++level)
+    {
+        const GLuint levelWidth =
+            static_cast<GLuint>(std::max(width >> level, 1));
+        const GLuint levelHeight =
+            static_cast<GLuint>(std::max(height >> level, 1));
+        glBindImageTexture(0, _depthPyramid, std::max(level - 1, 0), GL_FALSE,
+                           0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, _depthPyramid, level, GL_FALSE, 0, GL_WRITE_ONLY,
+                           GL_R32F);
+        _depthPyramidShader->SendUniformVariable("targetLevelIdx", level);
+        glDispatchCompute(
+            (levelWidth + kDepthPyramidGroupSize - 1) / kDepthPyramidGroupSize,
+            (levelHeight + kDepthPyramidGroupSize - 1) / kDepthPyramidGroupSize,
+            1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindTextureUnit(kDepthPyramidTextureUnit, 0);
+    Shader::UnbindShaderProgram();
+
+    _occlusionViewProjection = viewProjection;
+    _occlusionCulling = true;
+    _drawCommandsDirty = true;
+}
+
+void Scene::UpdateInstanceBounds(size_t node)
+{
+    const size_t matrixIdx = static_cast<size_t>(_nodeMatrixIndices[node]);
+    const size_t numInstances =
+        std::max(_sceneNodes.instanceOffsets[node + 1] -
+                     _sceneNodes.instanceOffsets[node],
+                 1u);
+
+    //! Deformed vertices are not bounded by the primitive bounds, such nodes
+    //! are never culled
+    if (_sceneNodes.skins[node] != -1 ||
+        _sceneNodes.weightOffsets[node] != _sceneNodes.weightOffsets[node + 1])
+    {
+        for (size_t i = 0; i < numInstances; ++i)
+        {
+            _instanceBounds.Set(
+                matrixIdx + i, glm::vec3(std::numeric_limits<float>::lowest()),
+                glm::vec3(std::numeric_limits<float>::max()));
+        }
+        return;
+    }
+
+    const auto& bounds = _nodeBounds[node];
+    for (size_t i = 0; i < numInstances; ++i)
+    {
+        glm::vec3 lower, upper;
+        Common::TransformAABB(_nodeMatrices[matrixIdx + i].first, bounds.first,
+                              bounds.second, lower, upper);
+        _instanceBounds.Set(matrixIdx + i, lower, upper);
+    }
+}
+
+void Scene::UpdateMatrixBuffer()
+{
+    //! Collect the world matrices of the changed nodes with primitives
+    _changedMatrices.clear();
+    _changedWorlds.clear();
+    for (unsigned int node : GetChangedNodes())
+    {
+        const int matrixIdx = _nodeMatrixIndices[node];
+        if (matrixIdx == -1)
+        {
+            continue;
+        }
+
+        const glm::mat4& world = _sceneNodes.worlds[node];
+        const unsigned int instanceBegin = _sceneNodes.instanceOffsets[node];
+        const unsigned int instanceEnd = _sceneNodes.instanceOffsets[node + 1];
+        if (instanceBegin == instanceEnd)
+        {
+            _changedMatrices.push_back(static_cast<unsigned int>(matrixIdx));
+            _changedWorlds.push_back(world);
+        }
+        for (unsigned int i = instanceBegin; i < instanceEnd; ++i)
+        {
+            _changedMatrices.push_back(static_cast<unsigned int>(matrixIdx) +
+                                       (i - instanceBegin));
+            _changedWorlds.push_back(world * _sceneNodes.instances[i]);
+        }
+    }
+    if (_changedMatrices.empty())
+    {
+        return;
+    }
+    _drawCommandsDirty = true;
+
+    _changedNormals.resize(_changedWorlds.size());
+    Common::ComputeNormalMatrices(_changedWorlds.data(), _changedWorlds.size(),
+                                  _changedNormals.data());
+    for (size_t i = 0; i < _changedMatrices.size(); ++i)
+    {
+        _nodeMatrices[_changedMatrices[i]] =
+            NodeMatrix(_changedWorlds[i], _changedNormals[i]);
+    }
+    for (unsigned int node : GetChangedNodes())
+    {
+        if (_nodeMatrixIndices[node] != -1)
+        {
+            UpdateInstanceBounds(node);
+        }
+    }
+
+    //! Queued draws keep reading the current region, write the next one once
+    //! the GPU has finished the frames that read it.
+    _matrixFences[_currentMatrixRegion] =
+        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _currentMatrixRegion = (_currentMatrixRegion + 1) % kNumMatrixRegions;
+    GLsync& fence = _matrixFences[_currentMatrixRegion];
+    if (fence != nullptr)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                         GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    //! The region was written kNumMatrixRegions updates ago, it also misses
+    //! the matrices changed while the other regions were written.
+    auto* matrices = reinterpret_cast<NodeMatrix*>(
+        _mappedMatrices + _currentMatrixRegion * _matrixRegionSize);
+    for (size_t region = 0; region < kNumMatrixRegions; ++region)
+    {
+        if (region != _currentMatrixRegion)
+        {
+            for (unsigned int matrixIdx : _modifiedMatrices[region])
+            {
+                matrices[matrixIdx] = _nodeMatrices[matrixIdx];
+            }
+        }
+    }
+    for (unsigned int matrixIdx : _changedMatrices)
+    {
+        matrices[matrixIdx] = _nodeMatrices[matrixIdx];
+    }
+    std::swap(_modifiedMatrices[_currentMatrixRegion], _changedMatrices);
+}
+
+void Scene::UpdateMorphTargets(const std::vector<unsigned int>& nodes)
+{
+    if (_morphInstances.empty() || nodes.empty())
+    {
+        return;
+    }
+
+    auto scope = _debug.ScopeLabel("Morph Target Blending");
+    _morphShader->BindShaderProgram();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _morphVertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _morphDeltaBuffer);
+
+    //! Both lists are sorted by node, walk them together
+    auto instance = _morphInstances.begin();
+    for (unsigned int node : nodes)
+    {
+        while (instance != _morphInstances.end() && instance->node < node)
+        {
+            ++instance;
+        }
+        for (; instance != _morphInstances.end() && instance->node == node;
+             ++instance)
+        {
+            const auto& primMesh = _scenePrimMeshes[instance->primMesh];
+            glClearNamedBufferSubData(
+                _morphVertexBuffer, GL_RGBA32F,
+                instance->vertexBegin * sizeof(MorphVertex),
+                primMesh.vertexCount * sizeof(MorphVertex), GL_RGBA, GL_FLOAT,
+                nullptr);
+
+            const unsigned int weightBegin = _sceneNodes.weightOffsets[node];
+            const unsigned int numWeights =
+                std::min(_sceneNodes.weightOffsets[node + 1] - weightBegin,
+                         primMesh.morphTargetCount);
+            _morphShader->SendUniformVariable(
+                "vertexBegin", static_cast<int>(instance->vertexBegin));
+            for (unsigned int t = 0; t < numWeights; ++t)
+            {
+                const float weight = _sceneNodes.weights[weightBegin + t];
+                const auto& target =
+                    _sceneMorphTargets[primMesh.morphTargetBegin + t];
+                if (weight == 0.0f || target.deltaCount == 0)
+                {
+                    continue;
+                }
+
+                //! Targets of the primitive touch the same vertices
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+                _morphShader->SendUniformVariable(
+                    "deltaBegin", static_cast<int>(target.deltaBegin));
+                _morphShader->SendUniformVariable(
+                    "deltaCount", static_cast<int>(target.deltaCount));
+                _morphShader->SendUniformVariable("weight", weight);
+                glDispatchCompute(
+                    (target.deltaCount + kMorphGroupSize - 1) / kMorphGroupSize,
+                    1, 1);
+            }
+        }
+    }
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    Shader::UnbindShaderProgram();
+}
+
+void Scene::UpdateSkins(const std::vector<unsigned int>& skinNodes,
+                        const std::vector<unsigned int>& morphNodes)
+{
+    if (_skinInstances.empty() || (skinNodes.empty() && morphNodes.empty()))
+    {
+        return;
+    }
+
+    //! Joint matrices of the node are contiguous in the palette
+    auto instance = _skinInstances.begin();
+    for (unsigned int node : skinNodes)
+    {
+        while (instance != _skinInstances.end() && instance->node < node)
+        {
+            ++instance;
+        }
+        if (instance == _skinInstances.end() || instance->node != node)
+        {
+            continue;
+        }
+
+        const unsigned int jointCount =
+            _sceneSkins[_sceneNodes.skins[node]].jointCount;
+        _jointMatrices.resize(jointCount);
+        ComputeJointMatrices(node, _jointMatrices.data());
+        glNamedBufferSubData(
+            _jointMatrixBuffer,
+            static_cast<GLintptr>(instance->jointBase * sizeof(glm::mat4)),
+            static_cast<GLsizeiptr>(jointCount * sizeof(glm::mat4)),
+            _jointMatrices.data());
+    }
+
+    if (_skinningMode != SkinningMode::Compute)
+    {
+        return;
+    }
+
+    //! Skin again the nodes whose joints or morph targets are changed
+    _skinUpdateNodes.clear();
+    std::set_union(skinNodes.begin(), skinNodes.end(), morphNodes.begin(),
+                   morphNodes.end(), std::back_inserter(_skinUpdateNodes));
+
+    auto scope = _debug.ScopeLabel("Vertex Skinning");
+    _skinShader->BindShaderProgram();
+    if (_morphVertexBuffer != 0)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _morphVertexBuffer);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _jointMatrixBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, _skinVertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, _skinnedVertexBuffer);
+
+    instance = _skinInstances.begin();
+    for (unsigned int node : _skinUpdateNodes)
+    {
+        while (instance != _skinInstances.end() && instance->node < node)
+        {
+            ++instance;
+        }
+        for (; instance != _skinInstances.end() && instance->node == node;
+             ++instance)
+        {
+            const unsigned int vertexCount =
+                _scenePrimMeshes[instance->primMesh].vertexCount;
+            _skinShader->SendUniformVariable(
+                "restBegin", static_cast<int>(instance->restBegin));
+            _skinShader->SendUniformVariable(
+                "vertexBegin", static_cast<int>(instance->vertexBegin));
+            _skinShader->SendUniformVariable("vertexCount",
+                                             static_cast<int>(vertexCount));
+            _skinShader->SendUniformVariable(
+                "jointBase", static_cast<int>(instance->jointBase));
+            _skinShader->SendUniformVariable("morphBase",
+                                             instance->morphVertexBegin);
+            glDispatchCompute((vertexCount + kSkinGroupSize - 1) /
+                                  kSkinGroupSize,
+                              1, 1);
+        }
+    }
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    Shader::UnbindShaderProgram();
+}
+
+void Scene::CleanUp()
+{
+    for (GLuint64 handle : _textureHandles)
+    {
+        glMakeTextureHandleNonResidentARB(handle);
+    }
+    _textureHandles.clear();
+    glDeleteTextures(static_cast<GLsizei>(_textures.size()), _textures.data());
+    _textures.clear();
+    glDeleteTextures(static_cast<GLsizei>(_textureArrays.size()),
+                     _textureArrays.data());
+    _textureArrays.clear();
+    _textureSets.clear();
+    _materialTextureSets.clear();
+
+    for (auto& fence : _matrixFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    _matrixFences.clear();
+    if (_mappedMatrices != nullptr)
+    {
+        glUnmapNamedBuffer(_matrixBuffer);
+        _mappedMatrices = nullptr;
+    }
+    glDeleteBuffers(1, &_matrixBuffer);
+    _matrixBuffer = 0;
 
     glDeleteBuffers(1, &_materialBuffer);
     _materialBuffer = 0;
 
+    glDeleteBuffers(1, &_instanceBuffer);
+    _instanceBuffer = 0;
+    glDeleteBuffers(1, &_commandBuffer);
+    _commandBuffer = 0;
+    glDeleteBuffers(1, &_drawDataBuffer);
+    _drawDataBuffer = 0;
+    glDeleteBuffers(1, &_drawSlotBuffer);
+    _drawSlotBuffer = 0;
+    _drawBatches.clear();
+    _batchInstances.clear();
+    _drawCommands.clear();
+    _commandTextureSets.clear();
+    _drawInstances.clear();
+    _commandGroups.clear();
+    _drawGroups.clear();
+    _blendCommandBegin = 0;
+    _blendInstanceBegin = 0;
+    _renderQueue.Clear();
+    _queueCommands.clear();
+    _queueSlots.clear();
+    _nodeBounds.clear();
+    _instanceBounds.Resize(0);
+    _instanceVisibility.clear();
+    _renderStats = RenderStats();
+
+    GLuint cullBuffers[] = { _cullInstanceBuffer, _cullBoundsBuffer,
+                             _cullBatchBuffer,    _cullCommandBuffer,
+                             _drawCounterBuffer,  _instanceLevelBuffer,
+                             _drawCountBuffer };
+    glDeleteBuffers(static_cast<GLsizei>(std::size(cullBuffers)), cullBuffers);
+    _cullInstanceBuffer = _cullBoundsBuffer = _cullBatchBuffer = 0;
+    _cullCommandBuffer = _drawCounterBuffer = _instanceLevelBuffer = 0;
+    _drawCountBuffer = 0;
+    glDeleteTextures(1, &_depthPyramid);
+    _depthPyramid = 0;
+    _depthPyramidWidth = _depthPyramidHeight = _depthPyramidLevels = 0;
+    _occlusionCulling = false;
+    for (auto* shader : { &_cullShader, &_buildDrawsShader, &_scatterShader,
+                          &_depthPyramidShader })
+    {
+        if (*shader)
+        {
+            (*shader)->CleanUp();
+            shader->reset();
+        }
+    }
+
+    glDeleteBuffers(1, &_morphDeltaBuffer);
+    _morphDeltaBuffer = 0;
+    glDeleteBuffers(1, &_morphVertexBuffer);
+    _morphVertexBuffer = 0;
+    _morphInstances.clear();
+    _morphInstanceIndices.clear();
+    if (_morphShader)
+    {
+        _morphShader->CleanUp();
+        _morphShader.reset();
+    }
+
+    glDeleteBuffers(1, &_jointMatrixBuffer);
+    _jointMatrixBuffer = 0;
+    glDeleteBuffers(1, &_skinVertexBuffer);
+    _skinVertexBuffer = 0;
+    glDeleteBuffers(1, &_skinnedVertexBuffer);
+    _skinnedVertexBuffer = 0;
+    _skinInstances.clear();
+    _skinInstanceIndices.clear();
+    if (_skinShader)
+    {
+        _skinShader->CleanUp();
+        _skinShader.reset();
+    }
+
     glDeleteBuffers(static_cast<GLsizei>(_buffers.size()), _buffers.data());
     _buffers.clear();
 
@@ -1,6 +1,13 @@
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <Common/HashUtils.hpp>
+#include <Common/MappedFile.hpp>
+#include <Common/ShaderSourceCache.hpp>
 #include <GL3/DebugUtils.hpp>
 #include <GL3/Shader.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/mat4x4.hpp>
@@ -9,53 +16,62 @@
 #include <iostream>
 #include <vector>
 
-std::string GetPathDirectory(const std::string& path)
+namespace GL3
+{
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+//! Header of the cached program binary, followed by the binary itself
+struct ProgramBinaryHeader
 {
-    size_t pos = path.find_last_of('/');
-    return path.substr(0, pos + 1);
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t key;
+    std::uint32_t format;
+    std::uint32_t length;
+};
+
+constexpr char kProgramBinaryMagic[4] = { 'R', 'F', 'P', 'B' };
+constexpr std::uint32_t kProgramBinaryVersion = 1;
+
+//! Let the driver compile on its own threads, queried once as the first
+//! shader is submitted with the current context
+bool IsParallelCompileSupported()
+{
+    static const bool supported = []() {
+        if (glfwExtensionSupported("GL_KHR_parallel_shader_compile") !=
+            GLFW_TRUE)
+        {
+            return false;
+        }
+        //! 0xFFFFFFFF leaves the number of threads to the driver
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        return true;
+    }();
+    return supported;
 }
 
-std::string PreprocessShaderInclude(const std::string& path,
-                                    std::string includePrefix = "#include")
+std::string& GetBinaryCacheDirectory()
 {
-    includePrefix += ' ';
-
-    //! Load shader source file.
-    std::ifstream file(path);
-
-    if (!file.is_open())
-    {
-        std::cerr << "Open shader source file failed" << path << std::endl;
-        GL3::DebugUtils::PrintStack();
-    }
+    static std::string directory;
+    return directory;
+}
 
-    std::string fullSourceCode;
-    std::string temp;
-    while (std::getline(file, temp))
+//! Hash of the strings identifying the driver, binaries are not portable
+//! between drivers or their versions
+std::uint64_t GetDriverHash()
+{
+    std::string driver;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
     {
-        if (temp.find(includePrefix) !=
-            std::string::npos)  //! temp string contain "#include "
-        {
-            temp.erase(0, includePrefix.length());
-
-            std::string filePath = GetPathDirectory(path);
-            filePath += temp;
-            std::string includeSrc = PreprocessShaderInclude(filePath);
-
-            fullSourceCode += includeSrc;
-            continue;
-        }
-
-        fullSourceCode += temp + '\n';
+        const auto* value = glGetString(name);
+        driver += value != nullptr ? reinterpret_cast<const char*>(value) : "";
+        driver += '\n';
     }
-
-    file.close();
-    return fullSourceCode;
+    return Common::HashUtils::HashBytes(driver.data(), driver.size());
 }
+}  // namespace
 
-namespace GL3
-{
-Shader::Shader() : _programID(0)
+Shader::Shader() : _binaryKey(0), _programID(0)
 {
     //! Do nothing
 }
@@ -65,66 +81,308 @@ Shader::~Shader()
     CleanUp();
 }
 
-bool Shader::Initialize(const std::unordered_map<GLenum, std::string>& sources)
+bool Shader::Initialize(const std::unordered_map<GLenum, std::string>& sources,
+                        const Defines& defines)
+{
+    return InitializeAsync(sources, defines) && Wait();
+}
+
+bool Shader::InitializeAsync(
+    const std::unordered_map<GLenum, std::string>& sources,
+    const Defines& defines)
 {
-    std::vector<GLuint> compiledShaders;
+    CleanUp();
+    _sourcePaths = sources;
+    _defines = defines;
+
+    //! Stages are sorted by type, so the cache key does not depend on the
+    //! iteration order of the map
+    auto& sourceCache = Common::ShaderSourceCache::GetGlobalCache();
+    ShaderStages stages;
     for (const auto& sourcePair : sources)
     {
-        const GLenum type = sourcePair.first;
-        const std::string& path = sourcePair.second;
-
         //! Load shader file contents handled with #include.
-        const std::string contents = PreprocessShaderInclude(path);
-        const char* source = contents.c_str();
+        stages.emplace_back(sourcePair.first,
+                            sourceCache.GetSource(sourcePair.second, defines));
+    }
+    std::sort(stages.begin(), stages.end());
 
-        GLuint shader = glCreateShader(type);
-        glShaderSource(shader, 1, &source, nullptr);
-        glCompileShader(shader);
+    const std::string& directory = GetBinaryCacheDirectory();
+    if (directory.empty())
+    {
+        SubmitProgram(stages, false);
+        return true;
+    }
 
-        int success;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-        if (success == 0)
+    std::uint64_t key = GetDriverHash();
+    for (const auto& [type, contents] : stages)
+    {
+        key = Common::HashUtils::HashBytes(&type, sizeof(type), key);
+        key = Common::HashUtils::HashBytes(contents.data(), contents.size(),
+                                           key);
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin",
+                  static_cast<unsigned long long>(key));
+    std::string path = directory;
+    if (path.back() != '/' && path.back() != '\\')
+    {
+        path.push_back('/');
+    }
+    path += name;
+
+    if (LoadProgramBinary(path, key))
+    {
+        return true;
+    }
+    SubmitProgram(stages, true);
+    _binaryPath = std::move(path);
+    _binaryKey = key;
+    return true;
+}
+
+bool Shader::IsReady() const
+{
+    if (_pendingShaders.empty() || !IsParallelCompileSupported())
+    {
+        return true;
+    }
+
+    GLint completed = GL_FALSE;
+    glGetProgramiv(_programID, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+bool Shader::Wait()
+{
+    if (_pendingShaders.empty())
+    {
+        return _programID != 0;
+    }
+
+    //! Status queries block until the driver finishes the compilation
+    bool success = true;
+    for (GLuint shader : _pendingShaders)
+    {
+        int compiled;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (compiled == 0 && success)
         {
             int length;
             glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
             std::vector<GLchar> logs(length);
             glGetShaderInfoLog(shader, length, nullptr, logs.data());
-            std::clog << "[Shader:Initialize] Shader Compile Error Log"
-                      << std::endl;
+            std::clog << "[Shader:Wait] Shader Compile Error Log" << std::endl;
             std::clog << logs.data() << std::endl;
             DebugUtils::PrintStack();
-            return false;
+            success = false;
         }
+        glDetachShader(_programID, shader);
+        glDeleteShader(shader);
+    }
+    _pendingShaders.clear();
 
-        compiledShaders.push_back(shader);
+    int linked;
+    glGetProgramiv(_programID, GL_LINK_STATUS, &linked);
+    if (success && linked == 0)
+    {
+        int length;
+        glGetProgramiv(_programID, GL_INFO_LOG_LENGTH, &length);
+        std::vector<GLchar> logs(length);
+        glGetProgramInfoLog(_programID, length, nullptr, logs.data());
+        std::clog << "[Shader:Wait] Program Linking Error Log" << std::endl;
+        std::clog << logs.data() << std::endl;
+        DebugUtils::PrintStack();
+        success = false;
     }
 
+    if (!success)
+    {
+        _binaryPath.clear();
+        CleanUp();
+        return false;
+    }
+
+    if (!_binaryPath.empty())
+    {
+        SaveProgramBinary(_binaryPath, _binaryKey);
+        _binaryPath.clear();
+    }
+    return true;
+}
+
+bool Shader::Reload()
+{
+    const auto& sourceCache = Common::ShaderSourceCache::GetGlobalCache();
+    const bool outdated = std::any_of(
+        _sourcePaths.begin(), _sourcePaths.end(), [&](const auto& sourcePair) {
+            return !sourceCache.Contains(sourcePair.second, _defines);
+        });
+    if (!outdated)
+    {
+        return false;
+    }
+
+    const auto sources = _sourcePaths;
+    const auto defines = _defines;
+    return InitializeAsync(sources, defines);
+}
+
+void Shader::SetVariantDefines(std::vector<std::string> featureDefines)
+{
+    _variantDefines = std::move(featureDefines);
+    _variants.clear();
+}
+
+Shader* Shader::GetVariant(std::uint32_t features)
+{
+    if (_variantDefines.empty() || _programID == 0)
+    {
+        return this;
+    }
+
+    auto iter = _variants.find(features);
+    if (iter == _variants.end())
+    {
+        Defines defines = _defines;
+        defines.emplace_back("SHADER_VARIANT", "1");
+        for (size_t bit = 0; bit < _variantDefines.size(); ++bit)
+        {
+            if ((features >> bit) & 1u)
+            {
+                defines.emplace_back(_variantDefines[bit], "1");
+            }
+        }
+
+        auto variant = std::make_unique<Shader>();
+        variant->InitializeAsync(_sourcePaths, defines);
+        iter = _variants.emplace(features, std::move(variant)).first;
+    }
+
+    //! Draws keep using this program while the variant is compiled
+    Shader& variant = *iter->second;
+    if (!variant._pendingShaders.empty())
+    {
+        if (!variant.IsReady())
+        {
+            return this;
+        }
+        variant.Wait();
+    }
+    return variant._programID != 0 ? &variant : this;
+}
+
+void Shader::SetBinaryCacheDirectory(const std::string& directory)
+{
+    GetBinaryCacheDirectory() = directory;
+}
+
+void Shader::SubmitProgram(const ShaderStages& stages, bool retrievable)
+{
+    //! Nothing is queried here, so the driver compiles and links on its
+    //! threads until Wait asks for the results
+    IsParallelCompileSupported();
     _programID = glCreateProgram();
-    for (GLuint shader : compiledShaders)
+    if (retrievable)
     {
+        glProgramParameteri(_programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                            GL_TRUE);
+    }
+    for (const auto& [type, contents] : stages)
+    {
+        const char* source = contents.c_str();
+
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
         glAttachShader(_programID, shader);
-        glDeleteShader(shader);
+        _pendingShaders.push_back(shader);
     }
     glLinkProgram(_programID);
+}
+
+bool Shader::LoadProgramBinary(const std::string& path, std::uint64_t key)
+{
+    Common::MappedFile file;
+    if (!file.Open(path) || file.GetSize() < sizeof(ProgramBinaryHeader))
+    {
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    if (std::memcmp(header.magic, kProgramBinaryMagic,
+                    sizeof(kProgramBinaryMagic)) != 0 ||
+        header.version != kProgramBinaryVersion || header.key != key ||
+        file.GetSize() != sizeof(header) + header.length)
+    {
+        return false;
+    }
 
+    //! Driver rejects the binary it can not use, such as the binary of the
+    //! same driver version with different settings
+    _programID = glCreateProgram();
+    glProgramBinary(_programID, header.format,
+                    file.GetData() + sizeof(header),
+                    static_cast<GLsizei>(header.length));
     int success;
     glGetProgramiv(_programID, GL_LINK_STATUS, &success);
     if (success == 0)
     {
-        int length;
-        glGetProgramiv(_programID, GL_INFO_LOG_LENGTH, &length);
-        std::vector<GLchar> logs(length);
-        glGetProgramInfoLog(_programID, length, nullptr, logs.data());
-        std::clog << "[Shader:Initialize] Program Linking Error Log"
-                  << std::endl;
-        std::clog << logs.data() << std::endl;
-        DebugUtils::PrintStack();
+        glDeleteProgram(_programID);
+        _programID = 0;
         return false;
     }
-
     return true;
 }
 
+void Shader::SaveProgramBinary(const std::string& path,
+                               std::uint64_t key) const
+{
+    GLint length = 0;
+    glGetProgramiv(_programID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    ProgramBinaryHeader header{};
+    std::memcpy(header.magic, kProgramBinaryMagic,
+                sizeof(kProgramBinaryMagic));
+    header.version = kProgramBinaryVersion;
+    header.key = key;
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(_programID, length, &length, &format, binary.data());
+    header.format = format;
+    header.length = static_cast<std::uint32_t>(length);
+
+    //! Written to the temporary file first, so the concurrent processes
+    //! never read a partial binary
+    const std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "[Shader:SaveProgramBinary] Failed to write " << path
+                  << std::endl;
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), length);
+    const bool success = file.good();
+    file.close();
+
+    if (!success)
+    {
+        std::remove(tempPath.c_str());
+        return;
+    }
+    std::remove(path.c_str());
+    std::rename(tempPath.c_str(), path.c_str());
+}
+
 void Shader::BindShaderProgram() const
 {
     glUseProgram(this->_programID);
@@ -183,6 +441,13 @@ GLint Shader::GetUniformLocation(const std::string& name)
 
 void Shader::CleanUp()
 {
+    for (GLuint shader : _pendingShaders)
+    {
+        glDeleteShader(shader);
+    }
+    _pendingShaders.clear();
+    _uniformCache.clear();
+    _variants.clear();
     if (_programID != 0)
     {
         glDeleteProgram(_programID);
@@ -21,6 +21,23 @@ SkyDome::~SkyDome()
 
 bool SkyDome::Initialize(const std::string& envPath)
 {
+    //! Filter shaders are compiled while the environment map is loaded
+    Shader brdfShader;
+    Shader diffuseShader;
+    Shader glossyShader;
+    brdfShader.InitializeAsync(
+        { { GL_VERTEX_SHADER, RESOURCES_DIR "shaders/integrate_brdf.vert" },
+          { GL_FRAGMENT_SHADER,
+            RESOURCES_DIR "shaders/integrate_brdf.frag" } });
+    diffuseShader.InitializeAsync(
+        { { GL_VERTEX_SHADER, RESOURCES_DIR "shaders/filtercube.vert" },
+          { GL_FRAGMENT_SHADER,
+            RESOURCES_DIR "shaders/prefilter_diffuse.frag" } });
+    glossyShader.InitializeAsync(
+        { { GL_VERTEX_SHADER, RESOURCES_DIR "shaders/filtercube.vert" },
+          { GL_FRAGMENT_SHADER,
+            RESOURCES_DIR "shaders/prefilter_glossy.frag" } });
+
     std::cout << "Loading Environment Map : " << envPath << '\n';
     int width;
     int height;
@@ -69,9 +86,9 @@ bool SkyDome::Initialize(const std::string& envPath)
         CreateCube();
     }
 
-    IntegrateBRDF(512);
-    PrefilterDiffuse(128);
-    PrefilterGlossy(512);
+    IntegrateBRDF(512, brdfShader);
+    PrefilterDiffuse(128, diffuseShader);
+    PrefilterGlossy(512, glossyShader);
 
     DebugUtils::SetObjectName(GL_TEXTURE, _textureSet.hdrTexture, "SkyHdr");
     DebugUtils::SetObjectName(GL_TEXTURE, _textureSet.accelTexture, "SkyImpSamp");
@@ -218,7 +235,7 @@ void SkyDome::RenderToCube(GLuint fbo, GLuint texture, Shader* shader,
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void SkyDome::IntegrateBRDF(unsigned int dim)
+void SkyDome::IntegrateBRDF(unsigned int dim, Shader& shader)
 {
     auto timerStart = std::chrono::high_resolution_clock::now();
 
@@ -246,12 +263,8 @@ void SkyDome::IntegrateBRDF(unsigned int dim)
         return;
     }
 
-    //! Create shader
-    Shader shader;
-    if (!shader.Initialize(
-            { { GL_VERTEX_SHADER, RESOURCES_DIR "shaders/integrate_brdf.vert" },
-              { GL_FRAGMENT_SHADER,
-                RESOURCES_DIR "shaders/integrate_brdf.frag" } }))
+    //! Wait for the submitted shader
+    if (!shader.Wait())
     {
         std::cerr << "[SkyDome:IntegradeBRDF] Failed to compile shader\n";
         DebugUtils::PrintStack();
@@ -275,7 +288,7 @@ void SkyDome::IntegrateBRDF(unsigned int dim)
     std::cout << "Intergrate BRDF LUT took " << elapsed << " (ms)\n";
 };
 
-void SkyDome::PrefilterDiffuse(unsigned int dim)
+void SkyDome::PrefilterDiffuse(unsigned int dim, Shader& shader)
 {
     auto timerStart = std::chrono::high_resolution_clock::now();
     const unsigned int numMips =
@@ -299,12 +312,8 @@ void SkyDome::PrefilterDiffuse(unsigned int dim)
     GLuint fbo;
     glCreateFramebuffers(1, &fbo);
 
-    //! Create shader
-    Shader shader;
-    if (!shader.Initialize(
-            { { GL_VERTEX_SHADER, RESOURCES_DIR "shaders/filtercube.vert" },
-              { GL_FRAGMENT_SHADER,
-                RESOURCES_DIR "shaders/prefilter_diffuse.frag" } }))
+    //! Wait for the submitted shader
+    if (!shader.Wait())
     {
         std::cerr << "[SkyDome:PrefilterDiffuse] Failed to compile shader\n";
         DebugUtils::PrintStack();
@@ -324,7 +333,7 @@ void SkyDome::PrefilterDiffuse(unsigned int dim)
     std::cout << "Prefilter Diffuse took " << elapsed << " (ms)\n";
 }
 
-void SkyDome::PrefilterGlossy(unsigned int dim)
+void SkyDome::PrefilterGlossy(unsigned int dim, Shader& shader)
 {
     auto timerStart = std::chrono::high_resolution_clock::now();
     const unsigned int numMips =
@@ -348,12 +357,8 @@ void SkyDome::PrefilterGlossy(unsigned int dim)
     GLuint fbo;
     glCreateFramebuffers(1, &fbo);
 
-    //! Create shader
-    Shader shader;
-    if (!shader.Initialize(
-            { { GL_VERTEX_SHADER, RESOURCES_DIR "shaders/filtercube.vert" },
-              { GL_FRAGMENT_SHADER,
-                RESOURCES_DIR "shaders/prefilter_glossy.frag" } }))
+    //! Wait for the submitted shader
+    if (!shader.Wait())
     {
         std::cerr << "[SkyDome:PrefilterGlossy] Failed to compile shader\n";
         DebugUtils::PrintStack();
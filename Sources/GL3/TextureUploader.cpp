@@ -0,0 +1,101 @@
+#include <glad/glad.h>
+#include <GL3/DebugUtils.hpp>
+#include <GL3/TextureUploader.hpp>
+#include <cstring>
+#include <iostream>
+
+namespace GL3
+{
+TextureUploader::~TextureUploader()
+{
+    CleanUp();
+}
+
+bool TextureUploader::Initialize(size_t segmentSize, size_t numSegments)
+{
+    const GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const size_t bufferSize = segmentSize * numSegments;
+
+    glCreateBuffers(1, &_buffer);
+    glNamedBufferStorage(_buffer, static_cast<GLsizeiptr>(bufferSize), nullptr,
+                         flags);
+    _mapped = static_cast<unsigned char*>(glMapNamedBufferRange(
+        _buffer, 0, static_cast<GLsizeiptr>(bufferSize), flags));
+    if (_mapped == nullptr)
+    {
+        DebugUtils::PrintStack();
+        std::cerr << "[TextureUploader:Initialize] Failed to map pixel "
+                     "unpack buffer"
+                  << std::endl;
+        CleanUp();
+        return false;
+    }
+    DebugUtils::SetObjectName(GL_BUFFER, _buffer, "Texture Upload Buffer");
+
+    _segmentSize = segmentSize;
+    _currentSegment = 0;
+    _fences.assign(numSegments, nullptr);
+    return true;
+}
+
+void TextureUploader::Upload(GLuint texture, GLsizei width, GLsizei height,
+                             GLenum format, GLenum type, const void* data,
+                             size_t size)
+{
+    //! Images not fitting in the segment are copied by the driver directly.
+    if (_mapped == nullptr || size > _segmentSize)
+    {
+        glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type,
+                            data);
+        return;
+    }
+
+    //! Wait until the previous transfer from this segment is finished.
+    GLsync& fence = _fences[_currentSegment];
+    if (fence != nullptr)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                         GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const size_t offset = _currentSegment * _segmentSize;
+    std::memcpy(_mapped + offset, data, size);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+    glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type,
+                        reinterpret_cast<const void*>(offset));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _currentSegment = (_currentSegment + 1) % _fences.size();
+}
+
+void TextureUploader::CleanUp()
+{
+    for (auto& fence : _fences)
+    {
+        if (fence != nullptr)
+        {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                             GL_TIMEOUT_IGNORED);
+            glDeleteSync(fence);
+        }
+    }
+    _fences.clear();
+
+    if (_buffer != 0)
+    {
+        if (_mapped != nullptr)
+        {
+            glUnmapNamedBuffer(_buffer);
+            _mapped = nullptr;
+        }
+        glDeleteBuffers(1, &_buffer);
+        _buffer = 0;
+    }
+}
+
+};  // namespace GL3
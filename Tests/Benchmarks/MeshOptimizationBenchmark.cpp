@@ -0,0 +1,107 @@
+#include <Common/GLTFScene.hpp>
+#include <Common/MeshUtils.hpp>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+/**
+ * @brief GLTFScene exposing the loaded primitives for measurement.
+ */
+class BenchmarkScene : public Common::GLTFScene
+{
+ public:
+    //! Returns triangle weighted ACMR of all primitives in the scene
+    double CalculateSceneACMR() const
+    {
+        return CalculateACMR(_indices);
+    }
+
+    //! Run the optimization passes on the copy of the index buffer and
+    //! returns the triangle weighted ACMR of the result
+    double OptimizeIndices(double& milliseconds) const
+    {
+        std::vector<unsigned int> indices = _indices;
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& primMesh : _scenePrimMeshes)
+        {
+            unsigned int* primIndices = indices.data() + primMesh.firstIndex;
+            Common::MeshUtils::OptimizeVertexCache(
+                primIndices, primMesh.indexCount, primMesh.vertexCount);
+            Common::MeshUtils::OptimizeOverdraw(
+                primIndices, primMesh.indexCount,
+                _positions.data() + primMesh.vertexOffset,
+                primMesh.vertexCount);
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        milliseconds =
+            std::chrono::duration<double, std::milli>(end - start).count();
+        return CalculateACMR(indices);
+    }
+
+    size_t GetNumTriangles() const
+    {
+        return _indices.size() / 3;
+    }
+
+ private:
+    double CalculateACMR(const std::vector<unsigned int>& indices) const
+    {
+        double sumACMR = 0.0, numTriangles = 0.0;
+        for (const auto& primMesh : _scenePrimMeshes)
+        {
+            const double triangles = primMesh.indexCount / 3;
+            sumACMR += Common::MeshUtils::CalculateACMR(
+                           indices.data() + primMesh.firstIndex,
+                           primMesh.indexCount, primMesh.vertexCount) *
+                       triangles;
+            numTriangles += triangles;
+        }
+        return numTriangles > 0.0 ? sumACMR / numTriangles : 0.0;
+    }
+};
+
+}  // namespace
+
+int main()
+{
+    constexpr auto kFormat =
+        Common::VertexFormat::Position3Normal3TexCoord2Color4Tangent4;
+    const char* scenes[] = {
+        RESOURCES_DIR "scenes/FlightHelmet/FlightHelmet.gltf",
+        RESOURCES_DIR "scenes/FlightHelmet/BoxVertexColors.gltf",
+        RESOURCES_DIR "scenes/AnimatedCube/AnimatedCube.gltf",
+    };
+
+    int result = 0;
+    for (const char* path : scenes)
+    {
+        BenchmarkScene original, optimized;
+        optimized.SetMeshOptimization(true);
+        if (!original.Initialize(path, kFormat) ||
+            !optimized.Initialize(path, kFormat))
+        {
+            std::fprintf(stderr, "Failed to load %s\n", path);
+            result = 1;
+            continue;
+        }
+
+        double milliseconds = 0.0;
+        const double before = original.CalculateSceneACMR();
+        const double after = original.OptimizeIndices(milliseconds);
+        const double loaded = optimized.CalculateSceneACMR();
+        std::printf(
+            "%s\n  triangles %zu, ACMR %.3f -> %.3f (loaded %.3f), %.2f ms\n",
+            path, original.GetNumTriangles(), before, after, loaded,
+            milliseconds);
+
+        //! Optimization must never make the cache behavior noticeably worse
+        if (loaded > before * 1.05 + 1e-3)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
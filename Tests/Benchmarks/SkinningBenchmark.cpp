@@ -0,0 +1,133 @@
+#include <Common/Skinning.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace  //! Anonymous namespace for file-specific helper functions
+{
+constexpr size_t kNumVertices = 1 << 18;
+constexpr size_t kNumJoints = 64;
+constexpr int kNumIterations = 20;
+
+//! Skinned positions and normals computed in double precision
+void SkinVerticesReference(const std::vector<glm::vec3>& positions,
+                           const std::vector<glm::vec3>& normals,
+                           const std::vector<Common::SkinVertex>& skinVertices,
+                           const std::vector<glm::mat4>& jointMatrices,
+                           std::vector<glm::dvec3>& skinnedPositions,
+                           std::vector<glm::dvec3>& skinnedNormals)
+{
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        double matrix[4][4] = {};
+        for (int k = 0; k < 4; ++k)
+        {
+            const glm::mat4& joint = jointMatrices[skinVertices[i].joints[k]];
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int r = 0; r < 4; ++r)
+                {
+                    matrix[c][r] += static_cast<double>(joint[c][r]) *
+                                    skinVertices[i].weights[k];
+                }
+            }
+        }
+
+        const glm::vec3& p = positions[i];
+        const glm::vec3& n = normals[i];
+        for (int r = 0; r < 3; ++r)
+        {
+            skinnedPositions[i][r] = matrix[0][r] * p.x + matrix[1][r] * p.y +
+                                     matrix[2][r] * p.z + matrix[3][r];
+            skinnedNormals[i][r] = matrix[0][r] * n.x + matrix[1][r] * n.y +
+                                   matrix[2][r] * n.z;
+        }
+    }
+}
+
+//! Returns the largest component difference relative to the magnitude
+double MaxError(const std::vector<glm::vec3>& values,
+                const std::vector<glm::dvec3>& references)
+{
+    double maxError = 0.0;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const double error = std::abs(values[i][c] - references[i][c]) /
+                                 std::max(1.0, std::abs(references[i][c]));
+            maxError = std::max(maxError, error);
+        }
+    }
+    return maxError;
+}
+}  // namespace
+
+int main()
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::uniform_int_distribution<unsigned int> joint(0, kNumJoints - 1);
+
+    //! Random affine joint matrices
+    std::vector<glm::mat4> jointMatrices(kNumJoints);
+    for (auto& matrix : jointMatrices)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 3; ++r)
+            {
+                matrix[c][r] = value(rng);
+            }
+            matrix[c][3] = c == 3 ? 1.0f : 0.0f;
+        }
+    }
+
+    std::vector<glm::vec3> positions(kNumVertices), normals(kNumVertices);
+    std::vector<Common::SkinVertex> skinVertices(kNumVertices);
+    for (size_t i = 0; i < kNumVertices; ++i)
+    {
+        positions[i] = glm::vec3(value(rng), value(rng), value(rng)) * 10.0f;
+        normals[i] = glm::vec3(value(rng), value(rng), value(rng));
+
+        glm::vec4 weights(std::abs(value(rng)), std::abs(value(rng)),
+                          std::abs(value(rng)), std::abs(value(rng)));
+        weights /= weights.x + weights.y + weights.z + weights.w;
+        skinVertices[i].joints =
+            glm::uvec4(joint(rng), joint(rng), joint(rng), joint(rng));
+        skinVertices[i].weights = weights;
+    }
+
+    std::vector<glm::vec3> skinnedPositions(kNumVertices);
+    std::vector<glm::vec3> skinnedNormals(kNumVertices);
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < kNumIterations; ++iteration)
+    {
+        Common::SkinVertices(positions.data(), normals.data(),
+                             skinVertices.data(), jointMatrices.data(),
+                             kNumVertices, skinnedPositions.data(),
+                             skinnedNormals.data());
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double milliseconds =
+        std::chrono::duration<double, std::milli>(end - start).count() /
+        kNumIterations;
+
+    std::vector<glm::dvec3> referencePositions(kNumVertices);
+    std::vector<glm::dvec3> referenceNormals(kNumVertices);
+    SkinVerticesReference(positions, normals, skinVertices, jointMatrices,
+                          referencePositions, referenceNormals);
+    const double positionError = MaxError(skinnedPositions, referencePositions);
+    const double normalError = MaxError(skinnedNormals, referenceNormals);
+
+    std::printf(
+        "Skinning %zu vertices with %zu joints: %.3f ms (%.1f Mvertices/s)\n"
+        "  max relative error position %.3g, normal %.3g\n",
+        kNumVertices, kNumJoints, milliseconds,
+        kNumVertices / milliseconds * 1e-3, positionError, normalError);
+
+    return positionError < 1e-4 && normalError < 1e-4 ? 0 : 1;
+}
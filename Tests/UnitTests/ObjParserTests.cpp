@@ -0,0 +1,228 @@
+#include <doctest/doctest.h>
+
+#include <Common/MeshUtils.hpp>
+#include <Common/ObjParser.hpp>
+#include <tiny_obj_loader.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Common;
+
+namespace
+{
+//! Parse the text with the native parser
+std::vector<PackedVertex> ParseNative(const std::string& text)
+{
+    std::vector<PackedVertex> corners;
+    REQUIRE(ObjParser::Parse(text.data(), text.size(), corners));
+    return corners;
+}
+
+//! Expand the corners of the text loaded by tinyobjloader the same way as
+//! the fallback path of AssetLoader::LoadObjFile
+std::vector<PackedVertex> ParseTinyObj(const std::string& text)
+{
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    std::istringstream stream(text);
+    REQUIRE(tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
+                             &stream));
+
+    std::vector<PackedVertex> corners;
+    for (const auto& shape : shapes)
+    {
+        for (size_t face = 0; face + 2 < shape.mesh.indices.size(); face += 3)
+        {
+            const tinyobj::index_t* indices = &shape.mesh.indices[face];
+            bool hasNormal = true;
+            bool hasTexCoord = true;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                hasNormal &= indices[k].normal_index >= 0;
+                hasTexCoord &= indices[k].texcoord_index >= 0;
+            }
+
+            PackedVertex vertices[3];
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const tinyobj::index_t& index = indices[k];
+                vertices[k].position =
+                    glm::vec3(attrib.vertices[3 * index.vertex_index + 0],
+                              attrib.vertices[3 * index.vertex_index + 1],
+                              attrib.vertices[3 * index.vertex_index + 2]);
+                if (hasNormal)
+                {
+                    vertices[k].normal =
+                        glm::vec3(attrib.normals[3 * index.normal_index + 0],
+                                  attrib.normals[3 * index.normal_index + 1],
+                                  attrib.normals[3 * index.normal_index + 2]);
+                }
+                if (hasTexCoord)
+                {
+                    vertices[k].texCoord = glm::vec2(
+                        attrib.texcoords[2 * index.texcoord_index + 0],
+                        1.0f - attrib.texcoords[2 * index.texcoord_index + 1]);
+                }
+            }
+            if (!hasNormal)
+            {
+                const glm::vec3 faceNormal = MeshUtils::CalculateFaceNormal(
+                    vertices[0].position, vertices[1].position,
+                    vertices[2].position);
+                for (auto& vertex : vertices)
+                {
+                    vertex.normal = faceNormal;
+                }
+            }
+            corners.insert(corners.end(), vertices, vertices + 3);
+        }
+    }
+    return corners;
+}
+
+void CheckCorners(const std::vector<PackedVertex>& actual,
+                  const std::vector<PackedVertex>& expected)
+{
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size(); ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            CHECK(actual[i].position[k] ==
+                  doctest::Approx(expected[i].position[k]));
+            CHECK(actual[i].normal[k] ==
+                  doctest::Approx(expected[i].normal[k]));
+        }
+        for (int k = 0; k < 2; ++k)
+        {
+            CHECK(actual[i].texCoord[k] ==
+                  doctest::Approx(expected[i].texCoord[k]));
+        }
+    }
+}
+}  // namespace
+
+TEST_CASE("[ObjParser] - Triangles with all attributes")
+{
+    const std::string text =
+        "# triangle\n"
+        "v 0.0 0.0 0.0\n"
+        "v 1.0 0.0 0.0\n"
+        "v 0.0 1.0 0.0\n"
+        "vt 0.0 0.0\n"
+        "vt 1.0 0.25\n"
+        "vt 0.0 1.0\n"
+        "vn 0.0 0.0 1.0\n"
+        "f 1/1/1 2/2/1 3/3/1\n";
+
+    CheckCorners(ParseNative(text), ParseTinyObj(text));
+}
+
+TEST_CASE("[ObjParser] - Negative indices")
+{
+    const std::string text =
+        "v 0.0 0.0 0.0\n"
+        "v 1.0 0.0 0.0\n"
+        "v 0.0 1.0 0.0\n"
+        "vn 0.0 0.0 1.0\n"
+        "f -3//-1 -2//-1 -1//-1\n"
+        "v 1.0 1.0 0.0\n"
+        "f 2 -1 3\n";
+
+    const std::vector<PackedVertex> corners = ParseNative(text);
+    REQUIRE(corners.size() == 6);
+    CHECK(corners[3].position.x == doctest::Approx(1.0f));
+    CHECK(corners[4].position.y == doctest::Approx(1.0f));
+    CheckCorners(corners, ParseTinyObj(text));
+}
+
+TEST_CASE("[ObjParser] - Forward indices")
+{
+    const std::string text =
+        "f 1 2 3\n"
+        "v 0.0 0.0 0.0\n"
+        "v 2.0 0.0 0.0\n"
+        "v 0.0 2.0 0.0\n";
+
+    CheckCorners(ParseNative(text), ParseTinyObj(text));
+}
+
+TEST_CASE("[ObjParser] - Optional second texture coordinate")
+{
+    const std::string text =
+        "v 0.0 0.0 0.0\n"
+        "v 1.0 0.0 0.0\n"
+        "v 0.0 1.0 0.0\n"
+        "vt 0.5\n"
+        "vt 0.25 0.75\n"
+        "f 1/1 2/2 3/1\n";
+
+    const std::vector<PackedVertex> corners = ParseNative(text);
+    REQUIRE(corners.size() == 3);
+    //! Missing v is zero, flipped to one
+    CHECK(corners[0].texCoord.x == doctest::Approx(0.5f));
+    CHECK(corners[0].texCoord.y == doctest::Approx(1.0f));
+    CheckCorners(corners, ParseTinyObj(text));
+}
+
+TEST_CASE("[ObjParser] - Polygon fan triangulation")
+{
+    //! tinyobjloader may split quads at the other diagonal, so the fan is
+    //! checked directly
+    const std::string text =
+        "v 0.0 0.0 0.0\n"
+        "v 1.0 0.0 0.0\n"
+        "v 2.0 1.0 0.0\n"
+        "v 1.0 2.0 0.0\n"
+        "v 0.0 1.0 0.0\n"
+        "f 1 2 3 4 5\n";
+
+    const std::vector<PackedVertex> corners = ParseNative(text);
+    REQUIRE(corners.size() == 9);
+    const int expected[9] = { 0, 1, 2, 0, 2, 3, 0, 3, 4 };
+    const glm::vec3 positions[5] = {
+        { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 2.0f, 1.0f, 0.0f },
+        { 1.0f, 2.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }
+    };
+    for (size_t i = 0; i < 9; ++i)
+    {
+        CHECK(corners[i].position.x ==
+              doctest::Approx(positions[expected[i]].x));
+        CHECK(corners[i].position.y ==
+              doctest::Approx(positions[expected[i]].y));
+        CHECK(corners[i].normal.z == doctest::Approx(1.0f));
+    }
+}
+
+TEST_CASE("[ObjParser] - Skipped and unsupported records")
+{
+    //! Groups, materials and smoothing groups are skipped
+    const std::string text =
+        "mtllib scene.mtl\n"
+        "o object\n"
+        "g group\n"
+        "usemtl material\n"
+        "s 1\n"
+        "v 0.0 0.0 0.0\n"
+        "v 1.0 0.0 0.0\n"
+        "v 0.0 1.0 0.0\n"
+        "f 1 2 3\n";
+    CheckCorners(ParseNative(text), ParseTinyObj(text));
+
+    //! Line continuations and malformed records are left to tinyobjloader
+    std::vector<PackedVertex> corners;
+    const std::string continued = "v 0.0 0.0 \\\n0.0\n";
+    CHECK_FALSE(
+        ObjParser::Parse(continued.data(), continued.size(), corners));
+    const std::string malformed =
+        "v 0.0 0.0 0.0\nv 1.0 0.0 0.0\nv 0.0 1.0 0.0\nf 1/x 2 3\n";
+    CHECK_FALSE(
+        ObjParser::Parse(malformed.data(), malformed.size(), corners));
+    const std::string outOfRange = "v 0.0 0.0 0.0\nf 1 2 3\n";
+    CHECK_FALSE(
+        ObjParser::Parse(outOfRange.data(), outOfRange.size(), corners));
+}
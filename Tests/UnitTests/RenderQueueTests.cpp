@@ -0,0 +1,121 @@
+#include <doctest/doctest.h>
+
+#include <Common/RenderQueue.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Common;
+
+namespace
+{
+//! Sort the items of the queue and compare them with std::stable_sort of
+//! the same items, payloads are the push order
+void CheckSort(const std::vector<std::uint64_t>& keys)
+{
+    RenderQueue queue;
+    std::vector<RenderQueue::Item> expected;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        queue.Push(keys[i], static_cast<std::uint32_t>(i));
+        expected.push_back({ keys[i], static_cast<std::uint32_t>(i) });
+    }
+    queue.Sort();
+    std::stable_sort(
+        expected.begin(), expected.end(),
+        [](const RenderQueue::Item& lhs, const RenderQueue::Item& rhs) {
+            return lhs.key < rhs.key;
+        });
+
+    const auto& items = queue.GetItems();
+    REQUIRE(items.size() == expected.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        CHECK(items[i].key == expected[i].key);
+        CHECK(items[i].payload == expected[i].payload);
+    }
+}
+}  // namespace
+
+TEST_CASE("[RenderQueue] - Sort random keys")
+{
+    std::mt19937_64 rng(1234);
+    std::vector<std::uint64_t> keys(10000);
+    for (auto& key : keys)
+    {
+        key = rng();
+    }
+    CheckSort(keys);
+
+    //! Few distinct keys, the push order of the equal keys is kept
+    for (auto& key : keys)
+    {
+        key = rng() % 16;
+    }
+    CheckSort(keys);
+}
+
+TEST_CASE("[RenderQueue] - Sort keys with shared digits")
+{
+    std::mt19937_64 rng(5678);
+
+    //! Only the middle digits differ, the others are skipped
+    std::vector<std::uint64_t> keys(1000);
+    for (auto& key : keys)
+    {
+        key = 0xAB000000000000CDULL | ((rng() & 0xFFFF) << 24);
+    }
+    CheckSort(keys);
+
+    //! Keys equal in every digit keep the push order
+    keys.assign(100, 0x0123456789ABCDEFULL);
+    CheckSort(keys);
+
+    CheckSort({});
+    CheckSort({ 42 });
+}
+
+TEST_CASE("[RenderQueue] - Sort key order")
+{
+    //! Opaque before masked before blended, lower pass first
+    const std::uint64_t opaque = RenderQueue::MakeSortKey(0, 0, 5, 3, 1, 9.0f);
+    const std::uint64_t masked = RenderQueue::MakeSortKey(0, 1, 0, 0, 0, 1.0f);
+    const std::uint64_t blended =
+        RenderQueue::MakeSortKey(0, 2, 0, 0, 0, 1.0f);
+    const std::uint64_t nextPass =
+        RenderQueue::MakeSortKey(1, 0, 0, 0, 0, 1.0f);
+    CHECK(opaque < masked);
+    CHECK(masked < blended);
+    CHECK(blended < nextPass);
+    CHECK(RenderQueue::GetAlphaMode(opaque) == 0);
+    CHECK(RenderQueue::GetAlphaMode(masked) == 1);
+    CHECK(RenderQueue::GetAlphaMode(blended) == 2);
+
+    //! Opaque draws are grouped by shader and material, then front-to-back
+    CHECK(RenderQueue::MakeSortKey(0, 0, 1, 7, 0, 100.0f) <
+          RenderQueue::MakeSortKey(0, 0, 2, 0, 0, 1.0f));
+    CHECK(RenderQueue::MakeSortKey(0, 0, 1, 3, 0, 100.0f) <
+          RenderQueue::MakeSortKey(0, 0, 1, 4, 0, 1.0f));
+    CHECK(RenderQueue::MakeSortKey(0, 0, 1, 3, 2, 1.0f) <
+          RenderQueue::MakeSortKey(0, 0, 1, 3, 2, 2.0f));
+
+    //! Blended draws are ordered back-to-front before the states
+    CHECK(RenderQueue::MakeSortKey(0, 2, 2, 7, 0, 10.0f) <
+          RenderQueue::MakeSortKey(0, 2, 1, 0, 0, 1.0f));
+    CHECK(RenderQueue::MakeSortKey(0, 2, 1, 0, 0, 5.0f) <
+          RenderQueue::MakeSortKey(0, 2, 2, 0, 0, 5.0f));
+
+    //! Fields are recovered from the key
+    CHECK(RenderQueue::GetShader(opaque) == 5);
+    CHECK(RenderQueue::GetShader(
+              RenderQueue::MakeSortKey(0, 2, 9, 3, 1, 2.0f)) == 9);
+    CHECK(RenderQueue::GetState(RenderQueue::MakeSortKey(0, 0, 1, 3, 0,
+                                                         1.0f)) ==
+          RenderQueue::GetState(RenderQueue::MakeSortKey(0, 0, 1, 3, 5,
+                                                         8.0f)));
+    CHECK(RenderQueue::GetState(RenderQueue::MakeSortKey(0, 2, 1, 3, 0,
+                                                         1.0f)) !=
+          RenderQueue::GetState(RenderQueue::MakeSortKey(0, 2, 1, 4, 0,
+                                                         1.0f)));
+}